@@ -160,38 +160,6 @@
     while (0)
 #endif
 
-/*
- * YV12 setup and access macros
- */
-
-#define YV12_SETUP(image)                                               \
-    bits_image_t *__bits_image = (bits_image_t *)image;                 \
-    uint32_t *bits = __bits_image->bits;                                \
-    int stride = __bits_image->rowstride;                               \
-    int offset0 = stride < 0 ?                                          \
-    ((-stride) >> 1) * ((__bits_image->height - 1) >> 1) - stride :	\
-    stride * __bits_image->height;					\
-    int offset1 = stride < 0 ?                                          \
-    offset0 + ((-stride) >> 1) * ((__bits_image->height) >> 1) :	\
-	offset0 + (offset0 >> 2)
-
-/* Note no trailing semicolon on the above macro; if it's there, then
- * the typical usage of YV12_SETUP(image); will have an extra trailing ;
- * that some compilers will interpret as a statement -- and then any further
- * variable declarations will cause an error.
- */
-
-#define YV12_Y(line)                                                    \
-    ((uint8_t *) ((bits) + (stride) * (line)))
-
-#define YV12_U(line)                                                    \
-    ((uint8_t *) ((bits) + offset1 +                                    \
-                  ((stride) >> 1) * ((line) >> 1)))
-
-#define YV12_V(line)                                                    \
-    ((uint8_t *) ((bits) + offset0 +                                    \
-                  ((stride) >> 1) * ((line) >> 1)))
-
 /* Misc. helpers */
 
 static force_inline void
@@ -507,81 +475,6 @@ MAKE_ACCESSORS(a1);
 MAKE_ACCESSORS(g1);
 
 /********************************** Fetch ************************************/
-/* Table mapping sRGB-encoded 8 bit numbers to linearly encoded
- * floating point numbers. We assume that single precision
- * floating point follows the IEEE 754 format.
- */
-static const uint32_t to_linear_u[256] =
-{
-    0x00000000, 0x399f22b4, 0x3a1f22b4, 0x3a6eb40e, 0x3a9f22b4, 0x3ac6eb61,
-    0x3aeeb40e, 0x3b0b3e5d, 0x3b1f22b4, 0x3b33070b, 0x3b46eb61, 0x3b5b518a,
-    0x3b70f18a, 0x3b83e1c5, 0x3b8fe614, 0x3b9c87fb, 0x3ba9c9b5, 0x3bb7ad6d,
-    0x3bc63547, 0x3bd5635f, 0x3be539bd, 0x3bf5ba70, 0x3c0373b5, 0x3c0c6152,
-    0x3c15a703, 0x3c1f45bc, 0x3c293e68, 0x3c3391f4, 0x3c3e4149, 0x3c494d43,
-    0x3c54b6c7, 0x3c607eb1, 0x3c6ca5df, 0x3c792d22, 0x3c830aa8, 0x3c89af9e,
-    0x3c9085db, 0x3c978dc5, 0x3c9ec7c0, 0x3ca63432, 0x3cadd37d, 0x3cb5a601,
-    0x3cbdac20, 0x3cc5e639, 0x3cce54ab, 0x3cd6f7d2, 0x3cdfd00e, 0x3ce8ddb9,
-    0x3cf2212c, 0x3cfb9ac1, 0x3d02a569, 0x3d0798dc, 0x3d0ca7e4, 0x3d11d2ae,
-    0x3d171963, 0x3d1c7c2e, 0x3d21fb3a, 0x3d2796af, 0x3d2d4ebb, 0x3d332380,
-    0x3d39152b, 0x3d3f23e3, 0x3d454fd0, 0x3d4b991c, 0x3d51ffeb, 0x3d588466,
-    0x3d5f26b7, 0x3d65e6fe, 0x3d6cc564, 0x3d73c210, 0x3d7add25, 0x3d810b65,
-    0x3d84b793, 0x3d88732e, 0x3d8c3e48, 0x3d9018f4, 0x3d940343, 0x3d97fd48,
-    0x3d9c0714, 0x3da020b9, 0x3da44a48, 0x3da883d6, 0x3daccd70, 0x3db12728,
-    0x3db59110, 0x3dba0b38, 0x3dbe95b2, 0x3dc3308f, 0x3dc7dbe0, 0x3dcc97b4,
-    0x3dd1641c, 0x3dd6412a, 0x3ddb2eec, 0x3de02d75, 0x3de53cd3, 0x3dea5d16,
-    0x3def8e52, 0x3df4d091, 0x3dfa23e5, 0x3dff885e, 0x3e027f06, 0x3e05427f,
-    0x3e080ea2, 0x3e0ae376, 0x3e0dc104, 0x3e10a752, 0x3e139669, 0x3e168e50,
-    0x3e198f0e, 0x3e1c98ab, 0x3e1fab2e, 0x3e22c6a0, 0x3e25eb08, 0x3e29186a,
-    0x3e2c4ed0, 0x3e2f8e42, 0x3e32d6c4, 0x3e362861, 0x3e39831e, 0x3e3ce702,
-    0x3e405416, 0x3e43ca5e, 0x3e4749e4, 0x3e4ad2ae, 0x3e4e64c2, 0x3e520027,
-    0x3e55a4e6, 0x3e595303, 0x3e5d0a8a, 0x3e60cb7c, 0x3e6495e0, 0x3e6869bf,
-    0x3e6c4720, 0x3e702e08, 0x3e741e7f, 0x3e78188c, 0x3e7c1c34, 0x3e8014c0,
-    0x3e822039, 0x3e84308b, 0x3e8645b8, 0x3e885fc3, 0x3e8a7eb0, 0x3e8ca281,
-    0x3e8ecb3a, 0x3e90f8df, 0x3e932b72, 0x3e9562f6, 0x3e979f6f, 0x3e99e0e0,
-    0x3e9c274e, 0x3e9e72b8, 0x3ea0c322, 0x3ea31892, 0x3ea57308, 0x3ea7d28a,
-    0x3eaa3718, 0x3eaca0b7, 0x3eaf0f69, 0x3eb18332, 0x3eb3fc16, 0x3eb67a15,
-    0x3eb8fd34, 0x3ebb8576, 0x3ebe12de, 0x3ec0a56e, 0x3ec33d2a, 0x3ec5da14,
-    0x3ec87c30, 0x3ecb2380, 0x3ecdd008, 0x3ed081ca, 0x3ed338c9, 0x3ed5f508,
-    0x3ed8b68a, 0x3edb7d52, 0x3ede4962, 0x3ee11abe, 0x3ee3f168, 0x3ee6cd64,
-    0x3ee9aeb6, 0x3eec955d, 0x3eef815d, 0x3ef272ba, 0x3ef56976, 0x3ef86594,
-    0x3efb6717, 0x3efe6e02, 0x3f00bd2b, 0x3f02460c, 0x3f03d1a5, 0x3f055ff8,
-    0x3f06f105, 0x3f0884ce, 0x3f0a1b54, 0x3f0bb499, 0x3f0d509f, 0x3f0eef65,
-    0x3f1090ef, 0x3f12353c, 0x3f13dc50, 0x3f15862a, 0x3f1732cc, 0x3f18e237,
-    0x3f1a946d, 0x3f1c4970, 0x3f1e013f, 0x3f1fbbde, 0x3f21794c, 0x3f23398c,
-    0x3f24fca0, 0x3f26c286, 0x3f288b42, 0x3f2a56d3, 0x3f2c253d, 0x3f2df680,
-    0x3f2fca9d, 0x3f31a195, 0x3f337b6a, 0x3f35581e, 0x3f3737b1, 0x3f391a24,
-    0x3f3aff7a, 0x3f3ce7b2, 0x3f3ed2d0, 0x3f40c0d2, 0x3f42b1bc, 0x3f44a58e,
-    0x3f469c49, 0x3f4895ee, 0x3f4a9280, 0x3f4c91ff, 0x3f4e946c, 0x3f5099c8,
-    0x3f52a216, 0x3f54ad55, 0x3f56bb88, 0x3f58ccae, 0x3f5ae0cb, 0x3f5cf7de,
-    0x3f5f11ec, 0x3f612ef0, 0x3f634eef, 0x3f6571ea, 0x3f6797e1, 0x3f69c0d6,
-    0x3f6beccb, 0x3f6e1bc0, 0x3f704db6, 0x3f7282af, 0x3f74baac, 0x3f76f5ae,
-    0x3f7933b6, 0x3f7b74c6, 0x3f7db8de, 0x3f800000
-};
-
-static const float * const to_linear = (const float *)to_linear_u;
-
-static uint8_t
-to_srgb (float f)
-{
-    uint8_t low = 0;
-    uint8_t high = 255;
-
-    while (high - low > 1)
-    {
-	uint8_t mid = (low + high) / 2;
-
-	if (to_linear[mid] > f)
-	    high = mid;
-	else
-	    low = mid;
-    }
-
-    if (to_linear[high] - f < f - to_linear[low])
-	return high;
-    else
-	return low;
-}
-
 static void
 fetch_scanline_a8r8g8b8_sRGB_float (bits_image_t *  image,
 				    int             x,
@@ -602,9 +495,9 @@ fetch_scanline_a8r8g8b8_sRGB_float (bits_image_t *  image,
 
 	argb->a = pixman_unorm_to_float ((p >> 24) & 0xff, 8);
 
-	argb->r = to_linear [(p >> 16) & 0xff];
-	argb->g = to_linear [(p >>  8) & 0xff];
-	argb->b = to_linear [(p >>  0) & 0xff];
+	argb->r = pixman_srgb_to_linear ((p >> 16) & 0xff);
+	argb->g = pixman_srgb_to_linear ((p >>  8) & 0xff);
+	argb->b = pixman_srgb_to_linear ((p >>  0) & 0xff);
 
 	buffer++;
     }
@@ -621,16 +514,16 @@ fetch_scanline_r8g8b8_sRGB_float (bits_image_t *  image,
     const uint8_t *bits = (uint8_t *)(image->bits + y * image->rowstride);
     argb_t *buffer = (argb_t *)b;
     int i;
-    for (i = x; i < width; ++i)
+    for (i = x; i < x + width; ++i)
     {
 	uint32_t p = FETCH_24 (image, bits, i);
 	argb_t *argb = buffer;
 
 	argb->a = 1.0f;
 
-	argb->r = to_linear[(p >> 16) & 0xff];
-	argb->g = to_linear[(p >>  8) & 0xff];
-	argb->b = to_linear[(p >>  0) & 0xff];
+	argb->r = pixman_srgb_to_linear ((p >> 16) & 0xff);
+	argb->g = pixman_srgb_to_linear ((p >>  8) & 0xff);
+	argb->b = pixman_srgb_to_linear ((p >>  0) & 0xff);
 
 	buffer++;
     }
@@ -708,6 +601,113 @@ fetch_scanline_rgbaf_float (bits_image_t   *image,
 	buffer->a = *pixel++;
     }
 }
+
+static void
+fetch_scanline_rgbah_float (bits_image_t   *image,
+			    int             x,
+			    int             y,
+			    int             width,
+			    uint32_t *      b,
+			    const uint32_t *mask)
+{
+    const uint16_t *bits = (uint16_t *)(image->bits + y * image->rowstride);
+    const uint16_t *pixel = bits + x * 4;
+    argb_t *buffer = (argb_t *)b;
+
+    for (; width--; buffer++) {
+	buffer->r = pixman_half_to_float (*pixel++);
+	buffer->g = pixman_half_to_float (*pixel++);
+	buffer->b = pixman_half_to_float (*pixel++);
+	buffer->a = pixman_half_to_float (*pixel++);
+    }
+}
+
+static void
+fetch_scanline_a16b16g16r16_float (bits_image_t   *image,
+				   int             x,
+				   int             y,
+				   int             width,
+				   uint32_t *      b,
+				   const uint32_t *mask)
+{
+    const uint64_t *bits = (uint64_t *)(image->bits + y * image->rowstride);
+    const uint64_t *pixel = bits + x;
+    argb_t *buffer = (argb_t *)b;
+
+    for (; width--; buffer++) {
+	uint64_t p = *pixel++;
+
+	buffer->a = pixman_unorm_to_float (p >> 48, 16);
+	buffer->b = pixman_unorm_to_float (p >> 32, 16);
+	buffer->g = pixman_unorm_to_float (p >> 16, 16);
+	buffer->r = pixman_unorm_to_float (p, 16);
+    }
+}
+
+static void
+fetch_scanline_x16b16g16r16_float (bits_image_t   *image,
+				   int             x,
+				   int             y,
+				   int             width,
+				   uint32_t *      b,
+				   const uint32_t *mask)
+{
+    const uint64_t *bits = (uint64_t *)(image->bits + y * image->rowstride);
+    const uint64_t *pixel = bits + x;
+    argb_t *buffer = (argb_t *)b;
+
+    for (; width--; buffer++) {
+	uint64_t p = *pixel++;
+
+	buffer->a = 1.f;
+	buffer->b = pixman_unorm_to_float (p >> 32, 16);
+	buffer->g = pixman_unorm_to_float (p >> 16, 16);
+	buffer->r = pixman_unorm_to_float (p, 16);
+    }
+}
+
+/* Medium buffers hold a16r16g16b16 pixels, so going from and to
+ * a16b16g16r16 is only a matter of swapping red and blue.
+ */
+static force_inline uint64_t
+swap_rb_16 (uint64_t p)
+{
+    return (p & 0xffff0000ffff0000ULL) |
+	((p >> 32) & 0xffff) | ((p & 0xffff) << 32);
+}
+
+/* Expects a medium buffer */
+static void
+fetch_scanline_a16b16g16r16_64 (bits_image_t   *image,
+				int             x,
+				int             y,
+				int             width,
+				uint32_t *      b,
+				const uint32_t *mask)
+{
+    const uint64_t *bits = (uint64_t *)(image->bits + y * image->rowstride);
+    const uint64_t *pixel = bits + x;
+    uint64_t *buffer = (uint64_t *)b;
+
+    while (width--)
+	*buffer++ = swap_rb_16 (*pixel++);
+}
+
+static void
+fetch_scanline_x16b16g16r16_64 (bits_image_t   *image,
+				int             x,
+				int             y,
+				int             width,
+				uint32_t *      b,
+				const uint32_t *mask)
+{
+    const uint64_t *bits = (uint64_t *)(image->bits + y * image->rowstride);
+    const uint64_t *pixel = bits + x;
+    uint64_t *buffer = (uint64_t *)b;
+
+    while (width--)
+	*buffer++ = swap_rb_16 (*pixel++) | 0xffff000000000000ULL;
+}
 #endif
 
 static void
@@ -808,67 +808,39 @@ fetch_scanline_yuy2 (bits_image_t   *image,
                      uint32_t *      buffer,
                      const uint32_t *mask)
 {
+    const pixman_yuv_coefficients_t *c = _pixman_yuv_get_coefficients (image);
     const uint32_t *bits = image->bits + image->rowstride * line;
     int i;
     
     for (i = 0; i < width; i++)
     {
-	int16_t y, u, v;
-	int32_t r, g, b;
-	
-	y = ((uint8_t *) bits)[(x + i) << 1] - 16;
-	u = ((uint8_t *) bits)[(((x + i) << 1) & - 4) + 1] - 128;
-	v = ((uint8_t *) bits)[(((x + i) << 1) & - 4) + 3] - 128;
+	uint8_t y, u, v;
 	
-	/* R = 1.164(Y - 16) + 1.596(V - 128) */
-	r = 0x012b27 * y + 0x019a2e * v;
-	/* G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128) */
-	g = 0x012b27 * y - 0x00d0f2 * v - 0x00647e * u;
-	/* B = 1.164(Y - 16) + 2.018(U - 128) */
-	b = 0x012b27 * y + 0x0206a2 * u;
+	y = ((uint8_t *) bits)[(x + i) << 1];
+	u = ((uint8_t *) bits)[(((x + i) << 1) & - 4) + 1];
+	v = ((uint8_t *) bits)[(((x + i) << 1) & - 4) + 3];
 	
-	*buffer++ = 0xff000000 |
-	    (r >= 0 ? r < 0x1000000 ? r         & 0xff0000 : 0xff0000 : 0) |
-	    (g >= 0 ? g < 0x1000000 ? (g >> 8)  & 0x00ff00 : 0x00ff00 : 0) |
-	    (b >= 0 ? b < 0x1000000 ? (b >> 16) & 0x0000ff : 0x0000ff : 0);
+	*buffer++ = convert_yuv_to_8888 (c, y, u, v);
     }
 }
 
+/* yv12, i420 and nv12 */
 static void
-fetch_scanline_yv12 (bits_image_t   *image,
-                     int             x,
-                     int             line,
-                     int             width,
-                     uint32_t *      buffer,
-                     const uint32_t *mask)
+fetch_scanline_planar_yuv (bits_image_t   *image,
+			   int             x,
+			   int             line,
+			   int             width,
+			   uint32_t *      buffer,
+			   const uint32_t *mask)
 {
-    YV12_SETUP (image);
-    uint8_t *y_line = YV12_Y (line);
-    uint8_t *u_line = YV12_U (line);
-    uint8_t *v_line = YV12_V (line);
+    const pixman_yuv_coefficients_t *c = _pixman_yuv_get_coefficients (image);
+    pixman_yuv_line_t yuv;
     int i;
-    
-    for (i = 0; i < width; i++)
-    {
-	int16_t y, u, v;
-	int32_t r, g, b;
-
-	y = y_line[x + i] - 16;
-	u = u_line[(x + i) >> 1] - 128;
-	v = v_line[(x + i) >> 1] - 128;
-
-	/* R = 1.164(Y - 16) + 1.596(V - 128) */
-	r = 0x012b27 * y + 0x019a2e * v;
-	/* G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128) */
-	g = 0x012b27 * y - 0x00d0f2 * v - 0x00647e * u;
-	/* B = 1.164(Y - 16) + 2.018(U - 128) */
-	b = 0x012b27 * y + 0x0206a2 * u;
-
-	*buffer++ = 0xff000000 |
-	    (r >= 0 ? r < 0x1000000 ? r         & 0xff0000 : 0xff0000 : 0) |
-	    (g >= 0 ? g < 0x1000000 ? (g >> 8)  & 0x00ff00 : 0x00ff00 : 0) |
-	    (b >= 0 ? b < 0x1000000 ? (b >> 16) & 0x0000ff : 0x0000ff : 0);
-    }
+
+    _pixman_yuv_get_line (image, line, &yuv);
+
+    for (i = x; i < x + width; i++)
+	*buffer++ = convert_yuv_line_to_8888 (c, &yuv, i);
 }
 
 /**************************** Pixel wise fetching *****************************/
@@ -905,6 +877,56 @@ fetch_pixel_rgbaf_float (bits_image_t *image,
 
     return argb;
 }
+
+static argb_t
+fetch_pixel_rgbah_float (bits_image_t *image,
+			 int	    offset,
+			 int	    line)
+{
+    uint16_t *bits = (uint16_t *)(image->bits + line * image->rowstride);
+    argb_t argb;
+
+    argb.r = pixman_half_to_float (bits[offset * 4]);
+    argb.g = pixman_half_to_float (bits[offset * 4 + 1]);
+    argb.b = pixman_half_to_float (bits[offset * 4 + 2]);
+    argb.a = pixman_half_to_float (bits[offset * 4 + 3]);
+
+    return argb;
+}
+
+static argb_t
+fetch_pixel_a16b16g16r16_float (bits_image_t *image,
+				int	      offset,
+				int	      line)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + line * image->rowstride);
+    uint64_t p = bits[offset];
+    argb_t argb;
+
+    argb.a = pixman_unorm_to_float (p >> 48, 16);
+    argb.b = pixman_unorm_to_float (p >> 32, 16);
+    argb.g = pixman_unorm_to_float (p >> 16, 16);
+    argb.r = pixman_unorm_to_float (p, 16);
+
+    return argb;
+}
+
+static argb_t
+fetch_pixel_x16b16g16r16_float (bits_image_t *image,
+				int	      offset,
+				int	      line)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + line * image->rowstride);
+    uint64_t p = bits[offset];
+    argb_t argb;
+
+    argb.a = 1.f;
+    argb.b = pixman_unorm_to_float (p >> 32, 16);
+    argb.g = pixman_unorm_to_float (p >> 16, 16);
+    argb.r = pixman_unorm_to_float (p, 16);
+
+    return argb;
+}
 #endif
 
 static argb_t
@@ -1000,9 +1022,9 @@ fetch_pixel_a8r8g8b8_sRGB_float (bits_image_t *image,
 
     argb.a = pixman_unorm_to_float ((p >> 24) & 0xff, 8);
 
-    argb.r = to_linear [(p >> 16) & 0xff];
-    argb.g = to_linear [(p >>  8) & 0xff];
-    argb.b = to_linear [(p >>  0) & 0xff];
+    argb.r = pixman_srgb_to_linear ((p >> 16) & 0xff);
+    argb.g = pixman_srgb_to_linear ((p >>  8) & 0xff);
+    argb.b = pixman_srgb_to_linear ((p >>  0) & 0xff);
 
     return argb;
 }
@@ -1018,9 +1040,9 @@ fetch_pixel_r8g8b8_sRGB_float (bits_image_t *image,
 
     argb.a = 1.0f;
 
-    argb.r = to_linear[(p >> 16) & 0xff];
-    argb.g = to_linear[(p >>  8) & 0xff];
-    argb.b = to_linear[(p >>  0) & 0xff];
+    argb.r = pixman_srgb_to_linear ((p >> 16) & 0xff);
+    argb.g = pixman_srgb_to_linear ((p >>  8) & 0xff);
+    argb.b = pixman_srgb_to_linear ((p >>  0) & 0xff);
 
     return argb;
 }
@@ -1031,53 +1053,26 @@ fetch_pixel_yuy2 (bits_image_t *image,
 		  int           line)
 {
     const uint32_t *bits = image->bits + image->rowstride * line;
+    uint8_t y, u, v;
     
-    int16_t y, u, v;
-    int32_t r, g, b;
+    y = ((uint8_t *) bits)[offset << 1];
+    u = ((uint8_t *) bits)[((offset << 1) & - 4) + 1];
+    v = ((uint8_t *) bits)[((offset << 1) & - 4) + 3];
     
-    y = ((uint8_t *) bits)[offset << 1] - 16;
-    u = ((uint8_t *) bits)[((offset << 1) & - 4) + 1] - 128;
-    v = ((uint8_t *) bits)[((offset << 1) & - 4) + 3] - 128;
-    
-    /* R = 1.164(Y - 16) + 1.596(V - 128) */
-    r = 0x012b27 * y + 0x019a2e * v;
-    
-    /* G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128) */
-    g = 0x012b27 * y - 0x00d0f2 * v - 0x00647e * u;
-    
-    /* B = 1.164(Y - 16) + 2.018(U - 128) */
-    b = 0x012b27 * y + 0x0206a2 * u;
-    
-    return 0xff000000 |
-	(r >= 0 ? r < 0x1000000 ? r         & 0xff0000 : 0xff0000 : 0) |
-	(g >= 0 ? g < 0x1000000 ? (g >> 8)  & 0x00ff00 : 0x00ff00 : 0) |
-	(b >= 0 ? b < 0x1000000 ? (b >> 16) & 0x0000ff : 0x0000ff : 0);
+    return convert_yuv_to_8888 (_pixman_yuv_get_coefficients (image), y, u, v);
 }
 
 static uint32_t
-fetch_pixel_yv12 (bits_image_t *image,
-		  int           offset,
-		  int           line)
+fetch_pixel_planar_yuv (bits_image_t *image,
+			int           offset,
+			int           line)
 {
-    YV12_SETUP (image);
-    int16_t y = YV12_Y (line)[offset] - 16;
-    int16_t u = YV12_U (line)[offset >> 1] - 128;
-    int16_t v = YV12_V (line)[offset >> 1] - 128;
-    int32_t r, g, b;
-    
-    /* R = 1.164(Y - 16) + 1.596(V - 128) */
-    r = 0x012b27 * y + 0x019a2e * v;
-    
-    /* G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128) */
-    g = 0x012b27 * y - 0x00d0f2 * v - 0x00647e * u;
-    
-    /* B = 1.164(Y - 16) + 2.018(U - 128) */
-    b = 0x012b27 * y + 0x0206a2 * u;
-    
-    return 0xff000000 |
-	(r >= 0 ? r < 0x1000000 ? r         & 0xff0000 : 0xff0000 : 0) |
-	(g >= 0 ? g < 0x1000000 ? (g >> 8)  & 0x00ff00 : 0x00ff00 : 0) |
-	(b >= 0 ? b < 0x1000000 ? (b >> 16) & 0x0000ff : 0x0000ff : 0);
+    pixman_yuv_line_t yuv;
+
+    _pixman_yuv_get_line (image, line, &yuv);
+
+    return convert_yuv_line_to_8888 (_pixman_yuv_get_coefficients (image),
+				     &yuv, offset);
 }
 
 /*********************************** Store ************************************/
@@ -1119,6 +1114,109 @@ store_scanline_rgbf_float (bits_image_t *  image,
 	*bits++ = values->b;
     }
 }
+
+static void
+store_scanline_rgbah_float (bits_image_t *  image,
+			    int             x,
+			    int             y,
+			    int             width,
+			    const uint32_t *v)
+{
+    uint16_t *bits = (uint16_t *)(image->bits + image->rowstride * y) + 4 * x;
+    const argb_t *values = (argb_t *)v;
+
+    for (; width; width--, values++)
+    {
+	*bits++ = pixman_float_to_half (values->r);
+	*bits++ = pixman_float_to_half (values->g);
+	*bits++ = pixman_float_to_half (values->b);
+	*bits++ = pixman_float_to_half (values->a);
+    }
+}
+
+/* Rounds to the nearest value instead of truncating like
+ * pixman_float_to_unorm(), so that every 16 bit value survives a trip
+ * through a float.
+ */
+static force_inline uint64_t
+float_to_unorm16 (float f)
+{
+    if (f > 1.0f)
+	f = 1.0f;
+    if (f < 0.0f)
+	f = 0.0f;
+
+    return (uint32_t)(f * 65535.0f + 0.5f);
+}
+
+static void
+store_scanline_a16b16g16r16_float (bits_image_t *  image,
+				   int             x,
+				   int             y,
+				   int             width,
+				   const uint32_t *v)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + image->rowstride * y) + x;
+    const argb_t *values = (argb_t *)v;
+
+    for (; width; width--, values++)
+    {
+	uint64_t a = float_to_unorm16 (values->a);
+	uint64_t b = float_to_unorm16 (values->b);
+	uint64_t g = float_to_unorm16 (values->g);
+	uint64_t r = float_to_unorm16 (values->r);
+
+	*bits++ = (a << 48) | (b << 32) | (g << 16) | r;
+    }
+}
+
+static void
+store_scanline_x16b16g16r16_float (bits_image_t *  image,
+				   int             x,
+				   int             y,
+				   int             width,
+				   const uint32_t *v)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + image->rowstride * y) + x;
+    const argb_t *values = (argb_t *)v;
+
+    for (; width; width--, values++)
+    {
+	uint64_t b = float_to_unorm16 (values->b);
+	uint64_t g = float_to_unorm16 (values->g);
+	uint64_t r = float_to_unorm16 (values->r);
+
+	*bits++ = (b << 32) | (g << 16) | r;
+    }
+}
+
+static void
+store_scanline_a16b16g16r16_64 (bits_image_t *  image,
+				int             x,
+				int             y,
+				int             width,
+				const uint32_t *v)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + image->rowstride * y) + x;
+    const uint64_t *values = (uint64_t *)v;
+
+    while (width--)
+	*bits++ = swap_rb_16 (*values++);
+}
+
+static void
+store_scanline_x16b16g16r16_64 (bits_image_t *  image,
+				int             x,
+				int             y,
+				int             width,
+				const uint32_t *v)
+{
+    uint64_t *bits = (uint64_t *)(image->bits + image->rowstride * y) + x;
+    const uint64_t *values = (uint64_t *)v;
+
+    while (width--)
+	*bits++ = swap_rb_16 (*values++) & 0x0000ffffffffffffULL;
+}
 #endif
 
 static void
@@ -1240,9 +1338,9 @@ store_scanline_a8r8g8b8_sRGB_float (bits_image_t *  image,
 	uint32_t a, r, g, b;
 
 	a = pixman_float_to_unorm (values[i].a, 8);
-	r = to_srgb (values[i].r);
-	g = to_srgb (values[i].g);
-	b = to_srgb (values[i].b);
+	r = pixman_linear_to_srgb (values[i].r);
+	g = pixman_linear_to_srgb (values[i].g);
+	b = pixman_linear_to_srgb (values[i].b);
 
 	WRITE (image, pixel++,
 	       (a << 24) | (r << 16) | (g << 8) | b);
@@ -1264,9 +1362,9 @@ store_scanline_r8g8b8_sRGB_float (bits_image_t *  image,
     {
 	uint32_t r, g, b, rgb;
 
-	r = to_srgb (values[i].r);
-	g = to_srgb (values[i].g);
-	b = to_srgb (values[i].b);
+	r = pixman_linear_to_srgb (values[i].r);
+	g = pixman_linear_to_srgb (values[i].g);
+	b = pixman_linear_to_srgb (values[i].b);
 
 	rgb = (r << 16) | (g << 8) | b;
 
@@ -1344,9 +1442,9 @@ fetch_scanline_a8r8g8b8_32_sRGB (bits_image_t   *image,
 	g = (tmp >> 8) & 0xff;
 	b = (tmp >> 0) & 0xff;
 
-	r = to_linear[r] * 255.0f + 0.5f;
-	g = to_linear[g] * 255.0f + 0.5f;
-	b = to_linear[b] * 255.0f + 0.5f;
+	r = pixman_srgb_to_linear (r) * 255.0f + 0.5f;
+	g = pixman_srgb_to_linear (g) * 255.0f + 0.5f;
+	b = pixman_srgb_to_linear (b) * 255.0f + 0.5f;
 
 	*buffer++ = (a << 24) | (r << 16) | (g << 8) | (b << 0);
     }
@@ -1375,9 +1473,9 @@ fetch_scanline_r8g8b8_32_sRGB (bits_image_t   *image,
 	g = (tmp >> 8) & 0xff;
 	b = (tmp >> 0) & 0xff;
 
-	r = to_linear[r] * 255.0f + 0.5f;
-	g = to_linear[g] * 255.0f + 0.5f;
-	b = to_linear[b] * 255.0f + 0.5f;
+	r = pixman_srgb_to_linear (r) * 255.0f + 0.5f;
+	g = pixman_srgb_to_linear (g) * 255.0f + 0.5f;
+	b = pixman_srgb_to_linear (b) * 255.0f + 0.5f;
 
 	*buffer++ = (a << 24) | (r << 16) | (g << 8) | (b << 0);
     }
@@ -1397,9 +1495,9 @@ fetch_pixel_a8r8g8b8_32_sRGB (bits_image_t *image,
     g = (tmp >> 8) & 0xff;
     b = (tmp >> 0) & 0xff;
 
-    r = to_linear[r] * 255.0f + 0.5f;
-    g = to_linear[g] * 255.0f + 0.5f;
-    b = to_linear[b] * 255.0f + 0.5f;
+    r = pixman_srgb_to_linear (r) * 255.0f + 0.5f;
+    g = pixman_srgb_to_linear (g) * 255.0f + 0.5f;
+    b = pixman_srgb_to_linear (b) * 255.0f + 0.5f;
 
     return (a << 24) | (r << 16) | (g << 8) | (b << 0);
 }
@@ -1418,9 +1516,9 @@ fetch_pixel_r8g8b8_32_sRGB (bits_image_t *image,
     g = (tmp >> 8) & 0xff;
     b = (tmp >> 0) & 0xff;
 
-    r = to_linear[r] * 255.0f + 0.5f;
-    g = to_linear[g] * 255.0f + 0.5f;
-    b = to_linear[b] * 255.0f + 0.5f;
+    r = pixman_srgb_to_linear (r) * 255.0f + 0.5f;
+    g = pixman_srgb_to_linear (g) * 255.0f + 0.5f;
+    b = pixman_srgb_to_linear (b) * 255.0f + 0.5f;
 
     return (a << 24) | (r << 16) | (g << 8) | (b << 0);
 }
@@ -1449,9 +1547,9 @@ store_scanline_a8r8g8b8_32_sRGB (bits_image_t   *image,
 	g = (tmp >> 8) & 0xff;
 	b = (tmp >> 0) & 0xff;
 
-	r = to_srgb (r * (1/255.0f));
-	g = to_srgb (g * (1/255.0f));
-	b = to_srgb (b * (1/255.0f));
+	r = pixman_linear_to_srgb (r * (1/255.0f));
+	g = pixman_linear_to_srgb (g * (1/255.0f));
+	b = pixman_linear_to_srgb (b * (1/255.0f));
 	
 	WRITE (image, pixel++, a | (r << 16) | (g << 8) | (b << 0));
     }
@@ -1479,9 +1577,9 @@ store_scanline_r8g8b8_32_sRGB (bits_image_t   *image,
 	g = (tmp >> 8) & 0xff;
 	b = (tmp >> 0) & 0xff;
 
-	r = to_srgb (r * (1/255.0f));
-	g = to_srgb (g * (1/255.0f));
-	b = to_srgb (b * (1/255.0f));
+	r = pixman_linear_to_srgb (r * (1/255.0f));
+	g = pixman_linear_to_srgb (g * (1/255.0f));
+	b = pixman_linear_to_srgb (b * (1/255.0f));
 
 	STORE_24 (image, bits, i, (r << 16) | (g << 8) | (b << 0));
     }
@@ -1528,6 +1626,8 @@ typedef struct
     fetch_pixel_float_t		fetch_pixel_float;
     store_scanline_t		store_scanline_32;
     store_scanline_t		store_scanline_float;
+    fetch_scanline_t		fetch_scanline_64;
+    store_scanline_t		store_scanline_64;
 } format_info_t;
 
 #define FORMAT_INFO(format) 						\
@@ -1632,6 +1732,23 @@ static const format_info_t accessors[] =
       NULL, fetch_scanline_rgbf_float,
       fetch_pixel_generic_lossy_32, fetch_pixel_rgbf_float,
       NULL, store_scanline_rgbf_float },
+
+    { PIXMAN_rgba_half,
+      NULL, fetch_scanline_rgbah_float,
+      fetch_pixel_generic_lossy_32, fetch_pixel_rgbah_float,
+      NULL, store_scanline_rgbah_float },
+
+    { PIXMAN_a16b16g16r16,
+      NULL, fetch_scanline_a16b16g16r16_float,
+      fetch_pixel_generic_lossy_32, fetch_pixel_a16b16g16r16_float,
+      NULL, store_scanline_a16b16g16r16_float,
+      fetch_scanline_a16b16g16r16_64, store_scanline_a16b16g16r16_64 },
+
+    { PIXMAN_x16b16g16r16,
+      NULL, fetch_scanline_x16b16g16r16_float,
+      fetch_pixel_generic_lossy_32, fetch_pixel_x16b16g16r16_float,
+      NULL, store_scanline_x16b16g16r16_float,
+      fetch_scanline_x16b16g16r16_64, store_scanline_x16b16g16r16_64 },
 #endif
 
     { PIXMAN_a2r10g10b10,
@@ -1661,8 +1778,18 @@ static const format_info_t accessors[] =
       NULL, NULL },
 
     { PIXMAN_yv12,
-      fetch_scanline_yv12, fetch_scanline_generic_float,
-      fetch_pixel_yv12, fetch_pixel_generic_float,
+      fetch_scanline_planar_yuv, fetch_scanline_generic_float,
+      fetch_pixel_planar_yuv, fetch_pixel_generic_float,
+      NULL, NULL },
+
+    { PIXMAN_i420,
+      fetch_scanline_planar_yuv, fetch_scanline_generic_float,
+      fetch_pixel_planar_yuv, fetch_pixel_generic_float,
+      NULL, NULL },
+
+    { PIXMAN_nv12,
+      fetch_scanline_planar_yuv, fetch_scanline_generic_float,
+      fetch_pixel_planar_yuv, fetch_pixel_generic_float,
       NULL, NULL },
     
     { PIXMAN_null },
@@ -1683,6 +1810,8 @@ setup_accessors (bits_image_t *image)
 	    image->fetch_pixel_float = info->fetch_pixel_float;
 	    image->store_scanline_32 = info->store_scanline_32;
 	    image->store_scanline_float = info->store_scanline_float;
+	    image->fetch_scanline_64 = info->fetch_scanline_64;
+	    image->store_scanline_64 = info->store_scanline_64;
 	    
 	    return;
 	}
@@ -749,19 +749,143 @@ replicate_pixel_float (bits_image_t *   bits,
 	*(buffer++) = color;
 }
 
+static void
+replicate_pixel_64 (bits_image_t *   bits,
+		    int              x,
+		    int              y,
+		    int              width,
+		    uint32_t *       b)
+{
+    uint64_t color;
+    uint64_t *buffer = (uint64_t *)b;
+    uint64_t *end;
+
+    bits->fetch_scanline_64 (bits, x, y, 1, (uint32_t *)&color, NULL);
+
+    end = buffer + width;
+    while (buffer < end)
+	*(buffer++) = color;
+}
+
+/* Number of uint32_t's taken up by a pixel in a buffer */
+static force_inline int
+pixel_size (iter_flags_t flags)
+{
+    if (flags & ITER_NARROW)
+	return 1;
+    else if (flags & ITER_MEDIUM)
+	return 2;
+    else
+	return 4;
+}
+
+#define ALPHA_MAP_CHUNK 64
+
+/* Replaces the alpha of the pixels at x, y with that from the alpha map,
+ * which is 0 outside of it.
+ */
+static void
+fetch_alpha_map (bits_image_t *image,
+		 iter_flags_t  flags,
+		 int           x,
+		 int           y,
+		 int           width,
+		 uint32_t *    buffer)
+{
+    bits_image_t *alpha_map = image->common.alpha_map;
+    int i;
+
+    x -= image->common.alpha_origin_x;
+    y -= image->common.alpha_origin_y;
+
+    while (width)
+    {
+	int w = width;
+	pixman_bool_t inside;
+
+	if (y < 0 || y >= alpha_map->height || x >= alpha_map->width)
+	{
+	    inside = FALSE;
+	}
+	else if (x < 0)
+	{
+	    w = MIN (w, -x);
+	    inside = FALSE;
+	}
+	else
+	{
+	    w = MIN (w, MIN (alpha_map->width - x, ALPHA_MAP_CHUNK));
+	    inside = TRUE;
+	}
+
+	if (flags & ITER_NARROW)
+	{
+	    uint32_t alpha[ALPHA_MAP_CHUNK];
+
+	    if (inside)
+		alpha_map->fetch_scanline_32 (alpha_map, x, y, w, alpha, NULL);
+
+	    for (i = 0; i < w; ++i)
+	    {
+		buffer[i] &= 0x00ffffff;
+		if (inside)
+		    buffer[i] |= alpha[i] & 0xff000000;
+	    }
+	}
+	else
+	{
+	    argb_t alpha[ALPHA_MAP_CHUNK];
+
+	    if (inside)
+	    {
+		alpha_map->fetch_scanline_float (
+		    alpha_map, x, y, w, (uint32_t *)alpha, NULL);
+	    }
+
+	    for (i = 0; i < w; ++i)
+		((argb_t *)buffer)[i].a = inside ? alpha[i].a : 0.f;
+	}
+
+	buffer += w * pixel_size (flags);
+	x += w;
+	width -= w;
+    }
+}
+
+static force_inline void
+fetch_scanline (bits_image_t *image,
+		iter_flags_t  flags,
+		int           x,
+		int           y,
+		int           width,
+		uint32_t *    buffer)
+{
+    if (flags & ITER_NARROW)
+	image->fetch_scanline_32 (image, x, y, width, buffer, NULL);
+    else if (flags & ITER_MEDIUM)
+	image->fetch_scanline_64 (image, x, y, width, buffer, NULL);
+    else
+	image->fetch_scanline_float (image, x, y, width, buffer, NULL);
+
+    /* Medium iterators are never used with alpha maps */
+    if (image->common.alpha_map)
+	fetch_alpha_map (image, flags, x, y, width, buffer);
+}
+
 static void
 bits_image_fetch_untransformed_repeat_none (bits_image_t *image,
-                                            pixman_bool_t wide,
+                                            iter_flags_t  flags,
                                             int           x,
                                             int           y,
                                             int           width,
                                             uint32_t *    buffer)
 {
+    int size = pixel_size (flags);
     uint32_t w;
 
     if (y < 0 || y >= image->height)
     {
-	memset (buffer, 0, width * (wide? sizeof (argb_t) : 4));
+	memset (buffer, 0, width * size * 4);
 	return;
     }
 
@@ -769,10 +893,10 @@ bits_image_fetch_untransformed_repeat_none (bits_image_t *image,
     {
 	w = MIN (width, -x);
 
-	memset (buffer, 0, w * (wide ? sizeof (argb_t) : 4));
+	memset (buffer, 0, w * size * 4);
 
 	width -= w;
-	buffer += w * (wide? 4 : 1);
+	buffer += w * size;
 	x += w;
     }
 
@@ -780,27 +904,25 @@ bits_image_fetch_untransformed_repeat_none (bits_image_t *image,
     {
 	w = MIN (width, image->width - x);
 
-	if (wide)
-	    image->fetch_scanline_float (image, x, y, w, buffer, NULL);
-	else
-	    image->fetch_scanline_32 (image, x, y, w, buffer, NULL);
+	fetch_scanline (image, flags, x, y, w, buffer);
 
 	width -= w;
-	buffer += w * (wide? 4 : 1);
+	buffer += w * size;
 	x += w;
     }
 
-    memset (buffer, 0, width * (wide ? sizeof (argb_t) : 4));
+    memset (buffer, 0, width * size * 4);
 }
 
 static void
 bits_image_fetch_untransformed_repeat_normal (bits_image_t *image,
-                                              pixman_bool_t wide,
+                                              iter_flags_t  flags,
                                               int           x,
                                               int           y,
                                               int           width,
                                               uint32_t *    buffer)
 {
+    int size = pixel_size (flags);
     uint32_t w;
 
     while (y < 0)
@@ -809,12 +931,14 @@ bits_image_fetch_untransformed_repeat_normal (bits_image_t *image,
     while (y >= image->height)
 	y -= image->height;
 
-    if (image->width == 1)
+    if (image->width == 1 && !image->common.alpha_map)
     {
-	if (wide)
-	    replicate_pixel_float (image, 0, y, width, buffer);
-	else
+	if (flags & ITER_NARROW)
 	    replicate_pixel_32 (image, 0, y, width, buffer);
+	else if (flags & ITER_MEDIUM)
+	    replicate_pixel_64 (image, 0, y, width, buffer);
+	else
+	    replicate_pixel_float (image, 0, y, width, buffer);
 
 	return;
     }
@@ -828,20 +952,17 @@ bits_image_fetch_untransformed_repeat_normal (bits_image_t *image,
 
 	w = MIN (width, image->width - x);
 
-	if (wide)
-	    image->fetch_scanline_float (image, x, y, w, buffer, NULL);
-	else
-	    image->fetch_scanline_32 (image, x, y, w, buffer, NULL);
+	fetch_scanline (image, flags, x, y, w, buffer);
 
-	buffer += w * (wide? 4 : 1);
+	buffer += w * size;
 	x += w;
 	width -= w;
     }
 }
 
-static uint32_t *
-bits_image_fetch_untransformed_32 (pixman_iter_t * iter,
-				   const uint32_t *mask)
+static force_inline uint32_t *
+bits_image_fetch_untransformed (pixman_iter_t * iter,
+				iter_flags_t    flags)
 {
     pixman_image_t *image  = iter->image;
     int             x      = iter->x;
@@ -852,12 +973,12 @@ bits_image_fetch_untransformed_32 (pixman_iter_t * iter,
     if (image->common.repeat == PIXMAN_REPEAT_NONE)
     {
 	bits_image_fetch_untransformed_repeat_none (
-	    &image->bits, FALSE, x, y, width, buffer);
+	    &image->bits, flags, x, y, width, buffer);
     }
     else
     {
 	bits_image_fetch_untransformed_repeat_normal (
-	    &image->bits, FALSE, x, y, width, buffer);
+	    &image->bits, flags, x, y, width, buffer);
     }
 
     iter->y++;
@@ -865,28 +986,24 @@ bits_image_fetch_untransformed_32 (pixman_iter_t * iter,
 }
 
 static uint32_t *
-bits_image_fetch_untransformed_float (pixman_iter_t * iter,
-				      const uint32_t *mask)
+bits_image_fetch_untransformed_32 (pixman_iter_t * iter,
+				   const uint32_t *mask)
 {
-    pixman_image_t *image  = iter->image;
-    int             x      = iter->x;
-    int             y      = iter->y;
-    int             width  = iter->width;
-    uint32_t *      buffer = iter->buffer;
+    return bits_image_fetch_untransformed (iter, ITER_NARROW);
+}
 
-    if (image->common.repeat == PIXMAN_REPEAT_NONE)
-    {
-	bits_image_fetch_untransformed_repeat_none (
-	    &image->bits, TRUE, x, y, width, buffer);
-    }
-    else
-    {
-	bits_image_fetch_untransformed_repeat_normal (
-	    &image->bits, TRUE, x, y, width, buffer);
-    }
+static uint32_t *
+bits_image_fetch_untransformed_64 (pixman_iter_t * iter,
+				   const uint32_t *mask)
+{
+    return bits_image_fetch_untransformed (iter, ITER_MEDIUM);
+}
 
-    iter->y++;
-    return buffer;
+static uint32_t *
+bits_image_fetch_untransformed_float (pixman_iter_t * iter,
+				      const uint32_t *mask)
+{
+    return bits_image_fetch_untransformed (iter, ITER_WIDE);
 }
 
 typedef struct
@@ -895,18 +1012,19 @@ typedef struct
     uint32_t			flags;
     pixman_iter_get_scanline_t	get_scanline_32;
     pixman_iter_get_scanline_t  get_scanline_float;
+    pixman_iter_get_scanline_t  get_scanline_64;
 } fetcher_info_t;
 
 static const fetcher_info_t fetcher_info[] =
 {
     { PIXMAN_any,
-      (FAST_PATH_NO_ALPHA_MAP			|
-       FAST_PATH_ID_TRANSFORM			|
+      (FAST_PATH_ID_TRANSFORM			|
        FAST_PATH_NO_CONVOLUTION_FILTER		|
        FAST_PATH_NO_PAD_REPEAT			|
        FAST_PATH_NO_REFLECT_REPEAT),
       bits_image_fetch_untransformed_32,
-      bits_image_fetch_untransformed_float
+      bits_image_fetch_untransformed_float,
+      bits_image_fetch_untransformed_64
     },
 
     /* Affine, no alpha */
@@ -948,6 +1066,13 @@ _pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter)
 	    {
 		iter->get_scanline = info->get_scanline_32;
 	    }
+	    else if (iter->iter_flags & ITER_MEDIUM)
+	    {
+		/* Medium iterators are only asked for when the image
+		 * is untransformed and has no alpha map.
+		 */
+		iter->get_scanline = info->get_scanline_64;
+	    }
 	    else
 	    {
 		iter->get_scanline = info->get_scanline_float;
@@ -971,28 +1096,7 @@ dest_get_scanline_narrow (pixman_iter_t *iter, const uint32_t *mask)
 
     image->bits.fetch_scanline_32 (&image->bits, x, y, width, buffer, mask);
     if (image->common.alpha_map)
-    {
-	uint32_t *alpha;
-
-	if ((alpha = malloc (width * sizeof (uint32_t))))
-	{
-	    int i;
-
-	    x -= image->common.alpha_origin_x;
-	    y -= image->common.alpha_origin_y;
-
-	    image->common.alpha_map->fetch_scanline_32 (
-		image->common.alpha_map, x, y, width, alpha, mask);
-
-	    for (i = 0; i < width; ++i)
-	    {
-		buffer[i] &= ~0xff000000;
-		buffer[i] |= (alpha[i] & 0xff000000);
-	    }
-
-	    free (alpha);
-	}
-    }
+	fetch_alpha_map (&image->bits, ITER_NARROW, x, y, width, buffer);
 
     return iter->buffer;
 }
@@ -1009,27 +1113,31 @@ dest_get_scanline_wide (pixman_iter_t *iter, const uint32_t *mask)
     image->fetch_scanline_float (
 	image, x, y, width, (uint32_t *)buffer, mask);
     if (image->common.alpha_map)
-    {
-	argb_t *alpha;
+	fetch_alpha_map (image, ITER_WIDE, x, y, width, (uint32_t *)buffer);
 
-	if ((alpha = malloc (width * sizeof (argb_t))))
-	{
-	    int i;
+    return iter->buffer;
+}
 
-	    x -= image->common.alpha_origin_x;
-	    y -= image->common.alpha_origin_y;
+static uint32_t *
+dest_get_scanline_medium (pixman_iter_t *iter, const uint32_t *mask)
+{
+    bits_image_t *  image  = &iter->image->bits;
 
-	    image->common.alpha_map->fetch_scanline_float (
-		image->common.alpha_map, x, y, width, (uint32_t *)alpha, mask);
+    image->fetch_scanline_64 (
+	image, iter->x, iter->y, iter->width, iter->buffer, mask);
 
-	    for (i = 0; i < width; ++i)
-		buffer[i].a = alpha[i].a;
+    return iter->buffer;
+}
 
-	    free (alpha);
-	}
-    }
+static void
+dest_write_back_medium (pixman_iter_t *iter)
+{
+    bits_image_t *  image  = &iter->image->bits;
 
-    return iter->buffer;
+    image->store_scanline_64 (
+	image, iter->x, iter->y, iter->width, iter->buffer);
+
+    iter->y++;
 }
 
 static void
@@ -1085,6 +1193,47 @@ dither_factor_bayer_8 (int x, int y)
 
 typedef float (* dither_factor_t)(int x, int y);
 
+/* The factor that dest_write_back_wide() uses for the pixel at x, y,
+ * for SIMD versions of it. It repeats every 64 pixels.
+ */
+float
+_pixman_dither_factor (pixman_dither_t dither, int x, int y)
+{
+    switch (dither)
+    {
+    case PIXMAN_DITHER_GOOD:
+    case PIXMAN_DITHER_BEST:
+    case PIXMAN_DITHER_ORDERED_BLUE_NOISE_64:
+	return dither_factor_blue_noise_64 (x, y);
+
+    case PIXMAN_DITHER_FAST:
+    case PIXMAN_DITHER_ORDERED_BAYER_8:
+	return dither_factor_bayer_8 (x, y);
+
+    case PIXMAN_DITHER_NONE:
+    default:
+	return 0.f;
+    }
+}
+
+/* The 8 bit thresholds for a line of the image, for dithering with
+ * integer math: a channel c becomes (c * (2^n - 1) + t) / 255, which
+ * is what dest_write_back_wide() computes, but exactly. Every
+ * implementation must use these so that they all give the same results.
+ */
+void
+_pixman_dither_thresholds (bits_image_t *image, int x, int y, int width,
+			   uint16_t thresholds[DITHER_PERIOD])
+{
+    int i;
+
+    x += image->dither_offset_x;
+    y += image->dither_offset_y;
+
+    for (i = 0; i < width && i < DITHER_PERIOD; ++i)
+	thresholds[i] = 255.f * _pixman_dither_factor (image->dither, x + i, y);
+}
+
 static force_inline float
 dither_apply_channel (float f, float d, float s)
 {
@@ -1225,6 +1374,20 @@ _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter)
 	
 	iter->write_back = dest_write_back_narrow;
     }
+    else if (iter->iter_flags & ITER_MEDIUM)
+    {
+	if ((iter->iter_flags & (ITER_IGNORE_RGB | ITER_IGNORE_ALPHA)) ==
+	    (ITER_IGNORE_RGB | ITER_IGNORE_ALPHA))
+	{
+	    iter->get_scanline = _pixman_iter_get_scanline_noop;
+	}
+	else
+	{
+	    iter->get_scanline = dest_get_scanline_medium;
+	}
+
+	iter->write_back = dest_write_back_medium;
+    }
     else
     {
 	iter->get_scanline = dest_get_scanline_wide;
@@ -1312,6 +1475,8 @@ _pixman_bits_image_init (pixman_image_t *     image,
     image->bits.dither = PIXMAN_DITHER_NONE;
     image->bits.dither_offset_x = 0;
     image->bits.dither_offset_y = 0;
+    image->bits.exact_coverage = FALSE;
+    image->bits.yuv_color_space = PIXMAN_YUV_BT601_LIMITED;
     image->bits.read_func = NULL;
     image->bits.write_func = NULL;
     image->bits.rowstride = rowstride;
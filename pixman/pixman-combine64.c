@@ -0,0 +1,202 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include "pixman-private.h"
+#include "pixman-combine-float.h"
+
+/* Combiners for medium iterators. Pixels are a16r16g16b16 in a uint64_t,
+ * and the channels are multiplied like the 8 bit combiners do it, only
+ * with 16 bits: each product is rounded to the nearest value, and the
+ * two halves of a Porter/Duff sum are added with saturation.
+ *
+ * Only the Porter/Duff operators up to and including ADD are here;
+ * everything else goes through the float combiners.
+ */
+
+#define ONE_UN16 0xffff
+
+static force_inline uint32_t
+mul_un16 (uint32_t a, uint32_t b)
+{
+    uint32_t t = a * b + 0x8000;
+
+    return ((t >> 16) + t) >> 16;
+}
+
+static force_inline uint32_t
+get_factor (combine_factor_t factor, uint32_t sa, uint32_t da)
+{
+    switch (factor)
+    {
+    case ONE:
+	return ONE_UN16;
+
+    case SRC_ALPHA:
+	return sa;
+
+    case DEST_ALPHA:
+	return da;
+
+    case INV_SA:
+	return ONE_UN16 - sa;
+
+    case INV_DA:
+	return ONE_UN16 - da;
+
+    default:
+	return 0;
+    }
+}
+
+/* Multiplying with ZERO or ONE is exact, so those are left out */
+static force_inline uint32_t
+apply_factor (combine_factor_t factor, uint32_t f, uint32_t c)
+{
+    if (factor == ZERO)
+	return 0;
+    else if (factor == ONE)
+	return c;
+    else
+	return mul_un16 (c, f);
+}
+
+static force_inline void
+combine_inner (pixman_bool_t     component,
+	       uint64_t *        dest,
+	       const uint64_t *  src,
+	       const uint64_t *  mask,
+	       int               width,
+	       combine_factor_t  a,
+	       combine_factor_t  b)
+{
+    int i, c;
+
+    for (i = 0; i < width; ++i)
+    {
+	uint64_t s = src[i];
+	uint64_t d = dest[i];
+	uint64_t result = 0;
+	uint32_t sa = s >> 48;
+	uint32_t da = d >> 48;
+
+	/* Per channel, the alpha value that the operator sees */
+	uint32_t m[4] = { sa, sa, sa, sa };
+
+	if (mask)
+	{
+	    uint64_t mp = mask[i];
+	    uint64_t t = 0;
+
+	    for (c = 0; c < 4; ++c)
+	    {
+		uint32_t sc = (s >> (c * 16)) & 0xffff;
+		uint32_t mc = component ? (mp >> (c * 16)) & 0xffff : mp >> 48;
+
+		t |= (uint64_t)mul_un16 (sc, mc) << (c * 16);
+		m[c] = mul_un16 (mc, sa);
+	    }
+
+	    s = t;
+	}
+
+	for (c = 0; c < 4; ++c)
+	{
+	    uint32_t sc = (s >> (c * 16)) & 0xffff;
+	    uint32_t dc = (d >> (c * 16)) & 0xffff;
+	    uint32_t r;
+
+	    r = apply_factor (a, get_factor (a, m[c], da), sc) +
+		apply_factor (b, get_factor (b, m[c], da), dc);
+
+	    result |= (uint64_t)MIN (r, ONE_UN16) << (c * 16);
+	}
+
+	dest[i] = result;
+    }
+}
+
+#define MAKE_COMBINER(name, component, a, b)				\
+    static void								\
+    combine_ ## name ## _64 (pixman_implementation_t *imp,		\
+			     pixman_op_t              op,		\
+			     uint64_t *               dest,		\
+			     const uint64_t *         src,		\
+			     const uint64_t *         mask,		\
+			     int                      width)		\
+    {									\
+	combine_inner (component, dest, src, mask, width, a, b);	\
+    }
+
+#define MAKE_PD_COMBINERS(name, a, b)					\
+    MAKE_COMBINER (name ## _ca, TRUE, a, b)				\
+    MAKE_COMBINER (name ## _u, FALSE, a, b)
+
+MAKE_PD_COMBINERS (clear,			ZERO,				ZERO)
+MAKE_PD_COMBINERS (src,				ONE,				ZERO)
+MAKE_PD_COMBINERS (dst,				ZERO,				ONE)
+MAKE_PD_COMBINERS (over,			ONE,				INV_SA)
+MAKE_PD_COMBINERS (over_reverse,		INV_DA,				ONE)
+MAKE_PD_COMBINERS (in,				DEST_ALPHA,			ZERO)
+MAKE_PD_COMBINERS (in_reverse,			ZERO,				SRC_ALPHA)
+MAKE_PD_COMBINERS (out,				INV_DA,				ZERO)
+MAKE_PD_COMBINERS (out_reverse,			ZERO,				INV_SA)
+MAKE_PD_COMBINERS (atop,			DEST_ALPHA,			INV_SA)
+MAKE_PD_COMBINERS (atop_reverse,		INV_DA,				SRC_ALPHA)
+MAKE_PD_COMBINERS (xor,				INV_DA,				INV_SA)
+MAKE_PD_COMBINERS (add,				ONE,				ONE)
+
+void
+_pixman_setup_combiner_functions_64 (pixman_implementation_t *imp)
+{
+    /* Unified alpha */
+    imp->combine_64[PIXMAN_OP_CLEAR] = combine_clear_u_64;
+    imp->combine_64[PIXMAN_OP_SRC] = combine_src_u_64;
+    imp->combine_64[PIXMAN_OP_DST] = combine_dst_u_64;
+    imp->combine_64[PIXMAN_OP_OVER] = combine_over_u_64;
+    imp->combine_64[PIXMAN_OP_OVER_REVERSE] = combine_over_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_IN] = combine_in_u_64;
+    imp->combine_64[PIXMAN_OP_IN_REVERSE] = combine_in_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_OUT] = combine_out_u_64;
+    imp->combine_64[PIXMAN_OP_OUT_REVERSE] = combine_out_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_ATOP] = combine_atop_u_64;
+    imp->combine_64[PIXMAN_OP_ATOP_REVERSE] = combine_atop_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_XOR] = combine_xor_u_64;
+    imp->combine_64[PIXMAN_OP_ADD] = combine_add_u_64;
+
+    /* Component alpha */
+    imp->combine_64_ca[PIXMAN_OP_CLEAR] = combine_clear_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_SRC] = combine_src_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_DST] = combine_dst_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OVER] = combine_over_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OVER_REVERSE] = combine_over_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_IN] = combine_in_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_IN_REVERSE] = combine_in_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OUT] = combine_out_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OUT_REVERSE] = combine_out_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ATOP] = combine_atop_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ATOP_REVERSE] = combine_atop_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_XOR] = combine_xor_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ADD] = combine_add_ca_64;
+}
@@ -232,3 +232,57 @@
 #    error "Unknown thread local support for this system. Pixman will not work with multiple threads. Define PIXMAN_NO_TLS to acknowledge and accept this limitation and compile pixman without thread-safety support."
 
 #endif
+
+/* Atomics, for the little global state that several threads can access.
+ * Loads acquire, and stores and successful exchanges release. Increments
+ * and decrements do both, and return the new value.
+ */
+#if defined(__GNUC__)
+
+#   define PIXMAN_HAVE_ATOMICS
+
+#   define PIXMAN_ATOMIC_LOAD_INT(ptr)					\
+    __atomic_load_n ((ptr), __ATOMIC_ACQUIRE)
+#   define PIXMAN_ATOMIC_STORE_INT(ptr, value)				\
+    __atomic_store_n ((ptr), (value), __ATOMIC_RELEASE)
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    __atomic_load_n ((ptr), __ATOMIC_ACQUIRE)
+#   define PIXMAN_ATOMIC_CAS_PTR(ptr, old_value, new_value)		\
+    __sync_bool_compare_and_swap ((ptr), (old_value), (new_value))
+#   define PIXMAN_ATOMIC_INC_INT(ptr)					\
+    __atomic_add_fetch ((ptr), 1, __ATOMIC_ACQ_REL)
+#   define PIXMAN_ATOMIC_DEC_INT(ptr)					\
+    __atomic_sub_fetch ((ptr), 1, __ATOMIC_ACQ_REL)
+
+#elif defined(_MSC_VER)
+
+#   include <intrin.h>
+
+#   define PIXMAN_HAVE_ATOMICS
+
+#   define PIXMAN_ATOMIC_LOAD_INT(ptr)					\
+    ((int)_InterlockedOr ((volatile long *)(ptr), 0))
+#   define PIXMAN_ATOMIC_STORE_INT(ptr, value)				\
+    ((void)_InterlockedExchange ((volatile long *)(ptr), (value)))
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    _InterlockedCompareExchangePointer ((void * volatile *)(ptr), NULL, NULL)
+#   define PIXMAN_ATOMIC_CAS_PTR(ptr, old_value, new_value)		\
+    (_InterlockedCompareExchangePointer (				\
+	(void * volatile *)(ptr), (new_value), (old_value)) == (old_value))
+#   define PIXMAN_ATOMIC_INC_INT(ptr)					\
+    ((int)_InterlockedIncrement ((volatile long *)(ptr)))
+#   define PIXMAN_ATOMIC_DEC_INT(ptr)					\
+    ((int)_InterlockedDecrement ((volatile long *)(ptr)))
+
+#else
+
+/* Without atomics, there is no thread safety either */
+#   define PIXMAN_ATOMIC_LOAD_INT(ptr)		(*(ptr))
+#   define PIXMAN_ATOMIC_STORE_INT(ptr, value)	(*(ptr) = (value))
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)		(*(ptr))
+#   define PIXMAN_ATOMIC_CAS_PTR(ptr, old_value, new_value)		\
+    (*(ptr) == (old_value) ? (*(ptr) = (new_value), 1) : 0)
+#   define PIXMAN_ATOMIC_INC_INT(ptr)		(++*(ptr))
+#   define PIXMAN_ATOMIC_DEC_INT(ptr)		(--*(ptr))
+
+#endif
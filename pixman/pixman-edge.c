@@ -24,39 +24,12 @@
 #include <pixman-config.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "pixman-private.h"
 #include "pixman-accessor.h"
 
-/*
- * Step across a small sample grid gap
- */
-#define RENDER_EDGE_STEP_SMALL(edge)					\
-    {									\
-	edge->x += edge->stepx_small;					\
-	edge->e += edge->dx_small;					\
-	if (edge->e > 0)						\
-	{								\
-	    edge->e -= edge->dy;					\
-	    edge->x += edge->signdx;					\
-	}								\
-    }
-
-/*
- * Step across a large sample grid gap
- */
-#define RENDER_EDGE_STEP_BIG(edge)					\
-    {									\
-	edge->x += edge->stepx_big;					\
-	edge->e += edge->dx_big;					\
-	if (edge->e > 0)						\
-	{								\
-	    edge->e -= edge->dy;					\
-	    edge->x += edge->signdx;					\
-	}								\
-    }
-
 #ifdef PIXMAN_FB_ACCESSORS
 #define PIXMAN_RASTERIZE_EDGES pixman_rasterize_edges_accessors
 #else
@@ -335,6 +308,212 @@ rasterize_edges_8 (pixman_image_t *image,
     }
 }
 
+/*
+ * 8 bit alpha, exact area coverage
+ *
+ * Rather than counting sample points, this computes the area of each
+ * pixel that lies between the two edges, and the edges are only stepped
+ * once per pixel row. Within a row, each edge is split at the pixel
+ * boundaries it crosses. Every piece adds the area to its right inside
+ * its own pixel to 'cells', and its height to 'cover' for the pixels
+ * further right; 'cover' holds deltas that are prefix-summed when the
+ * row is written out. The coverage of the span is then the area to the
+ * right of the left edge minus the area to the right of the right edge.
+ *
+ * Areas are in 16.16 fixed point, so a covered pixel is pixman_fixed_1.
+ */
+#define N_STACK_CELLS 256
+
+static force_inline pixman_fixed_t
+edge_x_at (pixman_edge_t *e, pixman_fixed_48_16_t dx,
+	   pixman_fixed_t t, pixman_fixed_t y)
+{
+    if (!e->dy)
+	return e->x;
+
+    return e->x + ((y - t) * dx) / e->dy;
+}
+
+static void
+add_edge_area (int32_t *       cells,
+	       int32_t *       cover,
+	       int             width,
+	       pixman_fixed_t  x0,
+	       pixman_fixed_t  x1,
+	       pixman_fixed_t  h,
+	       int             sign)
+{
+    pixman_fixed_t lo = MIN (x0, x1);
+    pixman_fixed_t hi = MAX (x0, x1);
+    pixman_fixed_t w = pixman_int_to_fixed (width);
+    pixman_fixed_t xs, done;
+    int c;
+
+    if (hi <= 0)
+    {
+	cover[0] += sign * h;
+	return;
+    }
+
+    if (lo >= w)
+	return;
+
+    if (lo >= 0 && pixman_fixed_to_int (lo) == pixman_fixed_to_int (hi))
+    {
+	c = pixman_fixed_to_int (lo);
+
+	cells[c] += sign * (int32_t)(((pixman_fixed_48_16_t)h *
+				      (pixman_int_to_fixed (c + 1) - (lo + hi) / 2)) >> 16);
+	cover[c + 1] += sign * h;
+	return;
+    }
+
+    /* 'done' is the height of the pieces that have been added so far;
+     * computing it from the distance to 'lo' makes the heights of the
+     * pieces add up to exactly h.
+     */
+    done = 0;
+    xs = lo;
+
+    if (lo < 0)
+    {
+	done = ((pixman_fixed_48_16_t)h * (MIN (hi, 0) - lo)) / (hi - lo);
+	cover[0] += sign * done;
+	xs = 0;
+    }
+
+    for (c = pixman_fixed_to_int (xs); xs < hi && c < width; ++c)
+    {
+	pixman_fixed_t xe = MIN (hi, pixman_int_to_fixed (c + 1));
+	pixman_fixed_t dh = ((pixman_fixed_48_16_t)h * (xe - lo)) / (hi - lo) - done;
+
+	cells[c] += sign * (int32_t)(((pixman_fixed_48_16_t)dh *
+				      (pixman_int_to_fixed (c + 1) - (xs + xe) / 2)) >> 16);
+	cover[c + 1] += sign * dh;
+
+	done += dh;
+	xs = xe;
+    }
+}
+
+static void
+rasterize_edges_exact_8 (pixman_image_t *image,
+			 pixman_edge_t * l,
+			 pixman_edge_t * r,
+			 pixman_fixed_t  t,
+			 pixman_fixed_t  b)
+{
+    int32_t stack_cells[2 * (N_STACK_CELLS + 1)];
+    int32_t *cells, *cover;
+    uint32_t *buf = (image)->bits.bits;
+    int stride = (image)->bits.rowstride;
+    int width = (image)->bits.width;
+    pixman_fixed_48_16_t l_dx, r_dx;
+    pixman_fixed_t xl0, xl1, xr0, xr1, x_off;
+    pixman_fixed_t x_min, x_max, y;
+    int x1, x2, n;
+
+    l_dx = (pixman_fixed_48_16_t)l->stepx * l->dy + l->signdx * l->dx;
+    r_dx = (pixman_fixed_48_16_t)r->stepx * r->dy + r->signdx * r->dx;
+
+    y = t;
+    if (y < 0)
+	y = 0;
+    if (b > pixman_int_to_fixed ((image)->bits.height))
+	b = pixman_int_to_fixed ((image)->bits.height);
+
+    if (b <= y)
+	return;
+
+    xl0 = edge_x_at (l, l_dx, t, y);
+    xr0 = edge_x_at (r, r_dx, t, y);
+    xl1 = edge_x_at (l, l_dx, t, b);
+    xr1 = edge_x_at (r, r_dx, t, b);
+
+    /* The edges are straight lines, so their ends determine the columns
+     * that can be touched.
+     */
+    x_min = MIN (MIN (xl0, xl1), MIN (xr0, xr1));
+    x_max = MAX (MAX (xl0, xl1), MAX (xr0, xr1));
+
+    x1 = x_min < 0 ? 0 : pixman_fixed_to_int (x_min);
+    x2 = x_max < 0 ? 0 : pixman_fixed_to_int (x_max) + 1;
+    if (x2 > width)
+	x2 = width;
+
+    if (x1 >= x2)
+	return;
+
+    n = x2 - x1;
+    if (n <= N_STACK_CELLS)
+	cells = stack_cells;
+    else if (!(cells = pixman_malloc_ab (n + 1, 2 * sizeof (int32_t))))
+	return;
+
+    cover = cells + n + 1;
+    memset (cells, 0, (n + 1) * 2 * sizeof (int32_t));
+
+    x_off = pixman_int_to_fixed (x1);
+    xl0 -= x_off;
+    xr0 -= x_off;
+
+    while (y < b)
+    {
+	int row = pixman_fixed_to_int (y);
+	pixman_fixed_t y_next = pixman_int_to_fixed (row + 1);
+	uint8_t *ap = (uint8_t *)(buf + row * stride) + x1;
+	int32_t c;
+	int lo, hi, i;
+
+	if (y_next > b)
+	    y_next = b;
+
+	xl1 = edge_x_at (l, l_dx, t, y_next) - x_off;
+	xr1 = edge_x_at (r, r_dx, t, y_next) - x_off;
+
+	add_edge_area (cells, cover, n, xl0, xl1, y_next - y, 1);
+	add_edge_area (cells, cover, n, xr0, xr1, y_next - y, -1);
+
+	x_min = MIN (MIN (xl0, xl1), MIN (xr0, xr1));
+	x_max = MAX (MAX (xl0, xl1), MAX (xr0, xr1));
+
+	lo = x_min < 0 ? 0 : pixman_fixed_to_int (x_min);
+	hi = x_max < 0 ? 0 : pixman_fixed_to_int (x_max) + 1;
+	if (hi > n)
+	    hi = n;
+
+	c = 0;
+	for (i = lo; i < hi; ++i)
+	{
+	    int32_t a;
+
+	    c += cover[i];
+	    a = c + cells[i];
+
+	    cover[i] = 0;
+	    cells[i] = 0;
+
+	    if (a > 0)
+	    {
+		a = (a * 255 + 0x8000) >> 16;
+
+		if (a)
+		    WRITE (image, ap + i, clip255 (READ (image, ap + i) + a));
+	    }
+	}
+
+	cover[hi] = 0;
+	cells[hi] = 0;
+
+	xl0 = xl1;
+	xr0 = xr1;
+	y = y_next;
+    }
+
+    if (cells != stack_cells)
+	free (cells);
+}
+
 #ifndef PIXMAN_FB_ACCESSORS
 static
 #endif
@@ -356,7 +535,10 @@ PIXMAN_RASTERIZE_EDGES (pixman_image_t *image,
 	break;
 
     case 8:
-	rasterize_edges_8 (image, l, r, t, b);
+	if (image->bits.exact_coverage)
+	    rasterize_edges_exact_8 (image, l, r, t, b);
+	else
+	    rasterize_edges_8 (image, l, r, t, b);
 	break;
 
     default:
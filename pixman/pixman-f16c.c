@@ -0,0 +1,227 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include <immintrin.h>
+#include "pixman-private.h"
+
+/* rgba_half pixels are four halfs in r, g, b, a order. The conversions
+ * here round exactly like pixman_float_to_half() and
+ * pixman_half_to_float() do.
+ */
+static force_inline __m128
+load_half_4 (const uint16_t *src)
+{
+    return _mm_cvtph_ps (_mm_loadl_epi64 ((const __m128i *)src));
+}
+
+static force_inline void
+store_half_4 (uint16_t *dst, __m128 v)
+{
+    _mm_storel_epi64 ((__m128i *)dst,
+		      _mm_cvtps_ph (v, _MM_FROUND_TO_NEAREST_INT));
+}
+
+static void
+convert_rgba_half_to_float (argb_t *dst, const uint16_t *src, int w)
+{
+    while (w >= 2)
+    {
+	__m128i h = _mm_loadu_si128 ((const __m128i *)src);
+	__m128 p0 = _mm_cvtph_ps (h);
+	__m128 p1 = _mm_cvtph_ps (_mm_unpackhi_epi64 (h, h));
+
+	/* r, g, b, a to a, r, g, b */
+	_mm_storeu_ps ((float *)dst, _mm_shuffle_ps (p0, p0, _MM_SHUFFLE (2, 1, 0, 3)));
+	_mm_storeu_ps ((float *)(dst + 1), _mm_shuffle_ps (p1, p1, _MM_SHUFFLE (2, 1, 0, 3)));
+
+	dst += 2;
+	src += 8;
+	w -= 2;
+    }
+
+    if (w)
+    {
+	__m128 p = load_half_4 (src);
+
+	_mm_storeu_ps ((float *)dst, _mm_shuffle_ps (p, p, _MM_SHUFFLE (2, 1, 0, 3)));
+    }
+}
+
+static void
+convert_float_to_rgba_half (uint16_t *dst, const argb_t *src, int w)
+{
+    while (w >= 2)
+    {
+	__m128 p0 = _mm_loadu_ps ((const float *)src);
+	__m128 p1 = _mm_loadu_ps ((const float *)(src + 1));
+	__m128i h0, h1;
+
+	/* a, r, g, b to r, g, b, a */
+	p0 = _mm_shuffle_ps (p0, p0, _MM_SHUFFLE (0, 3, 2, 1));
+	p1 = _mm_shuffle_ps (p1, p1, _MM_SHUFFLE (0, 3, 2, 1));
+
+	h0 = _mm_cvtps_ph (p0, _MM_FROUND_TO_NEAREST_INT);
+	h1 = _mm_cvtps_ph (p1, _MM_FROUND_TO_NEAREST_INT);
+
+	_mm_storeu_si128 ((__m128i *)dst, _mm_unpacklo_epi64 (h0, h1));
+
+	dst += 8;
+	src += 2;
+	w -= 2;
+    }
+
+    if (w)
+    {
+	__m128 p = _mm_loadu_ps ((const float *)src);
+
+	store_half_4 (dst, _mm_shuffle_ps (p, p, _MM_SHUFFLE (0, 3, 2, 1)));
+    }
+}
+
+static uint32_t *
+f16c_fetch_rgba_half (pixman_iter_t *iter, const uint32_t *mask)
+{
+    convert_rgba_half_to_float (
+	(argb_t *)iter->buffer, (uint16_t *)iter->bits, iter->width);
+
+    iter->bits += iter->stride;
+
+    return iter->buffer;
+}
+
+/* The destination is fetched even when the operator ignores it, as the
+ * wide general path relies on the buffer never holding a NaN.
+ */
+static uint32_t *
+f16c_dest_fetch_rgba_half (pixman_iter_t *iter, const uint32_t *mask)
+{
+    convert_rgba_half_to_float (
+	(argb_t *)iter->buffer, (uint16_t *)iter->bits, iter->width);
+
+    return iter->buffer;
+}
+
+static void
+f16c_dest_write_back_rgba_half (pixman_iter_t *iter)
+{
+    convert_float_to_rgba_half (
+	(uint16_t *)iter->bits, (argb_t *)iter->buffer, iter->width);
+
+    iter->bits += iter->stride;
+}
+
+static void
+f16c_dest_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *info)
+{
+    /* Leave dithering to the general write back */
+    if (iter->image->bits.dither != PIXMAN_DITHER_NONE)
+    {
+	_pixman_bits_image_dest_iter_init (iter->image, iter);
+	return;
+    }
+
+    _pixman_iter_init_bits_stride (iter, info);
+}
+
+static void
+f16c_composite_over_half_half (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint16_t *dst_line, *dst;
+    uint16_t *src_line, *src;
+    int dst_stride, src_stride;
+    const __m128 one = _mm_set1_ps (1.0f);
+    int32_t w;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint16_t, dst_stride, dst_line, 4);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint16_t, src_stride, src_line, 4);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w--)
+	{
+	    __m128 s = load_half_4 (src);
+	    __m128 d = load_half_4 (dst);
+	    __m128 ia = _mm_sub_ps (one, _mm_shuffle_ps (s, s, _MM_SHUFFLE (3, 3, 3, 3)));
+
+	    /* Same as the float OVER combiner, including its clamping:
+	     * MIN (1.0f, s + d * (1 - sa)).
+	     */
+	    d = _mm_min_ps (one, _mm_add_ps (s, _mm_mul_ps (d, ia)));
+
+	    store_half_4 (dst, d);
+
+	    src += 4;
+	    dst += 4;
+	}
+    }
+}
+
+#define SRC_IMAGE_FLAGS							\
+    (FAST_PATH_NO_CONVOLUTION_FILTER | FAST_PATH_NO_ACCESSORS |	\
+     FAST_PATH_NO_ALPHA_MAP | FAST_PATH_ID_TRANSFORM |			\
+     FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
+
+#define DEST_IMAGE_FLAGS						\
+    (FAST_PATH_NO_ACCESSORS | FAST_PATH_NO_ALPHA_MAP)
+
+static const pixman_iter_info_t f16c_iters[] =
+{
+    { PIXMAN_rgba_half, SRC_IMAGE_FLAGS, ITER_WIDE | ITER_SRC,
+      _pixman_iter_init_bits_stride, f16c_fetch_rgba_half, NULL
+    },
+    { PIXMAN_rgba_half, DEST_IMAGE_FLAGS, ITER_WIDE | ITER_DEST,
+      f16c_dest_iter_init,
+      f16c_dest_fetch_rgba_half, f16c_dest_write_back_rgba_half
+    },
+    { PIXMAN_null },
+};
+
+static const pixman_fast_path_t f16c_fast_paths[] =
+{
+    PIXMAN_WIDE_FAST_PATH (OVER, rgba_half, rgba_half, f16c_composite_over_half_half),
+
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_f16c (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp =
+	_pixman_implementation_create (fallback, f16c_fast_paths);
+
+    imp->iter_info = f16c_iters;
+
+    return imp;
+}
@@ -1182,6 +1182,125 @@ fast_composite_src_memcpy (pixman_implementation_t *imp,
     }
 }
 
+/* Dithering with exact integer math, using the thresholds from
+ * _pixman_dither_thresholds(). SIMD versions must give the same results.
+ */
+static force_inline uint32_t
+dither_unorm (uint32_t c, int n_bits, uint32_t t)
+{
+    return (c * ((1 << n_bits) - 1) + t) / 255;
+}
+
+/* The dither paths also match destinations that aren't dithered, which
+ * are left to the fallback.
+ */
+static void
+fallback_composite (pixman_implementation_t *imp,
+		    pixman_composite_info_t *info)
+{
+    pixman_composite_func_t func;
+
+    _pixman_implementation_lookup_composite (
+	imp->fallback, info->op,
+	info->src_image->common.extended_format_code, info->src_flags,
+	PIXMAN_null, info->mask_flags,
+	info->dest_image->common.extended_format_code, info->dest_flags,
+	&imp, &func);
+
+    func (imp, info);
+}
+
+static void
+fast_composite_src_8888_0565_dither (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint16_t thresholds[DITHER_PERIOD];
+    uint16_t *dst_line, *dst;
+    uint32_t *src_line, *src;
+    int dst_stride, src_stride;
+    int i, j;
+
+    if (dest_image->bits.dither == PIXMAN_DITHER_NONE)
+    {
+	fallback_composite (imp, info);
+	return;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint16_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	_pixman_dither_thresholds (&dest_image->bits, dest_x, dest_y + j,
+				   width, thresholds);
+
+	dst = dst_line;
+	src = src_line;
+
+	for (i = 0; i < width; ++i)
+	{
+	    uint32_t s = src[i];
+	    uint32_t t = thresholds[i & (DITHER_PERIOD - 1)];
+
+	    dst[i] = (dither_unorm ((s >> 16) & 0xff, 5, t) << 11) |
+		     (dither_unorm ((s >> 8) & 0xff, 6, t) << 5)   |
+		     (dither_unorm (s & 0xff, 5, t));
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+fast_composite_src_8888_2101010_dither (pixman_implementation_t *imp,
+					pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t alpha = PIXMAN_FORMAT_A (src_image->bits.format) ? 0 : 0xff000000;
+    uint16_t thresholds[DITHER_PERIOD];
+    uint32_t *dst_line, *dst, *src_line, *src;
+    int dst_stride, src_stride;
+    int i, j;
+
+    if (dest_image->bits.dither == PIXMAN_DITHER_NONE)
+    {
+	fallback_composite (imp, info);
+	return;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	_pixman_dither_thresholds (&dest_image->bits, dest_x, dest_y + j,
+				   width, thresholds);
+
+	dst = dst_line;
+	src = src_line;
+
+	for (i = 0; i < width; ++i)
+	{
+	    uint32_t s = src[i] | alpha;
+	    uint32_t t = thresholds[i & (DITHER_PERIOD - 1)];
+
+	    dst[i] = (dither_unorm (s >> 24, 2, t) << 30)		|
+		     (dither_unorm ((s >> 16) & 0xff, 10, t) << 20)	|
+		     (dither_unorm ((s >> 8) & 0xff, 10, t) << 10)	|
+		     (dither_unorm (s & 0xff, 10, t));
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
 FAST_NEAREST (8888_8888_cover, 8888, 8888, uint32_t, uint32_t, SRC, COVER)
 FAST_NEAREST (8888_8888_none, 8888, 8888, uint32_t, uint32_t, SRC, NONE)
 FAST_NEAREST (8888_8888_pad, 8888, 8888, uint32_t, uint32_t, SRC, PAD)
@@ -1877,6 +1996,9 @@ static const pixman_fast_path_t c_fast_paths[] =
     PIXMAN_STD_FAST_PATH (SRC, x1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy),
     PIXMAN_STD_FAST_PATH (SRC, a1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy),
     PIXMAN_STD_FAST_PATH (SRC, a8, null, a8, fast_composite_src_memcpy),
+    PIXMAN_WIDE_FAST_PATH (SRC, rgba_half, rgba_half, fast_composite_src_memcpy),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8_sRGB, a8r8g8b8_sRGB, fast_composite_src_memcpy),
+    PIXMAN_WIDE_FAST_PATH (SRC, r8g8b8_sRGB, r8g8b8_sRGB, fast_composite_src_memcpy),
     PIXMAN_STD_FAST_PATH (IN, a8, null, a8, fast_composite_in_8_8),
     PIXMAN_STD_FAST_PATH (IN, solid, a8, a8, fast_composite_in_n_8_8),
 
@@ -1961,6 +2083,20 @@ static const pixman_fast_path_t c_fast_paths[] =
     SIMPLE_ROTATE_FAST_PATH (SRC, r5g6b5, r5g6b5, 565),
     SIMPLE_ROTATE_FAST_PATH (SRC, a8, a8, 8),
 
+    /* After the other paths, which take undithered destinations first */
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, r5g6b5, fast_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, r5g6b5, fast_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, b5g6r5, fast_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, b5g6r5, fast_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, a2r10g10b10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, x2r10g10b10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, a2r10g10b10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, x2r10g10b10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, a2b10g10r10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, x2b10g10r10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, a2b10g10r10, fast_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, x2b10g10r10, fast_composite_src_8888_2101010_dither),
+
     /* Simple repeat fast path entry. */
     {	PIXMAN_OP_any,
 	PIXMAN_any,
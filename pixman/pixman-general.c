@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "pixman-private.h"
+#include "pixman-combine32.h"
 
 static void
 general_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *info)
@@ -123,6 +124,69 @@ operator_needs_division (pixman_op_t op)
     return needs_division[op];
 }
 
+/* The flags an image needs to have its own medium iterator */
+#define MEDIUM_SRC_FLAGS						\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_ID_TRANSFORM		|				\
+     FAST_PATH_NO_CONVOLUTION_FILTER	|				\
+     FAST_PATH_NO_PAD_REPEAT		|				\
+     FAST_PATH_NO_REFLECT_REPEAT)
+
+/* How an image is fetched when compositing with medium iterators: with
+ * a medium iterator of its own, with a narrow one whose pixels are then
+ * expanded, or not at all, in which case the composite has to be wide.
+ */
+static iter_flags_t
+medium_fetch_width (pixman_image_t *image,
+		    uint32_t        flags,
+		    pixman_bool_t   dest)
+{
+    if (!image)
+	return ITER_NARROW;
+
+    if (image->type == SOLID)
+	return ITER_MEDIUM;
+
+    if (flags & FAST_PATH_NARROW_FORMAT)
+	return ITER_NARROW;
+
+    if (image->type != BITS || !image->bits.fetch_scanline_64)
+	return 0;
+
+    if (dest)
+    {
+	if (image->bits.store_scanline_64 && (flags & FAST_PATH_NO_ALPHA_MAP))
+	    return ITER_MEDIUM;
+    }
+    else if ((flags & MEDIUM_SRC_FLAGS) == MEDIUM_SRC_FLAGS)
+    {
+	return ITER_MEDIUM;
+    }
+
+    return 0;
+}
+
+static uint32_t *
+get_scanline_medium (pixman_iter_t *iter,
+		     iter_flags_t   fetch_width,
+		     uint8_t       *buffer,
+		     int            width)
+{
+    uint32_t *p = iter->get_scanline (iter, NULL);
+
+    /* The narrow iterator may return the image bits themselves, so the
+     * expanded pixels always go to the medium buffer
+     */
+    if (p && fetch_width == ITER_NARROW)
+    {
+	pixman_expand_to_64 ((uint64_t *)buffer, p, width);
+
+	return (uint32_t *)buffer;
+    }
+
+    return p;
+}
+
 static void
 general_composite_rect  (pixman_implementation_t *imp,
                          pixman_composite_info_t *info)
@@ -135,6 +199,7 @@ general_composite_rect  (pixman_implementation_t *imp,
     pixman_combine_32_func_t compose;
     pixman_bool_t component_alpha;
     iter_flags_t width_flag, src_iter_flags;
+    iter_flags_t src_width, mask_width, dest_width;
     int Bpp;
     int i;
 
@@ -144,13 +209,31 @@ general_composite_rect  (pixman_implementation_t *imp,
 	!(operator_needs_division (op))                                      &&
 	(dest_image->bits.dither == PIXMAN_DITHER_NONE))
     {
-	width_flag = ITER_NARROW;
+	width_flag = src_width = mask_width = dest_width = ITER_NARROW;
 	Bpp = 4;
     }
     else
     {
-	width_flag = ITER_WIDE;
-	Bpp = 16;
+	src_width = medium_fetch_width (src_image, info->src_flags, FALSE);
+	mask_width = medium_fetch_width (mask_image, info->mask_flags, FALSE);
+	dest_width = medium_fetch_width (dest_image, info->dest_flags, TRUE);
+
+	if (op <= PIXMAN_OP_ADD					&&
+	    dest_image->bits.dither == PIXMAN_DITHER_NONE	&&
+	    src_width && mask_width && dest_width)
+	{
+	    /* Images fetched narrow get a buffer of their own after the
+	     * medium one, as their iterators may hand back the same buffer
+	     * for every scanline.
+	     */
+	    width_flag = ITER_MEDIUM;
+	    Bpp = 8 + 4;
+	}
+	else
+	{
+	    width_flag = src_width = mask_width = dest_width = ITER_WIDE;
+	    Bpp = 16;
+	}
     }
 
 #define ALIGN(addr)							\
@@ -185,13 +268,17 @@ general_composite_rect  (pixman_implementation_t *imp,
 	memset (dest_buffer, 0, width * Bpp);
     }
     
+#define ITER_BUFFER(buffer, fetch_width)				\
+    (width_flag == ITER_MEDIUM && fetch_width == ITER_NARROW ?		\
+     buffer + width * 8 : buffer)
+
     /* src iter */
-    src_iter_flags = width_flag | op_flags[op].src | ITER_SRC;
+    src_iter_flags = src_width | op_flags[op].src | ITER_SRC;
 
     _pixman_implementation_iter_init (imp->toplevel, &src_iter, src_image,
                                       src_x, src_y, width, height,
-                                      src_buffer, src_iter_flags,
-                                      info->src_flags);
+                                      ITER_BUFFER (src_buffer, src_width),
+                                      src_iter_flags, info->src_flags);
 
     /* mask iter */
     if ((src_iter_flags & (ITER_IGNORE_ALPHA | ITER_IGNORE_RGB)) ==
@@ -207,27 +294,51 @@ general_composite_rect  (pixman_implementation_t *imp,
 
     _pixman_implementation_iter_init (
 	imp->toplevel, &mask_iter,
-	mask_image, mask_x, mask_y, width, height, mask_buffer,
-	ITER_SRC | width_flag | (component_alpha? 0 : ITER_IGNORE_RGB),
+	mask_image, mask_x, mask_y, width, height,
+	ITER_BUFFER (mask_buffer, mask_width),
+	ITER_SRC | mask_width | (component_alpha? 0 : ITER_IGNORE_RGB),
 	info->mask_flags);
 
     /* dest iter */
     _pixman_implementation_iter_init (
 	imp->toplevel, &dest_iter, dest_image, dest_x, dest_y, width, height,
-	dest_buffer, ITER_DEST | width_flag | op_flags[op].dst, info->dest_flags);
+	ITER_BUFFER (dest_buffer, dest_width),
+	ITER_DEST | dest_width | op_flags[op].dst, info->dest_flags);
 
     compose = _pixman_implementation_lookup_combiner (
-	imp->toplevel, op, component_alpha, width_flag != ITER_WIDE);
+	imp->toplevel, op, component_alpha, width_flag);
 
     for (i = 0; i < height; ++i)
     {
 	uint32_t *s, *m, *d;
 
-	m = mask_iter.get_scanline (&mask_iter, NULL);
-	s = src_iter.get_scanline (&src_iter, m);
-	d = dest_iter.get_scanline (&dest_iter, NULL);
-
-	compose (imp->toplevel, op, d, s, m, width);
+	if (width_flag == ITER_MEDIUM)
+	{
+	    m = get_scanline_medium (&mask_iter, mask_width, mask_buffer, width);
+	    s = get_scanline_medium (&src_iter, src_width, src_buffer, width);
+	    d = dest_iter.get_scanline (&dest_iter, NULL);
+
+	    if (dest_width == ITER_NARROW)
+	    {
+		uint64_t *medium_d = (uint64_t *)dest_buffer;
+
+		pixman_expand_to_64 (medium_d, d, width);
+		compose (imp->toplevel, op, (uint32_t *)medium_d, s, m, width);
+		pixman_contract_from_64 (d, medium_d, width);
+	    }
+	    else
+	    {
+		compose (imp->toplevel, op, d, s, m, width);
+	    }
+	}
+	else
+	{
+	    m = mask_iter.get_scanline (&mask_iter, NULL);
+	    s = src_iter.get_scanline (&src_iter, m);
+	    d = dest_iter.get_scanline (&dest_iter, NULL);
+
+	    compose (imp->toplevel, op, d, s, m, width);
+	}
 
 	dest_iter.write_back (&dest_iter);
     }
@@ -243,6 +354,119 @@ general_composite_rect  (pixman_implementation_t *imp,
 	free (scanline_buffer);
 }
 
+static uint32_t
+premultiply_8888 (uint32_t p, int alpha_shift)
+{
+    uint32_t a = (p >> alpha_shift) & 0xff;
+    uint32_t alpha_mask = 0xffu << alpha_shift;
+
+    UN8x4_MUL_UN8 (p, a);
+
+    return (p & ~alpha_mask) | (a << alpha_shift);
+}
+
+static uint32_t
+unpremultiply_8888 (uint32_t p, int alpha_shift)
+{
+    uint32_t a = (p >> alpha_shift) & 0xff;
+    uint32_t result = a << alpha_shift;
+    int shift;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+	if (shift != alpha_shift)
+	    result |= pixman_unpremultiply_un8 ((p >> shift) & 0xff, a) << shift;
+    }
+
+    return result;
+}
+
+static uint64_t
+premultiply_16161616 (uint64_t p)
+{
+    uint32_t a = p >> 48;
+    uint64_t result = (uint64_t)a << 48;
+    int shift;
+
+    for (shift = 0; shift < 48; shift += 16)
+    {
+	uint32_t t = ((p >> shift) & 0xffff) * a + 0x8000;
+
+	result |= (uint64_t)(((t >> 16) + t) >> 16) << shift;
+    }
+
+    return result;
+}
+
+static uint64_t
+unpremultiply_16161616 (uint64_t p)
+{
+    uint32_t a = p >> 48;
+    uint64_t result = (uint64_t)a << 48;
+    int shift;
+
+    if (!a)
+	return 0;
+
+    for (shift = 0; shift < 48; shift += 16)
+    {
+	uint32_t c = ((p >> shift) & 0xffff) * 0xffff + a / 2;
+
+	result |= (uint64_t)MIN (c / a, 0xffff) << shift;
+    }
+
+    return result;
+}
+
+static pixman_bool_t
+general_premultiply (pixman_implementation_t *imp,
+		     pixman_format_code_t     format,
+		     const uint8_t *          src,
+		     int                      src_stride,
+		     uint8_t *                dst,
+		     int                      dst_stride,
+		     int                      width,
+		     int                      height,
+		     pixman_bool_t            unpremultiply)
+{
+    /* Alpha is in the top byte of a8r8g8b8 and a8b8g8r8 */
+    int alpha_shift = PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB ||
+		      PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR ? 24 : 0;
+    int i;
+
+    while (height--)
+    {
+	if (PIXMAN_FORMAT_BPP (format) == 64)
+	{
+	    const uint64_t *s = (const uint64_t *)src;
+	    uint64_t *d = (uint64_t *)dst;
+
+	    for (i = 0; i < width; ++i)
+	    {
+		d[i] = unpremultiply ?
+		    unpremultiply_16161616 (s[i]) : premultiply_16161616 (s[i]);
+	    }
+	}
+	else
+	{
+	    const uint32_t *s = (const uint32_t *)src;
+	    uint32_t *d = (uint32_t *)dst;
+
+	    for (i = 0; i < width; ++i)
+	    {
+		d[i] = unpremultiply ?
+		    unpremultiply_8888 (s[i], alpha_shift) :
+		    premultiply_8888 (s[i], alpha_shift);
+	    }
+	}
+
+	src += src_stride;
+	dst += dst_stride;
+    }
+
+    return TRUE;
+}
+
 static const pixman_fast_path_t general_fast_path[] =
 {
     { PIXMAN_OP_any, PIXMAN_any, 0, PIXMAN_any,	0, PIXMAN_any, 0, general_composite_rect },
@@ -255,9 +479,11 @@ _pixman_implementation_create_general (void)
     pixman_implementation_t *imp = _pixman_implementation_create (NULL, general_fast_path);
 
     _pixman_setup_combiner_functions_32 (imp);
+    _pixman_setup_combiner_functions_64 (imp);
     _pixman_setup_combiner_functions_float (imp);
 
     imp->iter_info = general_iters;
+    imp->premultiply = general_premultiply;
 
     return imp;
 }
@@ -28,53 +28,357 @@
 #include <pixman-config.h>
 #endif
 #include "pixman-private.h"
+#include "pixman-combine32.h"
 
 #include <stdlib.h>
 
 typedef struct glyph_metrics_t glyph_metrics_t;
 typedef struct glyph_t glyph_t;
+typedef struct glyph_table_t glyph_table_t;
+typedef struct atlas_t atlas_t;
+typedef struct freeze_t freeze_t;
 
 #define TOMBSTONE ((glyph_t *)0x1)
 
-/* XXX: These numbers are arbitrary---we've never done any measurements.
+/* XXX: This number is arbitrary---we've never done any measurements.
+ *
+ * When a cache has more glyphs than its limit, or uses more bytes than
+ * its byte limit, the least recently used glyphs are evicted until it is
+ * down to half of the limit.
+ */
+#define DEFAULT_MAX_GLYPHS  (16384)
+
+/* The hash tables start out this big and double in size whenever they
+ * become half full.
+ */
+#define MIN_HASH_SIZE (64)
+
+/* A shared cache is split into this many tables, each with its own
+ * lock, its own MRU list and an equal share of the limits. The table
+ * is selected by the top bits of the hash.
+ */
+#define N_SHARED_TABLE_BITS (4)
+#define N_SHARED_TABLES (1 << N_SHARED_TABLE_BITS)
+
+/* In atlas mode, a8 and a8r8g8b8 glyphs that are no larger than
+ * ATLAS_MAX_GLYPH_SIZE are packed into shelves of ATLAS_SIZE x ATLAS_SIZE
+ * atlas images. Glyphs are only added at the end of a shelf, but once
+ * all the glyphs of a shelf are gone it is emptied and reused, and an
+ * atlas is freed once all of its glyphs are gone. The atlases count
+ * against the byte limit in full.
  */
-#define N_GLYPHS_HIGH_WATER  (16384)
-#define N_GLYPHS_LOW_WATER   (8192)
-#define HASH_SIZE (2 * N_GLYPHS_HIGH_WATER)
-#define HASH_MASK (HASH_SIZE - 1)
+#define ATLAS_SIZE (512)
+#define ATLAS_MAX_GLYPH_SIZE (64)
 
 struct glyph_t
 {
     void *		font_key;
     void *		glyph_key;
+    int			phase;		/* subpixel variant */
     int			origin_x;
     int			origin_y;
     pixman_image_t *	image;
+    int			image_x;	/* position of the glyph in image */
+    int			image_y;
+    int			width;
+    int			height;
+    atlas_t *		atlas;		/* NULL if image is the glyph's own */
+    int			shelf;		/* index of the shelf in the atlas */
+    uint64_t		n_bytes;
+    uint64_t		retired_epoch;
     pixman_link_t	mru_link;
 };
 
-struct pixman_glyph_cache_t
+typedef struct
+{
+    int			y;
+    int			height;
+    int			x;		/* start of the free space */
+    int			n_glyphs;
+} shelf_t;
+
+struct atlas_t
 {
+    pixman_image_t *	image;
+    uint64_t		n_bytes;
+    int			n_glyphs;
+    int			n_shelves;
+    int			next_y;		/* start of the space below the shelves */
+    pixman_link_t	link;
+    shelf_t		shelves[ATLAS_SIZE];
+};
+
+struct glyph_table_t
+{
+    pixman_mutex_t *	lock;		/* NULL unless the cache is shared */
     int			n_glyphs;
     int			n_tombstones;
-    int			freeze_count;
+    uint64_t		n_bytes;
+    int			max_glyphs;
+    uint64_t		max_bytes;	/* 0 means no limit */
+    unsigned int	hash_mask;
     pixman_list_t	mru;
-    glyph_t *		glyphs[HASH_SIZE];
+    glyph_t **		glyphs;
+
+    uint64_t		hits;
+    uint64_t		misses;
+    uint64_t		evictions;
 };
 
+struct pixman_glyph_cache_t
+{
+    int			freeze_count;
+    pixman_bool_t	shared;
+    int			n_tables;
+    glyph_table_t *	tables;
+
+    /* For shared caches: protects freeze_count, the freezes and the
+     * retired glyphs. freeze_count is only written with the lock held,
+     * but it is read atomically to check that a thread has frozen the
+     * cache before it looks up or inserts glyphs.
+     *
+     * Every glyph that is evicted or removed from a shared cache is
+     * retired with the current epoch, which is then advanced. It is
+     * freed once every thread that froze the cache in that epoch or
+     * earlier has thawed it, since only those threads can be using it.
+     * freezes holds one freeze_t for each thread that has the cache
+     * frozen, and n_pinned counts the freezes that couldn't be given
+     * one and so keep all retired glyphs alive.
+     */
+    pixman_mutex_t *	lock;
+    uint64_t		epoch;
+    pixman_list_t	freezes;
+    int			n_pinned;
+    pixman_list_t	retired;
+
+    /* Also protected by the lock of a shared cache. atlas_bytes is the
+     * size of all the atlases, and atlas_used_bytes the part of it that
+     * is charged to the glyphs in them. The rest is charged to the
+     * tables, split evenly between them, so that the byte limit covers
+     * all of the memory that the atlases use. Atlases are only created
+     * while they take up no more than half of max_bytes.
+     */
+    pixman_bool_t	use_atlas;
+    pixman_list_t	atlases;
+    uint64_t		max_bytes;
+    uint64_t		atlas_bytes;
+    uint64_t		atlas_used_bytes;
+};
+
+/* Nested freezes by the same thread share a freeze_t, which keeps the
+ * epoch of the outermost one. Each thread has a list of the caches it
+ * has frozen.
+ */
+struct freeze_t
+{
+    pixman_glyph_cache_t *	cache;
+    uint64_t			epoch;
+    int				count;
+    freeze_t *			next;		/* in the thread's list */
+    pixman_link_t		link;		/* in the cache's list */
+};
+
+PIXMAN_DEFINE_THREAD_LOCAL (freeze_t *, thread_freezes);
+
+/* These must be called with the cache lock held */
+static void
+release_atlas_space (pixman_glyph_cache_t *cache,
+		     atlas_t              *atlas,
+		     int                   shelf_index)
+{
+    shelf_t *shelf = &atlas->shelves[shelf_index];
+
+    if (--atlas->n_glyphs == 0)
+    {
+	cache->atlas_bytes -= atlas->n_bytes;
+
+	pixman_list_unlink (&atlas->link);
+	pixman_image_unref (atlas->image);
+	free (atlas);
+	return;
+    }
+
+    if (--shelf->n_glyphs > 0)
+	return;
+
+    /* The shelf can be filled again from the start. Empty shelves at
+     * the bottom are given back to the space below the shelves, so that
+     * they can be reused for glyphs of any height. The atlas goes to the
+     * front of the list, since it now has space.
+     */
+    shelf->x = 0;
+
+    pixman_list_unlink (&atlas->link);
+    pixman_list_prepend (&cache->atlases, &atlas->link);
+
+    while (atlas->n_shelves > 0 &&
+	   atlas->shelves[atlas->n_shelves - 1].n_glyphs == 0)
+    {
+	atlas->n_shelves--;
+	atlas->next_y = atlas->shelves[atlas->n_shelves].y;
+    }
+}
+
+static void
+release_glyph_image (pixman_glyph_cache_t *cache, glyph_t *glyph)
+{
+    if (glyph->atlas)
+    {
+	cache->atlas_used_bytes -= glyph->n_bytes;
+	release_atlas_space (cache, glyph->atlas, glyph->shelf);
+    }
+    else
+    {
+	pixman_image_unref (glyph->image);
+    }
+}
+
 static void
-free_glyph (glyph_t *glyph)
+free_glyph (pixman_glyph_cache_t *cache, glyph_t *glyph)
 {
     pixman_list_unlink (&glyph->mru_link);
-    pixman_image_unref (glyph->image);
+    release_glyph_image (cache, glyph);
     free (glyph);
 }
 
+static pixman_bool_t
+allocate_from_atlas (atlas_t *atlas, glyph_t *glyph)
+{
+    int w = glyph->width;
+    int h = glyph->height;
+    shelf_t *best = NULL;
+    shelf_t *empty = NULL;
+    int i;
+
+    /* Use the lowest shelf that fits without wasting too much space */
+    for (i = 0; i < atlas->n_shelves; ++i)
+    {
+	shelf_t *shelf = &atlas->shelves[i];
+
+	if (shelf->height >= h				&&
+	    shelf->height <= h + h / 2 + 1		&&
+	    shelf->x + w <= ATLAS_SIZE			&&
+	    (!best || shelf->height < best->height))
+	{
+	    best = shelf;
+	}
+
+	if (shelf->n_glyphs == 0 && shelf->height >= h	&&
+	    (!empty || shelf->height < empty->height))
+	{
+	    empty = shelf;
+	}
+    }
+
+    /* If there is no room below the shelves, an empty shelf that is
+     * too tall is better than a new atlas.
+     */
+    if (!best && (atlas->next_y + h > ATLAS_SIZE ||
+		  atlas->n_shelves == ATLAS_SIZE))
+    {
+	best = empty;
+    }
+
+    if (!best)
+    {
+	if (atlas->next_y + h > ATLAS_SIZE || atlas->n_shelves == ATLAS_SIZE)
+	    return FALSE;
+
+	best = &atlas->shelves[atlas->n_shelves++];
+	best->y = atlas->next_y;
+	best->height = h;
+	best->x = 0;
+	best->n_glyphs = 0;
+
+	atlas->next_y += h;
+    }
+
+    glyph->image = atlas->image;
+    glyph->image_x = best->x;
+    glyph->image_y = best->y;
+    glyph->atlas = atlas;
+    glyph->shelf = best - atlas->shelves;
+
+    best->x += w;
+    best->n_glyphs++;
+    atlas->n_glyphs++;
+
+    return TRUE;
+}
+
+/* Finds space for the glyph in an atlas of the given format, creating
+ * a new atlas if necessary and the atlases are within their share of
+ * the byte limit. Must be called with the cache lock held.
+ */
+static pixman_bool_t
+allocate_glyph_in_atlas (pixman_glyph_cache_t *cache,
+			 glyph_t              *glyph,
+			 pixman_format_code_t  format)
+{
+    pixman_link_t *link;
+    atlas_t *atlas;
+    uint64_t n_bytes;
+
+    for (link = cache->atlases.head;
+	 link != (pixman_link_t *)&cache->atlases;
+	 link = link->next)
+    {
+	atlas = CONTAINER_OF (atlas_t, link, link);
+
+	if (atlas->image->bits.format == format &&
+	    allocate_from_atlas (atlas, glyph))
+	{
+	    cache->atlas_used_bytes += glyph->n_bytes;
+	    return TRUE;
+	}
+    }
+
+    n_bytes = (uint64_t)ATLAS_SIZE * ATLAS_SIZE * PIXMAN_FORMAT_BPP (format) / 8;
+
+    if (cache->max_bytes && cache->atlas_bytes + n_bytes > cache->max_bytes / 2)
+	return FALSE;
+
+    if (!(atlas = malloc (sizeof *atlas)))
+	return FALSE;
+
+    if (!(atlas->image = pixman_image_create_bits (
+	      format, ATLAS_SIZE, ATLAS_SIZE, NULL, -1)))
+    {
+	free (atlas);
+	return FALSE;
+    }
+
+    if (PIXMAN_FORMAT_RGB (format) != 0)
+	pixman_image_set_component_alpha (atlas->image, TRUE);
+
+    _pixman_image_validate (atlas->image);
+
+    atlas->n_bytes = n_bytes;
+    atlas->n_glyphs = 0;
+    atlas->n_shelves = 0;
+    atlas->next_y = 0;
+
+    /* New atlases go first, since older ones are likely to be full */
+    pixman_list_prepend (&cache->atlases, &atlas->link);
+    cache->atlas_bytes += n_bytes;
+
+    if (!allocate_from_atlas (atlas, glyph))
+	return FALSE;
+
+    cache->atlas_used_bytes += glyph->n_bytes;
+    return TRUE;
+}
+
 static unsigned int
-hash (const void *font_key, const void *glyph_key)
+hash (const void *font_key, const void *glyph_key, int phase)
 {
     size_t key = (size_t)font_key + (size_t)glyph_key;
 
+    /* Spread the variants of a glyph over the table rather than
+     * giving them neighbouring keys.
+     */
+    key += (size_t)phase * 0x9e3779b9;
+
     /* This hash function is based on one found on Thomas Wang's
      * web page at
      *
@@ -91,20 +395,62 @@ hash (const void *font_key, const void *glyph_key)
     return key;
 }
 
+/* The low bits of the hash select the slot within a table, so the
+ * table is selected with higher ones.
+ */
+static glyph_table_t *
+get_table (pixman_glyph_cache_t *cache, unsigned int h)
+{
+    if (cache->n_tables == 1)
+	return &cache->tables[0];
+
+    return &cache->tables[(h & 0xffffffff) >> (32 - N_SHARED_TABLE_BITS)];
+}
+
+static void
+lock_table (glyph_table_t *table)
+{
+    if (table->lock)
+	_pixman_mutex_lock (table->lock);
+}
+
+static void
+unlock_table (glyph_table_t *table)
+{
+    if (table->lock)
+	_pixman_mutex_unlock (table->lock);
+}
+
+static void
+lock_cache (pixman_glyph_cache_t *cache)
+{
+    if (cache->lock)
+	_pixman_mutex_lock (cache->lock);
+}
+
+static void
+unlock_cache (pixman_glyph_cache_t *cache)
+{
+    if (cache->lock)
+	_pixman_mutex_unlock (cache->lock);
+}
+
 static glyph_t *
-lookup_glyph (pixman_glyph_cache_t *cache,
-	      void                 *font_key,
-	      void                 *glyph_key)
+lookup_glyph (glyph_table_t *table,
+	      void          *font_key,
+	      void          *glyph_key,
+	      int            phase)
 {
     unsigned idx;
     glyph_t *g;
 
-    idx = hash (font_key, glyph_key);
-    while ((g = cache->glyphs[idx++ & HASH_MASK]))
+    idx = hash (font_key, glyph_key, phase);
+    while ((g = table->glyphs[idx++ & table->hash_mask]))
     {
 	if (g != TOMBSTONE			&&
 	    g->font_key == font_key		&&
-	    g->glyph_key == glyph_key)
+	    g->glyph_key == glyph_key		&&
+	    g->phase == phase)
 	{
 	    return g;
 	}
@@ -114,130 +460,597 @@ lookup_glyph (pixman_glyph_cache_t *cache,
 }
 
 static void
-insert_glyph (pixman_glyph_cache_t *cache,
-	      glyph_t              *glyph)
+insert_glyph (glyph_table_t *table,
+	      glyph_t       *glyph)
 {
     unsigned idx;
     glyph_t **loc;
 
-    idx = hash (glyph->font_key, glyph->glyph_key);
+    idx = hash (glyph->font_key, glyph->glyph_key, glyph->phase);
 
     /* Note: we assume that there is room in the table. If there isn't,
      * this will be an infinite loop.
      */
     do
     {
-	loc = &cache->glyphs[idx++ & HASH_MASK];
+	loc = &table->glyphs[idx++ & table->hash_mask];
     } while (*loc && *loc != TOMBSTONE);
 
     if (*loc == TOMBSTONE)
-	cache->n_tombstones--;
-    cache->n_glyphs++;
+	table->n_tombstones--;
+    table->n_glyphs++;
 
     *loc = glyph;
 }
 
 static void
-remove_glyph (pixman_glyph_cache_t *cache,
-	      glyph_t              *glyph)
+remove_glyph (glyph_table_t *table,
+	      glyph_t       *glyph)
+{
+    unsigned idx;
+
+    idx = hash (glyph->font_key, glyph->glyph_key, glyph->phase);
+    while (table->glyphs[idx & table->hash_mask] != glyph)
+	idx++;
+
+    table->glyphs[idx & table->hash_mask] = TOMBSTONE;
+    table->n_tombstones++;
+    table->n_glyphs--;
+    table->n_bytes -= glyph->n_bytes;
+
+    /* Eliminate tombstones if possible */
+    if (table->glyphs[(idx + 1) & table->hash_mask] == NULL)
+    {
+	while (table->glyphs[idx & table->hash_mask] == TOMBSTONE)
+	{
+	    table->glyphs[idx & table->hash_mask] = NULL;
+	    table->n_tombstones--;
+	    idx--;
+	}
+    }
+}
+
+/* Rehashes the table into one with the given number of slots, which
+ * also gets rid of all tombstones.
+ */
+static pixman_bool_t
+resize_table (glyph_table_t *table,
+	      unsigned int   size)
+{
+    glyph_t **old_glyphs = table->glyphs;
+    unsigned int old_size = table->hash_mask + 1;
+    unsigned int i;
+
+    if (!(table->glyphs = calloc (size, sizeof (glyph_t *))))
+    {
+	table->glyphs = old_glyphs;
+	return FALSE;
+    }
+
+    table->hash_mask = size - 1;
+    table->n_glyphs = 0;
+    table->n_tombstones = 0;
+
+    for (i = 0; i < old_size; ++i)
+    {
+	glyph_t *glyph = old_glyphs[i];
+
+	if (glyph && glyph != TOMBSTONE)
+	    insert_glyph (table, glyph);
+    }
+
+    free (old_glyphs);
+
+    return TRUE;
+}
+
+/* Makes sure that there is room for one more glyph while keeping the
+ * table at most half full, so that probe sequences stay short.
+ */
+static pixman_bool_t
+reserve_glyph (glyph_table_t *table)
+{
+    unsigned int size = table->hash_mask + 1;
+
+    if (2 * (table->n_glyphs + table->n_tombstones + 1) <= size)
+	return TRUE;
+
+    if (2 * (table->n_glyphs + 1) <= size / 2)
+    {
+	/* Mostly tombstones */
+	return resize_table (table, size);
+    }
+
+    if (size > UINT32_MAX / 2)
+	return FALSE;
+
+    return resize_table (table, size * 2);
+}
+
+/* Frees a glyph that has been removed from its table, or, if the cache
+ * is shared and other threads may still be using it, retires it; see
+ * free_retired(). Must be called with the cache lock held.
+ */
+static void
+discard_glyph (pixman_glyph_cache_t *cache,
+	       glyph_t              *glyph)
+{
+    if (cache->shared)
+    {
+	glyph->retired_epoch = cache->epoch++;
+
+	pixman_list_unlink (&glyph->mru_link);
+	pixman_list_prepend (&cache->retired, &glyph->mru_link);
+    }
+    else
+    {
+	free_glyph (cache, glyph);
+    }
+}
+
+/* Discards the glyphs on a list of glyphs that have been removed from
+ * their table. Must be called with the cache lock held.
+ */
+static void
+discard_glyphs (pixman_glyph_cache_t *cache,
+		pixman_list_t        *glyphs)
+{
+    while (glyphs->head != (pixman_link_t *)glyphs)
+	discard_glyph (cache, CONTAINER_OF (glyph_t, mru_link, glyphs->head));
+}
+
+/* Frees the retired glyphs that no thread can be using any more. They
+ * are retired at the head of the list, so the oldest ones are at the
+ * tail. Must be called with the cache lock held.
+ */
+static void
+free_retired (pixman_glyph_cache_t *cache)
+{
+    uint64_t oldest = cache->epoch;
+    pixman_link_t *link;
+
+    if (cache->n_pinned > 0)
+	return;
+
+    for (link = cache->freezes.head;
+	 link != (pixman_link_t *)&cache->freezes;
+	 link = link->next)
+    {
+	freeze_t *freeze = CONTAINER_OF (freeze_t, link, link);
+
+	if (freeze->epoch < oldest)
+	    oldest = freeze->epoch;
+    }
+
+    while (cache->retired.tail != (pixman_link_t *)&cache->retired)
+    {
+	glyph_t *glyph = CONTAINER_OF (glyph_t, mru_link, cache->retired.tail);
+
+	if (glyph->retired_epoch >= oldest)
+	    break;
+
+	free_glyph (cache, glyph);
+    }
+}
+
+static void
+clear_table (pixman_glyph_cache_t *cache,
+	     glyph_table_t        *table)
+{
+    unsigned int i;
+
+    for (i = 0; i <= table->hash_mask; ++i)
+    {
+	glyph_t *glyph = table->glyphs[i];
+
+	if (glyph && glyph != TOMBSTONE)
+	    discard_glyph (cache, glyph);
+
+	table->glyphs[i] = NULL;
+    }
+
+    table->n_glyphs = 0;
+    table->n_tombstones = 0;
+    table->n_bytes = 0;
+}
+
+/* The table's share of the atlas space that isn't charged to glyphs.
+ * Must be called with the cache lock held.
+ */
+static uint64_t
+get_atlas_overhead (pixman_glyph_cache_t *cache)
+{
+    return (cache->atlas_bytes - cache->atlas_used_bytes) / cache->n_tables;
+}
+
+static pixman_bool_t
+table_over_limit (glyph_table_t *table, uint64_t overhead, int shift)
+{
+    uint64_t max_bytes = table->max_bytes - MIN (overhead, table->max_bytes);
+
+    return table->n_glyphs > (table->max_glyphs >> shift)	||
+	(table->max_bytes && table->n_bytes > (max_bytes >> shift));
+}
+
+/* If the table is over its limits, moves its least recently used
+ * glyphs other than keep to the evicted list until it is down to half
+ * of them. Must be called with the table lock held.
+ */
+static void
+evict_glyphs (glyph_table_t *table,
+	      uint64_t       overhead,
+	      glyph_t       *keep,
+	      pixman_list_t *evicted)
+{
+    if (!table_over_limit (table, overhead, 0))
+	return;
+
+    while (table->n_glyphs > 0 && table_over_limit (table, overhead, 1))
+    {
+	glyph_t *glyph = CONTAINER_OF (glyph_t, mru_link, table->mru.tail);
+
+	if (glyph == keep)
+	    break;
+
+	remove_glyph (table, glyph);
+	pixman_list_unlink (&glyph->mru_link);
+	pixman_list_prepend (evicted, &glyph->mru_link);
+
+	table->evictions++;
+    }
+}
+
+/* Must be called with the cache lock held */
+static void
+trim_table (pixman_glyph_cache_t *cache,
+	    glyph_table_t        *table)
+{
+    pixman_list_t evicted;
+
+    pixman_list_init (&evicted);
+
+    lock_table (table);
+    evict_glyphs (table, get_atlas_overhead (cache), NULL, &evicted);
+    unlock_table (table);
+
+    discard_glyphs (cache, &evicted);
+}
+
+static void
+destroy_cache (pixman_glyph_cache_t *cache)
+{
+    int i;
+
+    if (cache->tables)
+    {
+	for (i = 0; i < cache->n_tables; ++i)
+	{
+	    glyph_table_t *table = &cache->tables[i];
+
+	    if (table->glyphs)
+		clear_table (cache, table);
+
+	    free (table->glyphs);
+
+	    if (table->lock)
+		_pixman_mutex_destroy (table->lock);
+	}
+    }
+
+    free_retired (cache);
+
+    if (cache->lock)
+	_pixman_mutex_destroy (cache->lock);
+
+    free (cache->tables);
+    free (cache);
+}
+
+static void
+set_limits (pixman_glyph_cache_t *cache,
+	    uint64_t              max_bytes,
+	    int                   max_glyphs)
+{
+    int i;
+
+    if (max_glyphs <= 0)
+	max_glyphs = DEFAULT_MAX_GLYPHS;
+
+    lock_cache (cache);
+    cache->max_bytes = max_bytes;
+    unlock_cache (cache);
+
+    for (i = 0; i < cache->n_tables; ++i)
+    {
+	glyph_table_t *table = &cache->tables[i];
+
+	lock_table (table);
+
+	table->max_glyphs = MAX (max_glyphs / cache->n_tables, 1);
+	table->max_bytes = max_bytes / cache->n_tables;
+	if (max_bytes && !table->max_bytes)
+	    table->max_bytes = 1;
+
+	unlock_table (table);
+    }
+}
+
+static pixman_glyph_cache_t *
+create_cache (pixman_bool_t shared)
+{
+    pixman_glyph_cache_t *cache;
+    int n_tables = shared ? N_SHARED_TABLES : 1;
+    int i;
+
+    if (!(cache = malloc (sizeof *cache)))
+	return NULL;
+
+    cache->freeze_count = 0;
+    cache->shared = shared;
+    cache->n_tables = n_tables;
+    cache->lock = NULL;
+    cache->epoch = 0;
+    pixman_list_init (&cache->freezes);
+    cache->n_pinned = 0;
+    pixman_list_init (&cache->retired);
+    cache->use_atlas = FALSE;
+    pixman_list_init (&cache->atlases);
+    cache->atlas_bytes = 0;
+    cache->atlas_used_bytes = 0;
+
+    if (!(cache->tables = calloc (n_tables, sizeof (glyph_table_t))))
+    {
+	free (cache);
+	return NULL;
+    }
+
+    if (shared && !(cache->lock = _pixman_mutex_create ()))
+	goto fail;
+
+    for (i = 0; i < n_tables; ++i)
+    {
+	glyph_table_t *table = &cache->tables[i];
+
+	table->hash_mask = MIN_HASH_SIZE - 1;
+	pixman_list_init (&table->mru);
+
+	if (!(table->glyphs = calloc (MIN_HASH_SIZE, sizeof (glyph_t *))))
+	    goto fail;
+
+	if (shared && !(table->lock = _pixman_mutex_create ()))
+	    goto fail;
+    }
+
+    set_limits (cache, 0, DEFAULT_MAX_GLYPHS);
+
+    return cache;
+
+fail:
+    destroy_cache (cache);
+    return NULL;
+}
+
+PIXMAN_EXPORT pixman_glyph_cache_t *
+pixman_glyph_cache_create (void)
+{
+    return create_cache (FALSE);
+}
+
+PIXMAN_EXPORT pixman_glyph_cache_t *
+pixman_glyph_cache_create_with_limits (uint64_t max_bytes,
+				       int      max_glyphs)
+{
+    pixman_glyph_cache_t *cache;
+
+    if ((cache = create_cache (FALSE)))
+	set_limits (cache, max_bytes, max_glyphs);
+
+    return cache;
+}
+
+PIXMAN_EXPORT pixman_glyph_cache_t *
+pixman_glyph_cache_create_shared (void)
+{
+    return create_cache (TRUE);
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_set_use_atlas (pixman_glyph_cache_t *cache,
+				  pixman_bool_t         use_atlas)
+{
+    lock_cache (cache);
+
+    cache->use_atlas = use_atlas;
+
+    unlock_cache (cache);
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_set_limits (pixman_glyph_cache_t *cache,
+			       uint64_t              max_bytes,
+			       int                   max_glyphs)
+{
+    set_limits (cache, max_bytes, max_glyphs);
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_get_stats (pixman_glyph_cache_t       *cache,
+			      pixman_glyph_cache_stats_t *stats)
+{
+    int i;
+
+    memset (stats, 0, sizeof (*stats));
+
+    lock_cache (cache);
+
+    stats->n_bytes = cache->atlas_bytes - cache->atlas_used_bytes;
+    stats->atlas_bytes = cache->atlas_bytes;
+
+    unlock_cache (cache);
+
+    for (i = 0; i < cache->n_tables; ++i)
+    {
+	glyph_table_t *table = &cache->tables[i];
+
+	lock_table (table);
+
+	stats->hits += table->hits;
+	stats->misses += table->misses;
+	stats->evictions += table->evictions;
+	stats->n_bytes += table->n_bytes;
+	stats->n_glyphs += table->n_glyphs;
+	stats->n_tombstones += table->n_tombstones;
+
+	unlock_table (table);
+    }
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_destroy (pixman_glyph_cache_t *cache)
+{
+    return_if_fail (cache->freeze_count == 0);
+
+    destroy_cache (cache);
+}
+
+static freeze_t **
+find_freeze (freeze_t **freezes, pixman_glyph_cache_t *cache)
+{
+    while (*freezes && (*freezes)->cache != cache)
+	freezes = &(*freezes)->next;
+
+    return freezes;
+}
+
+/* Records that the calling thread has frozen a shared cache. Must be
+ * called with the cache lock held.
+ */
+static void
+freeze_shared (pixman_glyph_cache_t *cache)
+{
+    freeze_t **freezes = PIXMAN_GET_THREAD_LOCAL (thread_freezes);
+    freeze_t *freeze;
+
+    if (freezes && (freeze = *find_freeze (freezes, cache)))
+    {
+	freeze->count++;
+    }
+    else if (freezes && (freeze = malloc (sizeof *freeze)))
+    {
+	freeze->cache = cache;
+	freeze->epoch = cache->epoch;
+	freeze->count = 1;
+	freeze->next = *freezes;
+	*freezes = freeze;
+
+	pixman_list_prepend (&cache->freezes, &freeze->link);
+    }
+    else
+    {
+	cache->n_pinned++;
+    }
+}
+
+static void
+thaw_shared (pixman_glyph_cache_t *cache)
 {
-    unsigned idx;
+    freeze_t **freezes = PIXMAN_GET_THREAD_LOCAL (thread_freezes);
+    freeze_t **loc;
+    freeze_t *freeze;
 
-    idx = hash (glyph->font_key, glyph->glyph_key);
-    while (cache->glyphs[idx & HASH_MASK] != glyph)
-	idx++;
-
-    cache->glyphs[idx & HASH_MASK] = TOMBSTONE;
-    cache->n_tombstones++;
-    cache->n_glyphs--;
-
-    /* Eliminate tombstones if possible */
-    if (cache->glyphs[(idx + 1) & HASH_MASK] == NULL)
+    if (freezes && (freeze = *(loc = find_freeze (freezes, cache))))
     {
-	while (cache->glyphs[idx & HASH_MASK] == TOMBSTONE)
+	if (--freeze->count == 0)
 	{
-	    cache->glyphs[idx & HASH_MASK] = NULL;
-	    cache->n_tombstones--;
-	    idx--;
+	    *loc = freeze->next;
+	    pixman_list_unlink (&freeze->link);
+	    free (freeze);
 	}
     }
+    else
+    {
+	cache->n_pinned--;
+    }
+
+    free_retired (cache);
 }
 
-static void
-clear_table (pixman_glyph_cache_t *cache)
+PIXMAN_EXPORT void
+pixman_glyph_cache_freeze (pixman_glyph_cache_t  *cache)
 {
-    int i;
+    lock_cache (cache);
 
-    for (i = 0; i < HASH_SIZE; ++i)
-    {
-	glyph_t *glyph = cache->glyphs[i];
-
-	if (glyph && glyph != TOMBSTONE)
-	    free_glyph (glyph);
+    PIXMAN_ATOMIC_STORE_INT (&cache->freeze_count, cache->freeze_count + 1);
 
-	cache->glyphs[i] = NULL;
-    }
+    if (cache->shared)
+	freeze_shared (cache);
 
-    cache->n_glyphs = 0;
-    cache->n_tombstones = 0;
+    unlock_cache (cache);
 }
 
-PIXMAN_EXPORT pixman_glyph_cache_t *
-pixman_glyph_cache_create (void)
+PIXMAN_EXPORT void
+pixman_glyph_cache_thaw (pixman_glyph_cache_t  *cache)
 {
-    pixman_glyph_cache_t *cache;
+    int i;
 
-    if (!(cache = malloc (sizeof *cache)))
-	return NULL;
+    lock_cache (cache);
 
-    memset (cache->glyphs, 0, sizeof (cache->glyphs));
-    cache->n_glyphs = 0;
-    cache->n_tombstones = 0;
-    cache->freeze_count = 0;
+    PIXMAN_ATOMIC_STORE_INT (&cache->freeze_count, cache->freeze_count - 1);
 
-    pixman_list_init (&cache->mru);
+    /* Shared caches are trimmed when glyphs are inserted instead, since
+     * some thread may always have them frozen.
+     */
+    if (cache->shared)
+    {
+	thaw_shared (cache);
+    }
+    else if (cache->freeze_count == 0)
+    {
+	for (i = 0; i < cache->n_tables; ++i)
+	    trim_table (cache, &cache->tables[i]);
+    }
 
-    return cache;
+    unlock_cache (cache);
 }
 
-PIXMAN_EXPORT void
-pixman_glyph_cache_destroy (pixman_glyph_cache_t *cache)
+PIXMAN_EXPORT const void *
+pixman_glyph_cache_lookup_subpixel (pixman_glyph_cache_t  *cache,
+				    void                  *font_key,
+				    void                  *glyph_key,
+				    int                    phase)
 {
-    return_if_fail (cache->freeze_count == 0);
+    glyph_table_t *table;
+    glyph_t *glyph;
 
-    clear_table (cache);
+    /* A glyph from a shared cache may be evicted as soon as no thread
+     * has the cache frozen.
+     */
+    return_val_if_fail (
+	!cache->shared || PIXMAN_ATOMIC_LOAD_INT (&cache->freeze_count) > 0,
+	NULL);
 
-    free (cache);
-}
+    table = get_table (cache, hash (font_key, glyph_key, phase));
 
-PIXMAN_EXPORT void
-pixman_glyph_cache_freeze (pixman_glyph_cache_t  *cache)
-{
-    cache->freeze_count++;
-}
+    lock_table (table);
 
-PIXMAN_EXPORT void
-pixman_glyph_cache_thaw (pixman_glyph_cache_t  *cache)
-{
-    if (--cache->freeze_count == 0					&&
-	cache->n_glyphs + cache->n_tombstones > N_GLYPHS_HIGH_WATER)
+    if ((glyph = lookup_glyph (table, font_key, glyph_key, phase)))
     {
-	if (cache->n_tombstones > N_GLYPHS_HIGH_WATER)
-	{
-	    /* More than half the entries are
-	     * tombstones. Just dump the whole table.
-	     */
-	    clear_table (cache);
-	}
+	table->hits++;
 
-	while (cache->n_glyphs > N_GLYPHS_LOW_WATER)
-	{
-	    glyph_t *glyph = CONTAINER_OF (glyph_t, mru_link, cache->mru.tail);
-
-	    remove_glyph (cache, glyph);
-	    free_glyph (glyph);
-	}
+	/* Threads sharing a cache can't update the MRU list when they
+	 * composite glyphs, so a lookup counts as a use instead.
+	 */
+	if (cache->shared)
+	    pixman_list_move_to_front (&table->mru, &glyph->mru_link);
+    }
+    else
+    {
+	table->misses++;
     }
+
+    unlock_table (table);
+
+    return glyph;
 }
 
 PIXMAN_EXPORT const void *
@@ -245,75 +1058,200 @@ pixman_glyph_cache_lookup (pixman_glyph_cache_t  *cache,
 			   void                  *font_key,
 			   void                  *glyph_key)
 {
-    return lookup_glyph (cache, font_key, glyph_key);
+    return pixman_glyph_cache_lookup_subpixel (cache, font_key, glyph_key, 0);
 }
 
 PIXMAN_EXPORT const void *
-pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
-			   void                  *font_key,
-			   void                  *glyph_key,
-			   int			  origin_x,
-			   int                    origin_y,
-			   pixman_image_t        *image)
+pixman_glyph_cache_insert_subpixel (pixman_glyph_cache_t  *cache,
+				    void                  *font_key,
+				    void                  *glyph_key,
+				    int                    phase,
+				    int                    origin_x,
+				    int                    origin_y,
+				    pixman_image_t        *image)
 {
-    glyph_t *glyph;
+    glyph_table_t *table;
+    glyph_t *glyph, *existing;
+    pixman_format_code_t format;
+    pixman_list_t evicted;
+    uint64_t overhead;
     int32_t width, height;
 
-    return_val_if_fail (cache->freeze_count > 0, NULL);
+    return_val_if_fail (PIXMAN_ATOMIC_LOAD_INT (&cache->freeze_count) > 0, NULL);
     return_val_if_fail (image->type == BITS, NULL);
+    return_val_if_fail (phase >= 0 && phase < PIXMAN_GLYPH_MAX_PHASES, NULL);
 
+    format = image->bits.format;
     width = image->bits.width;
     height = image->bits.height;
 
-    if (cache->n_glyphs >= HASH_SIZE)
-	return NULL;
+    table = get_table (cache, hash (font_key, glyph_key, phase));
 
     if (!(glyph = malloc (sizeof *glyph)))
 	return NULL;
 
     glyph->font_key = font_key;
     glyph->glyph_key = glyph_key;
+    glyph->phase = phase;
     glyph->origin_x = origin_x;
     glyph->origin_y = origin_y;
+    glyph->width = width;
+    glyph->height = height;
+    glyph->image = NULL;
+    glyph->image_x = 0;
+    glyph->image_y = 0;
+    glyph->atlas = NULL;
+
+    /* Glyphs in an atlas are charged for their area of it */
+    glyph->n_bytes = (uint64_t)width * height * PIXMAN_FORMAT_BPP (format) / 8;
+
+    /* The glyph's space in an atlas belongs to this thread once it has
+     * been allocated, so it can be filled in without holding the lock.
+     */
+    lock_cache (cache);
 
-    if (!(glyph->image = pixman_image_create_bits (
-	      image->bits.format, width, height, NULL, -1)))
+    if (cache->use_atlas					&&
+	(format == PIXMAN_a8 || format == PIXMAN_a8r8g8b8)	&&
+	width <= ATLAS_MAX_GLYPH_SIZE				&&
+	height <= ATLAS_MAX_GLYPH_SIZE)
     {
-	free (glyph);
-	return NULL;
+	allocate_glyph_in_atlas (cache, glyph, format);
+    }
+
+    overhead = get_atlas_overhead (cache);
+
+    unlock_cache (cache);
+
+    if (!glyph->atlas)
+    {
+	if (!(glyph->image = pixman_image_create_bits (
+		  format, width, height, NULL, -1)))
+	{
+	    free (glyph);
+	    return NULL;
+	}
+
+	glyph->n_bytes = (uint64_t)height *
+	    glyph->image->bits.rowstride * sizeof (uint32_t);
+
+	if (PIXMAN_FORMAT_A   (format) != 0	&&
+	    PIXMAN_FORMAT_RGB (format) != 0)
+	{
+	    pixman_image_set_component_alpha (glyph->image, TRUE);
+	}
     }
 
     pixman_image_composite32 (PIXMAN_OP_SRC,
-			      image, NULL, glyph->image, 0, 0, 0, 0, 0, 0,
+			      image, NULL, glyph->image, 0, 0, 0, 0,
+			      glyph->image_x, glyph->image_y,
 			      width, height);
 
-    if (PIXMAN_FORMAT_A   (glyph->image->bits.format) != 0	&&
-	PIXMAN_FORMAT_RGB (glyph->image->bits.format) != 0)
+    _pixman_image_validate (glyph->image);
+
+    lock_table (table);
+
+    /* With a shared cache, another thread may have inserted the same
+     * glyph since this one looked it up.
+     */
+    existing = NULL;
+    if (cache->shared)
+	existing = lookup_glyph (table, font_key, glyph_key, phase);
+
+    if (existing || !reserve_glyph (table))
     {
-	pixman_image_set_component_alpha (glyph->image, TRUE);
+	unlock_table (table);
+
+	lock_cache (cache);
+	release_glyph_image (cache, glyph);
+	unlock_cache (cache);
+
+	free (glyph);
+
+	return existing;
     }
 
-    pixman_list_prepend (&cache->mru, &glyph->mru_link);
+    pixman_list_prepend (&table->mru, &glyph->mru_link);
+    insert_glyph (table, glyph);
+    table->n_bytes += glyph->n_bytes;
 
-    _pixman_image_validate (glyph->image);
-    insert_glyph (cache, glyph);
+    /* A shared cache may never be completely thawed, so each of its
+     * tables is trimmed as soon as it goes over its limits.
+     */
+    pixman_list_init (&evicted);
+    if (cache->shared)
+	evict_glyphs (table, overhead, glyph, &evicted);
+
+    unlock_table (table);
+
+    if (evicted.head != (pixman_link_t *)&evicted)
+    {
+	lock_cache (cache);
+
+	discard_glyphs (cache, &evicted);
+	free_retired (cache);
+
+	unlock_cache (cache);
+    }
 
     return glyph;
 }
 
-PIXMAN_EXPORT void
-pixman_glyph_cache_remove (pixman_glyph_cache_t  *cache,
+PIXMAN_EXPORT const void *
+pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
 			   void                  *font_key,
-			   void                  *glyph_key)
+			   void                  *glyph_key,
+			   int			  origin_x,
+			   int                    origin_y,
+			   pixman_image_t        *image)
+{
+    return pixman_glyph_cache_insert_subpixel (
+	cache, font_key, glyph_key, 0, origin_x, origin_y, image);
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_remove_subpixel (pixman_glyph_cache_t  *cache,
+				    void                  *font_key,
+				    void                  *glyph_key,
+				    int                    phase)
 {
+    glyph_table_t *table = get_table (cache, hash (font_key, glyph_key, phase));
     glyph_t *glyph;
 
-    if ((glyph = lookup_glyph (cache, font_key, glyph_key)))
+    lock_cache (cache);
+    lock_table (table);
+
+    if ((glyph = lookup_glyph (table, font_key, glyph_key, phase)))
     {
-	remove_glyph (cache, glyph);
+	remove_glyph (table, glyph);
 
-	free_glyph (glyph);
+	discard_glyph (cache, glyph);
     }
+
+    unlock_table (table);
+
+    if (cache->shared)
+	free_retired (cache);
+
+    unlock_cache (cache);
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_remove (pixman_glyph_cache_t  *cache,
+			   void                  *font_key,
+			   void                  *glyph_key)
+{
+    pixman_glyph_cache_remove_subpixel (cache, font_key, glyph_key, 0);
+}
+
+/* Moves a glyph to the front of the MRU list after it has been used.
+ * Shared caches do this in pixman_glyph_cache_lookup() instead.
+ */
+static void
+touch_glyph (pixman_glyph_cache_t *cache,
+	     glyph_t              *glyph)
+{
+    if (!cache->shared)
+	pixman_list_move_to_front (&cache->tables[0].mru, &glyph->mru_link);
 }
 
 PIXMAN_EXPORT void
@@ -334,8 +1272,8 @@ pixman_glyph_get_extents (pixman_glyph_cache_t *cache,
 
 	x1 = glyphs[i].x - glyph->origin_x;
 	y1 = glyphs[i].y - glyph->origin_y;
-	x2 = glyphs[i].x - glyph->origin_x + glyph->image->bits.width;
-	y2 = glyphs[i].y - glyph->origin_y + glyph->image->bits.height;
+	x2 = glyphs[i].x - glyph->origin_x + glyph->width;
+	y2 = glyphs[i].y - glyph->origin_y + glyph->height;
 
 	if (x1 < extents->x1)
 	    extents->x1 = x1;
@@ -391,6 +1329,28 @@ box32_intersect (pixman_box32_t *dest,
     return dest->x2 > dest->x1 && dest->y2 > dest->y1;
 }
 
+/* Return the first box in [begin, end) whose y2 is greater than y, or
+ * end if there is none. Region boxes are sorted in y-x bands, so their
+ * y2 values never decrease.
+ */
+static const pixman_box32_t *
+find_box_for_y (const pixman_box32_t *begin,
+		const pixman_box32_t *end,
+		int                   y)
+{
+    while (begin < end)
+    {
+	const pixman_box32_t *mid = begin + (end - begin) / 2;
+
+	if (mid->y2 > y)
+	    end = mid;
+	else
+	    begin = mid + 1;
+    }
+
+    return begin;
+}
+
 #if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
 __attribute__((__force_align_arg_pointer__))
 #endif
@@ -414,7 +1374,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
     pixman_composite_func_t func = NULL;
     pixman_implementation_t *implementation = NULL;
     pixman_composite_info_t info;
-    int i;
+    const pixman_box32_t *boxes, *boxes_end;
+    int i, n_boxes;
 
     _pixman_image_validate (src);
     _pixman_image_validate (dest);
@@ -438,26 +1399,29 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
     info.src_flags = src->common.flags;
     info.dest_flags = dest->common.flags;
 
+    boxes = pixman_region32_rectangles (&region, &n_boxes);
+    boxes_end = boxes + n_boxes;
+
     for (i = 0; i < n_glyphs; ++i)
     {
 	glyph_t *glyph = (glyph_t *)glyphs[i].glyph;
 	pixman_image_t *glyph_img = glyph->image;
 	pixman_box32_t glyph_box;
-	pixman_box32_t *pbox;
+	const pixman_box32_t *pbox;
 	uint32_t extra = FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
 	pixman_box32_t composite_box;
-	int n;
 
 	glyph_box.x1 = dest_x + glyphs[i].x - glyph->origin_x;
 	glyph_box.y1 = dest_y + glyphs[i].y - glyph->origin_y;
-	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
-	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
-	
-	pbox = pixman_region32_rectangles (&region, &n);
+	glyph_box.x2 = glyph_box.x1 + glyph->width;
+	glyph_box.y2 = glyph_box.y1 + glyph->height;
 	
 	info.mask_image = glyph_img;
 
-	while (n--)
+	/* Only visit the bands that the glyph overlaps vertically */
+	for (pbox = find_box_for_y (boxes, boxes_end, glyph_box.y1);
+	     pbox < boxes_end && pbox->y1 < glyph_box.y2;
+	     pbox++)
 	{
 	    if (box32_intersect (&composite_box, pbox, &glyph_box))
 	    {
@@ -477,8 +1441,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 
 		info.src_x = src_x + composite_box.x1 - dest_x;
 		info.src_y = src_y + composite_box.y1 - dest_y;
-		info.mask_x = composite_box.x1 - (dest_x + glyphs[i].x - glyph->origin_x);
-		info.mask_y = composite_box.y1 - (dest_y + glyphs[i].y - glyph->origin_y);
+		info.mask_x = composite_box.x1 - glyph_box.x1 + glyph->image_x;
+		info.mask_y = composite_box.y1 - glyph_box.y1 + glyph->image_y;
 		info.dest_x = composite_box.x1;
 		info.dest_y = composite_box.y1;
 		info.width = composite_box.x2 - composite_box.x1;
@@ -488,10 +1452,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 
 		func (implementation, &info);
 	    }
-
-	    pbox++;
 	}
-	pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
+	touch_glyph (cache, glyph);
     }
 
 out:
@@ -586,13 +1548,13 @@ add_glyphs (pixman_glyph_cache_t *cache,
 
 	glyph_box.x1 = glyphs[i].x - glyph->origin_x + off_x;
 	glyph_box.y1 = glyphs[i].y - glyph->origin_y + off_y;
-	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
-	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
+	glyph_box.x2 = glyph_box.x1 + glyph->width;
+	glyph_box.y2 = glyph_box.y1 + glyph->height;
 	
 	if (box32_intersect (&composite_box, &glyph_box, &dest_box))
 	{
-	    int src_x = composite_box.x1 - glyph_box.x1;
-	    int src_y = composite_box.y1 - glyph_box.y1;
+	    int src_x = composite_box.x1 - glyph_box.x1 + glyph->image_x;
+	    int src_y = composite_box.y1 - glyph_box.y1 + glyph->image_y;
 
 	    if (white_src)
 		info.mask_image = glyph_img;
@@ -608,7 +1570,7 @@ add_glyphs (pixman_glyph_cache_t *cache,
 
 	    func (implementation, &info);
 
-	    pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
+	    touch_glyph (cache, glyph);
 	}
     }
 
@@ -617,6 +1579,167 @@ out:
 	pixman_image_unref (white_img);
 }
 
+/*
+ * When all the glyphs are a8 and so is the mask, the glyphs are added
+ * straight into the mask, four pixels at a time, instead of going
+ * through a composite function per glyph. The mask is only
+ * GLYPH_BAND_HEIGHT rows high and each band is composited as soon as
+ * all the glyphs have been added to it, so it stays in the cache.
+ */
+#define GLYPH_BAND_HEIGHT 32
+
+static pixman_bool_t
+glyphs_are_a8 (int n_glyphs, const pixman_glyph_t *glyphs)
+{
+    int i;
+
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	const glyph_t *glyph = glyphs[i].glyph;
+
+	if (glyph->image->bits.format != PIXMAN_a8)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+static force_inline uint8_t
+add_saturate_8 (uint8_t a, uint8_t b)
+{
+    uint16_t t = a + b;
+
+    return t | (0 - (t >> 8));
+}
+
+static void
+add_row_8 (uint8_t *dst, const uint8_t *src, int w)
+{
+    while (w && ((uintptr_t)dst & 3))
+    {
+	*dst = add_saturate_8 (*dst, *src++);
+	dst++;
+	w--;
+    }
+
+    while (w >= 4)
+    {
+	uint32_t d = *(uint32_t *)dst;
+	uint32_t s;
+
+	memcpy (&s, src, sizeof (s));
+
+	UN8x4_ADD_UN8x4 (d, s);
+
+	*(uint32_t *)dst = d;
+
+	dst += 4;
+	src += 4;
+	w -= 4;
+    }
+
+    while (w--)
+    {
+	*dst = add_saturate_8 (*dst, *src++);
+	dst++;
+    }
+}
+
+static void
+composite_a8_glyphs_in_bands (pixman_glyph_cache_t   *cache,
+			      pixman_op_t             op,
+			      pixman_image_t         *src,
+			      pixman_image_t         *dest,
+			      int32_t                 src_x,
+			      int32_t                 src_y,
+			      int32_t                 mask_x,
+			      int32_t                 mask_y,
+			      int32_t                 dest_x,
+			      int32_t                 dest_y,
+			      int32_t                 width,
+			      int32_t                 height,
+			      int                     n_glyphs,
+			      const pixman_glyph_t   *glyphs)
+{
+    pixman_image_t *mask;
+    uint8_t *mask_bits;
+    int mask_stride;
+    int band_height = MIN (height, GLYPH_BAND_HEIGHT);
+    int y, i;
+
+    if (!(mask = pixman_image_create_bits (
+	      PIXMAN_a8, width, band_height, NULL, -1)))
+    {
+	return;
+    }
+
+    mask_bits = (uint8_t *)mask->bits.bits;
+    mask_stride = mask->bits.rowstride * 4;
+
+    for (y = 0; y < height; y += band_height)
+    {
+	pixman_box32_t band_box;
+	pixman_bool_t empty = TRUE;
+	int h = MIN (band_height, height - y);
+
+	band_box.x1 = 0;
+	band_box.y1 = y;
+	band_box.x2 = width;
+	band_box.y2 = y + h;
+
+	if (y > 0)
+	    memset (mask_bits, 0, mask_stride * band_height);
+
+	for (i = 0; i < n_glyphs; ++i)
+	{
+	    glyph_t *glyph = (glyph_t *)glyphs[i].glyph;
+	    pixman_image_t *glyph_img = glyph->image;
+	    pixman_box32_t glyph_box, box;
+	    const uint8_t *glyph_row;
+	    uint8_t *mask_row;
+	    int glyph_stride, row;
+
+	    glyph_box.x1 = glyphs[i].x - glyph->origin_x - mask_x;
+	    glyph_box.y1 = glyphs[i].y - glyph->origin_y - mask_y;
+	    glyph_box.x2 = glyph_box.x1 + glyph->width;
+	    glyph_box.y2 = glyph_box.y1 + glyph->height;
+
+	    if (!box32_intersect (&box, &glyph_box, &band_box))
+		continue;
+
+	    glyph_stride = glyph_img->bits.rowstride * 4;
+	    glyph_row = (uint8_t *)glyph_img->bits.bits +
+		(glyph->image_y + box.y1 - glyph_box.y1) * glyph_stride +
+		glyph->image_x + box.x1 - glyph_box.x1;
+	    mask_row = mask_bits + (box.y1 - y) * mask_stride + box.x1;
+
+	    for (row = box.y1; row < box.y2; ++row)
+	    {
+		add_row_8 (mask_row, glyph_row, box.x2 - box.x1);
+
+		mask_row += mask_stride;
+		glyph_row += glyph_stride;
+	    }
+
+	    empty = FALSE;
+
+	    touch_glyph (cache, glyph);
+	}
+
+	/* An empty mask only has an effect for some operators */
+	if (empty && (op == PIXMAN_OP_OVER || op == PIXMAN_OP_ADD))
+	    continue;
+
+	pixman_image_composite32 (op, src, mask, dest,
+				  src_x, src_y + y,
+				  0, 0,
+				  dest_x, dest_y + y,
+				  width, h);
+    }
+
+    pixman_image_unref (mask);
+}
+
 /* Conceptually, for each glyph, (white IN glyph) is PIXMAN_OP_ADDed to an
  * infinitely big mask image at the position such that the glyph origin point
  * is positioned at the (glyphs[i].x, glyphs[i].y) point.
@@ -655,6 +1778,16 @@ pixman_composite_glyphs (pixman_op_t            op,
 {
     pixman_image_t *mask;
 
+    if (mask_format == PIXMAN_a8 && width > 0 && height > 0 &&
+	glyphs_are_a8 (n_glyphs, glyphs))
+    {
+	composite_a8_glyphs_in_bands (cache, op, src, dest,
+				      src_x, src_y, mask_x, mask_y,
+				      dest_x, dest_y, width, height,
+				      n_glyphs, glyphs);
+	return;
+    }
+
     if (!(mask = pixman_image_create_bits (mask_format, width, height, NULL, -1)))
 	return;
 
@@ -674,3 +1807,149 @@ pixman_composite_glyphs (pixman_op_t            op,
 
     pixman_image_unref (mask);
 }
+
+/*
+ * Subpixel positioning
+ *
+ * The glyphs are given with 24.8 fixed point positions. Each glyph is
+ * drawn at the integer pixel position below its x coordinate, using
+ * the variant for the nearest of n_phases horizontal phases; a glyph
+ * that rounds up to the next phase is drawn as phase 0 one pixel
+ * further right. The y coordinate is rounded to the nearest pixel.
+ * If the cache has no variant for the phase, the glyph is drawn at the
+ * nearest pixel with phase 0, and if it doesn't have that either, the
+ * glyph is skipped.
+ */
+#define N_STACK_GLYPHS 256
+
+static pixman_glyph_t *
+resolve_subpixel_glyphs (pixman_glyph_cache_t            *cache,
+			 int                              n_phases,
+			 int                              n_glyphs,
+			 const pixman_subpixel_glyph_t   *glyphs,
+			 pixman_glyph_t                  *stack_glyphs,
+			 int                             *n_resolved)
+{
+    pixman_glyph_t *resolved = stack_glyphs;
+    int i, n;
+
+    if (n_phases < 1)
+	n_phases = 1;
+    if (n_phases > PIXMAN_GLYPH_MAX_PHASES)
+	n_phases = PIXMAN_GLYPH_MAX_PHASES;
+
+    if (n_glyphs > N_STACK_GLYPHS)
+    {
+	if (!(resolved = pixman_malloc_ab (n_glyphs, sizeof (pixman_glyph_t))))
+	    return NULL;
+    }
+
+    n = 0;
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	const pixman_subpixel_glyph_t *g = &glyphs[i];
+	int x = g->x >> 8;
+	int phase = ((g->x & 0xff) * n_phases + 0x80) >> 8;
+	const void *glyph = NULL;
+
+	if (phase == n_phases)
+	{
+	    x++;
+	    phase = 0;
+	}
+
+	if (phase != 0)
+	{
+	    glyph = pixman_glyph_cache_lookup_subpixel (
+		cache, g->font_key, g->glyph_key, phase);
+
+	    if (!glyph)
+		x = (g->x + 0x80) >> 8;
+	}
+
+	if (!glyph)
+	{
+	    glyph = pixman_glyph_cache_lookup_subpixel (
+		cache, g->font_key, g->glyph_key, 0);
+	}
+
+	if (glyph)
+	{
+	    resolved[n].x = x;
+	    resolved[n].y = (g->y + 0x80) >> 8;
+	    resolved[n].glyph = glyph;
+	    n++;
+	}
+    }
+
+    *n_resolved = n;
+
+    return resolved;
+}
+
+PIXMAN_EXPORT void
+pixman_composite_subpixel_glyphs (pixman_op_t                      op,
+				  pixman_image_t                  *src,
+				  pixman_image_t                  *dest,
+				  pixman_format_code_t             mask_format,
+				  int32_t                          src_x,
+				  int32_t                          src_y,
+				  int32_t                          mask_x,
+				  int32_t                          mask_y,
+				  int32_t                          dest_x,
+				  int32_t                          dest_y,
+				  int32_t                          width,
+				  int32_t                          height,
+				  pixman_glyph_cache_t            *cache,
+				  int                              n_phases,
+				  int                              n_glyphs,
+				  const pixman_subpixel_glyph_t   *glyphs)
+{
+    pixman_glyph_t stack_glyphs[N_STACK_GLYPHS];
+    pixman_glyph_t *resolved;
+    int n_resolved;
+
+    if (!(resolved = resolve_subpixel_glyphs (
+	      cache, n_phases, n_glyphs, glyphs, stack_glyphs, &n_resolved)))
+    {
+	return;
+    }
+
+    pixman_composite_glyphs (op, src, dest, mask_format,
+			     src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			     width, height, cache, n_resolved, resolved);
+
+    if (resolved != stack_glyphs)
+	free (resolved);
+}
+
+PIXMAN_EXPORT void
+pixman_composite_subpixel_glyphs_no_mask (pixman_op_t                      op,
+					  pixman_image_t                  *src,
+					  pixman_image_t                  *dest,
+					  int32_t                          src_x,
+					  int32_t                          src_y,
+					  int32_t                          dest_x,
+					  int32_t                          dest_y,
+					  pixman_glyph_cache_t            *cache,
+					  int                              n_phases,
+					  int                              n_glyphs,
+					  const pixman_subpixel_glyph_t   *glyphs)
+{
+    pixman_glyph_t stack_glyphs[N_STACK_GLYPHS];
+    pixman_glyph_t *resolved;
+    int n_resolved;
+
+    if (!(resolved = resolve_subpixel_glyphs (
+	      cache, n_phases, n_glyphs, glyphs, stack_glyphs, &n_resolved)))
+    {
+	return;
+    }
+
+    pixman_composite_glyphs_no_mask (op, src, dest,
+				     src_x, src_y, dest_x, dest_y,
+				     cache, n_resolved, resolved);
+
+    if (resolved != stack_glyphs)
+	free (resolved);
+}
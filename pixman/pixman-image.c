@@ -430,7 +430,7 @@ compute_image_info (pixman_image_t *image)
     else
 	flags |= FAST_PATH_UNIFIED_ALPHA;
 
-    flags |= (FAST_PATH_NO_ACCESSORS | FAST_PATH_NARROW_FORMAT);
+    flags |= (FAST_PATH_NO_ACCESSORS | FAST_PATH_NARROW_FORMAT | FAST_PATH_NO_DITHER);
 
     /* Type specific checks */
     switch (image->type)
@@ -468,6 +468,10 @@ compute_image_info (pixman_image_t *image)
 	if (image->bits.read_func || image->bits.write_func)
 	    flags &= ~FAST_PATH_NO_ACCESSORS;
 
+	/* Only the general wide write back dithers */
+	if (image->bits.dither != PIXMAN_DITHER_NONE)
+	    flags &= ~FAST_PATH_NO_DITHER;
+
 	if (PIXMAN_FORMAT_IS_WIDE (image->bits.format))
 	    flags &= ~FAST_PATH_NARROW_FORMAT;
 	break;
@@ -719,6 +723,43 @@ pixman_image_set_dither_offset (pixman_image_t *image,
     }
 }
 
+PIXMAN_EXPORT void
+pixman_image_set_yuv_color_space (pixman_image_t           *image,
+				  pixman_yuv_color_space_t  color_space)
+{
+    return_if_fail ((unsigned int)color_space <= PIXMAN_YUV_BT709_FULL);
+
+    if (image->type == BITS)
+    {
+	if (image->bits.yuv_color_space == color_space)
+	    return;
+
+	image->bits.yuv_color_space = color_space;
+
+	image_property_changed (image);
+    }
+}
+
+PIXMAN_EXPORT void
+pixman_image_set_exact_coverage (pixman_image_t *image,
+				 pixman_bool_t   exact_coverage)
+{
+    /* This only affects rasterization into the image, not how it
+     * is composited, so there is no need to recompute the flags.
+     */
+    if (image->type == BITS)
+	image->bits.exact_coverage = exact_coverage;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+pixman_image_get_exact_coverage (pixman_image_t *image)
+{
+    if (image->type == BITS)
+	return image->bits.exact_coverage;
+
+    return FALSE;
+}
+
 PIXMAN_EXPORT pixman_bool_t
 pixman_image_set_filter (pixman_image_t *      image,
                          pixman_filter_t       filter,
@@ -992,3 +1033,45 @@ _pixman_image_get_solid (pixman_implementation_t *imp,
 
     return result;
 }
+
+/* Like _pixman_image_get_solid(), but with the color that the wide
+ * iterators would give, and with red and blue swapped when the format
+ * isn't an ARGB one.
+ */
+argb_t
+_pixman_image_get_solid_float (pixman_implementation_t *imp,
+			       pixman_image_t *         image,
+			       pixman_format_code_t     format)
+{
+    argb_t result;
+
+    if (image->type == SOLID)
+    {
+	result = image->solid.color_float;
+    }
+    else
+    {
+	pixman_iter_t iter;
+
+	_pixman_implementation_iter_init (
+	    imp, &iter, image, 0, 0, 1, 1,
+	    (uint8_t *)&result,
+	    ITER_WIDE | ITER_SRC, image->common.flags);
+
+	result = *(argb_t *)iter.get_scanline (&iter, NULL);
+
+	if (iter.fini)
+	    iter.fini (&iter);
+    }
+
+    if (PIXMAN_FORMAT_TYPE (format) != PIXMAN_TYPE_ARGB
+	&& PIXMAN_FORMAT_TYPE (format) != PIXMAN_TYPE_ARGB_SRGB)
+    {
+	float t = result.r;
+
+	result.r = result.b;
+	result.b = t;
+    }
+
+    return result;
+}
@@ -193,28 +193,33 @@ pixman_combine_32_func_t
 _pixman_implementation_lookup_combiner (pixman_implementation_t *imp,
 					pixman_op_t		 op,
 					pixman_bool_t		 component_alpha,
-					pixman_bool_t		 narrow)
+					iter_flags_t		 width)
 {
     while (imp)
     {
 	pixman_combine_32_func_t f = NULL;
 
-	switch ((narrow << 1) | component_alpha)
+	switch (width)
 	{
-	case 0: /* not narrow, not component alpha */
-	    f = (pixman_combine_32_func_t)imp->combine_float[op];
-	    break;
-	    
-	case 1: /* not narrow, component_alpha */
-	    f = (pixman_combine_32_func_t)imp->combine_float_ca[op];
+	case ITER_NARROW:
+	    if (component_alpha)
+		f = imp->combine_32_ca[op];
+	    else
+		f = imp->combine_32[op];
 	    break;
 
-	case 2: /* narrow, not component alpha */
-	    f = imp->combine_32[op];
+	case ITER_MEDIUM:
+	    if (component_alpha)
+		f = (pixman_combine_32_func_t)imp->combine_64_ca[op];
+	    else
+		f = (pixman_combine_32_func_t)imp->combine_64[op];
 	    break;
 
-	case 3: /* narrow, component_alpha */
-	    f = imp->combine_32_ca[op];
+	default:
+	    if (component_alpha)
+		f = (pixman_combine_32_func_t)imp->combine_float_ca[op];
+	    else
+		f = (pixman_combine_32_func_t)imp->combine_float[op];
 	    break;
 	}
 
@@ -285,6 +290,58 @@ _pixman_implementation_fill (pixman_implementation_t *imp,
     return FALSE;
 }
 
+pixman_bool_t
+_pixman_implementation_convert (pixman_implementation_t *imp,
+                                pixman_format_code_t     src_format,
+                                const uint8_t *          src,
+                                int                      src_stride,
+                                pixman_format_code_t     dst_format,
+                                uint8_t *                dst,
+                                int                      dst_stride,
+                                int                      width,
+                                int                      height)
+{
+    while (imp)
+    {
+	if (imp->convert &&
+	    (*imp->convert) (imp, src_format, src, src_stride,
+			     dst_format, dst, dst_stride, width, height))
+	{
+	    return TRUE;
+	}
+
+	imp = imp->fallback;
+    }
+
+    return FALSE;
+}
+
+pixman_bool_t
+_pixman_implementation_premultiply (pixman_implementation_t *imp,
+                                    pixman_format_code_t     format,
+                                    const uint8_t *          src,
+                                    int                      src_stride,
+                                    uint8_t *                dst,
+                                    int                      dst_stride,
+                                    int                      width,
+                                    int                      height,
+                                    pixman_bool_t            unpremultiply)
+{
+    while (imp)
+    {
+	if (imp->premultiply &&
+	    (*imp->premultiply) (imp, format, src, src_stride, dst, dst_stride,
+				 width, height, unpremultiply))
+	{
+	    return TRUE;
+	}
+
+	imp = imp->fallback;
+    }
+
+    return FALSE;
+}
+
 static uint32_t *
 get_scanline_null (pixman_iter_t *iter, const uint32_t *mask)
 {
@@ -1350,6 +1350,16 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
     SIMPLE_BILINEAR_FAST_PATH_PAD (op,s,d,func),			\
     SIMPLE_BILINEAR_FAST_PATH_NORMAL (op,s,d,func)
 
+/* Any repeat, onto a format that isn't narrow */
+#define WIDE_BILINEAR_FAST_PATH(op,s,d,func)				\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	SCALED_BILINEAR_FLAGS,						\
+	PIXMAN_null, 0,							\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS & ~FAST_PATH_NARROW_FORMAT, \
+	func,								\
+    }
+
 #define SIMPLE_BILINEAR_A8_MASK_FAST_PATH(op,s,d,func)			\
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH_COVER (op,s,d,func),		\
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH_NONE (op,s,d,func),		\
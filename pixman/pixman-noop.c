@@ -65,6 +65,32 @@ noop_init_solid_narrow (pixman_iter_t *iter,
 	*(buffer++) = color;
 }
 
+static void
+noop_init_solid_medium (pixman_iter_t *iter,
+			const pixman_iter_info_t *info)
+{
+    pixman_image_t *image = iter->image;
+    uint64_t *buffer = (uint64_t *)iter->buffer;
+    uint64_t *end = buffer + iter->width;
+    uint64_t color;
+
+    if (iter->image->type == SOLID)
+    {
+	const pixman_color_t *c = &image->solid.color;
+
+	color = ((uint64_t)c->alpha << 48) | ((uint64_t)c->red << 32) |
+		((uint64_t)c->green << 16) | c->blue;
+    }
+    else
+    {
+	image->bits.fetch_scanline_64 (
+	    &image->bits, 0, 0, 1, (uint32_t *)&color, NULL);
+    }
+
+    while (buffer < end)
+	*(buffer++) = color;
+}
+
 static void
 noop_init_solid_wide (pixman_iter_t *iter,
 		      const pixman_iter_info_t *info)
@@ -113,6 +139,12 @@ static const pixman_iter_info_t noop_iters[] =
       _pixman_iter_get_scanline_noop,
       NULL,
     },
+    { PIXMAN_solid,
+      FAST_PATH_NO_ALPHA_MAP, ITER_MEDIUM | ITER_SRC,
+      noop_init_solid_medium,
+      _pixman_iter_get_scanline_noop,
+      NULL
+    },
     { PIXMAN_solid,
       FAST_PATH_NO_ALPHA_MAP, ITER_WIDE | ITER_SRC,
       noop_init_solid_wide,
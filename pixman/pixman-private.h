@@ -184,6 +184,10 @@ struct bits_image
     uint32_t                   dither_offset_y;
     uint32_t                   dither_offset_x;
 
+    pixman_bool_t              exact_coverage;
+
+    pixman_yuv_color_space_t   yuv_color_space;
+
     fetch_scanline_t           fetch_scanline_32;
     fetch_pixel_32_t	       fetch_pixel_32;
     store_scanline_t           store_scanline_32;
@@ -192,6 +196,12 @@ struct bits_image
     fetch_pixel_float_t	       fetch_pixel_float;
     store_scanline_t           store_scanline_float;
 
+    /* Only set for formats that have more than 8 bits per channel, but
+     * fit in 16 bits per channel
+     */
+    fetch_scanline_t	       fetch_scanline_64;
+    store_scanline_t           store_scanline_64;
+
     /* Used for indirect access to the bits */
     pixman_read_memory_func_t  read_func;
     pixman_write_memory_func_t write_func;
@@ -219,6 +229,13 @@ typedef enum
     ITER_NARROW =               (1 << 0),
     ITER_WIDE =                 (1 << 1),
 
+    /* Medium iterators produce 64 bit pixels with 16 bits per channel,
+     * laid out like a16r16g16b16 in a uint64_t. They are only used when
+     * at least one image has more than 8 bits per channel, and all of
+     * them can be fetched at 16 bits per channel or less.
+     */
+    ITER_MEDIUM =		(1 << 7),
+
     /* "Localized alpha" is when the alpha channel is used only to compute
      * the alpha value of the destination. This means that the computation
      * of the RGB values of the result is independent of the alpha value.
@@ -289,6 +306,16 @@ _pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 void
 _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
+float
+_pixman_dither_factor (pixman_dither_t dither, int x, int y);
+
+/* The dither factors of a line repeat every DITHER_PERIOD pixels */
+#define DITHER_PERIOD 64
+
+void
+_pixman_dither_thresholds (bits_image_t *image, int x, int y, int width,
+			   uint16_t thresholds[DITHER_PERIOD]);
+
 void
 _pixman_linear_gradient_iter_init (pixman_image_t *image, pixman_iter_t  *iter);
 
@@ -424,6 +451,34 @@ _pixman_gradient_walker_fill_wide(pixman_gradient_walker_t *walker,
     ((n) == 1? 0 : (pixman_fixed_frac (x) +				\
 		    X_FRAC_FIRST (n)) / STEP_X_SMALL (n))
 
+/*
+ * Step across a small sample grid gap
+ */
+#define RENDER_EDGE_STEP_SMALL(edge)					\
+    {									\
+	edge->x += edge->stepx_small;					\
+	edge->e += edge->dx_small;					\
+	if (edge->e > 0)						\
+	{								\
+	    edge->e -= edge->dy;					\
+	    edge->x += edge->signdx;					\
+	}								\
+    }
+
+/*
+ * Step across a large sample grid gap
+ */
+#define RENDER_EDGE_STEP_BIG(edge)					\
+    {									\
+	edge->x += edge->stepx_big;					\
+	edge->e += edge->dx_big;					\
+	if (edge->e > 0)						\
+	{								\
+	    edge->e -= edge->dy;					\
+	    edge->x += edge->signdx;					\
+	}								\
+    }
+
 void
 pixman_rasterize_edges_accessors (pixman_image_t *image,
                                   pixman_edge_t * l,
@@ -484,6 +539,13 @@ typedef void (*pixman_combine_float_func_t) (pixman_implementation_t *imp,
 					     const float *	      mask,
 					     int		      n_pixels);
 
+typedef void (*pixman_combine_64_func_t) (pixman_implementation_t *imp,
+					  pixman_op_t              op,
+					  uint64_t *               dest,
+					  const uint64_t *         src,
+					  const uint64_t *         mask,
+					  int                      width);
+
 typedef void (*pixman_composite_func_t) (pixman_implementation_t *imp,
 					 pixman_composite_info_t *info);
 typedef pixman_bool_t (*pixman_blt_func_t) (pixman_implementation_t *imp,
@@ -508,9 +570,28 @@ typedef pixman_bool_t (*pixman_fill_func_t) (pixman_implementation_t *imp,
 					     int                      width,
 					     int                      height,
 					     uint32_t                 filler);
+typedef pixman_bool_t (*pixman_convert_func_t) (pixman_implementation_t *imp,
+						pixman_format_code_t     src_format,
+						const uint8_t *          src,
+						int                      src_stride,
+						pixman_format_code_t     dst_format,
+						uint8_t *                dst,
+						int                      dst_stride,
+						int                      width,
+						int                      height);
+typedef pixman_bool_t (*pixman_premultiply_func_t) (pixman_implementation_t *imp,
+						    pixman_format_code_t     format,
+						    const uint8_t *          src,
+						    int                      src_stride,
+						    uint8_t *                dst,
+						    int                      dst_stride,
+						    int                      width,
+						    int                      height,
+						    pixman_bool_t            unpremultiply);
 
 void _pixman_setup_combiner_functions_32 (pixman_implementation_t *imp);
 void _pixman_setup_combiner_functions_float (pixman_implementation_t *imp);
+void _pixman_setup_combiner_functions_64 (pixman_implementation_t *imp);
 
 typedef struct
 {
@@ -533,11 +614,15 @@ struct pixman_implementation_t
 
     pixman_blt_func_t		blt;
     pixman_fill_func_t		fill;
+    pixman_convert_func_t	convert;
+    pixman_premultiply_func_t	premultiply;
 
     pixman_combine_32_func_t	combine_32[PIXMAN_N_OPERATORS];
     pixman_combine_32_func_t	combine_32_ca[PIXMAN_N_OPERATORS];
     pixman_combine_float_func_t	combine_float[PIXMAN_N_OPERATORS];
     pixman_combine_float_func_t	combine_float_ca[PIXMAN_N_OPERATORS];
+    pixman_combine_64_func_t	combine_64[PIXMAN_N_OPERATORS];
+    pixman_combine_64_func_t	combine_64_ca[PIXMAN_N_OPERATORS];
 };
 
 uint32_t
@@ -545,6 +630,11 @@ _pixman_image_get_solid (pixman_implementation_t *imp,
 			 pixman_image_t *         image,
                          pixman_format_code_t     format);
 
+argb_t
+_pixman_image_get_solid_float (pixman_implementation_t *imp,
+			       pixman_image_t *         image,
+			       pixman_format_code_t     format);
+
 pixman_implementation_t *
 _pixman_implementation_create (pixman_implementation_t *fallback,
 			       const pixman_fast_path_t *fast_paths);
@@ -565,7 +655,7 @@ pixman_combine_32_func_t
 _pixman_implementation_lookup_combiner (pixman_implementation_t *imp,
 					pixman_op_t		 op,
 					pixman_bool_t		 component_alpha,
-					pixman_bool_t		 wide);
+					iter_flags_t		 width);
 
 pixman_bool_t
 _pixman_implementation_blt (pixman_implementation_t *imp,
@@ -593,6 +683,28 @@ _pixman_implementation_fill (pixman_implementation_t *imp,
                              int                      height,
                              uint32_t                 filler);
 
+pixman_bool_t
+_pixman_implementation_convert (pixman_implementation_t *imp,
+                                pixman_format_code_t     src_format,
+                                const uint8_t *          src,
+                                int                      src_stride,
+                                pixman_format_code_t     dst_format,
+                                uint8_t *                dst,
+                                int                      dst_stride,
+                                int                      width,
+                                int                      height);
+
+pixman_bool_t
+_pixman_implementation_premultiply (pixman_implementation_t *imp,
+                                    pixman_format_code_t     format,
+                                    const uint8_t *          src,
+                                    int                      src_stride,
+                                    uint8_t *                dst,
+                                    int                      dst_stride,
+                                    int                      width,
+                                    int                      height,
+                                    pixman_bool_t            unpremultiply);
+
 void
 _pixman_implementation_iter_init (pixman_implementation_t       *imp,
                                   pixman_iter_t                 *iter,
@@ -630,6 +742,11 @@ pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback);
 #endif
 
+#ifdef USE_F16C
+pixman_implementation_t *
+_pixman_implementation_create_f16c (pixman_implementation_t *fallback);
+#endif
+
 #ifdef USE_ARM_SIMD
 pixman_implementation_t *
 _pixman_implementation_create_arm_simd (pixman_implementation_t *fallback);
@@ -746,6 +863,8 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_NO_DITHER			(1 << 27)
+#define FAST_PATH_A8_ALPHA_MAP			(1 << 28)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
@@ -776,6 +895,7 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_STD_DEST_FLAGS					\
     (FAST_PATH_NO_ACCESSORS		|				\
      FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_DITHER		|				\
      FAST_PATH_NARROW_FORMAT)
 
 #define SOURCE_FLAGS(format)						\
@@ -812,6 +932,36 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 	    dest, FAST_PATH_STD_DEST_FLAGS,				\
 	    func) }
 
+/* Unmasked fast paths where the source or the destination has more than
+ * 8 bits per channel and would otherwise take the wide general path.
+ */
+#define PIXMAN_WIDE_FAST_PATH(op, src, dest, func)			\
+    { FAST_PATH (							\
+	    op,								\
+	    src,  SOURCE_FLAGS (src) & ~FAST_PATH_NARROW_FORMAT,	\
+	    null, 0,							\
+	    dest, FAST_PATH_STD_DEST_FLAGS & ~FAST_PATH_NARROW_FORMAT,	\
+	    func) }
+
+/* Also matches destinations that are dithered */
+#define PIXMAN_DITHER_FAST_PATH(op, src, dest, func)			\
+    { FAST_PATH (							\
+	    op,								\
+	    src,  SOURCE_FLAGS (src),					\
+	    null, 0,							\
+	    dest, FAST_PATH_NO_ACCESSORS | FAST_PATH_NO_ALPHA_MAP,	\
+	    func) }
+
+/* Sources with an a8 alpha map */
+#define PIXMAN_ALPHA_MAP_FAST_PATH(op, src, dest, func)			\
+    { FAST_PATH (							\
+	    op,								\
+	    src,  ((SOURCE_FLAGS (src) & ~FAST_PATH_NO_ALPHA_MAP) |	\
+		   FAST_PATH_A8_ALPHA_MAP),				\
+	    null, 0,							\
+	    dest, FAST_PATH_STD_DEST_FLAGS,				\
+	    func) }
+
 extern pixman_implementation_t *global_implementation;
 
 static force_inline pixman_implementation_t *
@@ -858,6 +1008,18 @@ pixman_malloc_abc (unsigned int a, unsigned int b, unsigned int c);
 void *
 pixman_malloc_ab_plus_c (unsigned int a, unsigned int b, unsigned int c);
 
+void *
+_pixman_region_alloc (size_t size);
+
+void *
+_pixman_region_realloc (void *ptr, size_t size);
+
+void
+_pixman_region_free (void *ptr);
+
+void
+_pixman_region32_fini_data_pool (void);
+
 pixman_bool_t
 _pixman_multiply_overflows_size (size_t a, size_t b);
 
@@ -879,6 +1041,16 @@ pixman_contract_from_float (uint32_t     *dst,
 			    const argb_t *src,
 			    int           width);
 
+void
+pixman_expand_to_64 (uint64_t       *dst,
+		     const uint32_t *src,
+		     int             width);
+
+void
+pixman_contract_from_64 (uint32_t       *dst,
+			 const uint64_t *src,
+			 int             width);
+
 /* Region Helpers */
 pixman_bool_t
 pixman_region32_copy_from_region16 (pixman_region32_t *dst,
@@ -1011,6 +1183,109 @@ convert_0565_to_0565 (uint16_t s)
     return s;
 }
 
+/* Conversion from YUV */
+
+typedef struct
+{
+    int32_t y_offset;
+    int32_t y, rv, gu, gv, bu;		/* 16.16 fixed point */
+} pixman_yuv_coefficients_t;
+
+extern const pixman_yuv_coefficients_t _pixman_yuv_coefficients[];
+
+static force_inline const pixman_yuv_coefficients_t *
+_pixman_yuv_get_coefficients (const bits_image_t *image)
+{
+    return &_pixman_yuv_coefficients[image->yuv_color_space];
+}
+
+static force_inline uint32_t
+convert_yuv_to_8888 (const pixman_yuv_coefficients_t *c,
+		     int32_t y, int32_t u, int32_t v)
+{
+    int32_t r, g, b;
+
+    y = (y - c->y_offset) * c->y;
+    u -= 128;
+    v -= 128;
+
+    r = y + c->rv * v;
+    g = y - c->gv * v - c->gu * u;
+    b = y + c->bu * u;
+
+    return 0xff000000 |
+	(r >= 0 ? r < 0x1000000 ? r         & 0xff0000 : 0xff0000 : 0) |
+	(g >= 0 ? g < 0x1000000 ? (g >> 8)  & 0x00ff00 : 0x00ff00 : 0) |
+	(b >= 0 ? b < 0x1000000 ? (b >> 16) & 0x0000ff : 0x0000ff : 0);
+}
+
+/* The planes of one line of a yv12, i420 or nv12 image. Pixel x has
+ * luma y[x] and chroma u[(x >> 1) * chroma_step] and
+ * v[(x >> 1) * chroma_step].
+ */
+typedef struct
+{
+    const uint8_t *y;
+    const uint8_t *u;
+    const uint8_t *v;
+    int		   chroma_step;
+} pixman_yuv_line_t;
+
+static force_inline void
+_pixman_yuv_get_line (const bits_image_t *image, int line, pixman_yuv_line_t *yuv)
+{
+    uint32_t *bits = image->bits;
+    int stride = image->rowstride;
+    int height = image->height;
+    int offset0, offset1;
+
+    /* With a negative stride, the chroma planes are stored bottom-up
+     * after the luma plane, too.
+     */
+    yuv->y = (uint8_t *)(bits + stride * line);
+
+    if (PIXMAN_FORMAT_TYPE (image->format) == PIXMAN_TYPE_NV12)
+    {
+	offset0 = stride < 0 ?
+	    (-stride) * ((height - 1) >> 1) - stride : stride * height;
+
+	yuv->u = (uint8_t *)(bits + offset0 + stride * (line >> 1));
+	yuv->v = yuv->u + 1;
+	yuv->chroma_step = 2;
+	return;
+    }
+
+    offset0 = stride < 0 ?
+	((-stride) >> 1) * ((height - 1) >> 1) - stride : stride * height;
+    offset1 = stride < 0 ?
+	offset0 + ((-stride) >> 1) * (height >> 1) : offset0 + (offset0 >> 2);
+
+    offset0 += (stride >> 1) * (line >> 1);
+    offset1 += (stride >> 1) * (line >> 1);
+
+    if (PIXMAN_FORMAT_TYPE (image->format) == PIXMAN_TYPE_I420)
+    {
+	yuv->u = (uint8_t *)(bits + offset0);
+	yuv->v = (uint8_t *)(bits + offset1);
+    }
+    else
+    {
+	yuv->v = (uint8_t *)(bits + offset0);
+	yuv->u = (uint8_t *)(bits + offset1);
+    }
+    yuv->chroma_step = 1;
+}
+
+static force_inline uint32_t
+convert_yuv_line_to_8888 (const pixman_yuv_coefficients_t *c,
+			  const pixman_yuv_line_t         *yuv,
+			  int                              x)
+{
+    int chroma = (x >> 1) * yuv->chroma_step;
+
+    return convert_yuv_to_8888 (c, yuv->y[x], yuv->u[chroma], yuv->v[chroma]);
+}
+
 #define PIXMAN_FORMAT_IS_WIDE(f)					\
     (PIXMAN_FORMAT_A (f) > 8 ||						\
      PIXMAN_FORMAT_R (f) > 8 ||						\
@@ -1072,6 +1347,171 @@ unorm_to_unorm (uint32_t val, int from_bits, int to_bits)
 uint16_t pixman_float_to_unorm (float f, int n_bits);
 float pixman_unorm_to_float (uint16_t u, int n_bits);
 
+/* Conversions between IEEE single and half precision floats. These
+ * round to nearest even and give the same results as the F16C
+ * instructions, including for denormals, infinities and NaNs.
+ */
+static force_inline float
+pixman_half_to_float (uint16_t h)
+{
+    union { uint32_t u; float f; } v;
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+
+    if (exponent == 0x1f)
+    {
+	/* Infinities, and NaNs which become quiet */
+	v.u = sign | 0x7f800000 | (mantissa << 13) | (mantissa ? 0x400000 : 0);
+    }
+    else if (exponent == 0)
+    {
+	/* Zeros and denormals are exact as mantissa * 2^-24 */
+	v.f = mantissa * (1.0f / (1 << 24));
+	v.u |= sign;
+    }
+    else
+    {
+	v.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    return v.f;
+}
+
+static force_inline uint16_t
+pixman_float_to_half (float f)
+{
+    union { uint32_t u; float f; } v;
+    uint32_t sign;
+
+    v.f = f;
+    sign = (v.u >> 16) & 0x8000;
+    v.u &= 0x7fffffff;
+
+    if (v.u >= 0x47800000)
+    {
+	/* Too large for a half, infinities and NaNs */
+	if (v.u > 0x7f800000)
+	    return sign | 0x7e00 | ((v.u >> 13) & 0x3ff);
+	else
+	    return sign | 0x7c00;
+    }
+    else if (v.u < 0x38800000)
+    {
+	/* The result is a denormal or zero. Adding 0.5 lines the
+	 * half's mantissa up with the float's, and the FPU does the
+	 * rounding.
+	 */
+	v.f += 0.5f;
+
+	return sign | (v.u - 0x3f000000);
+    }
+    else
+    {
+	/* Rebias the exponent and round to nearest even; a carry out
+	 * of the mantissa correctly bumps the exponent, up to infinity.
+	 */
+	uint32_t odd = (v.u >> 13) & 1;
+
+	v.u += ((uint32_t)(15 - 127) << 23) + 0xfff + odd;
+
+	return sign | (v.u >> 13);
+    }
+}
+
+/* sRGB conversions, with the tables in pixman-srgb.c. The float tables
+ * are stored as IEEE 754 bit patterns.
+ */
+extern const uint32_t _pixman_srgb_to_linear[256];
+extern const uint32_t _pixman_linear_to_srgb_threshold[256];
+extern const uint8_t _pixman_linear_to_srgb_base[4097];
+
+static force_inline float
+pixman_srgb_to_linear (uint8_t s)
+{
+    union { uint32_t u; float f; } v;
+
+    v.u = _pixman_srgb_to_linear[s];
+
+    return v.f;
+}
+
+static force_inline float
+pixman_linear_to_srgb_threshold (uint8_t s)
+{
+    union { uint32_t u; float f; } v;
+
+    v.u = _pixman_linear_to_srgb_threshold[s];
+
+    return v.f;
+}
+
+/* The sRGB value whose linear value is nearest to f */
+static force_inline uint8_t
+pixman_linear_to_srgb (float f)
+{
+    uint8_t s;
+
+    if (!(f > 0.0f))
+	f = 0.0f;
+    else if (f > 1.0f)
+	f = 1.0f;
+
+    s = _pixman_linear_to_srgb_base[(int)(f * 4096.0f)];
+
+    return s + (f >= pixman_linear_to_srgb_threshold (s));
+}
+
+/* Unpremultiplying an 8 bit channel rounds c * 255 / a to the nearest
+ * value, with ties going up, and saturates. Away from ties, the exact
+ * quotient is at least 1 / 510 from the rounding point, so the bias
+ * that makes ties go up can't change other results.
+ */
+extern const float _pixman_unpremultiply_factors[256];
+
+#define PIXMAN_UNPREMULTIPLY_BIAS (0.5f + 1.0f / 1024)
+
+static force_inline uint32_t
+pixman_unpremultiply_un8 (uint32_t c, uint32_t a)
+{
+    uint32_t u = c * _pixman_unpremultiply_factors[a] + PIXMAN_UNPREMULTIPLY_BIAS;
+
+    return u > 255 ? 255 : u;
+}
+
+/*
+ * Threads
+ */
+#define PIXMAN_MAX_THREADS 64
+
+typedef void (* pixman_job_func_t) (void *data, int job);
+
+int
+_pixman_get_rasterization_threads (void);
+
+void
+_pixman_run_jobs (int               n_threads,
+		  int               n_jobs,
+		  pixman_job_func_t func,
+		  void *            data);
+
+void
+_pixman_stop_threads (void);
+
+typedef struct pixman_mutex pixman_mutex_t;
+
+pixman_mutex_t *
+_pixman_mutex_create (void);
+
+void
+_pixman_mutex_destroy (pixman_mutex_t *mutex);
+
+void
+_pixman_mutex_lock (pixman_mutex_t *mutex);
+
+void
+_pixman_mutex_unlock (pixman_mutex_t *mutex);
+
 /*
  * Various debugging code
  */
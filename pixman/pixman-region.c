@@ -202,18 +202,261 @@ PIXREGION_SZOF (size_t n)
     return size + sizeof(region_data_type_t);
 }
 
+/* When the data is shared, each block is preceded by a reference count,
+ * and copies of a region share the block until one of them changes.
+ */
+#ifdef PIXMAN_REGION_SHARED_DATA
+typedef union
+{
+    int			ref_count;
+    long		align;		/* for the data that follows */
+} data_header_t;
+
+#define DATA_HEADER_SIZE	sizeof (data_header_t)
+#define DATA_HEADER(data)	((data_header_t *)(data) - 1)
+
+static force_inline void
+set_data_ref_count (region_data_type_t *data, int ref_count)
+{
+    DATA_HEADER (data)->ref_count = ref_count;
+}
+
+static force_inline void
+ref_data (region_data_type_t *data)
+{
+    PIXMAN_ATOMIC_INC_INT (&DATA_HEADER (data)->ref_count);
+}
+
+static force_inline pixman_bool_t
+unref_data (region_data_type_t *data)
+{
+    return PIXMAN_ATOMIC_DEC_INT (&DATA_HEADER (data)->ref_count) == 0;
+}
+
+static force_inline pixman_bool_t
+data_is_shared (region_data_type_t *data)
+{
+    return data && data->size &&
+	PIXMAN_ATOMIC_LOAD_INT (&DATA_HEADER (data)->ref_count) > 1;
+}
+#else
+#define DATA_HEADER_SIZE	0
+#define set_data_ref_count(data, ref_count)
+#define unref_data(data)	TRUE
+#define data_is_shared(data)	FALSE
+#endif
+
+static force_inline void *
+data_block (region_data_type_t *data)
+{
+    return (uint8_t *)data - DATA_HEADER_SIZE;
+}
+
+#ifdef PIXMAN_REGION_CUSTOM_ALLOCATOR
+#define region_alloc(size)		_pixman_region_alloc (size)
+#define region_realloc(ptr, size)	_pixman_region_realloc (ptr, size)
+#define region_free(ptr)		_pixman_region_free (ptr)
+#else
+#define region_alloc(size)		malloc (size)
+#define region_realloc(ptr, size)	realloc (ptr, size)
+#define region_free(ptr)		free (ptr)
+#endif
+
+/* Small data blocks are recycled through a per-thread pool, so that
+ * the short-lived regions that compositing with a simple clip creates
+ * don't go to the allocator every time. The blocks that are left in the
+ * pool of a thread are freed when it exits, or when the library is
+ * unloaded for the thread that unloads it.
+ */
+#ifdef PIXMAN_REGION_POOLED_DATA
+#include <pthread.h>
+
+#define SMALL_DATA_BOXES	16
+#define N_POOLED_DATA		4
+
+typedef struct
+{
+    int			n_data;
+    region_data_type_t *data[N_POOLED_DATA];
+} data_pool_t;
+
+static pthread_once_t data_pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t data_pool_key;
+static pixman_bool_t data_pool_key_created;
+
+static void
+destroy_data_pool (void *value)
+{
+    data_pool_t *pool = value;
+
+    while (pool->n_data)
+	region_free (data_block (pool->data[--pool->n_data]));
+
+    free (pool);
+}
+
+static void
+create_data_pool_key (void)
+{
+    data_pool_key_created =
+	pthread_key_create (&data_pool_key, destroy_data_pool) == 0;
+}
+
+static data_pool_t *
+get_data_pool (void)
+{
+    data_pool_t *pool;
+
+    if (pthread_once (&data_pool_once, create_data_pool_key) != 0 ||
+	!data_pool_key_created)
+    {
+	return NULL;
+    }
+
+    if (!(pool = pthread_getspecific (data_pool_key)))
+    {
+	if (!(pool = calloc (1, sizeof (data_pool_t))))
+	    return NULL;
+
+	if (pthread_setspecific (data_pool_key, pool) != 0)
+	{
+	    free (pool);
+	    return NULL;
+	}
+    }
+
+    return pool;
+}
+
+/* Deletes the key, so that it isn't leaked when the library is
+ * unloaded. The pools of other threads can't be reached any more, so
+ * their blocks are leaked. From then on, blocks are no longer pooled.
+ */
+static void
+fini_data_pool (void)
+{
+    data_pool_t *pool;
+
+    if (!data_pool_key_created)
+	return;
+
+    if ((pool = pthread_getspecific (data_pool_key)))
+    {
+	pthread_setspecific (data_pool_key, NULL);
+	destroy_data_pool (pool);
+    }
+
+    pthread_key_delete (data_pool_key);
+    data_pool_key_created = FALSE;
+}
+#endif
+
+/* Returns a block with room for at least n boxes; its size field is
+ * set to the actual number.
+ */
 static region_data_type_t *
 alloc_data (size_t n)
 {
-    size_t sz = PIXREGION_SZOF (n);
+    region_data_type_t *data;
+    void *block;
+    size_t sz;
+
+#ifdef PIXMAN_REGION_POOLED_DATA
+    if (n <= SMALL_DATA_BOXES)
+    {
+	data_pool_t *pool = get_data_pool ();
+
+	n = SMALL_DATA_BOXES;
+
+	if (pool && pool->n_data)
+	{
+	    data = pool->data[--pool->n_data];
+	    data->size = n;
+	    set_data_ref_count (data, 1);
+	    return data;
+	}
+    }
+#endif
 
-    if (!sz)
+    if (!(sz = PIXREGION_SZOF (n)) || sz > SIZE_MAX - DATA_HEADER_SIZE)
 	return NULL;
 
-    return malloc (sz);
+    if (!(block = region_alloc (sz + DATA_HEADER_SIZE)))
+	return NULL;
+
+    data = (region_data_type_t *)((uint8_t *)block + DATA_HEADER_SIZE);
+    data->size = n;
+    set_data_ref_count (data, 1);
+
+    return data;
 }
 
-#define FREE_DATA(reg) if ((reg)->data && (reg)->data->size) free ((reg)->data)
+static void
+free_data (region_data_type_t *data)
+{
+    /* The empty and broken data are static */
+    if (!data || !data->size)
+	return;
+
+    if (!unref_data (data))
+	return;
+
+#ifdef PIXMAN_REGION_POOLED_DATA
+    /* Any block of this size has room for at least this many boxes */
+    if (data->size == SMALL_DATA_BOXES)
+    {
+	data_pool_t *pool = get_data_pool ();
+
+	if (pool && pool->n_data < N_POOLED_DATA)
+	{
+	    pool->data[pool->n_data++] = data;
+	    return;
+	}
+    }
+#endif
+
+    region_free (data_block (data));
+}
+
+/* Resizes a block to hold n boxes. A shared block is copied instead,
+ * and the old block is only released if that succeeds.
+ */
+static region_data_type_t *
+realloc_data (region_data_type_t *data, size_t n)
+{
+    void *block;
+    size_t sz;
+
+    critical_if_fail (data->numRects <= (long)n);
+
+    if (data_is_shared (data))
+    {
+	region_data_type_t *new_data;
+
+	if (!(new_data = alloc_data (n)))
+	    return NULL;
+
+	new_data->numRects = data->numRects;
+	memcpy (new_data + 1, data + 1, data->numRects * sizeof (box_type_t));
+
+	free_data (data);
+
+	return new_data;
+    }
+
+    if (!(sz = PIXREGION_SZOF (n)) || sz > SIZE_MAX - DATA_HEADER_SIZE)
+	return NULL;
+
+    if (!(block = region_realloc (data_block (data), sz + DATA_HEADER_SIZE)))
+	return NULL;
+
+    data = (region_data_type_t *)((uint8_t *)block + DATA_HEADER_SIZE);
+    data->size = n;
+
+    return data;
+}
+
+#define FREE_DATA(reg) free_data ((reg)->data)
 
 #define RECTALLOC_BAIL(region, n, bail)					\
     do									\
@@ -271,23 +514,11 @@ alloc_data (size_t n)
 	    ((reg)->data->size > 50))					\
 	{								\
 	    region_data_type_t * new_data;				\
-	    size_t data_size = PIXREGION_SZOF (numRects);		\
 									\
-	    if (!data_size)						\
-	    {								\
-		new_data = NULL;					\
-	    }								\
-	    else							\
-	    {								\
-		new_data = (region_data_type_t *)			\
-		    realloc ((reg)->data, data_size);			\
-	    }								\
+	    new_data = realloc_data ((reg)->data, (numRects));		\
 									\
 	    if (new_data)						\
-	    {								\
-		new_data->size = (numRects);				\
 		(reg)->data = new_data;					\
-	    }								\
 	}								\
     } while (0)
 
@@ -313,6 +544,10 @@ PREFIX (_equal) (const region_type_t *reg1, const region_type_t *reg2)
     if (PIXREGION_NUMRECTS (reg1) != PIXREGION_NUMRECTS (reg2))
 	return FALSE;
 
+    /* Copies share their boxes */
+    if (reg1->data && reg1->data == reg2->data)
+	return TRUE;
+
     rects1 = PIXREGION_RECTS (reg1);
     rects2 = PIXREGION_RECTS (reg2);
     
@@ -471,8 +706,6 @@ pixman_rect_alloc (region_type_t * region,
     }
     else
     {
-	size_t data_size;
-
 	if (n == 1)
 	{
 	    n = region->data->numRects;
@@ -481,25 +714,12 @@ pixman_rect_alloc (region_type_t * region,
 	}
 
 	n += region->data->numRects;
-	data_size = PIXREGION_SZOF (n);
 
-	if (!data_size)
-	{
-	    data = NULL;
-	}
-	else
-	{
-	    data = (region_data_type_t *)
-		realloc (region->data, PIXREGION_SZOF (n));
-	}
-	
-	if (!data)
+	if (!(data = realloc_data (region->data, n)))
 	    return pixman_break (region);
 	
 	region->data = data;
     }
-    
-    region->data->size = n;
 
     return TRUE;
 }
@@ -521,7 +741,13 @@ PREFIX (_copy) (region_type_t *dst, const region_type_t *src)
 	dst->data = src->data;
 	return TRUE;
     }
-    
+
+#ifdef PIXMAN_REGION_SHARED_DATA
+    /* The copy shares the data until one of the regions changes */
+    ref_data (src->data);
+    FREE_DATA (dst);
+    dst->data = src->data;
+#else
     if (!dst->data || (dst->data->size < src->data->numRects))
     {
 	FREE_DATA (dst);
@@ -530,14 +756,13 @@ PREFIX (_copy) (region_type_t *dst, const region_type_t *src)
 
 	if (!dst->data)
 	    return pixman_break (dst);
-
-	dst->data->size = src->data->numRects;
     }
 
     dst->data->numRects = src->data->numRects;
 
     memmove ((char *)PIXREGION_BOXPTR (dst), (char *)PIXREGION_BOXPTR (src),
              dst->data->numRects * sizeof(box_type_t));
+#endif
 
     return TRUE;
 }
@@ -819,15 +1044,25 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     new_size <<= 1;
 
     if (!new_reg->data)
+    {
 	new_reg->data = pixman_region_empty_data;
+    }
+    else if (data_is_shared (new_reg->data))
+    {
+	/* The boxes are rebuilt from scratch, so don't copy them */
+	free_data (new_reg->data);
+	new_reg->data = pixman_region_empty_data;
+    }
     else if (new_reg->data->size)
+    {
 	new_reg->data->numRects = 0;
+    }
 
     if (new_size > new_reg->data->size)
     {
         if (!pixman_rect_alloc (new_reg, new_size))
         {
-            free (old_data);
+            free_data (old_data);
             return FALSE;
 	}
     }
@@ -1002,7 +1237,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
         APPEND_REGIONS (new_reg, r2_band_end, r2_end);
     }
 
-    free (old_data);
+    free_data (old_data);
 
     if (!(numRects = new_reg->data->numRects))
     {
@@ -1023,7 +1258,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     return TRUE;
 
 bail:
-    free (old_data);
+    free_data (old_data);
 
     return pixman_break (new_reg);
 }
@@ -2096,6 +2331,47 @@ find_box_for_y (box_type_t *begin, box_type_t *end, int y)
     }
 }
 
+/* In time O(log n), locate the end of the band that starts at @begin,
+ * ie. the first box in [begin, end) with a different y1.
+ */
+static box_type_t *
+find_band_end (box_type_t *begin, box_type_t *end)
+{
+    int y1 = begin->y1;
+
+    /* begin is always in the band, end never is */
+    while (end - begin > 1)
+    {
+	box_type_t *mid = begin + (end - begin) / 2;
+
+	if (mid->y1 == y1)
+	    begin = mid;
+	else
+	    end = mid;
+    }
+
+    return end;
+}
+
+/* In time O(log n), locate the first box in the band [begin, end) whose
+ * x2 is greater than x. Return @end if no such box exists.
+ */
+static box_type_t *
+find_box_for_x (box_type_t *begin, box_type_t *end, int x)
+{
+    while (begin != end)
+    {
+	box_type_t *mid = begin + (end - begin) / 2;
+
+	if (mid->x2 > x)
+	    end = mid;
+	else
+	    begin = mid + 1;
+    }
+
+    return begin;
+}
+
 /*
  *   rect_in(region, rect)
  *   This routine takes a pointer to a region and a pointer to a box
@@ -2167,7 +2443,11 @@ PREFIX (_contains_rectangle) (const region_type_t *  region,
 	}
 
         if (pbox->x2 <= x)
-	    continue;           /* not far enough over yet */
+        {
+            /* not far enough over yet; skip ahead within the band */
+            pbox = find_box_for_x (pbox, find_band_end (pbox, pbox_end), x) - 1;
+	    continue;
+	}
 
         if (pbox->x1 > x)
         {
@@ -2233,6 +2513,19 @@ PREFIX (_translate) (region_type_t *region, int x, int y)
     if (x == 0 && y == 0)
         return;
 
+    if (data_is_shared (region->data))
+    {
+	region_data_type_t *data = realloc_data (region->data, region->data->numRects);
+
+	if (!data)
+	{
+	    pixman_break (region);
+	    return;
+	}
+
+	region->data = data;
+    }
+
     region->extents.x1 = x1 = region->extents.x1 + x;
     region->extents.y1 = y1 = region->extents.y1 + y;
     region->extents.x2 = x2 = region->extents.x2 + x;
@@ -2373,21 +2666,19 @@ PREFIX (_contains_point) (const region_type_t * region,
 
     pbox = find_box_for_y (pbox, pbox_end, y);
 
-    for (;pbox != pbox_end; pbox++)
-    {
-        if ((y < pbox->y1) || (x < pbox->x1))
-	    break;              /* missed it */
+    if (pbox == pbox_end || y < pbox->y1)
+	return(FALSE);          /* missed it */
 
-        if (x >= pbox->x2)
-	    continue;           /* not there yet */
+    pbox_end = find_band_end (pbox, pbox_end);
+    pbox = find_box_for_x (pbox, pbox_end, x);
 
-        if (box)
-	    *box = *pbox;
+    if (pbox == pbox_end || x < pbox->x1)
+	return(FALSE);
 
-        return(TRUE);
-    }
+    if (box)
+	*box = *pbox;
 
-    return(FALSE);
+    return(TRUE);
 }
 
 PIXMAN_EXPORT int
@@ -2565,240 +2856,494 @@ PREFIX (_init_rects) (region_type_t *region,
     return validate (region);
 }
 
-#define READ(_ptr) (*(_ptr))
-
-static inline box_type_t *
-bitmap_addrect (region_type_t *reg,
-                box_type_t *r,
-                box_type_t **first_rect,
-                int rx1, int ry1,
-                int rx2, int ry2)
+/*
+ * Sweep-line construction
+ *
+ * The boxes are sorted once by y1, and then swept from top to bottom
+ * while the boxes that cross the current scanline are kept in x1
+ * order. Each band is the union of the x spans of those boxes, and it
+ * is coalesced with the band above it as soon as it is emitted, so the
+ * region is built in a single pass without going through pixman_op().
+ */
+static pixman_bool_t
+init_from_sorted_boxes (region_type_t *region,
+                        box_type_t    *boxes,
+                        int            count)
 {
-    if ((rx1 < rx2) && (ry1 < ry2) &&
-	(!(reg->data->numRects &&
-	   ((r-1)->y1 == ry1) && ((r-1)->y2 == ry2) &&
-	   ((r-1)->x1 <= rx1) && ((r-1)->x2 >= rx2))))
+    box_type_t *next = boxes, *end = boxes + count;
+    box_type_t **active, **merged, **tmp;
+    int n_active, prev_band;
+    int y;
+
+    PREFIX (_init) (region);
+
+    if (count == 0)
+	return TRUE;
+
+    if (count == 1)
     {
-	if (reg->data->numRects == reg->data->size)
+	region->extents = boxes[0];
+	region->data = NULL;
+	return TRUE;
+    }
+
+    if (!(active = pixman_malloc_abc (count, 2, sizeof (box_type_t *))))
+	return pixman_break (region);
+    merged = active + count;
+
+    if (!pixman_rect_alloc (region, count))
+	goto bail;
+
+    n_active = 0;
+    prev_band = 0;
+    y = next->y1;
+
+    for (;;)
+    {
+	box_type_t *r;
+	int cur_band;
+	int x1, x2, y2;
+	int i, j, k;
+
+	/* Merge the boxes that start on this scanline into the
+	 * active list. They arrive in x1 order already.
+	 */
+	i = j = k = 0;
+	while (next + j != end && next[j].y1 == y)
+	    j++;
+
+	if (j)
 	{
-	    if (!pixman_rect_alloc (reg, 1))
-		return NULL;
-	    *first_rect = PIXREGION_BOXPTR(reg);
-	    r = *first_rect + reg->data->numRects;
+	    box_type_t *new_boxes = next;
+	    int n_new = j;
+
+	    j = 0;
+	    while (i < n_active || j < n_new)
+	    {
+		if (j == n_new ||
+		    (i < n_active && active[i]->x1 <= new_boxes[j].x1))
+		{
+		    merged[k++] = active[i++];
+		}
+		else
+		{
+		    merged[k++] = &new_boxes[j++];
+		}
+	    }
+
+	    tmp = active;
+	    active = merged;
+	    merged = tmp;
+
+	    n_active = k;
+	    next += n_new;
+	}
+
+	/* The band ends where an active box ends or a new one starts */
+	y2 = (next != end) ? next->y1 : PIXMAN_REGION_MAX;
+	for (i = 0; i < n_active; ++i)
+	{
+	    if (active[i]->y2 < y2)
+		y2 = active[i]->y2;
+	}
+
+	RECTALLOC_BAIL (region, n_active, bail);
+
+	cur_band = region->data->numRects;
+	r = PIXREGION_TOP (region);
+
+	x1 = active[0]->x1;
+	x2 = active[0]->x2;
+	for (i = 1; i < n_active; ++i)
+	{
+	    if (active[i]->x1 <= x2)
+	    {
+		if (active[i]->x2 > x2)
+		    x2 = active[i]->x2;
+	    }
+	    else
+	    {
+		ADDRECT (r, x1, y, x2, y2);
+		x1 = active[i]->x1;
+		x2 = active[i]->x2;
+	    }
+	}
+	ADDRECT (r, x1, y, x2, y2);
+
+	region->data->numRects = r - PIXREGION_BOXPTR (region);
+	COALESCE (region, prev_band, cur_band);
+
+	/* Retire the boxes that end on this scanline */
+	y = y2;
+	for (i = j = 0; i < n_active; ++i)
+	{
+	    if (active[i]->y2 > y)
+		active[j++] = active[i];
+	}
+	n_active = j;
+
+	if (!n_active)
+	{
+	    if (next == end)
+		break;
+
+	    y = next->y1;
 	}
-	r->x1 = rx1;
-	r->y1 = ry1;
-	r->x2 = rx2;
-	r->y2 = ry2;
-	reg->data->numRects++;
-	if (r->x1 < reg->extents.x1)
-	    reg->extents.x1 = r->x1;
-	if (r->x2 > reg->extents.x2)
-	    reg->extents.x2 = r->x2;
-	r++;
     }
-    return r;
+
+    free (active < merged ? active : merged);
+
+    count = region->data->numRects;
+    if (count == 1)
+    {
+	region->extents = *PIXREGION_BOXPTR (region);
+	FREE_DATA (region);
+	region->data = NULL;
+    }
+    else
+    {
+	pixman_set_extents (region);
+	DOWNSIZE (region, count);
+    }
+
+    GOOD (region);
+
+    return TRUE;
+
+bail:
+    free (active < merged ? active : merged);
+
+    return pixman_break (region);
 }
 
-/* Convert bitmap clip mask into clipping region.
- * First, goes through each line and makes boxes by noting the transitions
- * from 0 to 1 and 1 to 0.
- * Then it coalesces the current line with the previous if they have boxes
- * at the same X coordinates.
- * Stride is in number of uint32_t per line.
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_init_from_boxes_unsorted) (region_type_t *   region,
+                                    const box_type_t *boxes,
+                                    int               count)
+{
+    box_type_t *sorted;
+    pixman_bool_t ret;
+    int i, n;
+
+    PREFIX (_init) (region);
+
+    if (count <= 0)
+	return TRUE;
+
+    if (!(sorted = pixman_malloc_ab (count, sizeof (box_type_t))))
+	return pixman_break (region);
+
+    /* Eliminate empty and malformed rectangles */
+    for (i = n = 0; i < count; ++i)
+    {
+	if (GOOD_RECT (&boxes[i]))
+	    sorted[n++] = boxes[i];
+    }
+
+    if (n > 1)
+	quick_sort_rects (sorted, n);
+
+    ret = init_from_sorted_boxes (region, sorted, n);
+
+    free (sorted);
+
+    return ret;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_union_many) (region_type_t *       dest,
+                      const region_type_t * regions,
+                      int                   n_regions)
+{
+    region_type_t result;
+    box_type_t *boxes;
+    size_t total;
+    int i, n;
+
+    total = 0;
+    for (i = 0; i < n_regions; ++i)
+    {
+	if (PIXREGION_NAR (&regions[i]))
+	    return pixman_break (dest);
+
+	total += PIXREGION_NUMRECTS (&regions[i]);
+    }
+
+    if (total > INT32_MAX)
+	return pixman_break (dest);
+
+    if (n_regions == 1)
+	return PREFIX (_copy) (dest, &regions[0]);
+
+    if (!(boxes = pixman_malloc_ab (total ? total : 1, sizeof (box_type_t))))
+	return pixman_break (dest);
+
+    /* The boxes of each region are banded already, but together they
+     * need sorting.
+     */
+    for (i = n = 0; i < n_regions; ++i)
+    {
+	int n_boxes = PIXREGION_NUMRECTS (&regions[i]);
+
+	memcpy (boxes + n, PIXREGION_RECTS (&regions[i]),
+		n_boxes * sizeof (box_type_t));
+	n += n_boxes;
+    }
+
+    if (n > 1)
+	quick_sort_rects (boxes, n);
+
+    init_from_sorted_boxes (&result, boxes, n);
+
+    free (boxes);
+
+    /* dest may be one of the regions, so it is only replaced now */
+    FREE_DATA (dest);
+    *dest = result;
+
+    return !PIXREGION_NAR (dest);
+}
+
+/*
+ * Conversion of a1 and a8 masks into regions
+ *
+ * Each scanline is processed 32 pixels at a time as a mask with bit i set
+ * when pixel i is inside the region. Words that are entirely inside or
+ * entirely outside the current run are skipped with a single test, and
+ * the transitions in the others are found with a bit scan. Scanlines
+ * with the same runs as the band above extend that band instead of
+ * adding new boxes.
  */
-PIXMAN_EXPORT void
-PREFIX (_init_from_image) (region_type_t *region,
-                           pixman_image_t *image)
+static force_inline int
+count_trailing_zeros (uint32_t x)
 {
-    uint32_t mask0 = 0xffffffff & ~SCREEN_SHIFT_RIGHT(0xffffffff, 1);
-    box_type_t *first_rect, *rects, *prect_line_start;
-    box_type_t *old_rect, *new_rect;
-    uint32_t *pw, w, *pw_line, *pw_line_end;
-    int	irect_prev_start, irect_line_start;
-    int	h, base, rx1 = 0, crects;
-    int	ib;
-    pixman_bool_t in_box, same;
+#ifdef HAVE_BUILTIN_CLZ
+    return __builtin_ctz (x);
+#else
+    int n = 0;
+
+    while (!(x & 1))
+    {
+	n++;
+	x >>= 1;
+    }
+
+    return n;
+#endif
+}
+
+static force_inline uint32_t
+a1_pixel_mask (uint32_t w)
+{
+#ifdef WORDS_BIGENDIAN
+    /* The leftmost pixel is the most significant bit */
+    w = ((w >> 1) & 0x55555555) | ((w & 0x55555555) << 1);
+    w = ((w >> 2) & 0x33333333) | ((w & 0x33333333) << 2);
+    w = ((w >> 4) & 0x0f0f0f0f) | ((w & 0x0f0f0f0f) << 4);
+    w = ((w >> 8) & 0x00ff00ff) | ((w & 0x00ff00ff) << 8);
+    w = (w >> 16) | (w << 16);
+#endif
+
+    return w;
+}
+
+/* The a8 pixels that are at least the threshold are found four at a time:
+ * for the low seven bits of each byte, setting the top bit before
+ * subtracting the low bits of the threshold leaves the top bit set
+ * exactly when the pixel's low bits are not smaller; the pixel's own top
+ * bit decides the rest.
+ */
+static force_inline uint32_t
+a8_pixel_mask (const uint32_t *line, int n_pixels, int threshold)
+{
+    uint32_t t_low = (threshold & 0x7f) * 0x01010101;
+    uint32_t mask = 0;
+    int i;
+
+    for (i = 0; i < n_pixels; i += 4)
+    {
+	uint32_t w = line[i >> 2];
+	uint32_t ge = ((w | 0x80808080) - t_low) & 0x80808080;
+
+	if (threshold & 0x80)
+	    ge &= w;
+	else
+	    ge |= w & 0x80808080;
+
+	ge >>= 7;
+#ifdef WORDS_BIGENDIAN
+	ge = ((ge >> 24) & 1) | ((ge >> 15) & 2) | ((ge >> 6) & 4) | ((ge << 3) & 8);
+#else
+	ge = (ge | (ge >> 7) | (ge >> 14) | (ge >> 21)) & 0xf;
+#endif
+
+	mask |= ge << i;
+    }
+
+    return mask;
+}
+
+/* Stores the runs of inside pixels of a scanline as pairs of x1, x2 and
+ * returns the number of runs.
+ */
+static int
+get_scanline_runs (const uint32_t *line,
+                   pixman_bool_t   is_a1,
+                   int             width,
+                   int             threshold,
+                   int *           runs)
+{
+    pixman_bool_t in_run = FALSE;
+    int n_runs = 0;
+    int x;
+
+    for (x = 0; x < width; x += 32)
+    {
+	int n_pixels = MIN (width - x, 32);
+	uint32_t mask;
+	int pos;
+
+	if (is_a1)
+	    mask = a1_pixel_mask (line[x >> 5]);
+	else
+	    mask = a8_pixel_mask (line + (x >> 2), n_pixels, threshold);
+
+	if (n_pixels < 32)
+	    mask &= (1U << n_pixels) - 1;
+
+	if (mask == (in_run ? 0xffffffff : 0))
+	    continue;
+
+	pos = 0;
+	for (;;)
+	{
+	    uint32_t t = (in_run ? ~mask : mask) & (0xffffffff << pos);
+
+	    if (!t)
+		break;
+
+	    pos = count_trailing_zeros (t);
+	    runs[2 * n_runs + in_run] = x + pos;
+	    if (in_run)
+		n_runs++;
+	    in_run = !in_run;
+	}
+    }
+
+    if (in_run)
+	runs[2 * n_runs++ + 1] = width;
+
+    return n_runs;
+}
+
+static void
+init_from_mask (region_type_t *region,
+                pixman_image_t *image,
+                int             threshold)
+{
+    const uint32_t *line;
     int width, height, stride;
+    int prev_band, n_prev;
+    int *runs;
+    int y, i, n_runs;
 
     PREFIX(_init) (region);
 
-    critical_if_fail (region->data);
-
     return_if_fail (image->type == BITS);
-    return_if_fail (image->bits.format == PIXMAN_a1);
+    return_if_fail (image->bits.format == PIXMAN_a1 ||
+		    image->bits.format == PIXMAN_a8);
 
-    pw_line = pixman_image_get_data (image);
+    line = pixman_image_get_data (image);
     width = pixman_image_get_width (image);
     height = pixman_image_get_height (image);
     stride = pixman_image_get_stride (image) / 4;
 
-    first_rect = PIXREGION_BOXPTR(region);
-    rects = first_rect;
+    if (!(runs = pixman_malloc_ab (width + 2, sizeof (int))))
+    {
+	pixman_break (region);
+	return;
+    }
 
-    region->extents.x1 = width - 1;
-    region->extents.x2 = 0;
-    irect_prev_start = -1;
-    for (h = 0; h < height; h++)
+    prev_band = 0;
+    n_prev = 0;
+
+    for (y = 0; y < height; y++, line += stride)
     {
-        pw = pw_line;
-        pw_line += stride;
-        irect_line_start = rects - first_rect;
+	box_type_t *r;
 
-        /* If the Screen left most bit of the word is set, we're starting in
-         * a box */
-        if (READ(pw) & mask0)
-        {
-            in_box = TRUE;
-            rx1 = 0;
-        }
-        else
-        {
-            in_box = FALSE;
-        }
+	n_runs = get_scanline_runs (line, image->bits.format == PIXMAN_a1,
+				    width, threshold, runs);
 
-        /* Process all words which are fully in the pixmap */
-        pw_line_end = pw + (width >> 5);
-        for (base = 0; pw < pw_line_end; base += 32)
-        {
-            w = READ(pw++);
-            if (in_box)
-            {
-                if (!~w)
-                    continue;
-            }
-            else
-            {
-                if (!w)
-                    continue;
-            }
-            for (ib = 0; ib < 32; ib++)
-            {
-                /* If the Screen left most bit of the word is set, we're
-                 * starting a box */
-                if (w & mask0)
-                {
-                    if (!in_box)
-                    {
-                        rx1 = base + ib;
-                        /* start new box */
-                        in_box = TRUE;
-                    }
-                }
-                else
-                {
-                    if (in_box)
-                    {
-                        /* end box */
-                        rects = bitmap_addrect (region, rects, &first_rect,
-                                                rx1, h, base + ib, h + 1);
-                        if (rects == NULL)
-                            goto error;
-                        in_box = FALSE;
-                    }
-                }
-                /* Shift the word VISUALLY left one. */
-                w = SCREEN_SHIFT_LEFT(w, 1);
-            }
-        }
-
-        if (width & 31)
-        {
-            /* Process final partial word on line */
-             w = READ(pw++);
-            for (ib = 0; ib < (width & 31); ib++)
-            {
-                /* If the Screen left most bit of the word is set, we're
-                 * starting a box */
-                if (w & mask0)
-                {
-                    if (!in_box)
-                    {
-                        rx1 = base + ib;
-                        /* start new box */
-                        in_box = TRUE;
-                    }
-                }
-                else
-                {
-                    if (in_box)
-                    {
-                        /* end box */
-                        rects = bitmap_addrect(region, rects, &first_rect,
-					       rx1, h, base + ib, h + 1);
-			if (rects == NULL)
-			    goto error;
-                        in_box = FALSE;
-                    }
-                }
-                /* Shift the word VISUALLY left one. */
-                w = SCREEN_SHIFT_LEFT(w, 1);
-            }
-        }
-        /* If scanline ended with last bit set, end the box */
-        if (in_box)
-        {
-            rects = bitmap_addrect(region, rects, &first_rect,
-				   rx1, h, base + (width & 31), h + 1);
-	    if (rects == NULL)
-		goto error;
-        }
-        /* if all rectangles on this line have the same x-coords as
-         * those on the previous line, then add 1 to all the previous  y2s and
-         * throw away all the rectangles from this line
-         */
-        same = FALSE;
-        if (irect_prev_start != -1)
-        {
-            crects = irect_line_start - irect_prev_start;
-            if (crects != 0 &&
-                crects == ((rects - first_rect) - irect_line_start))
-            {
-                old_rect = first_rect + irect_prev_start;
-                new_rect = prect_line_start = first_rect + irect_line_start;
-                same = TRUE;
-                while (old_rect < prect_line_start)
-                {
-                    if ((old_rect->x1 != new_rect->x1) ||
-                        (old_rect->x2 != new_rect->x2))
-                    {
-                          same = FALSE;
-                          break;
-                    }
-                    old_rect++;
-                    new_rect++;
-                }
-                if (same)
-                {
-                    old_rect = first_rect + irect_prev_start;
-                    while (old_rect < prect_line_start)
-                    {
-                        old_rect->y2 += 1;
-                        old_rect++;
-                    }
-                    rects -= crects;
-                    region->data->numRects -= crects;
-                }
-            }
-        }
-        if(!same)
-            irect_prev_start = irect_line_start;
-    }
-    if (!region->data->numRects)
-    {
-        region->extents.x1 = region->extents.x2 = 0;
+	if (!n_runs)
+	{
+	    n_prev = 0;
+	    continue;
+	}
+
+	/* Extend the band above if it has the same runs */
+	if (n_runs == n_prev)
+	{
+	    r = PIXREGION_BOX (region, prev_band);
+
+	    for (i = 0; i < n_runs; ++i)
+	    {
+		if (r[i].x1 != runs[2 * i] || r[i].x2 != runs[2 * i + 1])
+		    break;
+	    }
+
+	    if (i == n_runs)
+	    {
+		for (i = 0; i < n_runs; ++i)
+		    r[i].y2 = y + 1;
+
+		continue;
+	    }
+	}
+
+	RECTALLOC_BAIL (region, n_runs, bail);
+
+	prev_band = region->data->numRects;
+	n_prev = n_runs;
+
+	r = PIXREGION_TOP (region);
+	for (i = 0; i < n_runs; ++i)
+	    ADDRECT (r, runs[2 * i], y, runs[2 * i + 1], y + 1);
+
+	region->data->numRects += n_runs;
+    }
+
+    free (runs);
+
+    if (region->data->numRects == 1)
+    {
+	region->extents = *PIXREGION_BOXPTR (region);
+	FREE_DATA (region);
+	region->data = NULL;
     }
     else
     {
-        region->extents.y1 = PIXREGION_BOXPTR(region)->y1;
-        region->extents.y2 = PIXREGION_END(region)->y2;
-        if (region->data->numRects == 1)
-        {
-            free (region->data);
-            region->data = NULL;
-        }
+	pixman_set_extents (region);
     }
 
- error:
+    GOOD (region);
+
     return;
+
+bail:
+    free (runs);
+}
+
+PIXMAN_EXPORT void
+PREFIX (_init_from_image) (region_type_t *region,
+                           pixman_image_t *image)
+{
+    init_from_mask (region, image, 1);
+}
+
+PIXMAN_EXPORT void
+PREFIX (_init_from_image_threshold) (region_type_t *region,
+                                     pixman_image_t *image,
+                                     int             threshold)
+{
+    init_from_mask (region, image, CLIP (threshold, 1, 255));
 }
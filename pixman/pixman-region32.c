@@ -44,4 +44,31 @@ typedef struct {
 #define PIXMAN_REGION_MAX INT32_MAX
 #define PIXMAN_REGION_MIN INT32_MIN
 
+/* Unlike 16 bit region data, which the X server allocates and frees
+ * itself, 32 bit region data only ever comes from pixman, so it can be
+ * reference counted and shared between copies. That needs atomics,
+ * since the copies may be used by different threads.
+ */
+#ifdef PIXMAN_HAVE_ATOMICS
+#define PIXMAN_REGION_SHARED_DATA
+#endif
+
+/* For the same reason, it can come from the allocator set with
+ * pixman_set_region_allocator(), and small blocks can be recycled
+ * through a per-thread pool, where threads can free it on exit.
+ */
+#define PIXMAN_REGION_CUSTOM_ALLOCATOR
+
+#if defined(HAVE_PTHREADS) && !defined(PIXMAN_NO_TLS)
+#define PIXMAN_REGION_POOLED_DATA
+#endif
+
 #include "pixman-region.c"
+
+void
+_pixman_region32_fini_data_pool (void)
+{
+#ifdef PIXMAN_REGION_POOLED_DATA
+    fini_data_pool ();
+#endif
+}
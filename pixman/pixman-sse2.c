@@ -37,6 +37,7 @@
 #include <emmintrin.h> /* for SSE2 intrinsics */
 #include "pixman-private.h"
 #include "pixman-combine32.h"
+#include "pixman-combine-float.h"
 #include "pixman-inlines.h"
 
 static __m128i mask_0080;
@@ -2351,6 +2352,177 @@ sse2_combine_add_ca (pixman_implementation_t *imp,
     }
 }
 
+/* Medium combiners. Two a16r16g16b16 pixels fit in a register, and the
+ * products round like mul_un16() in pixman-combine64.c, so the results
+ * are the same as with the C combiners.
+ */
+static force_inline __m128i
+pix_multiply_16_128 (__m128i data, __m128i alpha)
+{
+    /* t = data * alpha + 0x8000, and the result is (t + (t >> 16)) >> 16,
+     * with the low and high halves of t in separate registers.
+     */
+    __m128i lo = _mm_mullo_epi16 (data, alpha);
+    __m128i hi = _mm_mulhi_epu16 (data, alpha);
+    __m128i t_lo = _mm_xor_si128 (lo, _mm_set1_epi16 (0x8000));
+    __m128i t_hi = _mm_add_epi16 (hi, _mm_srli_epi16 (lo, 15));
+    __m128i carry;
+
+    /* Adding the halves carries where the saturated sum is not the
+     * wrapped around one.
+     */
+    carry = _mm_cmpeq_epi16 (_mm_adds_epu16 (t_lo, t_hi),
+			     _mm_add_epi16 (t_lo, t_hi));
+    carry = _mm_andnot_si128 (carry, _mm_set1_epi16 (-1));
+
+    return _mm_sub_epi16 (t_hi, carry);
+}
+
+static force_inline __m128i
+expand_alpha_16_128 (__m128i data)
+{
+    return _mm_shufflehi_epi16 (
+	_mm_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3)),
+	_MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m128i
+negate_16_128 (__m128i data)
+{
+    return _mm_xor_si128 (data, _mm_set1_epi16 (-1));
+}
+
+static force_inline __m128i
+apply_factor_16_128 (combine_factor_t factor,
+		     __m128i          data,
+		     __m128i          sa,
+		     __m128i          da)
+{
+    switch (factor)
+    {
+    case ONE:
+	return data;
+
+    case SRC_ALPHA:
+	return pix_multiply_16_128 (data, sa);
+
+    case DEST_ALPHA:
+	return pix_multiply_16_128 (data, da);
+
+    case INV_SA:
+	return pix_multiply_16_128 (data, negate_16_128 (sa));
+
+    case INV_DA:
+	return pix_multiply_16_128 (data, negate_16_128 (da));
+
+    default:
+	return _mm_setzero_si128 ();
+    }
+}
+
+static force_inline __m128i
+combine_16_128 (pixman_bool_t    component,
+		pixman_bool_t    has_mask,
+		combine_factor_t a,
+		combine_factor_t b,
+		__m128i          src,
+		__m128i          mask,
+		__m128i          dst)
+{
+    __m128i sa, da = expand_alpha_16_128 (dst);
+
+    if (!has_mask)
+    {
+	sa = expand_alpha_16_128 (src);
+    }
+    else if (component)
+    {
+	sa = pix_multiply_16_128 (mask, expand_alpha_16_128 (src));
+	src = pix_multiply_16_128 (src, mask);
+    }
+    else
+    {
+	src = pix_multiply_16_128 (src, expand_alpha_16_128 (mask));
+	sa = expand_alpha_16_128 (src);
+    }
+
+    return _mm_adds_epu16 (apply_factor_16_128 (a, src, sa, da),
+			   apply_factor_16_128 (b, dst, sa, da));
+}
+
+static force_inline void
+combine_64_inner (pixman_bool_t    component,
+		  pixman_bool_t    has_mask,
+		  combine_factor_t a,
+		  combine_factor_t b,
+		  uint64_t *       pd,
+		  const uint64_t * ps,
+		  const uint64_t * pm,
+		  int              w)
+{
+    __m128i m = _mm_setzero_si128 ();
+
+    while (w >= 2)
+    {
+	if (has_mask)
+	{
+	    m = load_128_unaligned ((__m128i *)pm);
+	    pm += 2;
+	}
+
+	_mm_storeu_si128 ((__m128i *)pd, combine_16_128 (
+			      component, has_mask, a, b,
+			      load_128_unaligned ((__m128i *)ps), m,
+			      load_128_unaligned ((__m128i *)pd)));
+
+	ps += 2;
+	pd += 2;
+	w -= 2;
+    }
+
+    if (w)
+    {
+	if (has_mask)
+	    m = _mm_loadl_epi64 ((__m128i *)pm);
+
+	_mm_storel_epi64 ((__m128i *)pd, combine_16_128 (
+			      component, has_mask, a, b,
+			      _mm_loadl_epi64 ((__m128i *)ps), m,
+			      _mm_loadl_epi64 ((__m128i *)pd)));
+    }
+}
+
+#define MAKE_COMBINER_64(name, component, a, b)				\
+    static void								\
+    sse2_combine_ ## name ## _64 (pixman_implementation_t *imp,		\
+				  pixman_op_t              op,		\
+				  uint64_t *               pd,		\
+				  const uint64_t *         ps,		\
+				  const uint64_t *         pm,		\
+				  int                      w)		\
+    {									\
+	if (pm)								\
+	    combine_64_inner (component, TRUE, a, b, pd, ps, pm, w);	\
+	else								\
+	    combine_64_inner (component, FALSE, a, b, pd, ps, pm, w);	\
+    }
+
+#define MAKE_PD_COMBINERS_64(name, a, b)				\
+    MAKE_COMBINER_64 (name ## _ca, TRUE, a, b)				\
+    MAKE_COMBINER_64 (name ## _u, FALSE, a, b)
+
+MAKE_PD_COMBINERS_64 (src,			ONE,				ZERO)
+MAKE_PD_COMBINERS_64 (over,			ONE,				INV_SA)
+MAKE_PD_COMBINERS_64 (over_reverse,		INV_DA,				ONE)
+MAKE_PD_COMBINERS_64 (in,			DEST_ALPHA,			ZERO)
+MAKE_PD_COMBINERS_64 (in_reverse,		ZERO,				SRC_ALPHA)
+MAKE_PD_COMBINERS_64 (out,			INV_DA,				ZERO)
+MAKE_PD_COMBINERS_64 (out_reverse,		ZERO,				INV_SA)
+MAKE_PD_COMBINERS_64 (atop,			DEST_ALPHA,			INV_SA)
+MAKE_PD_COMBINERS_64 (atop_reverse,		INV_DA,				SRC_ALPHA)
+MAKE_PD_COMBINERS_64 (xor,			INV_DA,				INV_SA)
+MAKE_PD_COMBINERS_64 (add,			ONE,				ONE)
+
 static force_inline __m128i
 create_mask_16_128 (uint16_t mask)
 {
@@ -4794,389 +4966,584 @@ sse2_blt (pixman_implementation_t *imp,
     return TRUE;
 }
 
-static void
-sse2_composite_copy_area (pixman_implementation_t *imp,
-                          pixman_composite_info_t *info)
-{
-    PIXMAN_COMPOSITE_ARGS (info);
-    sse2_blt (imp, src_image->bits.bits,
-	      dest_image->bits.bits,
-	      src_image->bits.rowstride,
-	      dest_image->bits.rowstride,
-	      PIXMAN_FORMAT_BPP (src_image->bits.format),
-	      PIXMAN_FORMAT_BPP (dest_image->bits.format),
-	      src_x, src_y, dest_x, dest_y, width, height);
-}
+/* Conversions between the 32 bpp formats with 8 bit channels and
+ * r5g6b5, a8 and a2r10g10b10 style formats. What alpha_shift means
+ * depends on the conversion; -1 means that the source has no alpha.
+ */
+typedef void (* convert_line_t) (uint8_t *       dst,
+				 const uint8_t * src,
+				 int             width,
+				 int             alpha_shift);
 
 static void
-sse2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
-                                 pixman_composite_info_t *info)
+convert_line_0565_8888 (uint8_t *dst, const uint8_t *src, int width, int alpha_shift)
 {
-    PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t    *src, *src_line, s;
-    uint32_t    *dst, *dst_line, d;
-    uint8_t         *mask, *mask_line;
-    int src_stride, mask_stride, dst_stride;
-    int32_t w;
-    __m128i ms;
-
-    __m128i xmm_src, xmm_src_lo, xmm_src_hi;
-    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+    const uint16_t *s = (const uint16_t *)src;
+    uint32_t *d = (uint32_t *)dst;
 
-    PIXMAN_IMAGE_GET_LINE (
-	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
-    PIXMAN_IMAGE_GET_LINE (
-	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
-    PIXMAN_IMAGE_GET_LINE (
-	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
-
-    while (height--)
+    while (width >= 8)
     {
-        src = src_line;
-        src_line += src_stride;
-        dst = dst_line;
-        dst_line += dst_stride;
-        mask = mask_line;
-        mask_line += mask_stride;
-
-        w = width;
+	__m128i p = load_128_unaligned ((__m128i *)s);
+	__m128i lo = _mm_unpacklo_epi16 (p, _mm_setzero_si128 ());
+	__m128i hi = _mm_unpackhi_epi16 (p, _mm_setzero_si128 ());
 
-        while (w && (uintptr_t)dst & 15)
-        {
-            uint8_t m = *mask++;
-            s = 0xff000000 | *src++;
-            d = *dst;
-            ms = unpack_32_1x128 (s);
+	lo = _mm_or_si128 (unpack_565_to_8888 (lo), mask_ff000000);
+	hi = _mm_or_si128 (unpack_565_to_8888 (hi), mask_ff000000);
 
-            if (m != 0xff)
-            {
-		__m128i ma = expand_alpha_rev_1x128 (unpack_32_1x128 (m));
-		__m128i md = unpack_32_1x128 (d);
+	_mm_storeu_si128 ((__m128i *)d, lo);
+	_mm_storeu_si128 ((__m128i *)(d + 4), hi);
 
-                ms = in_over_1x128 (&ms, &mask_00ff, &ma, &md);
-            }
+	s += 8;
+	d += 8;
+	width -= 8;
+    }
 
-            *dst++ = pack_1x128_32 (ms);
-            w--;
-        }
+    while (width--)
+	*d++ = convert_0565_to_8888 (*s++);
+}
 
-        while (w >= 4)
-        {
-            uint32_t m;
-            memcpy(&m, mask, sizeof(uint32_t));
-            xmm_src = _mm_or_si128 (
-		load_128_unaligned ((__m128i*)src), mask_ff000000);
+static void
+convert_line_8888_0565 (uint8_t *dst, const uint8_t *src, int width, int alpha_shift)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint16_t *d = (uint16_t *)dst;
 
-            if (m == 0xffffffff)
-            {
-                save_128_aligned ((__m128i*)dst, xmm_src);
-            }
-            else
-            {
-                xmm_dst = load_128_aligned ((__m128i*)dst);
+    while (width >= 8)
+    {
+	__m128i lo = load_128_unaligned ((__m128i *)s);
+	__m128i hi = load_128_unaligned ((__m128i *)(s + 4));
 
-                xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+	_mm_storeu_si128 ((__m128i *)d, pack_565_2packedx128_128 (lo, hi));
 
-                unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-                unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
-                unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+	s += 8;
+	d += 8;
+	width -= 8;
+    }
 
-                expand_alpha_rev_2x128 (
-		    xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+    while (width--)
+	*d++ = convert_8888_to_0565 (*s++);
+}
 
-                in_over_2x128 (&xmm_src_lo, &xmm_src_hi,
-			       &mask_00ff, &mask_00ff, &xmm_mask_lo, &xmm_mask_hi,
-			       &xmm_dst_lo, &xmm_dst_hi);
+/* alpha_shift is where alpha goes in the destination */
+static void
+convert_line_a8_8888 (uint8_t *dst, const uint8_t *src, int width, int alpha_shift)
+{
+    __m128i shift = _mm_cvtsi32_si128 (alpha_shift);
+    __m128i zero = _mm_setzero_si128 ();
+    uint32_t *d = (uint32_t *)dst;
 
-                save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-            }
+    while (width >= 16)
+    {
+	__m128i p = load_128_unaligned ((__m128i *)src);
+	__m128i lo = _mm_unpacklo_epi8 (p, zero);
+	__m128i hi = _mm_unpackhi_epi8 (p, zero);
 
-            src += 4;
-            dst += 4;
-            mask += 4;
-            w -= 4;
-        }
+	_mm_storeu_si128 ((__m128i *)d + 0,
+			  _mm_sll_epi32 (_mm_unpacklo_epi16 (lo, zero), shift));
+	_mm_storeu_si128 ((__m128i *)d + 1,
+			  _mm_sll_epi32 (_mm_unpackhi_epi16 (lo, zero), shift));
+	_mm_storeu_si128 ((__m128i *)d + 2,
+			  _mm_sll_epi32 (_mm_unpacklo_epi16 (hi, zero), shift));
+	_mm_storeu_si128 ((__m128i *)d + 3,
+			  _mm_sll_epi32 (_mm_unpackhi_epi16 (hi, zero), shift));
 
-        while (w)
-        {
-            uint8_t m = *mask++;
+	src += 16;
+	d += 16;
+	width -= 16;
+    }
 
-            if (m)
-            {
-                s = 0xff000000 | *src;
+    while (width--)
+	*d++ = (uint32_t)*src++ << alpha_shift;
+}
 
-                if (m == 0xff)
-                {
-                    *dst = s;
-                }
-                else
-                {
-		    __m128i ma, md, ms;
+static void
+convert_line_8888_a8 (uint8_t *dst, const uint8_t *src, int width, int alpha_shift)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    __m128i shift = _mm_cvtsi32_si128 (alpha_shift);
+    __m128i mask = _mm_set1_epi32 (0xff);
 
-                    d = *dst;
+    if (alpha_shift < 0)
+    {
+	memset (dst, 0xff, width);
+	return;
+    }
 
-		    ma = expand_alpha_rev_1x128 (unpack_32_1x128 (m));
-		    md = unpack_32_1x128 (d);
-		    ms = unpack_32_1x128 (s);
+    while (width >= 16)
+    {
+	__m128i p0 = load_128_unaligned ((__m128i *)s + 0);
+	__m128i p1 = load_128_unaligned ((__m128i *)s + 1);
+	__m128i p2 = load_128_unaligned ((__m128i *)s + 2);
+	__m128i p3 = load_128_unaligned ((__m128i *)s + 3);
 
-                    *dst = pack_1x128_32 (in_over_1x128 (&ms, &mask_00ff, &ma, &md));
-                }
+	p0 = _mm_and_si128 (_mm_srl_epi32 (p0, shift), mask);
+	p1 = _mm_and_si128 (_mm_srl_epi32 (p1, shift), mask);
+	p2 = _mm_and_si128 (_mm_srl_epi32 (p2, shift), mask);
+	p3 = _mm_and_si128 (_mm_srl_epi32 (p3, shift), mask);
 
-            }
+	_mm_storeu_si128 ((__m128i *)dst,
+			  _mm_packus_epi16 (_mm_packs_epi32 (p0, p1),
+					    _mm_packs_epi32 (p2, p3)));
 
-            src++;
-            dst++;
-            w--;
-        }
+	s += 16;
+	dst += 16;
+	width -= 16;
     }
 
+    while (width--)
+	*dst++ = *s++ >> alpha_shift;
 }
 
-static void
-sse2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
-                                 pixman_composite_info_t *info)
+/* The wide iterators go through floats when converting to or from
+ * 10 bit channels, so this does the same, in the same way, to get
+ * identical results.
+ */
+static force_inline __m128i
+convert_unorm_1x128 (__m128i p, int shift, int bits, int new_shift, int new_bits)
 {
-    PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t    *src, *src_line, s;
-    uint32_t    *dst, *dst_line, d;
-    uint8_t         *mask, *mask_line;
-    int src_stride, mask_stride, dst_stride;
-    int32_t w;
+    __m128i u = _mm_and_si128 (_mm_srli_epi32 (p, shift),
+			       _mm_set1_epi32 ((1 << bits) - 1));
+    __m128 f = _mm_mul_ps (_mm_cvtepi32_ps (u),
+			   _mm_set1_ps (1.f / (float)((1 << bits) - 1)));
 
-    __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
-    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+    f = _mm_min_ps (f, _mm_set1_ps (1.f));
+    u = _mm_cvttps_epi32 (_mm_mul_ps (f, _mm_set1_ps (1 << new_bits)));
+    u = _mm_sub_epi32 (u, _mm_srli_epi32 (u, new_bits));
 
-    PIXMAN_IMAGE_GET_LINE (
-	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
-    PIXMAN_IMAGE_GET_LINE (
-	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
-    PIXMAN_IMAGE_GET_LINE (
-	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+    return _mm_slli_epi32 (u, new_shift);
+}
 
-    while (height--)
-    {
-        src = src_line;
-        src_line += src_stride;
-        dst = dst_line;
-        dst_line += dst_stride;
-        mask = mask_line;
-        mask_line += mask_stride;
+static force_inline __m128i
+convert_2101010_to_8888_1x128 (__m128i p, int alpha_shift)
+{
+    __m128i a = alpha_shift < 0 ?
+	mask_ff000000 : convert_unorm_1x128 (p, 30, 2, 24, 8);
 
-        w = width;
+    return _mm_or_si128 (
+	_mm_or_si128 (a, convert_unorm_1x128 (p, 20, 10, 16, 8)),
+	_mm_or_si128 (convert_unorm_1x128 (p, 10, 10, 8, 8),
+		      convert_unorm_1x128 (p, 0, 10, 0, 8)));
+}
 
-        while (w && (uintptr_t)dst & 15)
-        {
-	    uint32_t sa;
-            uint8_t m = *mask++;
+static force_inline __m128i
+convert_8888_to_2101010_1x128 (__m128i p, int alpha_shift)
+{
+    __m128i a = alpha_shift < 0 ?
+	_mm_set1_epi32 (0xc0000000) : convert_unorm_1x128 (p, 24, 8, 30, 2);
 
-            s = *src++;
-            d = *dst;
+    return _mm_or_si128 (
+	_mm_or_si128 (a, convert_unorm_1x128 (p, 16, 8, 20, 10)),
+	_mm_or_si128 (convert_unorm_1x128 (p, 8, 8, 10, 10),
+		      convert_unorm_1x128 (p, 0, 8, 0, 10)));
+}
 
-	    sa = s >> 24;
+#define CONVERT_LINE_32(name, convert)					\
+    static void								\
+    convert_line_ ## name (uint8_t *       dst,				\
+			   const uint8_t * src,				\
+			   int             width,			\
+			   int             alpha_shift)			\
+    {									\
+	const uint32_t *s = (const uint32_t *)src;			\
+	uint32_t *d = (uint32_t *)dst;					\
+									\
+	while (width >= 4)						\
+	{								\
+	    __m128i p = load_128_unaligned ((__m128i *)s);		\
+									\
+	    _mm_storeu_si128 ((__m128i *)d, convert (p, alpha_shift));	\
+									\
+	    s += 4;							\
+	    d += 4;							\
+	    width -= 4;							\
+	}								\
+									\
+	while (width--)							\
+	{								\
+	    __m128i p = _mm_cvtsi32_si128 (*s++);			\
+									\
+	    *d++ = _mm_cvtsi128_si32 (convert (p, alpha_shift));	\
+	}								\
+    }
+
+CONVERT_LINE_32 (2101010_8888, convert_2101010_to_8888_1x128)
+CONVERT_LINE_32 (8888_2101010, convert_8888_to_2101010_1x128)
 
-	    if (m)
-	    {
-		if (sa == 0xff && m == 0xff)
-		{
-		    *dst = s;
-		}
-		else
-		{
-		    __m128i ms, md, ma, msa;
+static pixman_bool_t
+is_8888 (pixman_format_code_t format)
+{
+    return PIXMAN_FORMAT_BPP (format) == 32		&&
+	   PIXMAN_FORMAT_R (format) == 8		&&
+	   PIXMAN_FORMAT_G (format) == 8		&&
+	   PIXMAN_FORMAT_B (format) == 8		&&
+	   (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB	||
+	    PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR	||
+	    PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_BGRA	||
+	    PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_RGBA);
+}
 
-		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		    ms = unpack_32_1x128 (s);
-		    md = unpack_32_1x128 (d);
+/* Alpha, or the unused byte, is the top byte for ARGB and ABGR, and
+ * the bottom one for BGRA and RGBA.
+ */
+static int
+alpha_position_8888 (pixman_format_code_t format)
+{
+    return (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB ||
+	    PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR) ? 24 : 0;
+}
 
-		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+/* A format with channels in the same order as an 8888 one, packed into
+ * bpp bits with r, g and b being r_bits, g_bits and b_bits wide.
+ */
+static pixman_bool_t
+is_packed_like (pixman_format_code_t format,
+		pixman_format_code_t format_8888,
+		int                  bpp,
+		int                  r_bits,
+		int                  g_bits,
+		int                  b_bits)
+{
+    return is_8888 (format_8888)					&&
+	   PIXMAN_FORMAT_TYPE (format) == PIXMAN_FORMAT_TYPE (format_8888) &&
+	   (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB	||
+	    PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR)	&&
+	   PIXMAN_FORMAT_BPP (format) == bpp				&&
+	   PIXMAN_FORMAT_R (format) == r_bits				&&
+	   PIXMAN_FORMAT_G (format) == g_bits				&&
+	   PIXMAN_FORMAT_B (format) == b_bits;
+}
 
-		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-		}
-	    }
+static pixman_bool_t
+sse2_convert (pixman_implementation_t *imp,
+	      pixman_format_code_t     src_format,
+	      const uint8_t *          src,
+	      int                      src_stride,
+	      pixman_format_code_t     dst_format,
+	      uint8_t *                dst,
+	      int                      dst_stride,
+	      int                      width,
+	      int                      height)
+{
+    convert_line_t convert_line;
+    int alpha_shift = -1;
 
-	    dst++;
-            w--;
-        }
+    if (is_packed_like (src_format, dst_format, 16, 5, 6, 5))
+    {
+	convert_line = convert_line_0565_8888;
+    }
+    else if (is_packed_like (dst_format, src_format, 16, 5, 6, 5))
+    {
+	convert_line = convert_line_8888_0565;
+    }
+    else if (is_packed_like (src_format, dst_format, 32, 10, 10, 10))
+    {
+	convert_line = convert_line_2101010_8888;
+	if (PIXMAN_FORMAT_A (src_format))
+	    alpha_shift = 30;
+    }
+    else if (is_packed_like (dst_format, src_format, 32, 10, 10, 10))
+    {
+	convert_line = convert_line_8888_2101010;
+	if (PIXMAN_FORMAT_A (src_format))
+	    alpha_shift = 24;
+    }
+    else if (src_format == PIXMAN_a8 && is_8888 (dst_format))
+    {
+	convert_line = convert_line_a8_8888;
+	alpha_shift = alpha_position_8888 (dst_format);
+    }
+    else if (is_8888 (src_format) && dst_format == PIXMAN_a8)
+    {
+	convert_line = convert_line_8888_a8;
+	if (PIXMAN_FORMAT_A (src_format))
+	    alpha_shift = alpha_position_8888 (src_format);
+    }
+    else
+    {
+	return FALSE;
+    }
 
-        while (w >= 4)
-        {
-            uint32_t m;
-            memcpy(&m, mask, sizeof(uint32_t));
+    while (height--)
+    {
+	convert_line (dst, src, width, alpha_shift);
 
-	    if (m)
-	    {
-		xmm_src = load_128_unaligned ((__m128i*)src);
+	src += src_stride;
+	dst += dst_stride;
+    }
 
-		if (m == 0xffffffff && is_opaque (xmm_src))
-		{
-		    save_128_aligned ((__m128i *)dst, xmm_src);
-		}
-		else
-		{
-		    xmm_dst = load_128_aligned ((__m128i *)dst);
+    return TRUE;
+}
 
-		    xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+/* Premultiplying and unpremultiplying. Four 8 bit pixels or two 16 bit
+ * ones are done at a time, and are left alone when they are all opaque.
+ * The results are the same as those of general_premultiply().
+ */
+static force_inline __m128i
+expand_alpha_8888_1x128 (__m128i data, int alpha_shift)
+{
+    if (alpha_shift)
+    {
+	data = _mm_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+	return _mm_shufflehi_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+    }
+    else
+    {
+	data = _mm_shufflelo_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0));
+	return _mm_shufflehi_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0));
+    }
+}
 
-		    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-		    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
-		    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+static force_inline __m128i
+premultiply_8888_4x128 (__m128i p, int alpha_shift)
+{
+    /* Alpha gets multiplied with 0xff, which leaves it unchanged */
+    __m128i alpha_ff = alpha_shift ?
+	_mm_set_epi16 (0xff, 0, 0, 0, 0xff, 0, 0, 0) :
+	_mm_set_epi16 (0, 0, 0, 0xff, 0, 0, 0, 0xff);
+    __m128i lo, hi, a_lo, a_hi;
 
-		    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
-		    expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+    unpack_128_2x128 (p, &lo, &hi);
 
-		    in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
-				   &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+    a_lo = _mm_or_si128 (expand_alpha_8888_1x128 (lo, alpha_shift), alpha_ff);
+    a_hi = _mm_or_si128 (expand_alpha_8888_1x128 (hi, alpha_shift), alpha_ff);
 
-		    save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-		}
-	    }
+    return pack_2x128_128 (pix_multiply_1x128 (lo, a_lo),
+			   pix_multiply_1x128 (hi, a_hi));
+}
 
-            src += 4;
-            dst += 4;
-            mask += 4;
-            w -= 4;
-        }
+static force_inline __m128i
+unpremultiply_8888_1x128 (__m128i p, uint32_t a, __m128 alpha_lane)
+{
+    __m128 f = _mm_or_ps (
+	_mm_andnot_ps (alpha_lane, _mm_set1_ps (_pixman_unpremultiply_factors[a])),
+	_mm_and_ps (alpha_lane, _mm_set1_ps (1.f)));
 
-        while (w)
-        {
-	    uint32_t sa;
-            uint8_t m = *mask++;
+    f = _mm_mul_ps (_mm_cvtepi32_ps (p), f);
+    f = _mm_add_ps (f, _mm_set1_ps (PIXMAN_UNPREMULTIPLY_BIAS));
 
-            s = *src++;
-            d = *dst;
+    return _mm_cvttps_epi32 (f);
+}
 
-	    sa = s >> 24;
+static force_inline __m128i
+unpremultiply_8888_4x128 (__m128i p, const uint32_t *s, int alpha_shift)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    __m128 alpha_lane = _mm_castsi128_ps (
+	alpha_shift ? _mm_set_epi32 (-1, 0, 0, 0) : _mm_set_epi32 (0, 0, 0, -1));
+    __m128i lo, hi, p0, p1, p2, p3;
+
+    unpack_128_2x128 (p, &lo, &hi);
+
+    p0 = unpremultiply_8888_1x128 (_mm_unpacklo_epi16 (lo, zero),
+				   (s[0] >> alpha_shift) & 0xff, alpha_lane);
+    p1 = unpremultiply_8888_1x128 (_mm_unpackhi_epi16 (lo, zero),
+				   (s[1] >> alpha_shift) & 0xff, alpha_lane);
+    p2 = unpremultiply_8888_1x128 (_mm_unpacklo_epi16 (hi, zero),
+				   (s[2] >> alpha_shift) & 0xff, alpha_lane);
+    p3 = unpremultiply_8888_1x128 (_mm_unpackhi_epi16 (hi, zero),
+				   (s[3] >> alpha_shift) & 0xff, alpha_lane);
+
+    /* Saturates channels that were larger than alpha */
+    return _mm_packus_epi16 (_mm_packs_epi32 (p0, p1), _mm_packs_epi32 (p2, p3));
+}
 
-	    if (m)
-	    {
-		if (sa == 0xff && m == 0xff)
-		{
-		    *dst = s;
-		}
-		else
-		{
-		    __m128i ms, md, ma, msa;
+static void
+premultiply_line_8888 (uint32_t *       d,
+		       const uint32_t * s,
+		       int              width,
+		       int              alpha_shift,
+		       pixman_bool_t    unpremultiply)
+{
+    /* Everything but alpha */
+    __m128i alpha_mask = _mm_set1_epi32 (~(0xffu << alpha_shift));
 
-		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		    ms = unpack_32_1x128 (s);
-		    md = unpack_32_1x128 (d);
+    while (width >= 4)
+    {
+	__m128i p = load_128_unaligned ((__m128i *)s);
+	__m128i opaque = _mm_cmpeq_epi32 (_mm_or_si128 (p, alpha_mask),
+					  _mm_set1_epi32 (-1));
 
-		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+	if (_mm_movemask_epi8 (opaque) != 0xffff)
+	{
+	    p = unpremultiply ?
+		unpremultiply_8888_4x128 (p, s, alpha_shift) :
+		premultiply_8888_4x128 (p, alpha_shift);
+	}
 
-		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-		}
-	    }
+	_mm_storeu_si128 ((__m128i *)d, p);
 
-	    dst++;
-            w--;
-        }
+	s += 4;
+	d += 4;
+	width -= 4;
     }
 
-}
+    while (width--)
+    {
+	__m128i p = _mm_cvtsi32_si128 (*s);
 
-static void
-sse2_composite_over_reverse_n_8888 (pixman_implementation_t *imp,
-				    pixman_composite_info_t *info)
-{
-    PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t src;
-    uint32_t    *dst_line, *dst;
-    __m128i xmm_src;
-    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-    __m128i xmm_dsta_hi, xmm_dsta_lo;
-    int dst_stride;
-    int32_t w;
+	if (unpremultiply)
+	{
+	    uint32_t a = (*s >> alpha_shift) & 0xff;
+	    __m128 alpha_lane = _mm_castsi128_ps (
+		alpha_shift ? _mm_set_epi32 (-1, 0, 0, 0) : _mm_set_epi32 (0, 0, 0, -1));
 
-    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+	    p = _mm_unpacklo_epi16 (unpack_32_1x128 (*s), _mm_setzero_si128 ());
+	    p = unpremultiply_8888_1x128 (p, a, alpha_lane);
+	    p = _mm_packus_epi16 (_mm_packs_epi32 (p, p), p);
+	}
+	else
+	{
+	    p = premultiply_8888_4x128 (p, alpha_shift);
+	}
 
-    if (src == 0)
-	return;
+	*d++ = _mm_cvtsi128_si32 (p);
+	s++;
+    }
+}
 
-    PIXMAN_IMAGE_GET_LINE (
-	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+static force_inline __m128i
+unpremultiply_16161616_1x128 (__m128i p, uint32_t a)
+{
+    __m128d f = _mm_set1_pd (a ? 65535.0 / a : 0.0);
+    __m128d bias = _mm_set1_pd (0.5 + 1.0 / (1 << 20));
+    __m128d max = _mm_set1_pd (65535.0);
+    __m128d rg = _mm_cvtepi32_pd (p);
+    __m128d ba = _mm_cvtepi32_pd (_mm_srli_si128 (p, 8));
 
-    xmm_src = expand_pixel_32_1x128 (src);
+    rg = _mm_min_pd (_mm_add_pd (_mm_mul_pd (rg, f), bias), max);
+    ba = _mm_min_pd (_mm_add_pd (_mm_mul_pd (ba, f), bias), max);
 
-    while (height--)
-    {
-	dst = dst_line;
+    return _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (rg), _mm_cvttpd_epi32 (ba));
+}
 
-	dst_line += dst_stride;
-	w = width;
+static void
+premultiply_line_16161616 (uint64_t *       d,
+			   const uint64_t * s,
+			   int              width,
+			   pixman_bool_t    unpremultiply)
+{
+    __m128i alpha_mask = _mm_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0);
 
-	while (w && (uintptr_t)dst & 15)
-	{
-	    __m128i vd;
+    while (width > 0)
+    {
+	__m128i p, a, opaque;
 
-	    vd = unpack_32_1x128 (*dst);
+	if (width >= 2)
+	    p = load_128_unaligned ((__m128i *)s);
+	else
+	    p = _mm_loadl_epi64 ((__m128i *)s);
 
-	    *dst = pack_1x128_32 (over_1x128 (vd, expand_alpha_1x128 (vd),
-					      xmm_src));
-	    w--;
-	    dst++;
-	}
+	a = expand_alpha_16_128 (p);
+	opaque = _mm_cmpeq_epi16 (_mm_or_si128 (p, negate_16_128 (alpha_mask)),
+				  _mm_set1_epi16 (-1));
 
-	while (w >= 4)
+	if (_mm_movemask_epi8 (opaque) != 0xffff)
 	{
-	    __m128i tmp_lo, tmp_hi;
+	    __m128i color;
 
-	    xmm_dst = load_128_aligned ((__m128i*)dst);
+	    if (unpremultiply)
+	    {
+		/* With the wide channels, there is no table, and
+		 * the reciprocal is computed for every pixel.
+		 */
+		__m128i lo = unpremultiply_16161616_1x128 (
+		    _mm_unpacklo_epi16 (p, _mm_setzero_si128 ()), s[0] >> 48);
+		__m128i hi = unpremultiply_16161616_1x128 (
+		    _mm_unpackhi_epi16 (p, _mm_setzero_si128 ()),
+		    width >= 2 ? s[1] >> 48 : 0);
+
+		/* Simulates _mm_packus_epi32 */
+		lo = _mm_srai_epi32 (_mm_slli_epi32 (lo, 16), 16);
+		hi = _mm_srai_epi32 (_mm_slli_epi32 (hi, 16), 16);
+		color = _mm_packs_epi32 (lo, hi);
+	    }
+	    else
+	    {
+		color = pix_multiply_16_128 (p, a);
+	    }
 
-	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
-	    expand_alpha_2x128 (xmm_dst_lo, xmm_dst_hi, &xmm_dsta_lo, &xmm_dsta_hi);
+	    p = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, color),
+			      _mm_and_si128 (alpha_mask, p));
+	}
 
-	    tmp_lo = xmm_src;
-	    tmp_hi = xmm_src;
+	if (width >= 2)
+	    _mm_storeu_si128 ((__m128i *)d, p);
+	else
+	    _mm_storel_epi64 ((__m128i *)d, p);
 
-	    over_2x128 (&xmm_dst_lo, &xmm_dst_hi,
-			&xmm_dsta_lo, &xmm_dsta_hi,
-			&tmp_lo, &tmp_hi);
+	s += 2;
+	d += 2;
+	width -= 2;
+    }
+}
 
-	    save_128_aligned (
-		(__m128i*)dst, pack_2x128_128 (tmp_lo, tmp_hi));
+static pixman_bool_t
+sse2_premultiply (pixman_implementation_t *imp,
+		  pixman_format_code_t     format,
+		  const uint8_t *          src,
+		  int                      src_stride,
+		  uint8_t *                dst,
+		  int                      dst_stride,
+		  int                      width,
+		  int                      height,
+		  pixman_bool_t            unpremultiply)
+{
+    int alpha_shift = alpha_position_8888 (format);
 
-	    w -= 4;
-	    dst += 4;
+    while (height--)
+    {
+	if (PIXMAN_FORMAT_BPP (format) == 64)
+	{
+	    premultiply_line_16161616 ((uint64_t *)dst, (const uint64_t *)src,
+				       width, unpremultiply);
 	}
-
-	while (w)
+	else
 	{
-	    __m128i vd;
-
-	    vd = unpack_32_1x128 (*dst);
-
-	    *dst = pack_1x128_32 (over_1x128 (vd, expand_alpha_1x128 (vd),
-					      xmm_src));
-	    w--;
-	    dst++;
+	    premultiply_line_8888 ((uint32_t *)dst, (const uint32_t *)src,
+				   width, alpha_shift, unpremultiply);
 	}
 
+	src += src_stride;
+	dst += dst_stride;
     }
 
+    return TRUE;
 }
 
 static void
-sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
-				    pixman_composite_info_t *info)
+sse2_composite_copy_area (pixman_implementation_t *imp,
+                          pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    sse2_blt (imp, src_image->bits.bits,
+	      dest_image->bits.bits,
+	      src_image->bits.rowstride,
+	      dest_image->bits.rowstride,
+	      PIXMAN_FORMAT_BPP (src_image->bits.format),
+	      PIXMAN_FORMAT_BPP (dest_image->bits.format),
+	      src_x, src_y, dest_x, dest_y, width, height);
+}
+
+static void
+sse2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
+                                 pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
     uint32_t    *src, *src_line, s;
     uint32_t    *dst, *dst_line, d;
-    uint32_t    *mask, *mask_line;
-    uint32_t    m;
+    uint8_t         *mask, *mask_line;
     int src_stride, mask_stride, dst_stride;
     int32_t w;
+    __m128i ms;
 
-    __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+    __m128i xmm_src, xmm_src_lo, xmm_src_hi;
     __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
     __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
 
     PIXMAN_IMAGE_GET_LINE (
 	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
     PIXMAN_IMAGE_GET_LINE (
-	mask_image, mask_x, mask_y, uint32_t, mask_stride, mask_line, 1);
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
     PIXMAN_IMAGE_GET_LINE (
 	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
 
@@ -5193,47 +5560,172 @@ sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
 
         while (w && (uintptr_t)dst & 15)
         {
-	    uint32_t sa;
-
-            s = *src++;
-            m = (*mask++) >> 24;
+            uint8_t m = *mask++;
+            s = 0xff000000 | *src++;
             d = *dst;
+            ms = unpack_32_1x128 (s);
 
-	    sa = s >> 24;
-
-	    if (m)
-	    {
-		if (sa == 0xff && m == 0xff)
-		{
-		    *dst = s;
-		}
-		else
-		{
-		    __m128i ms, md, ma, msa;
-
-		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		    ms = unpack_32_1x128 (s);
-		    md = unpack_32_1x128 (d);
-
-		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+            if (m != 0xff)
+            {
+		__m128i ma = expand_alpha_rev_1x128 (unpack_32_1x128 (m));
+		__m128i md = unpack_32_1x128 (d);
 
-		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-		}
-	    }
+                ms = in_over_1x128 (&ms, &mask_00ff, &ma, &md);
+            }
 
-	    dst++;
+            *dst++ = pack_1x128_32 (ms);
             w--;
         }
 
         while (w >= 4)
         {
-	    xmm_mask = load_128_unaligned ((__m128i*)mask);
+            uint32_t m;
+            memcpy(&m, mask, sizeof(uint32_t));
+            xmm_src = _mm_or_si128 (
+		load_128_unaligned ((__m128i*)src), mask_ff000000);
 
-	    if (!is_transparent (xmm_mask))
+            if (m == 0xffffffff)
+            {
+                save_128_aligned ((__m128i*)dst, xmm_src);
+            }
+            else
+            {
+                xmm_dst = load_128_aligned ((__m128i*)dst);
+
+                xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+
+                unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+                unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
+                unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+                expand_alpha_rev_2x128 (
+		    xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+
+                in_over_2x128 (&xmm_src_lo, &xmm_src_hi,
+			       &mask_00ff, &mask_00ff, &xmm_mask_lo, &xmm_mask_hi,
+			       &xmm_dst_lo, &xmm_dst_hi);
+
+                save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+            }
+
+            src += 4;
+            dst += 4;
+            mask += 4;
+            w -= 4;
+        }
+
+        while (w)
+        {
+            uint8_t m = *mask++;
+
+            if (m)
+            {
+                s = 0xff000000 | *src;
+
+                if (m == 0xff)
+                {
+                    *dst = s;
+                }
+                else
+                {
+		    __m128i ma, md, ms;
+
+                    d = *dst;
+
+		    ma = expand_alpha_rev_1x128 (unpack_32_1x128 (m));
+		    md = unpack_32_1x128 (d);
+		    ms = unpack_32_1x128 (s);
+
+                    *dst = pack_1x128_32 (in_over_1x128 (&ms, &mask_00ff, &ma, &md));
+                }
+
+            }
+
+            src++;
+            dst++;
+            w--;
+        }
+    }
+
+}
+
+static void
+sse2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
+                                 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *src, *src_line, s;
+    uint32_t    *dst, *dst_line, d;
+    uint8_t         *mask, *mask_line;
+    int src_stride, mask_stride, dst_stride;
+    int32_t w;
+
+    __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+        src = src_line;
+        src_line += src_stride;
+        dst = dst_line;
+        dst_line += dst_stride;
+        mask = mask_line;
+        mask_line += mask_stride;
+
+        w = width;
+
+        while (w && (uintptr_t)dst & 15)
+        {
+	    uint32_t sa;
+            uint8_t m = *mask++;
+
+            s = *src++;
+            d = *dst;
+
+	    sa = s >> 24;
+
+	    if (m)
+	    {
+		if (sa == 0xff && m == 0xff)
+		{
+		    *dst = s;
+		}
+		else
+		{
+		    __m128i ms, md, ma, msa;
+
+		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+		    ms = unpack_32_1x128 (s);
+		    md = unpack_32_1x128 (d);
+
+		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+		}
+	    }
+
+	    dst++;
+            w--;
+        }
+
+        while (w >= 4)
+        {
+            uint32_t m;
+            memcpy(&m, mask, sizeof(uint32_t));
+
+	    if (m)
 	    {
 		xmm_src = load_128_unaligned ((__m128i*)src);
 
-		if (is_opaque (xmm_mask) && is_opaque (xmm_src))
+		if (m == 0xffffffff && is_opaque (xmm_src))
 		{
 		    save_128_aligned ((__m128i *)dst, xmm_src);
 		}
@@ -5241,12 +5733,14 @@ sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
 		{
 		    xmm_dst = load_128_aligned ((__m128i *)dst);
 
+		    xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+
 		    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
 		    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
 		    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
 
 		    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
-		    expand_alpha_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+		    expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
 
 		    in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
 				   &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
@@ -5264,9 +5758,9 @@ sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
         while (w)
         {
 	    uint32_t sa;
+            uint8_t m = *mask++;
 
             s = *src++;
-            m = (*mask++) >> 24;
             d = *dst;
 
 	    sa = s >> 24;
@@ -5298,91 +5792,313 @@ sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
 
 }
 
-/* A variant of 'sse2_combine_over_u' with minor tweaks */
-static force_inline void
-scaled_nearest_scanline_sse2_8888_8888_OVER (uint32_t*       pd,
-                                             const uint32_t* ps,
-                                             int32_t         w,
-                                             pixman_fixed_t  vx,
-                                             pixman_fixed_t  unit_x,
-                                             pixman_fixed_t  src_width_fixed,
-                                             pixman_bool_t   fully_transparent_src)
+static void
+sse2_composite_over_reverse_n_8888 (pixman_implementation_t *imp,
+				    pixman_composite_info_t *info)
 {
-    uint32_t s, d;
-    const uint32_t* pm = NULL;
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t    *dst_line, *dst;
+    __m128i xmm_src;
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+    __m128i xmm_dsta_hi, xmm_dsta_lo;
+    int dst_stride;
+    int32_t w;
 
-    __m128i xmm_dst_lo, xmm_dst_hi;
-    __m128i xmm_src_lo, xmm_src_hi;
-    __m128i xmm_alpha_lo, xmm_alpha_hi;
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
-    if (fully_transparent_src)
+    if (src == 0)
 	return;
 
-    /* Align dst on a 16-byte boundary */
-    while (w && ((uintptr_t)pd & 15))
-    {
-	d = *pd;
-	s = combine1 (ps + pixman_fixed_to_int (vx), pm);
-	vx += unit_x;
-	while (vx >= 0)
-	    vx -= src_width_fixed;
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
 
-	*pd++ = core_combine_over_u_pixel_sse2 (s, d);
-	if (pm)
-	    pm++;
-	w--;
-    }
+    xmm_src = expand_pixel_32_1x128 (src);
 
-    while (w >= 4)
+    while (height--)
     {
-	__m128i tmp;
-	uint32_t tmp1, tmp2, tmp3, tmp4;
+	dst = dst_line;
 
-	tmp1 = *(ps + pixman_fixed_to_int (vx));
-	vx += unit_x;
-	while (vx >= 0)
-	    vx -= src_width_fixed;
-	tmp2 = *(ps + pixman_fixed_to_int (vx));
-	vx += unit_x;
-	while (vx >= 0)
-	    vx -= src_width_fixed;
-	tmp3 = *(ps + pixman_fixed_to_int (vx));
-	vx += unit_x;
-	while (vx >= 0)
-	    vx -= src_width_fixed;
-	tmp4 = *(ps + pixman_fixed_to_int (vx));
-	vx += unit_x;
-	while (vx >= 0)
-	    vx -= src_width_fixed;
+	dst_line += dst_stride;
+	w = width;
 
-	tmp = _mm_set_epi32 (tmp4, tmp3, tmp2, tmp1);
+	while (w && (uintptr_t)dst & 15)
+	{
+	    __m128i vd;
 
-	xmm_src_hi = combine4 ((__m128i*)&tmp, (__m128i*)pm);
+	    vd = unpack_32_1x128 (*dst);
 
-	if (is_opaque (xmm_src_hi))
-	{
-	    save_128_aligned ((__m128i*)pd, xmm_src_hi);
+	    *dst = pack_1x128_32 (over_1x128 (vd, expand_alpha_1x128 (vd),
+					      xmm_src));
+	    w--;
+	    dst++;
 	}
-	else if (!is_zero (xmm_src_hi))
+
+	while (w >= 4)
 	{
-	    xmm_dst_hi = load_128_aligned ((__m128i*) pd);
+	    __m128i tmp_lo, tmp_hi;
 
-	    unpack_128_2x128 (xmm_src_hi, &xmm_src_lo, &xmm_src_hi);
-	    unpack_128_2x128 (xmm_dst_hi, &xmm_dst_lo, &xmm_dst_hi);
+	    xmm_dst = load_128_aligned ((__m128i*)dst);
 
-	    expand_alpha_2x128 (
-		xmm_src_lo, xmm_src_hi, &xmm_alpha_lo, &xmm_alpha_hi);
+	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+	    expand_alpha_2x128 (xmm_dst_lo, xmm_dst_hi, &xmm_dsta_lo, &xmm_dsta_hi);
 
-	    over_2x128 (&xmm_src_lo, &xmm_src_hi,
-			&xmm_alpha_lo, &xmm_alpha_hi,
-			&xmm_dst_lo, &xmm_dst_hi);
+	    tmp_lo = xmm_src;
+	    tmp_hi = xmm_src;
 
-	    /* rebuid the 4 pixel data and save*/
-	    save_128_aligned ((__m128i*)pd,
-			      pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-	}
+	    over_2x128 (&xmm_dst_lo, &xmm_dst_hi,
+			&xmm_dsta_lo, &xmm_dsta_hi,
+			&tmp_lo, &tmp_hi);
 
-	w -= 4;
+	    save_128_aligned (
+		(__m128i*)dst, pack_2x128_128 (tmp_lo, tmp_hi));
+
+	    w -= 4;
+	    dst += 4;
+	}
+
+	while (w)
+	{
+	    __m128i vd;
+
+	    vd = unpack_32_1x128 (*dst);
+
+	    *dst = pack_1x128_32 (over_1x128 (vd, expand_alpha_1x128 (vd),
+					      xmm_src));
+	    w--;
+	    dst++;
+	}
+
+    }
+
+}
+
+static void
+sse2_composite_over_8888_8888_8888 (pixman_implementation_t *imp,
+				    pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *src, *src_line, s;
+    uint32_t    *dst, *dst_line, d;
+    uint32_t    *mask, *mask_line;
+    uint32_t    m;
+    int src_stride, mask_stride, dst_stride;
+    int32_t w;
+
+    __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint32_t, mask_stride, mask_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+        src = src_line;
+        src_line += src_stride;
+        dst = dst_line;
+        dst_line += dst_stride;
+        mask = mask_line;
+        mask_line += mask_stride;
+
+        w = width;
+
+        while (w && (uintptr_t)dst & 15)
+        {
+	    uint32_t sa;
+
+            s = *src++;
+            m = (*mask++) >> 24;
+            d = *dst;
+
+	    sa = s >> 24;
+
+	    if (m)
+	    {
+		if (sa == 0xff && m == 0xff)
+		{
+		    *dst = s;
+		}
+		else
+		{
+		    __m128i ms, md, ma, msa;
+
+		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+		    ms = unpack_32_1x128 (s);
+		    md = unpack_32_1x128 (d);
+
+		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+		}
+	    }
+
+	    dst++;
+            w--;
+        }
+
+        while (w >= 4)
+        {
+	    xmm_mask = load_128_unaligned ((__m128i*)mask);
+
+	    if (!is_transparent (xmm_mask))
+	    {
+		xmm_src = load_128_unaligned ((__m128i*)src);
+
+		if (is_opaque (xmm_mask) && is_opaque (xmm_src))
+		{
+		    save_128_aligned ((__m128i *)dst, xmm_src);
+		}
+		else
+		{
+		    xmm_dst = load_128_aligned ((__m128i *)dst);
+
+		    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+		    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
+		    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+		    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
+		    expand_alpha_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+
+		    in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
+				   &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+
+		    save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+		}
+	    }
+
+            src += 4;
+            dst += 4;
+            mask += 4;
+            w -= 4;
+        }
+
+        while (w)
+        {
+	    uint32_t sa;
+
+            s = *src++;
+            m = (*mask++) >> 24;
+            d = *dst;
+
+	    sa = s >> 24;
+
+	    if (m)
+	    {
+		if (sa == 0xff && m == 0xff)
+		{
+		    *dst = s;
+		}
+		else
+		{
+		    __m128i ms, md, ma, msa;
+
+		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+		    ms = unpack_32_1x128 (s);
+		    md = unpack_32_1x128 (d);
+
+		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+		}
+	    }
+
+	    dst++;
+            w--;
+        }
+    }
+
+}
+
+/* A variant of 'sse2_combine_over_u' with minor tweaks */
+static force_inline void
+scaled_nearest_scanline_sse2_8888_8888_OVER (uint32_t*       pd,
+                                             const uint32_t* ps,
+                                             int32_t         w,
+                                             pixman_fixed_t  vx,
+                                             pixman_fixed_t  unit_x,
+                                             pixman_fixed_t  src_width_fixed,
+                                             pixman_bool_t   fully_transparent_src)
+{
+    uint32_t s, d;
+    const uint32_t* pm = NULL;
+
+    __m128i xmm_dst_lo, xmm_dst_hi;
+    __m128i xmm_src_lo, xmm_src_hi;
+    __m128i xmm_alpha_lo, xmm_alpha_hi;
+
+    if (fully_transparent_src)
+	return;
+
+    /* Align dst on a 16-byte boundary */
+    while (w && ((uintptr_t)pd & 15))
+    {
+	d = *pd;
+	s = combine1 (ps + pixman_fixed_to_int (vx), pm);
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+
+	*pd++ = core_combine_over_u_pixel_sse2 (s, d);
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 4)
+    {
+	__m128i tmp;
+	uint32_t tmp1, tmp2, tmp3, tmp4;
+
+	tmp1 = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+	tmp2 = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+	tmp3 = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+	tmp4 = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+
+	tmp = _mm_set_epi32 (tmp4, tmp3, tmp2, tmp1);
+
+	xmm_src_hi = combine4 ((__m128i*)&tmp, (__m128i*)pm);
+
+	if (is_opaque (xmm_src_hi))
+	{
+	    save_128_aligned ((__m128i*)pd, xmm_src_hi);
+	}
+	else if (!is_zero (xmm_src_hi))
+	{
+	    xmm_dst_hi = load_128_aligned ((__m128i*) pd);
+
+	    unpack_128_2x128 (xmm_src_hi, &xmm_src_lo, &xmm_src_hi);
+	    unpack_128_2x128 (xmm_dst_hi, &xmm_dst_lo, &xmm_dst_hi);
+
+	    expand_alpha_2x128 (
+		xmm_src_lo, xmm_src_hi, &xmm_alpha_lo, &xmm_alpha_hi);
+
+	    over_2x128 (&xmm_src_lo, &xmm_src_hi,
+			&xmm_alpha_lo, &xmm_alpha_hi,
+			&xmm_dst_lo, &xmm_dst_hi);
+
+	    /* rebuid the 4 pixel data and save*/
+	    save_128_aligned ((__m128i*)pd,
+			      pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+	}
+
+	w -= 4;
 	pd += 4;
 	if (pm)
 	    pm += 4;
@@ -5935,234 +6651,2068 @@ scaled_bilinear_scanline_sse2_8888_8_8888_OVER (uint32_t *       dst,
 		ms = unpack_32_1x128 (pix1);
 		md = unpack_32_1x128 (pix2);
 
-		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+	    }
+	}
+	else
+	{
+	    BILINEAR_SKIP_ONE_PIXEL ();
+	}
+
+	w--;
+	dst++;
+    }
+
+    while (w >= 4)
+    {
+        uint32_t m;
+
+	__m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+	__m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+	__m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+
+        memcpy(&m, mask, sizeof(uint32_t));
+
+	if (m)
+	{
+	    BILINEAR_INTERPOLATE_FOUR_PIXELS (xmm_src);
+
+	    if (m == 0xffffffff && is_opaque (xmm_src))
+	    {
+		save_128_aligned ((__m128i *)dst, xmm_src);
+	    }
+	    else
+	    {
+		xmm_dst = load_128_aligned ((__m128i *)dst);
+
+		xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+
+		unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+		unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
+		unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+		expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
+		expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+
+		in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
+			       &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+
+		save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+	    }
+	}
+	else
+	{
+	    BILINEAR_SKIP_FOUR_PIXELS ();
+	}
+
+	w -= 4;
+	dst += 4;
+	mask += 4;
+    }
+
+    while (w)
+    {
+	uint32_t sa;
+	uint8_t m = *mask++;
+
+	if (m)
+	{
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
+	    sa = pix1 >> 24;
+
+	    if (sa == 0xff && m == 0xff)
+	    {
+		*dst = pix1;
+	    }
+	    else
+	    {
+		__m128i ms, md, ma, msa;
+
+		pix2 = *dst;
+		ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+		ms = unpack_32_1x128 (pix1);
+		md = unpack_32_1x128 (pix2);
+
+		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+	    }
+	}
+	else
+	{
+	    BILINEAR_SKIP_ONE_PIXEL ();
+	}
+
+	w--;
+	dst++;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_cover_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
+			       uint32_t, uint8_t, uint32_t,
+			       COVER, FLAG_HAVE_NON_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_pad_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
+			       uint32_t, uint8_t, uint32_t,
+			       PAD, FLAG_HAVE_NON_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_none_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
+			       uint32_t, uint8_t, uint32_t,
+			       NONE, FLAG_HAVE_NON_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_normal_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
+			       uint32_t, uint8_t, uint32_t,
+			       NORMAL, FLAG_HAVE_NON_SOLID_MASK)
+
+static force_inline void
+scaled_bilinear_scanline_sse2_8888_n_8888_OVER (uint32_t *       dst,
+						const uint32_t * mask,
+						const uint32_t * src_top,
+						const uint32_t * src_bottom,
+						int32_t          w,
+						int              wt,
+						int              wb,
+						pixman_fixed_t   vx_,
+						pixman_fixed_t   unit_x_,
+						pixman_fixed_t   max_vx,
+						pixman_bool_t    zero_src)
+{
+    intptr_t vx = vx_;
+    intptr_t unit_x = unit_x_;
+    BILINEAR_DECLARE_VARIABLES;
+    uint32_t pix1;
+    __m128i xmm_mask;
+
+    if (zero_src || (*mask >> 24) == 0)
+	return;
+
+    xmm_mask = create_mask_16_128 (*mask >> 24);
+
+    while (w && ((uintptr_t)dst & 15))
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
+	if (pix1)
+	{
+		uint32_t d = *dst;
+
+		__m128i ms = unpack_32_1x128 (pix1);
+		__m128i alpha     = expand_alpha_1x128 (ms);
+		__m128i dest      = xmm_mask;
+		__m128i alpha_dst = unpack_32_1x128 (d);
+
+		*dst = pack_1x128_32
+			(in_over_1x128 (&ms, &alpha, &dest, &alpha_dst));
+	}
+
+	dst++;
+	w--;
+    }
+
+    while (w >= 4)
+    {
+	__m128i xmm_src;
+	BILINEAR_INTERPOLATE_FOUR_PIXELS (xmm_src);
+
+	if (!is_zero (xmm_src))
+	{
+	    __m128i xmm_src_lo, xmm_src_hi;
+	    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+	    __m128i xmm_alpha_lo, xmm_alpha_hi;
+
+	    xmm_dst = load_128_aligned ((__m128i*)dst);
+
+	    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+	    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
+				&xmm_alpha_lo, &xmm_alpha_hi);
+
+	    in_over_2x128 (&xmm_src_lo, &xmm_src_hi,
+			   &xmm_alpha_lo, &xmm_alpha_hi,
+			   &xmm_mask, &xmm_mask,
+			   &xmm_dst_lo, &xmm_dst_hi);
+
+	    save_128_aligned
+		((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+	}
+
+	dst += 4;
+	w -= 4;
+    }
+
+    while (w)
+    {
+	BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
+	if (pix1)
+	{
+		uint32_t d = *dst;
+
+		__m128i ms = unpack_32_1x128 (pix1);
+		__m128i alpha     = expand_alpha_1x128 (ms);
+		__m128i dest      = xmm_mask;
+		__m128i alpha_dst = unpack_32_1x128 (d);
+
+		*dst = pack_1x128_32
+			(in_over_1x128 (&ms, &alpha, &dest, &alpha_dst));
+	}
+
+	dst++;
+	w--;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_cover_OVER,
+			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_HAVE_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_pad_OVER,
+			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_HAVE_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_none_OVER,
+			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NONE, FLAG_HAVE_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_normal_OVER,
+			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_HAVE_SOLID_MASK)
+
+/* YUV to RGB conversion, 8 pixels at a time. Each 16.16 coefficient is
+ * split into (hi << 16) + lo with both halves in 16 bits, so that
+ * _mm_madd_epi16() gives exactly the same results as convert_yuv_to_8888().
+ */
+typedef struct
+{
+    __m128i y_offset;
+    __m128i r_hi, r_lo;		/* (y, v) pairs */
+    __m128i g_hi, g_lo;		/* (y, u) pairs */
+    __m128i gv_hi, gv_lo;	/* (v, 0) pairs */
+    __m128i b_hi, b_lo;		/* (y, u) pairs */
+} sse2_yuv_coefficients_t;
+
+static void
+split_yuv_coefficient (int32_t c, int16_t *hi, int16_t *lo)
+{
+    int32_t h = (c + 0x8000) >> 16;
+
+    *hi = h;
+    *lo = c - h * 0x10000;
+}
+
+static force_inline __m128i
+create_yuv_pair_128 (int16_t a, int16_t b)
+{
+    return _mm_set_epi16 (b, a, b, a, b, a, b, a);
+}
+
+static void
+sse2_yuv_coefficients_init (sse2_yuv_coefficients_t         *k,
+			    const pixman_yuv_coefficients_t *c)
+{
+    int16_t y_hi, y_lo, rv_hi, rv_lo, gu_hi, gu_lo, gv_hi, gv_lo, bu_hi, bu_lo;
+
+    split_yuv_coefficient (c->y, &y_hi, &y_lo);
+    split_yuv_coefficient (c->rv, &rv_hi, &rv_lo);
+    split_yuv_coefficient (-c->gu, &gu_hi, &gu_lo);
+    split_yuv_coefficient (-c->gv, &gv_hi, &gv_lo);
+    split_yuv_coefficient (c->bu, &bu_hi, &bu_lo);
+
+    k->y_offset = _mm_set1_epi16 (c->y_offset);
+    k->r_hi = create_yuv_pair_128 (y_hi, rv_hi);
+    k->r_lo = create_yuv_pair_128 (y_lo, rv_lo);
+    k->g_hi = create_yuv_pair_128 (y_hi, gu_hi);
+    k->g_lo = create_yuv_pair_128 (y_lo, gu_lo);
+    k->gv_hi = create_yuv_pair_128 (gv_hi, 0);
+    k->gv_lo = create_yuv_pair_128 (gv_lo, 0);
+    k->b_hi = create_yuv_pair_128 (y_hi, bu_hi);
+    k->b_lo = create_yuv_pair_128 (y_lo, bu_lo);
+}
+
+static force_inline void
+madd_yuv_pair_128 (__m128i a, __m128i b, __m128i hi, __m128i lo,
+		   __m128i *sum0, __m128i *sum1)
+{
+    __m128i ab0 = _mm_unpacklo_epi16 (a, b);
+    __m128i ab1 = _mm_unpackhi_epi16 (a, b);
+
+    *sum0 = _mm_add_epi32 (_mm_slli_epi32 (_mm_madd_epi16 (ab0, hi), 16),
+			   _mm_madd_epi16 (ab0, lo));
+    *sum1 = _mm_add_epi32 (_mm_slli_epi32 (_mm_madd_epi16 (ab1, hi), 16),
+			   _mm_madd_epi16 (ab1, lo));
+}
+
+static force_inline __m128i
+pack_yuv_channel_128 (__m128i sum0, __m128i sum1)
+{
+    return _mm_packs_epi32 (_mm_srai_epi32 (sum0, 16), _mm_srai_epi32 (sum1, 16));
+}
+
+/* y, u and v are 8 16-bit values each, with the offsets subtracted */
+static force_inline void
+convert_yuv_8_to_8888 (uint32_t *dst, __m128i y, __m128i u, __m128i v,
+		       const sse2_yuv_coefficients_t *k)
+{
+    __m128i s0, s1, t0, t1;
+    __m128i r, g, b, br, ga, bg, ra;
+
+    madd_yuv_pair_128 (y, v, k->r_hi, k->r_lo, &s0, &s1);
+    r = pack_yuv_channel_128 (s0, s1);
+
+    madd_yuv_pair_128 (y, u, k->g_hi, k->g_lo, &s0, &s1);
+    madd_yuv_pair_128 (v, _mm_setzero_si128 (), k->gv_hi, k->gv_lo, &t0, &t1);
+    g = pack_yuv_channel_128 (_mm_add_epi32 (s0, t0), _mm_add_epi32 (s1, t1));
+
+    madd_yuv_pair_128 (y, u, k->b_hi, k->b_lo, &s0, &s1);
+    b = pack_yuv_channel_128 (s0, s1);
+
+    /* Saturating to bytes clamps the channels like the scalar code */
+    br = _mm_packus_epi16 (b, r);
+    ga = _mm_packus_epi16 (g, mask_00ff);
+    bg = _mm_unpacklo_epi8 (br, ga);
+    ra = _mm_unpackhi_epi8 (br, ga);
+
+    _mm_storeu_si128 ((__m128i *)(dst + 0), _mm_unpacklo_epi16 (bg, ra));
+    _mm_storeu_si128 ((__m128i *)(dst + 4), _mm_unpackhi_epi16 (bg, ra));
+}
+
+static void
+sse2_convert_yuv_line (uint32_t                        *dst,
+		       const pixman_yuv_line_t         *yuv,
+		       int                              x,
+		       int                              w,
+		       const pixman_yuv_coefficients_t *c,
+		       const sse2_yuv_coefficients_t   *k)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i mask_0080_16 = _mm_set1_epi16 (128);
+    __m128i mask_low_16 = _mm_set1_epi32 (0xffff);
+
+    /* Start on a pixel that has its own chroma sample */
+    if (w && (x & 1))
+    {
+	*dst++ = convert_yuv_line_to_8888 (c, yuv, x++);
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	const uint8_t *u = yuv->u + (x >> 1) * yuv->chroma_step;
+	const uint8_t *v = yuv->v + (x >> 1) * yuv->chroma_step;
+	__m128i yy, uu, vv;
+
+	yy = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *)(yuv->y + x)), zero);
+
+	if (yuv->chroma_step == 2)
+	{
+	    __m128i uv = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *)u), zero);
+
+	    uu = _mm_and_si128 (uv, mask_low_16);
+	    vv = _mm_srli_epi32 (uv, 16);
+	    uu = _mm_or_si128 (uu, _mm_slli_epi32 (uu, 16));
+	    vv = _mm_or_si128 (vv, _mm_slli_epi32 (vv, 16));
+	}
+	else
+	{
+	    int u4, v4;
+
+	    memcpy (&u4, u, 4);
+	    memcpy (&v4, v, 4);
+
+	    uu = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (u4), zero);
+	    vv = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (v4), zero);
+	    uu = _mm_unpacklo_epi16 (uu, uu);
+	    vv = _mm_unpacklo_epi16 (vv, vv);
+	}
+
+	convert_yuv_8_to_8888 (dst,
+			       _mm_sub_epi16 (yy, k->y_offset),
+			       _mm_sub_epi16 (uu, mask_0080_16),
+			       _mm_sub_epi16 (vv, mask_0080_16), k);
+
+	dst += 8;
+	x += 8;
+	w -= 8;
+    }
+
+    while (w--)
+	*dst++ = convert_yuv_line_to_8888 (c, yuv, x++);
+}
+
+static void
+sse2_composite_src_yuv_8888 (pixman_implementation_t *imp,
+			     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    const pixman_yuv_coefficients_t *c =
+	_pixman_yuv_get_coefficients (&src_image->bits);
+    sse2_yuv_coefficients_t k;
+    uint32_t *dst_line;
+    int dst_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    sse2_yuv_coefficients_init (&k, c);
+
+    while (height--)
+    {
+	pixman_yuv_line_t yuv;
+
+	_pixman_yuv_get_line (&src_image->bits, src_y++, &yuv);
+	sse2_convert_yuv_line (dst_line, &yuv, src_x, width, c, &k);
+
+	dst_line += dst_stride;
+    }
+}
+
+#define N_STACK_YUV_PIXELS 1024
+
+/* Bilinear scaling of a yv12, i420 or nv12 image that covers the
+ * destination. The two source lines that a destination line is
+ * interpolated from are converted to 8888 first, and then kept while
+ * consecutive destination lines use them.
+ */
+static void
+fast_composite_scaled_bilinear_sse2_yuv_8888_cover_SRC (pixman_implementation_t *imp,
+							 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    const pixman_yuv_coefficients_t *c =
+	_pixman_yuv_get_coefficients (&src_image->bits);
+    uint32_t stack_lines[2 * (N_STACK_YUV_PIXELS + 1)];
+    uint32_t *lines[2];
+    int line_y[2] = { -1, -1 };
+    sse2_yuv_coefficients_t k;
+    uint32_t *dst_line, *free_me = NULL;
+    int dst_stride;
+    pixman_vector_t v;
+    pixman_fixed_t vx, vy, unit_x, unit_y;
+    int x1, x2, n, i;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (src_x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (src_y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (src_image->common.transform, &v))
+	return;
+
+    unit_x = src_image->common.transform->matrix[0][0];
+    unit_y = src_image->common.transform->matrix[1][1];
+
+    vx = v.vector[0] - pixman_fixed_1 / 2;
+    vy = v.vector[1] - pixman_fixed_1 / 2;
+
+    /* The source columns that the destination lines sample */
+    x1 = pixman_fixed_to_int (vx);
+    x2 = pixman_fixed_to_int (vx + (width - 1) * (int64_t)unit_x);
+    if (x1 > x2)
+    {
+	int t = x1;
+
+	x1 = x2;
+	x2 = t;
+    }
+    x1 = MAX (x1, 0);
+    x2 = MIN (x2 + 1, src_image->bits.width - 1);
+    n = x2 - x1 + 1;
+
+    if (n <= N_STACK_YUV_PIXELS)
+    {
+	lines[0] = stack_lines;
+    }
+    else
+    {
+	lines[0] = free_me = pixman_malloc_ab (2 * (n + 1), sizeof (uint32_t));
+	if (!free_me)
+	    return;
+    }
+    lines[1] = lines[0] + n + 1;
+
+    sse2_yuv_coefficients_init (&k, c);
+
+    vx -= pixman_int_to_fixed (x1);
+
+    while (--height >= 0)
+    {
+	int y[2], weight1, weight2;
+	uint32_t *top = NULL, *bottom = NULL;
+
+	y[0] = pixman_fixed_to_int (vy);
+	weight2 = pixman_fixed_to_bilinear_weight (vy);
+	if (weight2)
+	{
+	    y[1] = MIN (y[0] + 1, src_image->bits.height - 1);
+	    weight1 = BILINEAR_INTERPOLATION_RANGE - weight2;
+	}
+	else
+	{
+	    y[1] = y[0];
+	    weight1 = weight2 = BILINEAR_INTERPOLATION_RANGE / 2;
+	}
+	vy += unit_y;
+
+	for (i = 0; i < 2; ++i)
+	{
+	    int slot;
+
+	    if (line_y[0] == y[i])
+	    {
+		slot = 0;
+	    }
+	    else if (line_y[1] == y[i])
+	    {
+		slot = 1;
+	    }
+	    else
+	    {
+		pixman_yuv_line_t yuv;
+
+		/* Don't replace the line that the other row needs */
+		slot = (i == 1 && line_y[0] == y[0]) ? 1 : 0;
+
+		_pixman_yuv_get_line (&src_image->bits, y[i], &yuv);
+		sse2_convert_yuv_line (lines[slot], &yuv, x1, n, c, &k);
+		lines[slot][n] = lines[slot][n - 1];
+		line_y[slot] = y[i];
+	    }
+
+	    if (i == 0)
+		top = lines[slot];
+	    else
+		bottom = lines[slot];
+	}
+
+	scaled_bilinear_scanline_sse2_8888_8888_SRC (
+	    dst_line, NULL, top, bottom, width, weight1, weight2,
+	    vx, unit_x, 0, FALSE);
+
+	dst_line += dst_stride;
+    }
+
+    free (free_me);
+}
+
+/* a8r8g8b8_sRGB. Pixels are converted to and from floats in a, r, g, b
+ * order, exactly like pixman-access.c does it, and composited like the
+ * float combiners, so the results match the general wide path.
+ */
+static force_inline __m128
+decode_srgb_8888 (uint32_t p)
+{
+    return _mm_set_ps (pixman_srgb_to_linear (p & 0xff),
+		       pixman_srgb_to_linear ((p >> 8) & 0xff),
+		       pixman_srgb_to_linear ((p >> 16) & 0xff),
+		       (p >> 24) * (1.f / 255.f));
+}
+
+static force_inline __m128
+unpack_8888_float (uint32_t p)
+{
+    __m128i v = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (p), _mm_setzero_si128 ());
+
+    v = _mm_unpacklo_epi16 (v, _mm_setzero_si128 ());
+
+    return _mm_mul_ps (_mm_cvtepi32_ps (_mm_shuffle_epi32 (v, _MM_SHUFFLE (0, 1, 2, 3))),
+		       _mm_set1_ps (1.f / 255.f));
+}
+
+/* The alpha is stored like pixman_float_to_unorm() does it, and the
+ * color channels like pixman_linear_to_srgb(): the table gives the value
+ * at the start of the bucket, and the comparison with the threshold
+ * adds the one that the value may be above it.
+ */
+static force_inline uint32_t
+encode_srgb_8888 (__m128 v)
+{
+    __m128 c = _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (1.0f));
+    __m128i n, s, t;
+    uint32_t a;
+    uint8_t r, g, b;
+
+    /* b, g, r, a from here on, which packs to the pixel directly */
+    c = _mm_shuffle_ps (c, c, _MM_SHUFFLE (0, 1, 2, 3));
+    n = _mm_cvttps_epi32 (_mm_mul_ps (c, _mm_set_ps (256.f, 4096.f, 4096.f, 4096.f)));
+
+    b = _pixman_linear_to_srgb_base[_mm_cvtsi128_si32 (n)];
+    g = _pixman_linear_to_srgb_base[_mm_extract_epi16 (n, 2)];
+    r = _pixman_linear_to_srgb_base[_mm_extract_epi16 (n, 4)];
+    a = _mm_extract_epi16 (n, 6);
+
+    s = _mm_set_epi32 (a - (a >> 8), r, g, b);
+    t = _mm_set_epi32 (0x7f800000,
+		       _pixman_linear_to_srgb_threshold[r],
+		       _pixman_linear_to_srgb_threshold[g],
+		       _pixman_linear_to_srgb_threshold[b]);
+
+    s = _mm_sub_epi32 (s, _mm_castps_si128 (_mm_cmpge_ps (c, _mm_castsi128_ps (t))));
+    s = _mm_packs_epi32 (s, s);
+
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (s, s));
+}
+
+/* r8g8b8_sRGB pixels are read as opaque a8r8g8b8_sRGB ones, which
+ * decode to an alpha of exactly 1.0 like the accessors give them.
+ */
+static force_inline uint32_t
+load_srgb (const uint8_t *p, int bpp)
+{
+    if (bpp == 3)
+	return p[0] | (p[1] << 8) | (p[2] << 16) | 0xff000000;
+    else
+	return *(uint32_t *)p;
+}
+
+static force_inline void
+store_srgb (uint8_t *p, int bpp, uint32_t v)
+{
+    if (bpp == 3)
+    {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+    }
+    else
+    {
+	*(uint32_t *)p = v;
+    }
+}
+
+static force_inline void
+composite_srgb_line (pixman_op_t     op,
+		     pixman_bool_t   srgb_src,
+		     int             src_bpp,
+		     int             dst_bpp,
+		     uint8_t        *dst,
+		     const uint8_t  *src,
+		     int             w)
+{
+    const __m128 one = _mm_set1_ps (1.0f);
+
+    while (w--)
+    {
+	uint32_t p = load_srgb (src, src_bpp);
+	__m128 s, d;
+
+	src += src_bpp;
+
+	/* The float combiners leave the destination as it is for a
+	 * transparent source, and decoding and encoding it doesn't
+	 * change it.
+	 */
+	if (op != PIXMAN_OP_SRC && p == 0)
+	{
+	    dst += dst_bpp;
+	    continue;
+	}
+
+	s = srgb_src ? decode_srgb_8888 (p) : unpack_8888_float (p);
+
+	if (op == PIXMAN_OP_OVER && p < 0xff000000)
+	{
+	    __m128 ia = _mm_sub_ps (one, _mm_shuffle_ps (s, s, _MM_SHUFFLE (0, 0, 0, 0)));
+
+	    d = decode_srgb_8888 (load_srgb (dst, dst_bpp));
+	    s = _mm_min_ps (one, _mm_add_ps (s, _mm_mul_ps (d, ia)));
+	}
+	else if (op == PIXMAN_OP_ADD)
+	{
+	    d = decode_srgb_8888 (load_srgb (dst, dst_bpp));
+	    s = _mm_min_ps (one, _mm_add_ps (s, d));
+	}
+
+	store_srgb (dst, dst_bpp, encode_srgb_8888 (s));
+	dst += dst_bpp;
+    }
+}
+
+static force_inline void
+composite_srgb (pixman_composite_info_t *info,
+		pixman_op_t              combine_op,
+		pixman_bool_t            srgb_src,
+		int                      src_bpp,
+		int                      dst_bpp)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, dst_bpp);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, src_bpp);
+
+    while (height--)
+    {
+	composite_srgb_line (combine_op, srgb_src, src_bpp, dst_bpp,
+			     dst_line, src_line, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+#define SRGB_FAST_PATH(name, op, srgb_src, src_bpp, dst_bpp)		\
+static void								\
+sse2_composite_ ## name (pixman_implementation_t *imp,			\
+			 pixman_composite_info_t *info)			\
+{									\
+    composite_srgb (info, PIXMAN_OP_ ## op, srgb_src, src_bpp, dst_bpp);	\
+}
+
+/* a8r8g8b8_sRGB destinations */
+SRGB_FAST_PATH (src_8888_srgb, SRC, FALSE, 4, 4)
+SRGB_FAST_PATH (over_8888_srgb, OVER, FALSE, 4, 4)
+SRGB_FAST_PATH (over_srgb_srgb, OVER, TRUE, 4, 4)
+SRGB_FAST_PATH (add_8888_srgb, ADD, FALSE, 4, 4)
+SRGB_FAST_PATH (add_srgb_srgb, ADD, TRUE, 4, 4)
+
+/* r8g8b8_sRGB sources and destinations. An r8g8b8_sRGB source is opaque,
+ * so OVER from it is the same as SRC.
+ */
+SRGB_FAST_PATH (src_8888_srgb24, SRC, FALSE, 4, 3)
+SRGB_FAST_PATH (over_8888_srgb24, OVER, FALSE, 4, 3)
+SRGB_FAST_PATH (add_8888_srgb24, ADD, FALSE, 4, 3)
+SRGB_FAST_PATH (src_srgb_srgb24, SRC, TRUE, 4, 3)
+SRGB_FAST_PATH (over_srgb_srgb24, OVER, TRUE, 4, 3)
+SRGB_FAST_PATH (add_srgb_srgb24, ADD, TRUE, 4, 3)
+SRGB_FAST_PATH (src_srgb24_srgb, SRC, TRUE, 3, 4)
+SRGB_FAST_PATH (add_srgb24_srgb, ADD, TRUE, 3, 4)
+SRGB_FAST_PATH (add_srgb24_srgb24, ADD, TRUE, 3, 3)
+
+/* a2r10g10b10, x2r10g10b10 and their BGR versions. Like the sRGB paths
+ * above, these go through floats in the same way as pixman-access.c and
+ * the float combiners, so the results are the same as those of the
+ * general wide path. The channels are in a, r, g, b order, or a, b, g, r
+ * for the BGR formats, which are composited with a8b8g8r8.
+ */
+static force_inline __m128
+unpack_2101010_float (uint32_t p, pixman_bool_t has_alpha)
+{
+    __m128i v = _mm_set_epi32 (p & 0x3ff, (p >> 10) & 0x3ff,
+			       (p >> 20) & 0x3ff, p >> 30);
+    __m128 f = _mm_mul_ps (_mm_cvtepi32_ps (v),
+			   _mm_set_ps (1.f / 1023.f, 1.f / 1023.f,
+				       1.f / 1023.f, 1.f / 3.f));
+
+    return has_alpha ? f : _mm_move_ss (f, _mm_set_ss (1.0f));
+}
+
+/* pixman_float_to_unorm() subtracts u >> n_bits, which only changes u
+ * when it is 1 << n_bits, so a minimum does the same.
+ */
+static force_inline uint32_t
+pack_2101010_float (__m128 v, pixman_bool_t has_alpha)
+{
+    __m128 c = _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (1.0f));
+    __m128i n = _mm_cvttps_epi32 (
+	_mm_mul_ps (c, _mm_set_ps (1024.f, 1024.f, 1024.f, 4.f)));
+    uint32_t p;
+
+    n = _mm_min_epi16 (n, _mm_set_epi32 (1023, 1023, 1023, 3));
+    n = _mm_packs_epi32 (n, n);
+
+    /* a << 10 | r and g << 10 | b */
+    n = _mm_madd_epi16 (n, _mm_set_epi16 (1, 1024, 1, 1024, 1, 1024, 1, 1024));
+    p = (_mm_cvtsi128_si32 (n) << 20) | _mm_cvtsi128_si32 (_mm_srli_si128 (n, 4));
+
+    return has_alpha ? p : p & 0x3fffffff;
+}
+
+static force_inline __m128
+over_float (__m128 s, __m128 d)
+{
+    __m128 ia = _mm_sub_ps (_mm_set1_ps (1.0f), _mm_shuffle_ps (s, s, _MM_SHUFFLE (0, 0, 0, 0)));
+
+    return _mm_min_ps (_mm_set1_ps (1.0f), _mm_add_ps (s, _mm_mul_ps (d, ia)));
+}
+
+static void
+sse2_composite_src_8888_2101010 (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+    int alpha_shift = PIXMAN_FORMAT_A (src_image->bits.format) ? 24 : -1;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	convert_line_8888_2101010 ((uint8_t *)dst_line, (uint8_t *)src_line,
+				   width, alpha_shift);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+sse2_composite_src_x2101010_2101010 (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t *dst_line, *dst, *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w >= 4)
+	{
+	    __m128i p = load_128_unaligned ((__m128i *)src);
+
+	    _mm_storeu_si128 ((__m128i *)dst,
+			      _mm_or_si128 (p, _mm_set1_epi32 (0xc0000000)));
+
+	    src += 4;
+	    dst += 4;
+	    w -= 4;
+	}
+
+	while (w--)
+	    *dst++ = *src++ | 0xc0000000;
+    }
+}
+
+/* A group of four opaque a8r8g8b8 pixels is stored like with SRC, and
+ * zero pixels leave the destination as it is, since decoding and encoding
+ * it doesn't change it.
+ */
+static force_inline void
+composite_over_2101010_line (uint32_t       *dst,
+			     const uint32_t *src,
+			     int             w,
+			     pixman_bool_t   src_2101010,
+			     pixman_bool_t   dest_alpha)
+{
+    while (w >= 4 && !src_2101010)
+    {
+	__m128i p = load_128_unaligned ((__m128i *)src);
+	int i;
+
+	if (is_opaque (p))
+	{
+	    _mm_storeu_si128 ((__m128i *)dst,
+			      convert_8888_to_2101010_1x128 (p, 24));
+	}
+	else if (!is_zero (p))
+	{
+	    for (i = 0; i < 4; ++i)
+	    {
+		__m128 d = unpack_2101010_float (dst[i], dest_alpha);
+
+		d = over_float (unpack_8888_float (src[i]), d);
+		dst[i] = pack_2101010_float (d, dest_alpha);
+	    }
+	}
+
+	src += 4;
+	dst += 4;
+	w -= 4;
+    }
+
+    while (w--)
+    {
+	uint32_t p = *src++;
+	__m128 s, d;
+
+	if (src_2101010)
+	{
+	    if (p == 0)
+	    {
+		dst++;
+		continue;
+	    }
+	    s = unpack_2101010_float (p, TRUE);
+	}
+	else
+	{
+	    s = unpack_8888_float (p);
+	}
+
+	d = unpack_2101010_float (*dst, dest_alpha);
+	*dst++ = pack_2101010_float (over_float (s, d), dest_alpha);
+    }
+}
+
+static force_inline void
+composite_over_2101010 (pixman_composite_info_t *info,
+			pixman_bool_t            src_2101010)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_bool_t dest_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) != 0;
+    uint32_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	composite_over_2101010_line (dst_line, src_line, width,
+				     src_2101010, dest_alpha);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+sse2_composite_over_8888_2101010 (pixman_implementation_t *imp,
+				  pixman_composite_info_t *info)
+{
+    composite_over_2101010 (info, FALSE);
+}
+
+static void
+sse2_composite_over_2101010_2101010 (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    composite_over_2101010 (info, TRUE);
+}
+
+static force_inline __m128
+get_solid_2101010 (pixman_implementation_t *imp,
+		   pixman_image_t *         image,
+		   pixman_format_code_t     format)
+{
+    argb_t c = _pixman_image_get_solid_float (imp, image, format);
+
+    return _mm_set_ps (c.b, c.g, c.r, c.a);
+}
+
+static void
+sse2_composite_src_n_2101010 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_format_code_t format = dest_image->bits.format;
+    __m128 s = get_solid_2101010 (imp, src_image, format);
+
+    sse2_fill (imp, dest_image->bits.bits, dest_image->bits.rowstride,
+	       32, dest_x, dest_y, width, height,
+	       pack_2101010_float (s, PIXMAN_FORMAT_A (format) != 0));
+}
+
+static void
+sse2_composite_over_n_2101010 (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_format_code_t format = dest_image->bits.format;
+    pixman_bool_t dest_alpha = PIXMAN_FORMAT_A (format) != 0;
+    __m128 s = get_solid_2101010 (imp, src_image, format);
+    uint32_t *dst_line, *dst;
+    int dst_stride;
+    int32_t w;
+
+    if (_mm_movemask_ps (_mm_cmpneq_ps (s, _mm_setzero_ps ())) == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	w = width;
+
+	while (w--)
+	{
+	    __m128 d = unpack_2101010_float (*dst, dest_alpha);
+
+	    *dst++ = pack_2101010_float (over_float (s, d), dest_alpha);
+	}
+    }
+}
+
+/* Bilinear scaling of a8r8g8b8 and x8r8g8b8, interpolated like
+ * bits_image_fetch_pixel_bilinear_float() does it, with the full
+ * precision of the coordinates.
+ */
+static force_inline __m128
+fetch_bilinear_8888_float (const uint32_t *row1,
+			   const uint32_t *row2,
+			   int             x1,
+			   int             x2,
+			   pixman_bool_t   x1_inside,
+			   pixman_bool_t   x2_inside,
+			   float           distx,
+			   float           disty,
+			   uint32_t        alpha)
+{
+    uint32_t tl = 0, tr = 0, bl = 0, br = 0;
+    float distxy, distxiy, distixy, distixiy;
+    __m128 r;
+
+    if (row1)
+    {
+	if (x1_inside)
+	    tl = row1[x1] | alpha;
+	if (x2_inside)
+	    tr = row1[x2] | alpha;
+    }
+    if (row2)
+    {
+	if (x1_inside)
+	    bl = row2[x1] | alpha;
+	if (x2_inside)
+	    br = row2[x2] | alpha;
+    }
+
+    distxy = distx * disty;
+    distxiy = distx * (1.f - disty);
+    distixy = (1.f - distx) * disty;
+    distixiy = (1.f - distx) * (1.f - disty);
+
+    r = _mm_mul_ps (unpack_8888_float (tl), _mm_set1_ps (distixiy));
+    r = _mm_add_ps (r, _mm_mul_ps (unpack_8888_float (tr), _mm_set1_ps (distxiy)));
+    r = _mm_add_ps (r, _mm_mul_ps (unpack_8888_float (bl), _mm_set1_ps (distixy)));
+    r = _mm_add_ps (r, _mm_mul_ps (unpack_8888_float (br), _mm_set1_ps (distxy)));
+
+    return r;
+}
+
+static force_inline void
+composite_bilinear_2101010 (pixman_implementation_t *imp,
+			    pixman_composite_info_t *info,
+			    pixman_op_t              combine_op)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    bits_image_t *src = &src_image->bits;
+    pixman_repeat_t repeat_mode = src->common.repeat;
+    pixman_bool_t dest_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) != 0;
+    uint32_t alpha = PIXMAN_FORMAT_A (src->format) ? 0 : 0xff000000;
+    pixman_fixed_t ux = src->common.transform->matrix[0][0];
+    uint32_t *dst_line, *dst;
+    int dst_stride;
+    int i, j;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	const uint32_t *row1 = NULL, *row2 = NULL;
+	pixman_vector_t v;
+	pixman_fixed_t x, y;
+	int y1, y2;
+	float disty;
+
+	dst = dst_line;
+	dst_line += dst_stride;
+
+	v.vector[0] = pixman_int_to_fixed (src_x) + pixman_fixed_1 / 2;
+	v.vector[1] = pixman_int_to_fixed (src_y + j) + pixman_fixed_1 / 2;
+	v.vector[2] = pixman_fixed_1;
+
+	if (!pixman_transform_point_3d (src->common.transform, &v))
+	    continue;
+
+	x = v.vector[0];
+	y = v.vector[1] - pixman_fixed_1 / 2;
+
+	disty = ((float)pixman_fixed_fraction (y)) / 65536.f;
+	y1 = pixman_fixed_to_int (y);
+	y2 = y1 + 1;
+
+	if (repeat (repeat_mode, &y1, src->height))
+	    row1 = src->bits + y1 * src->rowstride;
+	if (repeat (repeat_mode, &y2, src->height))
+	    row2 = src->bits + y2 * src->rowstride;
+
+	for (i = 0; i < width; ++i)
+	{
+	    pixman_fixed_t x1 = x - pixman_fixed_1 / 2;
+	    float distx = ((float)pixman_fixed_fraction (x1)) / 65536.f;
+	    int x2;
+	    pixman_bool_t x1_inside, x2_inside;
+	    __m128 s;
+
+	    x1 = pixman_fixed_to_int (x1);
+	    x2 = x1 + 1;
+	    x1_inside = repeat (repeat_mode, &x1, src->width);
+	    x2_inside = repeat (repeat_mode, &x2, src->width);
+
+	    s = fetch_bilinear_8888_float (row1, row2, x1, x2,
+					   x1_inside, x2_inside,
+					   distx, disty, alpha);
+
+	    if (combine_op == PIXMAN_OP_OVER)
+		s = over_float (s, unpack_2101010_float (*dst, dest_alpha));
+
+	    *dst++ = pack_2101010_float (s, dest_alpha);
+
+	    x += ux;
+	}
+    }
+}
+
+static void
+sse2_composite_scaled_bilinear_src_8888_2101010 (pixman_implementation_t *imp,
+						 pixman_composite_info_t *info)
+{
+    composite_bilinear_2101010 (imp, info, PIXMAN_OP_SRC);
+}
+
+static void
+sse2_composite_scaled_bilinear_over_8888_2101010 (pixman_implementation_t *imp,
+						  pixman_composite_info_t *info)
+{
+    composite_bilinear_2101010 (imp, info, PIXMAN_OP_OVER);
+}
+
+/* Dithering. The factors of a line repeat every DITHER_PERIOD pixels,
+ * so they are computed once per line with _pixman_dither_factor().
+ */
+static void
+get_dither_factors (bits_image_t *image, int x, int y, int width,
+		    float factors[DITHER_PERIOD])
+{
+    int i;
+
+    x += image->dither_offset_x;
+    y += image->dither_offset_y;
+
+    for (i = 0; i < width && i < DITHER_PERIOD; ++i)
+	factors[i] = _pixman_dither_factor (image->dither, x + i, y);
+}
+
+/* Two pixels with 16 bit channels. (2^n - 1) is q * 255 + r for each
+ * channel, which keeps the products below 65535.
+ */
+static force_inline __m128i
+dither_unorm_2x128 (__m128i c, __m128i t, __m128i q, __m128i r)
+{
+    __m128i x = _mm_add_epi16 (_mm_mullo_epi16 (c, r), t);
+
+    /* x / 255 */
+    x = _mm_add_epi16 (_mm_add_epi16 (x, _mm_set1_epi16 (1)), _mm_srli_epi16 (x, 8));
+
+    return _mm_add_epi16 (_mm_mullo_epi16 (c, q), _mm_srli_epi16 (x, 8));
+}
+
+/* The same as fast_composite_src_8888_0565_dither() and
+ * fast_composite_src_8888_2101010_dither() in pixman-fast-path.c
+ */
+static force_inline uint32_t
+dither_unorm (uint32_t c, int n_bits, uint32_t t)
+{
+    return (c * ((1 << n_bits) - 1) + t) / 255;
+}
+
+/* Four pixels; lo and hi get the channels of two each */
+static force_inline void
+dither_8888_4x128 (__m128i p, const uint16_t *thresholds, __m128i q, __m128i r,
+		   __m128i *lo, __m128i *hi)
+{
+    __m128i t = _mm_loadl_epi64 ((__m128i *)thresholds);
+
+    t = _mm_unpacklo_epi16 (t, t);
+
+    *lo = dither_unorm_2x128 (_mm_unpacklo_epi8 (p, _mm_setzero_si128 ()),
+			      _mm_unpacklo_epi32 (t, t), q, r);
+    *hi = dither_unorm_2x128 (_mm_unpackhi_epi8 (p, _mm_setzero_si128 ()),
+			      _mm_unpackhi_epi32 (t, t), q, r);
+}
+
+static void
+dither_line_8888_0565 (uint16_t *dst, const uint32_t *src,
+		       const uint16_t *thresholds, int width)
+{
+    /* Shifts the 5 and 6 bit values to where pack_565 expects them */
+    const __m128i to_8888 = _mm_set_epi16 (0, 8, 4, 8, 0, 8, 4, 8);
+    const __m128i r = _mm_set_epi16 (0, 31, 63, 31, 0, 31, 63, 31);
+    int i;
+
+    for (i = 0; i + 4 <= width; i += 4)
+    {
+	__m128i lo, hi, p;
+
+	dither_8888_4x128 (load_128_unaligned ((__m128i *)(src + i)),
+			   thresholds + (i & (DITHER_PERIOD - 1)),
+			   _mm_setzero_si128 (), r, &lo, &hi);
+
+	p = _mm_packus_epi16 (_mm_mullo_epi16 (lo, to_8888),
+			      _mm_mullo_epi16 (hi, to_8888));
+
+	_mm_storel_epi64 ((__m128i *)(dst + i), pack_565_2packedx128_128 (p, p));
+    }
+
+    for (; i < width; ++i)
+    {
+	uint32_t s = src[i];
+	uint32_t t = thresholds[i & (DITHER_PERIOD - 1)];
+
+	dst[i] = (dither_unorm ((s >> 16) & 0xff, 5, t) << 11) |
+		 (dither_unorm ((s >> 8) & 0xff, 6, t) << 5)   |
+		 (dither_unorm (s & 0xff, 5, t));
+    }
+}
+
+static force_inline __m128i
+pack_2101010_2x128 (__m128i u)
+{
+    /* b | g << 10 and r | a << 10 */
+    __m128i v = _mm_madd_epi16 (u, _mm_set_epi16 (1024, 1, 1024, 1,
+						  1024, 1, 1024, 1));
+
+    v = _mm_or_si128 (v, _mm_slli_epi32 (_mm_srli_epi64 (v, 32), 20));
+
+    return _mm_shuffle_epi32 (v, _MM_SHUFFLE (3, 1, 2, 0));
+}
+
+static void
+dither_line_8888_2101010 (uint32_t *dst, const uint32_t *src,
+			  const uint16_t *thresholds, int width, uint32_t alpha)
+{
+    const __m128i q = _mm_set_epi16 (0, 4, 4, 4, 0, 4, 4, 4);
+    const __m128i r = _mm_set1_epi16 (3);
+    int i;
+
+    for (i = 0; i + 4 <= width; i += 4)
+    {
+	__m128i p = load_128_unaligned ((__m128i *)(src + i));
+	__m128i lo, hi;
+
+	dither_8888_4x128 (_mm_or_si128 (p, _mm_set1_epi32 (alpha)),
+			   thresholds + (i & (DITHER_PERIOD - 1)),
+			   q, r, &lo, &hi);
+
+	_mm_storeu_si128 ((__m128i *)(dst + i),
+			  _mm_unpacklo_epi64 (pack_2101010_2x128 (lo),
+					      pack_2101010_2x128 (hi)));
+    }
+
+    for (; i < width; ++i)
+    {
+	uint32_t s = src[i] | alpha;
+	uint32_t t = thresholds[i & (DITHER_PERIOD - 1)];
+
+	dst[i] = (dither_unorm (s >> 24, 2, t) << 30)		|
+		 (dither_unorm ((s >> 16) & 0xff, 10, t) << 20)	|
+		 (dither_unorm ((s >> 8) & 0xff, 10, t) << 10)	|
+		 (dither_unorm (s & 0xff, 10, t));
+    }
+}
+
+static void
+sse2_composite_src_8888_0565_dither (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint16_t thresholds[DITHER_PERIOD];
+    uint16_t *dst_line;
+    uint32_t *src_line;
+    int dst_stride, src_stride;
+    int j;
+
+    if (dest_image->bits.dither == PIXMAN_DITHER_NONE)
+    {
+	sse2_composite_src_x888_0565 (imp, info);
+	return;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint16_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	_pixman_dither_thresholds (&dest_image->bits, dest_x, dest_y + j,
+				   width, thresholds);
+	dither_line_8888_0565 (dst_line, src_line, thresholds, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+sse2_composite_src_8888_2101010_dither (pixman_implementation_t *imp,
+					pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t alpha = PIXMAN_FORMAT_A (src_image->bits.format) ? 0 : 0xff000000;
+    uint16_t thresholds[DITHER_PERIOD];
+    uint32_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+    int j;
+
+    if (dest_image->bits.dither == PIXMAN_DITHER_NONE)
+    {
+	sse2_composite_src_8888_2101010 (imp, info);
+	return;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	_pixman_dither_thresholds (&dest_image->bits, dest_x, dest_y + j,
+				   width, thresholds);
+	dither_line_8888_2101010 (dst_line, src_line, thresholds, width, alpha);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+/* The wide write back for dithered destinations with up to 10 bits per
+ * channel in 16 or 32 bpp pixels. It does the same float math as
+ * dest_write_back_wide() and the stores.
+ */
+static pixman_bool_t
+get_channel_shifts (pixman_format_code_t format, int shifts[4])
+{
+    int bpp = PIXMAN_FORMAT_BPP (format);
+    int a = PIXMAN_FORMAT_A (format);
+    int r = PIXMAN_FORMAT_R (format);
+    int g = PIXMAN_FORMAT_G (format);
+    int b = PIXMAN_FORMAT_B (format);
+
+    if ((bpp != 16 && bpp != 32) || a > 10 || r > 10 || g > 10 || b > 10)
+	return FALSE;
+
+    switch (PIXMAN_FORMAT_TYPE (format))
+    {
+    case PIXMAN_TYPE_ARGB:
+	shifts[3] = 0;
+	shifts[2] = b;
+	shifts[1] = b + g;
+	shifts[0] = b + g + r;
+	break;
+
+    case PIXMAN_TYPE_ABGR:
+	shifts[1] = 0;
+	shifts[2] = r;
+	shifts[3] = r + g;
+	shifts[0] = r + g + b;
+	break;
+
+    case PIXMAN_TYPE_BGRA:
+	shifts[3] = bpp - b;
+	shifts[2] = shifts[3] - g;
+	shifts[1] = shifts[2] - r;
+	shifts[0] = shifts[1] - a;
+	break;
+
+    case PIXMAN_TYPE_RGBA:
+	shifts[1] = bpp - r;
+	shifts[2] = shifts[1] - g;
+	shifts[3] = shifts[2] - b;
+	shifts[0] = shifts[3] - a;
+	break;
+
+    default:
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+sse2_dest_write_back_dither (pixman_iter_t *iter)
+{
+    bits_image_t *image = &iter->image->bits;
+    pixman_format_code_t format = image->format;
+    int bpp = PIXMAN_FORMAT_BPP (format);
+    int width = iter->width;
+    const argb_t *buffer = (argb_t *)iter->buffer;
+    uint8_t *line = (uint8_t *)(image->bits + iter->y * image->rowstride) +
+		    iter->x * (bpp / 8);
+    int bits[4] = { PIXMAN_FORMAT_A (format), PIXMAN_FORMAT_R (format),
+		    PIXMAN_FORMAT_G (format), PIXMAN_FORMAT_B (format) };
+    float factors[DITHER_PERIOD];
+    __m128 scale, mul;
+    __m128i max, shift;
+    int shifts[4];
+    int i;
+
+    get_channel_shifts (format, shifts);
+    get_dither_factors (image, iter->x, iter->y, width, factors);
+
+    /* Channels that aren't there are neither dithered nor stored */
+    scale = _mm_set_ps (bits[3] ? 1.f / (float)(1 << bits[3]) : 0.f,
+			bits[2] ? 1.f / (float)(1 << bits[2]) : 0.f,
+			bits[1] ? 1.f / (float)(1 << bits[1]) : 0.f,
+			bits[0] ? 1.f / (float)(1 << bits[0]) : 0.f);
+    mul = _mm_set_ps (1 << bits[3], 1 << bits[2], 1 << bits[1], 1 << bits[0]);
+    max = _mm_set_epi32 ((1 << bits[3]) - 1, (1 << bits[2]) - 1,
+			 (1 << bits[1]) - 1, (1 << bits[0]) - 1);
+    shift = _mm_set_epi32 (1 << shifts[3], 1 << shifts[2],
+			   1 << shifts[1], 1 << shifts[0]);
+
+    for (i = 0; i < width; ++i)
+    {
+	__m128 f = _mm_loadu_ps ((float *)(buffer + i));
+	__m128 d = _mm_set1_ps (factors[i & (DITHER_PERIOD - 1)]);
+	__m128i u, lo, hi;
+	uint32_t p;
+
+	f = _mm_add_ps (f, _mm_mul_ps (_mm_sub_ps (d, f), scale));
+
+	/* float_to_unorm (f, n), and then the channels shifted into place;
+	 * the 8 bit formats are stored by truncating 8 bit values, which
+	 * gives the same.
+	 */
+	f = _mm_min_ps (_mm_max_ps (f, _mm_setzero_ps ()), _mm_set1_ps (1.0f));
+	u = _mm_min_epi16 (_mm_cvttps_epi32 (_mm_mul_ps (f, mul)), max);
+
+	lo = _mm_mul_epu32 (u, shift);
+	hi = _mm_mul_epu32 (_mm_srli_epi64 (u, 32), _mm_srli_epi64 (shift, 32));
+	lo = _mm_or_si128 (lo, hi);
+	p = _mm_cvtsi128_si32 (lo) | _mm_cvtsi128_si32 (_mm_srli_si128 (lo, 8));
+
+	if (bpp == 32)
+	    ((uint32_t *)line)[i] = p;
+	else
+	    ((uint16_t *)line)[i] = p;
+    }
+
+    iter->y++;
+}
+
+static void
+sse2_dest_iter_init_dither (pixman_iter_t *iter, const pixman_iter_info_t *info)
+{
+    int shifts[4];
+
+    _pixman_bits_image_dest_iter_init (iter->image, iter);
+
+    if (iter->image->bits.dither != PIXMAN_DITHER_NONE &&
+	get_channel_shifts (iter->image->bits.format, shifts))
+    {
+	iter->write_back = sse2_dest_write_back_dither;
+    }
+}
+
+/* Images with an a8 alpha map. The color comes from an untransformed
+ * x8r8g8b8 or a8r8g8b8 image that covers the samples, and the alpha from
+ * the alpha map, or 0 outside of it.
+ */
+/* a holds the alpha of the four pixels in the top bytes of its 16 bit lanes */
+static force_inline void
+merge_alpha_a8_4 (uint32_t *dst, const uint32_t *src, __m128i a)
+{
+    __m128i s = load_128_unaligned ((__m128i *)src);
+
+    s = _mm_and_si128 (s, _mm_set1_epi32 (0x00ffffff));
+    _mm_storeu_si128 ((__m128i *)dst, _mm_or_si128 (s, a));
+}
+
+static void
+merge_alpha_a8_line (uint32_t *dst, const uint32_t *src, const uint8_t *alpha,
+		     int w)
+{
+    while (w >= 16)
+    {
+	__m128i a = load_128_unaligned ((__m128i *)alpha);
+	__m128i a_lo = _mm_unpacklo_epi8 (_mm_setzero_si128 (), a);
+	__m128i a_hi = _mm_unpackhi_epi8 (_mm_setzero_si128 (), a);
+
+	merge_alpha_a8_4 (dst, src,
+			  _mm_unpacklo_epi16 (_mm_setzero_si128 (), a_lo));
+	merge_alpha_a8_4 (dst + 4, src + 4,
+			  _mm_unpackhi_epi16 (_mm_setzero_si128 (), a_lo));
+	merge_alpha_a8_4 (dst + 8, src + 8,
+			  _mm_unpacklo_epi16 (_mm_setzero_si128 (), a_hi));
+	merge_alpha_a8_4 (dst + 12, src + 12,
+			  _mm_unpackhi_epi16 (_mm_setzero_si128 (), a_hi));
+
+	dst += 16;
+	src += 16;
+	alpha += 16;
+	w -= 16;
+    }
+
+    while (w--)
+	*dst++ = (*src++ & 0x00ffffff) | ((uint32_t)*alpha++ << 24);
+}
+
+static void
+fetch_8888_a8_line (pixman_image_t *image, int x, int y, int w, uint32_t *dst)
+{
+    bits_image_t *alpha_map = image->common.alpha_map;
+    const uint32_t *src = image->bits.bits + y * image->bits.rowstride + x;
+    int ax = x - image->common.alpha_origin_x;
+    int ay = y - image->common.alpha_origin_y;
+    int n;
+
+    if (ay >= 0 && ay < alpha_map->height && ax < alpha_map->width)
+    {
+	const uint8_t *alpha = (uint8_t *)(
+	    alpha_map->bits + ay * alpha_map->rowstride);
+
+	for (n = 0; n < w && ax + n < 0; ++n)
+	    dst[n] = src[n] & 0x00ffffff;
+
+	if (n < w)
+	{
+	    int inside = MIN (w - n, alpha_map->width - (ax + n));
+
+	    merge_alpha_a8_line (dst + n, src + n, alpha + ax + n, inside);
+	    n += inside;
+	}
+    }
+    else
+    {
+	n = 0;
+    }
+
+    for (; n < w; ++n)
+	dst[n] = src[n] & 0x00ffffff;
+}
+
+static void
+sse2_composite_over_8888_a8map_8888 (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t buffer[64];
+    uint32_t *dst_line;
+    int dst_stride;
+    int i, j;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    for (j = 0; j < height; ++j)
+    {
+	for (i = 0; i < width; i += 64)
+	{
+	    int w = MIN (width - i, 64);
+
+	    fetch_8888_a8_line (src_image, src_x + i, src_y + j, w, buffer);
+	    core_combine_over_u_sse2_no_mask (dst_line + i, buffer, w);
+	}
+
+	dst_line += dst_stride;
+    }
+}
+
+/* The HSL blend modes, with the same float math as pixman-combine-float.c
+ * but for four pixels at once, with a channel per register.
+ */
+typedef struct
+{
+    __m128 r;
+    __m128 g;
+    __m128 b;
+} rgb_4x128_t;
+
+static force_inline __m128
+select_4x128 (__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+static force_inline __m128
+is_zero_4x128 (__m128 f)
+{
+    return _mm_and_ps (_mm_cmpgt_ps (f, _mm_set1_ps (-FLT_MIN)),
+		       _mm_cmplt_ps (f, _mm_set1_ps (FLT_MIN)));
+}
+
+static force_inline __m128
+get_lum_4x128 (const rgb_4x128_t *c)
+{
+    return _mm_add_ps (_mm_add_ps (_mm_mul_ps (c->r, _mm_set1_ps (0.3f)),
+				   _mm_mul_ps (c->g, _mm_set1_ps (0.59f))),
+		       _mm_mul_ps (c->b, _mm_set1_ps (0.11f)));
+}
+
+static force_inline __m128
+channel_min_4x128 (const rgb_4x128_t *c)
+{
+    return _mm_min_ps (_mm_min_ps (c->r, c->g), c->b);
+}
+
+static force_inline __m128
+channel_max_4x128 (const rgb_4x128_t *c)
+{
+    return _mm_max_ps (_mm_max_ps (c->r, c->g), c->b);
+}
+
+static force_inline void
+clip_color_4x128 (rgb_4x128_t *c, __m128 a)
+{
+    __m128 l = get_lum_4x128 (c);
+    __m128 n = channel_min_4x128 (c);
+    __m128 x = channel_max_4x128 (c);
+    __m128 m, t, zero, calc;
+
+    m = _mm_cmplt_ps (n, _mm_setzero_ps ());
+    if (_mm_movemask_ps (m))
+    {
+	t = _mm_sub_ps (l, n);
+	zero = _mm_and_ps (is_zero_4x128 (t), m);
+	calc = _mm_andnot_ps (is_zero_4x128 (t), m);
+	t = select_4x128 (calc, t, _mm_set1_ps (1.f));
+
+#define CLIP_MIN(v)							\
+	v = select_4x128 (calc, _mm_add_ps (				\
+			      l, _mm_div_ps (_mm_mul_ps (_mm_sub_ps (v, l), l), t)), \
+			  _mm_andnot_ps (zero, v))
+
+	CLIP_MIN (c->r);
+	CLIP_MIN (c->g);
+	CLIP_MIN (c->b);
+#undef CLIP_MIN
+    }
+
+    m = _mm_cmpgt_ps (x, a);
+    if (_mm_movemask_ps (m))
+    {
+	__m128 al = _mm_sub_ps (a, l);
+
+	t = _mm_sub_ps (x, l);
+	zero = _mm_and_ps (is_zero_4x128 (t), m);
+	calc = _mm_andnot_ps (is_zero_4x128 (t), m);
+	t = select_4x128 (calc, t, _mm_set1_ps (1.f));
+
+#define CLIP_MAX(v)							\
+	v = select_4x128 (calc, _mm_add_ps (				\
+			      l, _mm_div_ps (_mm_mul_ps (_mm_sub_ps (v, l), al), t)), \
+			  select_4x128 (zero, a, v))
+
+	CLIP_MAX (c->r);
+	CLIP_MAX (c->g);
+	CLIP_MAX (c->b);
+#undef CLIP_MAX
+    }
+}
+
+static force_inline void
+set_lum_4x128 (rgb_4x128_t *c, __m128 sa, __m128 l)
+{
+    __m128 d = _mm_sub_ps (l, get_lum_4x128 (c));
+
+    c->r = _mm_add_ps (c->r, d);
+    c->g = _mm_add_ps (c->g, d);
+    c->b = _mm_add_ps (c->b, d);
+
+    clip_color_4x128 (c, sa);
+}
+
+static force_inline void
+set_sat_4x128 (rgb_4x128_t *c, __m128 sat)
+{
+    /* Which channel is the max, the mid and the min has to be decided
+     * like set_sat() does, because for ties the mid one is computed.
+     */
+    __m128 rg = _mm_cmpgt_ps (c->r, c->g), nrg = _mm_cmple_ps (c->r, c->g);
+    __m128 rb = _mm_cmpgt_ps (c->r, c->b), nrb = _mm_cmple_ps (c->r, c->b);
+    __m128 gb = _mm_cmpgt_ps (c->g, c->b), ngb = _mm_cmple_ps (c->g, c->b);
+    __m128 min = channel_min_4x128 (c);
+    __m128 t = _mm_sub_ps (channel_max_4x128 (c), min);
+    __m128 z = is_zero_4x128 (t);
+
+    /* Lanes that would divide by zero are not used */
+    t = select_4x128 (z, _mm_set1_ps (1.f), t);
+
+#define SET_SAT(v, is_max, is_min)					\
+    v = _mm_andnot_ps (							\
+	_mm_or_ps (z, is_min),						\
+	select_4x128 (is_max, sat,					\
+		      _mm_div_ps (_mm_mul_ps (_mm_sub_ps (v, min), sat), t)))
+
+    SET_SAT (c->r, _mm_and_ps (rg, rb), _mm_and_ps (nrg, nrb));
+    SET_SAT (c->g, _mm_and_ps (nrg, _mm_or_ps (rb, gb)),
+	     _mm_and_ps (rg, _mm_or_ps (nrb, ngb)));
+    SET_SAT (c->b, _mm_and_ps (nrb, _mm_or_ps (rg, ngb)),
+	     _mm_and_ps (rb, _mm_or_ps (gb, nrg)));
+#undef SET_SAT
+}
+
+static force_inline void
+scale_4x128 (rgb_4x128_t *res, const rgb_4x128_t *c, __m128 f)
+{
+    res->r = _mm_mul_ps (c->r, f);
+    res->g = _mm_mul_ps (c->g, f);
+    res->b = _mm_mul_ps (c->b, f);
+}
+
+/* da and dc become the result of blending sc and sa onto them */
+static force_inline void
+blend_hsl_4x128 (pixman_op_t op,
+		 __m128 *da, rgb_4x128_t *dc, __m128 sa, const rgb_4x128_t *sc)
+{
+    __m128 one = _mm_set1_ps (1.f);
+    rgb_4x128_t res;
+
+    switch (op)
+    {
+    case PIXMAN_OP_HSL_HUE:
+	scale_4x128 (&res, sc, *da);
+	set_sat_4x128 (&res, _mm_mul_ps (
+			   _mm_sub_ps (channel_max_4x128 (dc),
+				       channel_min_4x128 (dc)), sa));
+	set_lum_4x128 (&res, _mm_mul_ps (sa, *da),
+		       _mm_mul_ps (get_lum_4x128 (dc), sa));
+	break;
+
+    case PIXMAN_OP_HSL_SATURATION:
+	scale_4x128 (&res, dc, sa);
+	set_sat_4x128 (&res, _mm_mul_ps (
+			   _mm_sub_ps (channel_max_4x128 (sc),
+				       channel_min_4x128 (sc)), *da));
+	set_lum_4x128 (&res, _mm_mul_ps (sa, *da),
+		       _mm_mul_ps (get_lum_4x128 (dc), sa));
+	break;
+
+    case PIXMAN_OP_HSL_COLOR:
+	scale_4x128 (&res, sc, *da);
+	set_lum_4x128 (&res, _mm_mul_ps (sa, *da),
+		       _mm_mul_ps (get_lum_4x128 (dc), sa));
+	break;
+
+    case PIXMAN_OP_HSL_LUMINOSITY:
+    default:
+	scale_4x128 (&res, dc, sa);
+	set_lum_4x128 (&res, _mm_mul_ps (sa, *da),
+		       _mm_mul_ps (get_lum_4x128 (sc), *da));
+	break;
+    }
+
+#define BLEND(d, s, r)							\
+    d = _mm_add_ps (_mm_add_ps (_mm_mul_ps (_mm_sub_ps (one, sa), d),	\
+				_mm_mul_ps (_mm_sub_ps (one, *da), s)),	\
+		    r)
+
+    BLEND (dc->r, sc->r, res.r);
+    BLEND (dc->g, sc->g, res.g);
+    BLEND (dc->b, sc->b, res.b);
+#undef BLEND
+
+    *da = _mm_sub_ps (_mm_add_ps (sa, *da), _mm_mul_ps (sa, *da));
+}
+
+static force_inline void
+combine_hsl_u_float_4 (pixman_op_t op,
+		       float *dest, const float *src, const float *mask)
+{
+    __m128 sa = _mm_loadu_ps (src + 0), da = _mm_loadu_ps (dest + 0);
+    __m128 s1 = _mm_loadu_ps (src + 4), d1 = _mm_loadu_ps (dest + 4);
+    __m128 s2 = _mm_loadu_ps (src + 8), d2 = _mm_loadu_ps (dest + 8);
+    __m128 s3 = _mm_loadu_ps (src + 12), d3 = _mm_loadu_ps (dest + 12);
+    rgb_4x128_t sc, dc;
+
+    _MM_TRANSPOSE4_PS (sa, s1, s2, s3);
+    _MM_TRANSPOSE4_PS (da, d1, d2, d3);
+
+    sc.r = s1; sc.g = s2; sc.b = s3;
+    dc.r = d1; dc.g = d2; dc.b = d3;
+
+    if (mask)
+    {
+	/* Component alpha is not supported for HSL modes */
+	__m128 ma = _mm_set_ps (mask[12], mask[8], mask[4], mask[0]);
+
+	sa = _mm_mul_ps (sa, ma);
+	scale_4x128 (&sc, &sc, ma);
+    }
+
+    blend_hsl_4x128 (op, &da, &dc, sa, &sc);
+
+    _MM_TRANSPOSE4_PS (da, dc.r, dc.g, dc.b);
 
-		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-	    }
-	}
-	else
-	{
-	    BILINEAR_SKIP_ONE_PIXEL ();
-	}
+    _mm_storeu_ps (dest + 0, da);
+    _mm_storeu_ps (dest + 4, dc.r);
+    _mm_storeu_ps (dest + 8, dc.g);
+    _mm_storeu_ps (dest + 12, dc.b);
+}
 
-	w--;
-	dst++;
+static force_inline void
+combine_hsl_u_float (pixman_op_t op, float *dest, const float *src,
+		     const float *mask, int n_pixels)
+{
+    float d[16], s[16], m[16];
+
+    while (n_pixels >= 4)
+    {
+	combine_hsl_u_float_4 (op, dest, src, mask);
+
+	dest += 16;
+	src += 16;
+	if (mask)
+	    mask += 16;
+	n_pixels -= 4;
     }
 
-    while (w >= 4)
+    if (n_pixels)
     {
-        uint32_t m;
+	memset (d, 0, sizeof (d));
+	memset (s, 0, sizeof (s));
+	memset (m, 0, sizeof (m));
 
-	__m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
-	__m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-	__m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+	memcpy (d, dest, n_pixels * 4 * sizeof (float));
+	memcpy (s, src, n_pixels * 4 * sizeof (float));
+	if (mask)
+	    memcpy (m, mask, n_pixels * 4 * sizeof (float));
 
-        memcpy(&m, mask, sizeof(uint32_t));
+	combine_hsl_u_float_4 (op, d, s, mask ? m : NULL);
 
-	if (m)
-	{
-	    BILINEAR_INTERPOLATE_FOUR_PIXELS (xmm_src);
+	memcpy (dest, d, n_pixels * 4 * sizeof (float));
+    }
+}
 
-	    if (m == 0xffffffff && is_opaque (xmm_src))
-	    {
-		save_128_aligned ((__m128i *)dst, xmm_src);
-	    }
-	    else
-	    {
-		xmm_dst = load_128_aligned ((__m128i *)dst);
+#define SSE2_HSL_COMBINER(name, op)					\
+    static void								\
+    sse2_combine_ ## name ## _u_float (pixman_implementation_t *imp,	\
+				       pixman_op_t              unused,	\
+				       float                   *dest,	\
+				       const float             *src,	\
+				       const float             *mask,	\
+				       int                      n_pixels) \
+    {									\
+	combine_hsl_u_float (op, dest, src, mask, n_pixels);		\
+    }
+
+SSE2_HSL_COMBINER (hsl_hue, PIXMAN_OP_HSL_HUE)
+SSE2_HSL_COMBINER (hsl_saturation, PIXMAN_OP_HSL_SATURATION)
+SSE2_HSL_COMBINER (hsl_color, PIXMAN_OP_HSL_COLOR)
+SSE2_HSL_COMBINER (hsl_luminosity, PIXMAN_OP_HSL_LUMINOSITY)
+
+/* 8888 pixels to and from floats, the same as unorm_to_float () and
+ * float_to_unorm () do.
+ */
+static force_inline __m128
+unorm_8_to_float_4x128 (__m128i p, int shift)
+{
+    p = _mm_and_si128 (_mm_srli_epi32 (p, shift), _mm_set1_epi32 (0xff));
 
-		xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+    return _mm_mul_ps (_mm_cvtepi32_ps (p), _mm_set1_ps (1.f / 255.f));
+}
 
-		unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-		unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
-		unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+static force_inline __m128i
+float_to_unorm_8_4x128 (__m128 f, int shift)
+{
+    __m128i u;
 
-		expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
-		expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+    f = _mm_min_ps (_mm_max_ps (f, _mm_setzero_ps ()), _mm_set1_ps (1.f));
+    u = _mm_cvttps_epi32 (_mm_mul_ps (f, _mm_set1_ps (256.f)));
+    u = _mm_sub_epi32 (u, _mm_srli_epi32 (u, 8));
 
-		in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
-			       &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+    return _mm_slli_epi32 (u, shift);
+}
 
-		save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-	    }
-	}
-	else
-	{
-	    BILINEAR_SKIP_FOUR_PIXELS ();
-	}
+static force_inline __m128i
+composite_hsl_8888_4 (pixman_op_t op, __m128i s, __m128i d, __m128 ma,
+		      pixman_bool_t has_mask, int r_shift, int b_shift)
+{
+    __m128 sa = unorm_8_to_float_4x128 (s, 24);
+    __m128 da = unorm_8_to_float_4x128 (d, 24);
+    rgb_4x128_t sc, dc;
 
-	w -= 4;
-	dst += 4;
-	mask += 4;
+    sc.r = unorm_8_to_float_4x128 (s, r_shift);
+    sc.g = unorm_8_to_float_4x128 (s, 8);
+    sc.b = unorm_8_to_float_4x128 (s, b_shift);
+    dc.r = unorm_8_to_float_4x128 (d, r_shift);
+    dc.g = unorm_8_to_float_4x128 (d, 8);
+    dc.b = unorm_8_to_float_4x128 (d, b_shift);
+
+    if (has_mask)
+    {
+	sa = _mm_mul_ps (sa, ma);
+	scale_4x128 (&sc, &sc, ma);
     }
 
+    blend_hsl_4x128 (op, &da, &dc, sa, &sc);
+
+    return _mm_or_si128 (
+	_mm_or_si128 (float_to_unorm_8_4x128 (da, 24),
+		      float_to_unorm_8_4x128 (dc.r, r_shift)),
+	_mm_or_si128 (float_to_unorm_8_4x128 (dc.g, 8),
+		      float_to_unorm_8_4x128 (dc.b, b_shift)));
+}
+
+static force_inline void
+composite_hsl_8888_line (pixman_op_t op, uint32_t *dst, const uint32_t *src,
+			 const uint8_t *mask, int w,
+			 uint32_t src_alpha, uint32_t dst_alpha,
+			 int r_shift, int b_shift)
+{
+    const __m128i sx = _mm_set1_epi32 (src_alpha);
+    const __m128i dx = _mm_set1_epi32 (dst_alpha);
+    __m128 ma = _mm_setzero_ps ();
+    uint32_t s[4], d[4];
+    uint8_t m[4];
+    int i;
+
     while (w)
     {
-	uint32_t sa;
-	uint8_t m = *mask++;
+	int n = MIN (w, 4);
+	__m128i vs, vd;
 
-	if (m)
+	if (n == 4)
 	{
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
-	    sa = pix1 >> 24;
-
-	    if (sa == 0xff && m == 0xff)
+	    vs = load_128_unaligned ((__m128i *)src);
+	    vd = load_128_unaligned ((__m128i *)dst);
+	}
+	else
+	{
+	    for (i = 0; i < 4; ++i)
 	    {
-		*dst = pix1;
+		s[i] = i < n ? src[i] : 0;
+		d[i] = i < n ? dst[i] : 0;
 	    }
-	    else
-	    {
-		__m128i ms, md, ma, msa;
 
-		pix2 = *dst;
-		ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		ms = unpack_32_1x128 (pix1);
-		md = unpack_32_1x128 (pix2);
+	    vs = load_128_unaligned ((__m128i *)s);
+	    vd = load_128_unaligned ((__m128i *)d);
+	}
 
-		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+	if (mask)
+	{
+	    for (i = 0; i < 4; ++i)
+		m[i] = i < n ? mask[i] : 0;
 
-		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-	    }
+	    /* Pixels that the mask makes transparent are left alone */
+	    if (!(m[0] | m[1] | m[2] | m[3]))
+		goto next;
+
+	    ma = _mm_mul_ps (_mm_cvtepi32_ps (_mm_set_epi32 (m[3], m[2], m[1], m[0])),
+			     _mm_set1_ps (1.f / 255.f));
+	}
+
+	vd = composite_hsl_8888_4 (op, _mm_or_si128 (vs, sx),
+				   _mm_or_si128 (vd, dx), ma, mask != NULL,
+				   r_shift, b_shift);
+
+	if (n == 4)
+	{
+	    _mm_storeu_si128 ((__m128i *)dst, vd);
 	}
 	else
 	{
-	    BILINEAR_SKIP_ONE_PIXEL ();
+	    _mm_storeu_si128 ((__m128i *)d, vd);
+	    for (i = 0; i < n; ++i)
+		dst[i] = d[i];
 	}
 
-	w--;
-	dst++;
+    next:
+	dst += n;
+	src += n;
+	if (mask)
+	    mask += n;
+	w -= n;
     }
 }
 
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_cover_OVER,
-			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
-			       uint32_t, uint8_t, uint32_t,
-			       COVER, FLAG_HAVE_NON_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_pad_OVER,
-			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
-			       uint32_t, uint8_t, uint32_t,
-			       PAD, FLAG_HAVE_NON_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_none_OVER,
-			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
-			       uint32_t, uint8_t, uint32_t,
-			       NONE, FLAG_HAVE_NON_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_normal_OVER,
-			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
-			       uint32_t, uint8_t, uint32_t,
-			       NORMAL, FLAG_HAVE_NON_SOLID_MASK)
-
 static force_inline void
-scaled_bilinear_scanline_sse2_8888_n_8888_OVER (uint32_t *       dst,
-						const uint32_t * mask,
-						const uint32_t * src_top,
-						const uint32_t * src_bottom,
-						int32_t          w,
-						int              wt,
-						int              wb,
-						pixman_fixed_t   vx_,
-						pixman_fixed_t   unit_x_,
-						pixman_fixed_t   max_vx,
-						pixman_bool_t    zero_src)
+composite_hsl_8888 (pixman_op_t blend_op, pixman_composite_info_t *info)
 {
-    intptr_t vx = vx_;
-    intptr_t unit_x = unit_x_;
-    BILINEAR_DECLARE_VARIABLES;
-    uint32_t pix1;
-    __m128i xmm_mask;
-
-    if (zero_src || (*mask >> 24) == 0)
-	return;
-
-    xmm_mask = create_mask_16_128 (*mask >> 24);
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src_alpha = PIXMAN_FORMAT_A (src_image->bits.format) ? 0 : 0xff000000;
+    uint32_t dst_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) ? 0 : 0xff000000;
+    pixman_bool_t bgr =
+	PIXMAN_FORMAT_TYPE (dest_image->bits.format) == PIXMAN_TYPE_ABGR;
+    uint32_t *dst_line, *src_line;
+    uint8_t *mask_line = NULL;
+    int dst_stride, src_stride, mask_stride = 0;
 
-    while (w && ((uintptr_t)dst & 15))
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+    if (mask_image)
     {
-	BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
-	if (pix1)
-	{
-		uint32_t d = *dst;
-
-		__m128i ms = unpack_32_1x128 (pix1);
-		__m128i alpha     = expand_alpha_1x128 (ms);
-		__m128i dest      = xmm_mask;
-		__m128i alpha_dst = unpack_32_1x128 (d);
-
-		*dst = pack_1x128_32
-			(in_over_1x128 (&ms, &alpha, &dest, &alpha_dst));
-	}
-
-	dst++;
-	w--;
+	PIXMAN_IMAGE_GET_LINE (
+	    mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
     }
 
-    while (w >= 4)
+    while (height--)
     {
-	__m128i xmm_src;
-	BILINEAR_INTERPOLATE_FOUR_PIXELS (xmm_src);
-
-	if (!is_zero (xmm_src))
+	if (bgr)
 	{
-	    __m128i xmm_src_lo, xmm_src_hi;
-	    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-	    __m128i xmm_alpha_lo, xmm_alpha_hi;
-
-	    xmm_dst = load_128_aligned ((__m128i*)dst);
-
-	    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
-	    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
-				&xmm_alpha_lo, &xmm_alpha_hi);
-
-	    in_over_2x128 (&xmm_src_lo, &xmm_src_hi,
-			   &xmm_alpha_lo, &xmm_alpha_hi,
-			   &xmm_mask, &xmm_mask,
-			   &xmm_dst_lo, &xmm_dst_hi);
-
-	    save_128_aligned
-		((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+	    composite_hsl_8888_line (blend_op, dst_line, src_line, mask_line, width,
+				     src_alpha, dst_alpha, 0, 16);
+	}
+	else
+	{
+	    composite_hsl_8888_line (blend_op, dst_line, src_line, mask_line, width,
+				     src_alpha, dst_alpha, 16, 0);
 	}
 
-	dst += 4;
-	w -= 4;
+	dst_line += dst_stride;
+	src_line += src_stride;
+	if (mask_line)
+	    mask_line += mask_stride;
     }
+}
 
-    while (w)
-    {
-	BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
-	if (pix1)
-	{
-		uint32_t d = *dst;
-
-		__m128i ms = unpack_32_1x128 (pix1);
-		__m128i alpha     = expand_alpha_1x128 (ms);
-		__m128i dest      = xmm_mask;
-		__m128i alpha_dst = unpack_32_1x128 (d);
+#define SSE2_HSL_COMPOSITE(name, op)					\
+    static void								\
+    sse2_composite_ ## name ## _8888_8888 (pixman_implementation_t *imp, \
+					   pixman_composite_info_t *info) \
+    {									\
+	composite_hsl_8888 (op, info);					\
+    }
 
-		*dst = pack_1x128_32
-			(in_over_1x128 (&ms, &alpha, &dest, &alpha_dst));
-	}
+SSE2_HSL_COMPOSITE (hsl_hue, PIXMAN_OP_HSL_HUE)
+SSE2_HSL_COMPOSITE (hsl_saturation, PIXMAN_OP_HSL_SATURATION)
+SSE2_HSL_COMPOSITE (hsl_color, PIXMAN_OP_HSL_COLOR)
+SSE2_HSL_COMPOSITE (hsl_luminosity, PIXMAN_OP_HSL_LUMINOSITY)
 
-	dst++;
-	w--;
-    }
+/* Component alpha is not supported for HSL modes; they leave the
+ * destination alone.
+ */
+static void
+sse2_composite_hsl_ca (pixman_implementation_t *imp,
+		       pixman_composite_info_t *info)
+{
 }
 
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_cover_OVER,
-			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
-			       uint32_t, uint32_t, uint32_t,
-			       COVER, FLAG_HAVE_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_pad_OVER,
-			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
-			       uint32_t, uint32_t, uint32_t,
-			       PAD, FLAG_HAVE_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_none_OVER,
-			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
-			       uint32_t, uint32_t, uint32_t,
-			       NONE, FLAG_HAVE_SOLID_MASK)
-FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_normal_OVER,
-			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
-			       uint32_t, uint32_t, uint32_t,
-			       NORMAL, FLAG_HAVE_SOLID_MASK)
+#define HSL_FAST_PATHS(op, func)					\
+    PIXMAN_STD_FAST_PATH (op, a8r8g8b8, null, a8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8r8g8b8, null, x8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8r8g8b8, null, a8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8r8g8b8, null, x8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8r8g8b8, a8, a8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8r8g8b8, a8, x8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8r8g8b8, a8, a8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8r8g8b8, a8, x8r8g8b8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8b8g8r8, null, a8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8b8g8r8, null, x8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8b8g8r8, null, a8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8b8g8r8, null, x8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8b8g8r8, a8, a8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, a8b8g8r8, a8, x8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8b8g8r8, a8, a8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH (op, x8b8g8r8, a8, x8b8g8r8, func),		\
+    PIXMAN_STD_FAST_PATH_CA (op, a8r8g8b8, a8r8g8b8, a8r8g8b8, sse2_composite_hsl_ca), \
+    PIXMAN_STD_FAST_PATH_CA (op, a8r8g8b8, a8r8g8b8, x8r8g8b8, sse2_composite_hsl_ca), \
+    PIXMAN_STD_FAST_PATH_CA (op, a8b8g8r8, a8b8g8r8, a8b8g8r8, sse2_composite_hsl_ca), \
+    PIXMAN_STD_FAST_PATH_CA (op, a8b8g8r8, a8b8g8r8, x8b8g8r8, sse2_composite_hsl_ca)
 
 static const pixman_fast_path_t sse2_fast_paths[] =
 {
@@ -6214,6 +8764,23 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (OVER, rpixbuf, rpixbuf, b5g6r5, sse2_composite_over_pixbuf_0565),
     PIXMAN_STD_FAST_PATH (OVER, x8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area),
     PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8_sRGB, sse2_composite_over_8888_srgb),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8_sRGB, a8r8g8b8_sRGB, sse2_composite_over_srgb_srgb),
+    PIXMAN_WIDE_FAST_PATH (OVER, r8g8b8_sRGB, a8r8g8b8_sRGB, sse2_composite_src_srgb24_srgb),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, r8g8b8_sRGB, sse2_composite_over_8888_srgb24),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8_sRGB, r8g8b8_sRGB, sse2_composite_over_srgb_srgb24),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, a2r10g10b10, sse2_composite_over_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, x2r10g10b10, sse2_composite_over_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, a2b10g10r10, sse2_composite_over_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, x2b10g10r10, sse2_composite_over_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, a2r10g10b10, sse2_composite_over_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, x2r10g10b10, sse2_composite_over_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8b8g8r8, a2b10g10r10, sse2_composite_over_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8b8g8r8, x2b10g10r10, sse2_composite_over_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a2r10g10b10, a2r10g10b10, sse2_composite_over_2101010_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a2r10g10b10, x2r10g10b10, sse2_composite_over_2101010_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a2b10g10r10, a2b10g10r10, sse2_composite_over_2101010_2101010),
+    PIXMAN_WIDE_FAST_PATH (OVER, a2b10g10r10, x2b10g10r10, sse2_composite_over_2101010_2101010),
     
     /* PIXMAN_OP_OVER_REVERSE */
     PIXMAN_STD_FAST_PATH (OVER_REVERSE, solid, null, a8r8g8b8, sse2_composite_over_reverse_n_8888),
@@ -6234,6 +8801,12 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, a8r8g8b8, sse2_composite_add_n_8_8888),
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, x8b8g8r8, sse2_composite_add_n_8_8888),
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, a8b8g8r8, sse2_composite_add_n_8_8888),
+    PIXMAN_WIDE_FAST_PATH (ADD, a8r8g8b8, a8r8g8b8_sRGB, sse2_composite_add_8888_srgb),
+    PIXMAN_WIDE_FAST_PATH (ADD, a8r8g8b8_sRGB, a8r8g8b8_sRGB, sse2_composite_add_srgb_srgb),
+    PIXMAN_WIDE_FAST_PATH (ADD, r8g8b8_sRGB, a8r8g8b8_sRGB, sse2_composite_add_srgb24_srgb),
+    PIXMAN_WIDE_FAST_PATH (ADD, a8r8g8b8, r8g8b8_sRGB, sse2_composite_add_8888_srgb24),
+    PIXMAN_WIDE_FAST_PATH (ADD, a8r8g8b8_sRGB, r8g8b8_sRGB, sse2_composite_add_srgb_srgb24),
+    PIXMAN_WIDE_FAST_PATH (ADD, r8g8b8_sRGB, r8g8b8_sRGB, sse2_composite_add_srgb24_srgb24),
 
     /* PIXMAN_OP_SRC */
     PIXMAN_STD_FAST_PATH (SRC, solid, a8, a8r8g8b8, sse2_composite_src_n_8_8888),
@@ -6254,6 +8827,48 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area),
     PIXMAN_STD_FAST_PATH (SRC, r5g6b5, null, r5g6b5, sse2_composite_copy_area),
     PIXMAN_STD_FAST_PATH (SRC, b5g6r5, null, b5g6r5, sse2_composite_copy_area),
+    PIXMAN_STD_FAST_PATH (SRC, yv12, null, a8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_STD_FAST_PATH (SRC, yv12, null, x8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_STD_FAST_PATH (SRC, i420, null, a8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_STD_FAST_PATH (SRC, i420, null, x8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_STD_FAST_PATH (SRC, nv12, null, a8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_STD_FAST_PATH (SRC, nv12, null, x8r8g8b8, sse2_composite_src_yuv_8888),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8_sRGB, sse2_composite_src_8888_srgb),
+    PIXMAN_WIDE_FAST_PATH (SRC, r8g8b8_sRGB, a8r8g8b8_sRGB, sse2_composite_src_srgb24_srgb),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, r8g8b8_sRGB, sse2_composite_src_8888_srgb24),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8_sRGB, r8g8b8_sRGB, sse2_composite_src_srgb_srgb24),
+    PIXMAN_WIDE_FAST_PATH (SRC, solid, a2r10g10b10, sse2_composite_src_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, solid, x2r10g10b10, sse2_composite_src_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, solid, a2b10g10r10, sse2_composite_src_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, solid, x2b10g10r10, sse2_composite_src_n_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, a2r10g10b10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, x2r10g10b10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8r8g8b8, a2r10g10b10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8r8g8b8, x2r10g10b10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8b8g8r8, a2b10g10r10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8b8g8r8, x2b10g10r10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8b8g8r8, a2b10g10r10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8b8g8r8, x2b10g10r10, sse2_composite_src_8888_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x2r10g10b10, a2r10g10b10, sse2_composite_src_x2101010_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, x2b10g10r10, a2b10g10r10, sse2_composite_src_x2101010_2101010),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2r10g10b10, a2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2b10g10r10, a2b10g10r10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2r10g10b10, x2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2b10g10r10, x2b10g10r10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, x2r10g10b10, x2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, x2b10g10r10, x2b10g10r10, sse2_composite_copy_area),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, r5g6b5, sse2_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, r5g6b5, sse2_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, b5g6r5, sse2_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, b5g6r5, sse2_composite_src_8888_0565_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, a2r10g10b10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8r8g8b8, x2r10g10b10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, a2r10g10b10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8r8g8b8, x2r10g10b10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, a2b10g10r10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, a8b8g8r8, x2b10g10r10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, a2b10g10r10, sse2_composite_src_8888_2101010_dither),
+    PIXMAN_DITHER_FAST_PATH (SRC, x8b8g8r8, x2b10g10r10, sse2_composite_src_8888_2101010_dither),
 
     /* PIXMAN_OP_IN */
     PIXMAN_STD_FAST_PATH (IN, a8, null, a8, sse2_composite_in_8_8),
@@ -6277,6 +8892,13 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, sse2_8888_8888),
     SIMPLE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, sse2_8888_8888),
 
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, yv12, a8r8g8b8, sse2_yuv_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, yv12, x8r8g8b8, sse2_yuv_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, i420, a8r8g8b8, sse2_yuv_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, i420, x8r8g8b8, sse2_yuv_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, nv12, a8r8g8b8, sse2_yuv_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, nv12, x8r8g8b8, sse2_yuv_8888),
+
     SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, x8r8g8b8, a8r8g8b8, sse2_x888_8888),
     SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, x8b8g8r8, a8b8g8r8, sse2_x888_8888),
     SIMPLE_BILINEAR_FAST_PATH_PAD    (SRC, x8r8g8b8, a8r8g8b8, sse2_x888_8888),
@@ -6299,6 +8921,34 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8_8888),
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8_8888),
 
+    WIDE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, a2r10g10b10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, x2r10g10b10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, a2r10g10b10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, x2r10g10b10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, a2b10g10r10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x2b10g10r10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, a2b10g10r10, sse2_composite_scaled_bilinear_src_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x2b10g10r10, sse2_composite_scaled_bilinear_src_8888_2101010),
+
+    WIDE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, a2r10g10b10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, x2r10g10b10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, x8r8g8b8, a2r10g10b10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, x8r8g8b8, x2r10g10b10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, a2b10g10r10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, x2b10g10r10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, x8b8g8r8, a2b10g10r10, sse2_composite_scaled_bilinear_over_8888_2101010),
+    WIDE_BILINEAR_FAST_PATH (OVER, x8b8g8r8, x2b10g10r10, sse2_composite_scaled_bilinear_over_8888_2101010),
+
+    PIXMAN_ALPHA_MAP_FAST_PATH (OVER, x8r8g8b8, a8r8g8b8, sse2_composite_over_8888_a8map_8888),
+    PIXMAN_ALPHA_MAP_FAST_PATH (OVER, x8r8g8b8, x8r8g8b8, sse2_composite_over_8888_a8map_8888),
+    PIXMAN_ALPHA_MAP_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_composite_over_8888_a8map_8888),
+    PIXMAN_ALPHA_MAP_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, sse2_composite_over_8888_a8map_8888),
+
+    HSL_FAST_PATHS (HSL_HUE, sse2_composite_hsl_hue_8888_8888),
+    HSL_FAST_PATHS (HSL_SATURATION, sse2_composite_hsl_saturation_8888_8888),
+    HSL_FAST_PATHS (HSL_COLOR, sse2_composite_hsl_color_8888_8888),
+    HSL_FAST_PATHS (HSL_LUMINOSITY, sse2_composite_hsl_luminosity_8888_8888),
+
     { PIXMAN_OP_NONE },
 };
 
@@ -6338,6 +8988,15 @@ sse2_fetch_x8r8g8b8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+static uint32_t *
+sse2_fetch_8888_a8 (pixman_iter_t *iter, const uint32_t *mask)
+{
+    fetch_8888_a8_line (iter->image, iter->x, iter->y++, iter->width,
+			iter->buffer);
+
+    return iter->buffer;
+}
+
 static uint32_t *
 sse2_fetch_r5g6b5 (pixman_iter_t *iter, const uint32_t *mask)
 {
@@ -6430,10 +9089,29 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+static uint32_t *
+sse2_fetch_planar_yuv (pixman_iter_t *iter, const uint32_t *mask)
+{
+    bits_image_t *image = &iter->image->bits;
+    const pixman_yuv_coefficients_t *c = _pixman_yuv_get_coefficients (image);
+    sse2_yuv_coefficients_t k;
+    pixman_yuv_line_t yuv;
+
+    sse2_yuv_coefficients_init (&k, c);
+
+    _pixman_yuv_get_line (image, iter->y++, &yuv);
+    sse2_convert_yuv_line (iter->buffer, &yuv, iter->x, iter->width, c, &k);
+
+    return iter->buffer;
+}
+
 #define IMAGE_FLAGS							\
     (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
      FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
 
+#define ALPHA_MAP_IMAGE_FLAGS						\
+    ((IMAGE_FLAGS & ~FAST_PATH_NO_ALPHA_MAP) | FAST_PATH_A8_ALPHA_MAP)
+
 static const pixman_iter_info_t sse2_iters[] = 
 {
     { PIXMAN_x8r8g8b8, IMAGE_FLAGS, ITER_NARROW,
@@ -6445,6 +9123,25 @@ static const pixman_iter_info_t sse2_iters[] =
     { PIXMAN_a8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_a8, NULL
     },
+    { PIXMAN_yv12, IMAGE_FLAGS, ITER_NARROW,
+      NULL, sse2_fetch_planar_yuv, NULL
+    },
+    { PIXMAN_i420, IMAGE_FLAGS, ITER_NARROW,
+      NULL, sse2_fetch_planar_yuv, NULL
+    },
+    { PIXMAN_nv12, IMAGE_FLAGS, ITER_NARROW,
+      NULL, sse2_fetch_planar_yuv, NULL
+    },
+    { PIXMAN_x8r8g8b8, ALPHA_MAP_IMAGE_FLAGS, ITER_NARROW,
+      NULL, sse2_fetch_8888_a8, NULL
+    },
+    { PIXMAN_a8r8g8b8, ALPHA_MAP_IMAGE_FLAGS, ITER_NARROW,
+      NULL, sse2_fetch_8888_a8, NULL
+    },
+    { PIXMAN_any, FAST_PATH_NO_ACCESSORS | FAST_PATH_NO_ALPHA_MAP,
+      ITER_WIDE | ITER_DEST,
+      sse2_dest_iter_init_dither, NULL, NULL
+    },
     { PIXMAN_null },
 };
 
@@ -6489,6 +9186,11 @@ _pixman_implementation_create_sse2 (pixman_implementation_t *fallback)
 
     imp->combine_32[PIXMAN_OP_SATURATE] = sse2_combine_saturate_u;
 
+    imp->combine_float[PIXMAN_OP_HSL_HUE] = sse2_combine_hsl_hue_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_SATURATION] = sse2_combine_hsl_saturation_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_COLOR] = sse2_combine_hsl_color_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_LUMINOSITY] = sse2_combine_hsl_luminosity_u_float;
+
     imp->combine_32_ca[PIXMAN_OP_SRC] = sse2_combine_src_ca;
     imp->combine_32_ca[PIXMAN_OP_OVER] = sse2_combine_over_ca;
     imp->combine_32_ca[PIXMAN_OP_OVER_REVERSE] = sse2_combine_over_reverse_ca;
@@ -6501,8 +9203,34 @@ _pixman_implementation_create_sse2 (pixman_implementation_t *fallback)
     imp->combine_32_ca[PIXMAN_OP_XOR] = sse2_combine_xor_ca;
     imp->combine_32_ca[PIXMAN_OP_ADD] = sse2_combine_add_ca;
 
+    imp->combine_64[PIXMAN_OP_SRC] = sse2_combine_src_u_64;
+    imp->combine_64[PIXMAN_OP_OVER] = sse2_combine_over_u_64;
+    imp->combine_64[PIXMAN_OP_OVER_REVERSE] = sse2_combine_over_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_IN] = sse2_combine_in_u_64;
+    imp->combine_64[PIXMAN_OP_IN_REVERSE] = sse2_combine_in_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_OUT] = sse2_combine_out_u_64;
+    imp->combine_64[PIXMAN_OP_OUT_REVERSE] = sse2_combine_out_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_ATOP] = sse2_combine_atop_u_64;
+    imp->combine_64[PIXMAN_OP_ATOP_REVERSE] = sse2_combine_atop_reverse_u_64;
+    imp->combine_64[PIXMAN_OP_XOR] = sse2_combine_xor_u_64;
+    imp->combine_64[PIXMAN_OP_ADD] = sse2_combine_add_u_64;
+
+    imp->combine_64_ca[PIXMAN_OP_SRC] = sse2_combine_src_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OVER] = sse2_combine_over_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OVER_REVERSE] = sse2_combine_over_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_IN] = sse2_combine_in_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_IN_REVERSE] = sse2_combine_in_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OUT] = sse2_combine_out_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_OUT_REVERSE] = sse2_combine_out_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ATOP] = sse2_combine_atop_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ATOP_REVERSE] = sse2_combine_atop_reverse_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_XOR] = sse2_combine_xor_ca_64;
+    imp->combine_64_ca[PIXMAN_OP_ADD] = sse2_combine_add_ca_64;
+
     imp->blt = sse2_blt;
     imp->fill = sse2_fill;
+    imp->convert = sse2_convert;
+    imp->premultiply = sse2_premultiply;
 
     imp->iter_info = sse2_iters;
 
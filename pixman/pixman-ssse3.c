@@ -339,6 +339,135 @@ static const pixman_fast_path_t ssse3_fast_paths[] =
     { PIXMAN_OP_NONE },
 };
 
+/* Formats with 8 bit channels, described by the byte in the pixel
+ * where each channel lives, so that converting between any two of them
+ * is a pshufb.
+ */
+typedef struct
+{
+    pixman_format_code_t	format;
+    int				bytes;
+    int				offset[4];	/* a, r, g, b; -1 if absent */
+} byte_layout_t;
+
+static const byte_layout_t byte_layouts[] =
+{
+    { PIXMAN_a8r8g8b8, 4, {  3, 2, 1, 0 } },
+    { PIXMAN_x8r8g8b8, 4, { -1, 2, 1, 0 } },
+    { PIXMAN_a8b8g8r8, 4, {  3, 0, 1, 2 } },
+    { PIXMAN_x8b8g8r8, 4, { -1, 0, 1, 2 } },
+    { PIXMAN_b8g8r8a8, 4, {  0, 1, 2, 3 } },
+    { PIXMAN_b8g8r8x8, 4, { -1, 1, 2, 3 } },
+    { PIXMAN_r8g8b8a8, 4, {  0, 3, 2, 1 } },
+    { PIXMAN_r8g8b8x8, 4, { -1, 3, 2, 1 } },
+    { PIXMAN_r8g8b8,   3, { -1, 2, 1, 0 } },
+    { PIXMAN_b8g8r8,   3, { -1, 0, 1, 2 } },
+};
+
+static const byte_layout_t *
+find_byte_layout (pixman_format_code_t format)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof (byte_layouts) / sizeof (byte_layouts[0]); ++i)
+    {
+	if (byte_layouts[i].format == format)
+	    return &byte_layouts[i];
+    }
+
+    return NULL;
+}
+
+static pixman_bool_t
+ssse3_convert (pixman_implementation_t *imp,
+	       pixman_format_code_t     src_format,
+	       const uint8_t *          src,
+	       int                      src_stride,
+	       pixman_format_code_t     dst_format,
+	       uint8_t *                dst,
+	       int                      dst_stride,
+	       int                      width,
+	       int                      height)
+{
+    const byte_layout_t *s = find_byte_layout (src_format);
+    const byte_layout_t *d = find_byte_layout (dst_format);
+    uint8_t shuffle[16], alpha[16];
+    __m128i xmm_shuffle, xmm_alpha;
+    int i, c, min_width;
+
+    if (!s || !d)
+	return FALSE;
+
+    /* Four pixels at a time. Unused destination bytes, and alpha when
+     * the source has none, are zero in the shuffle and then get the
+     * alpha mask or'ed in.
+     */
+    memset (shuffle, 0x80, sizeof shuffle);
+    memset (alpha, 0, sizeof alpha);
+
+    for (i = 0; i < 4; ++i)
+    {
+	for (c = 0; c < 4; ++c)
+	{
+	    int o = d->offset[c];
+
+	    if (o < 0)
+		continue;
+
+	    if (s->offset[c] >= 0)
+		shuffle[i * d->bytes + o] = i * s->bytes + s->offset[c];
+	    else
+		alpha[i * d->bytes + o] = 0xff;
+	}
+    }
+
+    xmm_shuffle = _mm_loadu_si128 ((__m128i *)shuffle);
+    xmm_alpha = _mm_loadu_si128 ((__m128i *)alpha);
+
+    /* With 3 byte pixels, 16 byte loads and stores only stay within the
+     * row when at least six pixels are left.
+     */
+    min_width = (s->bytes == 3 || d->bytes == 3)? 6 : 4;
+
+    while (height--)
+    {
+	const uint8_t *sp = src;
+	uint8_t *dp = dst;
+	int w = width;
+
+	while (w >= min_width)
+	{
+	    __m128i p = _mm_loadu_si128 ((__m128i *)sp);
+
+	    p = _mm_or_si128 (_mm_shuffle_epi8 (p, xmm_shuffle), xmm_alpha);
+	    _mm_storeu_si128 ((__m128i *)dp, p);
+
+	    sp += 4 * s->bytes;
+	    dp += 4 * d->bytes;
+	    w -= 4;
+	}
+
+	while (w--)
+	{
+	    for (c = 0; c < 4; ++c)
+	    {
+		int o = d->offset[c];
+
+		if (o >= 0)
+		    dp[o] = s->offset[c] >= 0 ? sp[s->offset[c]] : 0xff;
+	    }
+
+	    sp += s->bytes;
+	    dp += d->bytes;
+	}
+
+	src += src_stride;
+	dst += dst_stride;
+    }
+
+    return TRUE;
+}
+
 pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback)
 {
@@ -346,6 +475,7 @@ _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback)
 	_pixman_implementation_create (fallback, ssse3_fast_paths);
 
     imp->iter_info = ssse3_iters;
+    imp->convert = ssse3_convert;
 
     return imp;
 }
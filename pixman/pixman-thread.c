@@ -0,0 +1,451 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <pixman-config.h>
+#endif
+
+#include <stdlib.h>
+#include "pixman-private.h"
+
+#if defined(HAVE_PTHREADS)
+#include <pthread.h>
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+/*
+ * Worker threads
+ *
+ * Work that can be split into independent jobs is handed to
+ * _pixman_run_jobs(), which runs the jobs on up to the configured number
+ * of threads and returns when all of them are done. The worker threads
+ * are started when they are first needed and then wait for more work,
+ * so only the first call pays for creating them. The calling thread runs
+ * jobs too, so all jobs get done even if no worker could be started. One
+ * caller at a time gets the workers; any other runs its jobs itself.
+ *
+ * When the library is unloaded, _pixman_stop_threads() makes the workers
+ * exit and waits for them. On Windows that would deadlock on the loader
+ * lock, so there the library is pinned in memory instead once it has
+ * started a worker.
+ */
+
+static int n_rasterization_threads = 1;
+
+PIXMAN_EXPORT void
+pixman_set_rasterization_threads (int n_threads)
+{
+    if (n_threads < 1)
+	n_threads = 1;
+    if (n_threads > PIXMAN_MAX_THREADS)
+	n_threads = PIXMAN_MAX_THREADS;
+
+    PIXMAN_ATOMIC_STORE_INT (&n_rasterization_threads, n_threads);
+}
+
+int
+_pixman_get_rasterization_threads (void)
+{
+#if defined(HAVE_PTHREADS) || defined(_WIN32)
+    return PIXMAN_ATOMIC_LOAD_INT (&n_rasterization_threads);
+#else
+    return 1;
+#endif
+}
+
+static void
+run_jobs_serially (int n_jobs, pixman_job_func_t func, void *data)
+{
+    int i;
+
+    for (i = 0; i < n_jobs; ++i)
+	func (data, i);
+}
+
+#if defined(HAVE_PTHREADS) || defined(_WIN32)
+
+#if defined(HAVE_PTHREADS)
+
+typedef pthread_t thread_t;
+typedef pthread_mutex_t lock_t;
+typedef pthread_cond_t cond_t;
+
+#define LOCK_INIT		PTHREAD_MUTEX_INITIALIZER
+#define COND_INIT		PTHREAD_COND_INITIALIZER
+#define pool_lock()		pthread_mutex_lock (&pool.lock)
+#define pool_unlock()		pthread_mutex_unlock (&pool.lock)
+#define pool_wait(c)		pthread_cond_wait (&pool.c, &pool.lock)
+#define pool_signal(c)		pthread_cond_signal (&pool.c)
+#define pool_broadcast(c)	pthread_cond_broadcast (&pool.c)
+
+#else
+
+typedef HANDLE thread_t;
+typedef SRWLOCK lock_t;
+typedef CONDITION_VARIABLE cond_t;
+
+#define LOCK_INIT		SRWLOCK_INIT
+#define COND_INIT		CONDITION_VARIABLE_INIT
+#define pool_lock()		AcquireSRWLockExclusive (&pool.lock)
+#define pool_unlock()		ReleaseSRWLockExclusive (&pool.lock)
+#define pool_wait(c)		SleepConditionVariableSRW (&pool.c, &pool.lock, INFINITE, 0)
+#define pool_signal(c)		WakeConditionVariable (&pool.c)
+#define pool_broadcast(c)	WakeAllConditionVariable (&pool.c)
+
+#endif
+
+/* Everything in the pool is protected by its lock. Worker i takes jobs
+ * while i < n_active_workers and there are jobs left, and exits once
+ * quit is set.
+ */
+static struct
+{
+    lock_t		lock;
+    cond_t		work_cond;
+    cond_t		done_cond;
+
+    thread_t		workers[PIXMAN_MAX_THREADS];
+    int			n_workers;
+    pixman_bool_t	busy;
+    pixman_bool_t	quit;
+
+    int			n_active_workers;
+    pixman_job_func_t	func;
+    void *		data;
+    int			n_jobs;
+    int			next_job;
+    int			n_done;
+} pool = { LOCK_INIT, COND_INIT, COND_INIT };
+
+/* Runs jobs until there are none left; called and returns with the lock
+ * held.
+ */
+static void
+run_pool_jobs (void)
+{
+    while (pool.next_job < pool.n_jobs)
+    {
+	pixman_job_func_t func = pool.func;
+	void *data = pool.data;
+	int job = pool.next_job++;
+
+	pool_unlock ();
+	func (data, job);
+	pool_lock ();
+
+	if (++pool.n_done == pool.n_jobs)
+	    pool_signal (done_cond);
+    }
+}
+
+static void
+worker_main (int index)
+{
+    pool_lock ();
+
+    while (!pool.quit)
+    {
+	if (index >= pool.n_active_workers || pool.next_job >= pool.n_jobs)
+	    pool_wait (work_cond);
+	else
+	    run_pool_jobs ();
+    }
+
+    pool_unlock ();
+}
+
+#if defined(HAVE_PTHREADS)
+
+static void *
+thread_main (void *data)
+{
+    worker_main ((int)(intptr_t)data);
+
+    return NULL;
+}
+
+static pixman_bool_t
+start_worker (int index)
+{
+    return pthread_create (&pool.workers[index], NULL, thread_main,
+			   (void *)(intptr_t)index) == 0;
+}
+
+static void
+join_worker (int index)
+{
+    pthread_join (pool.workers[index], NULL);
+}
+
+#else
+
+static DWORD WINAPI
+thread_main (LPVOID data)
+{
+    worker_main ((int)(intptr_t)data);
+
+    return 0;
+}
+
+static pixman_bool_t
+start_worker (int index)
+{
+    pool.workers[index] =
+	CreateThread (NULL, 0, thread_main, (LPVOID)(intptr_t)index, 0, NULL);
+
+    return pool.workers[index] != NULL;
+}
+
+static void
+join_worker (int index)
+{
+    WaitForSingleObject (pool.workers[index], INFINITE);
+    CloseHandle (pool.workers[index]);
+}
+
+#endif
+
+#if defined(_WIN32)
+
+static pixman_bool_t
+pin_library (void)
+{
+    HMODULE module;
+
+    return GetModuleHandleExW (GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+			       GET_MODULE_HANDLE_EX_FLAG_PIN,
+			       (LPCWSTR)(void *)pin_library, &module);
+}
+
+#else
+
+#define pin_library() TRUE
+
+#endif
+
+void
+_pixman_run_jobs (int               n_threads,
+		  int               n_jobs,
+		  pixman_job_func_t func,
+		  void *            data)
+{
+    if (n_threads > n_jobs)
+	n_threads = n_jobs;
+    if (n_threads > PIXMAN_MAX_THREADS)
+	n_threads = PIXMAN_MAX_THREADS;
+
+    if (n_threads <= 1)
+    {
+	run_jobs_serially (n_jobs, func, data);
+	return;
+    }
+
+    pool_lock ();
+
+    if (pool.busy || pool.quit || (pool.n_workers == 0 && !pin_library ()))
+    {
+	pool_unlock ();
+	run_jobs_serially (n_jobs, func, data);
+	return;
+    }
+
+    pool.busy = TRUE;
+
+    /* The calling thread is one of the n_threads */
+    while (pool.n_workers < n_threads - 1 && start_worker (pool.n_workers))
+	pool.n_workers++;
+
+    pool.n_active_workers = n_threads - 1;
+    pool.func = func;
+    pool.data = data;
+    pool.n_jobs = n_jobs;
+    pool.next_job = 0;
+    pool.n_done = 0;
+
+    pool_broadcast (work_cond);
+
+    run_pool_jobs ();
+
+    while (pool.n_done < pool.n_jobs)
+	pool_wait (done_cond);
+
+    pool.busy = FALSE;
+
+    pool_unlock ();
+}
+
+void
+_pixman_stop_threads (void)
+{
+#if !defined(_WIN32)
+    int n_workers, i;
+
+    pool_lock ();
+
+    pool.quit = TRUE;
+    n_workers = pool.n_workers;
+    pool_broadcast (work_cond);
+
+    pool_unlock ();
+
+    /* A worker that is running a job finishes it before it exits */
+    for (i = 0; i < n_workers; ++i)
+	join_worker (i);
+#endif
+}
+
+#else
+
+void
+_pixman_run_jobs (int               n_threads,
+		  int               n_jobs,
+		  pixman_job_func_t func,
+		  void *            data)
+{
+    run_jobs_serially (n_jobs, func, data);
+}
+
+void
+_pixman_stop_threads (void)
+{
+}
+
+#endif
+
+/*
+ * Mutexes
+ */
+
+#if defined(HAVE_PTHREADS)
+
+struct pixman_mutex
+{
+    pthread_mutex_t	mutex;
+};
+
+pixman_mutex_t *
+_pixman_mutex_create (void)
+{
+    pixman_mutex_t *mutex;
+
+    if (!(mutex = malloc (sizeof *mutex)))
+	return NULL;
+
+    if (pthread_mutex_init (&mutex->mutex, NULL) != 0)
+    {
+	free (mutex);
+	return NULL;
+    }
+
+    return mutex;
+}
+
+void
+_pixman_mutex_destroy (pixman_mutex_t *mutex)
+{
+    pthread_mutex_destroy (&mutex->mutex);
+    free (mutex);
+}
+
+void
+_pixman_mutex_lock (pixman_mutex_t *mutex)
+{
+    pthread_mutex_lock (&mutex->mutex);
+}
+
+void
+_pixman_mutex_unlock (pixman_mutex_t *mutex)
+{
+    pthread_mutex_unlock (&mutex->mutex);
+}
+
+#elif defined(_WIN32)
+
+struct pixman_mutex
+{
+    CRITICAL_SECTION	section;
+};
+
+pixman_mutex_t *
+_pixman_mutex_create (void)
+{
+    pixman_mutex_t *mutex;
+
+    if (!(mutex = malloc (sizeof *mutex)))
+	return NULL;
+
+    InitializeCriticalSection (&mutex->section);
+
+    return mutex;
+}
+
+void
+_pixman_mutex_destroy (pixman_mutex_t *mutex)
+{
+    DeleteCriticalSection (&mutex->section);
+    free (mutex);
+}
+
+void
+_pixman_mutex_lock (pixman_mutex_t *mutex)
+{
+    EnterCriticalSection (&mutex->section);
+}
+
+void
+_pixman_mutex_unlock (pixman_mutex_t *mutex)
+{
+    LeaveCriticalSection (&mutex->section);
+}
+
+#else
+
+/* Without threads, there is nothing to protect against */
+struct pixman_mutex
+{
+    int			dummy;
+};
+
+pixman_mutex_t *
+_pixman_mutex_create (void)
+{
+    return malloc (sizeof (pixman_mutex_t));
+}
+
+void
+_pixman_mutex_destroy (pixman_mutex_t *mutex)
+{
+    free (mutex);
+}
+
+void
+_pixman_mutex_lock (pixman_mutex_t *mutex)
+{
+}
+
+void
+_pixman_mutex_unlock (pixman_mutex_t *mutex)
+{
+}
+
+#endif
@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "pixman-private.h"
 
 /*
@@ -229,6 +230,44 @@ pixman_line_fixed_edge_init (pixman_edge_t *            e,
                       bot->y + y_off_fixed);
 }
 
+/*
+ * Compute the range of y values that a trapezoid from top to bottom
+ * covers in the image. This is from the first to the last sample row,
+ * or with exact coverage, the exact top and bottom clipped to the image.
+ */
+static pixman_bool_t
+get_trap_y_range (pixman_image_t *image,
+		  pixman_fixed_t  top,
+		  pixman_fixed_t  bottom,
+		  pixman_fixed_t *t,
+		  pixman_fixed_t *b)
+{
+    int bpp = PIXMAN_FORMAT_BPP (image->bits.format);
+    int height = image->bits.height;
+
+    if (top < 0)
+	top = 0;
+
+    if (bpp == 8 && image->bits.exact_coverage)
+    {
+	if (bottom > pixman_int_to_fixed (height))
+	    bottom = pixman_int_to_fixed (height);
+
+	*t = top;
+	*b = bottom;
+
+	return bottom > top;
+    }
+
+    *t = pixman_sample_ceil_y (top, bpp);
+
+    if (pixman_fixed_to_int (bottom) >= height)
+	bottom = pixman_int_to_fixed (height) - 1;
+    *b = pixman_sample_floor_y (bottom, bpp);
+
+    return *b >= *t;
+}
+
 PIXMAN_EXPORT void
 pixman_add_traps (pixman_image_t *     image,
                   int16_t              x_off,
@@ -237,7 +276,6 @@ pixman_add_traps (pixman_image_t *     image,
                   const pixman_trap_t *traps)
 {
     int bpp;
-    int height;
 
     pixman_fixed_t x_off_fixed;
     pixman_fixed_t y_off_fixed;
@@ -246,7 +284,6 @@ pixman_add_traps (pixman_image_t *     image,
 
     _pixman_image_validate (image);
     
-    height = image->bits.height;
     bpp = PIXMAN_FORMAT_BPP (image->bits.format);
 
     x_off_fixed = pixman_int_to_fixed (x_off);
@@ -254,17 +291,10 @@ pixman_add_traps (pixman_image_t *     image,
 
     while (ntrap--)
     {
-	t = traps->top.y + y_off_fixed;
-	if (t < 0)
-	    t = 0;
-	t = pixman_sample_ceil_y (t, bpp);
-
-	b = traps->bot.y + y_off_fixed;
-	if (pixman_fixed_to_int (b) >= height)
-	    b = pixman_int_to_fixed (height) - 1;
-	b = pixman_sample_floor_y (b, bpp);
-
-	if (b >= t)
+	if (get_trap_y_range (image,
+			      traps->top.y + y_off_fixed,
+			      traps->bot.y + y_off_fixed,
+			      &t, &b))
 	{
 	    /* initialize edge walkers */
 	    pixman_edge_init (&l, bpp, t,
@@ -349,7 +379,6 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
                             int                       y_off)
 {
     int bpp;
-    int height;
 
     pixman_fixed_t y_off_fixed;
     pixman_edge_t l, r;
@@ -362,22 +391,14 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
     if (!pixman_trapezoid_valid (trap))
 	return;
 
-    height = image->bits.height;
     bpp = PIXMAN_FORMAT_BPP (image->bits.format);
 
     y_off_fixed = pixman_int_to_fixed (y_off);
 
-    t = trap->top + y_off_fixed;
-    if (t < 0)
-	t = 0;
-    t = pixman_sample_ceil_y (t, bpp);
-
-    b = trap->bottom + y_off_fixed;
-    if (pixman_fixed_to_int (b) >= height)
-	b = pixman_int_to_fixed (height) - 1;
-    b = pixman_sample_floor_y (b, bpp);
-    
-    if (b >= t)
+    if (get_trap_y_range (image,
+			  trap->top + y_off_fixed,
+			  trap->bottom + y_off_fixed,
+			  &t, &b))
     {
 	/* initialize edge walkers */
 	pixman_line_fixed_edge_init (&l, bpp, t, &trap->left, x_off, y_off);
@@ -404,6 +425,26 @@ static const pixman_bool_t zero_src_has_no_effect[PIXMAN_N_OPERATORS] =
     TRUE,	/* Add			1			1    */
 };
 
+/* Grow 'box' to include the pixels that the x coordinate 'x' touches */
+static force_inline void
+extend_box_x (pixman_box32_t *box, pixman_fixed_t x)
+{
+    if (pixman_fixed_to_int (x) < box->x1)
+	box->x1 = pixman_fixed_to_int (x);
+    if (pixman_fixed_to_int (pixman_fixed_ceil (x)) > box->x2)
+	box->x2 = pixman_fixed_to_int (pixman_fixed_ceil (x));
+}
+
+/* Grow 'box' to include the pixels that the y coordinate 'y' touches */
+static force_inline void
+extend_box_y (pixman_box32_t *box, pixman_fixed_t y)
+{
+    if (pixman_fixed_to_int (y) < box->y1)
+	box->y1 = pixman_fixed_to_int (y);
+    if (pixman_fixed_to_int (pixman_fixed_ceil (y)) > box->y2)
+	box->y2 = pixman_fixed_to_int (pixman_fixed_ceil (y));
+}
+
 static pixman_bool_t
 get_trap_extents (pixman_op_t op, pixman_image_t *dest,
 		  const pixman_trapezoid_t *traps, int n_traps,
@@ -445,21 +486,10 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
 	if (y2 > box->y2)
 	    box->y2 = y2;
 	    
-#define EXTEND_MIN(x)							\
-	if (pixman_fixed_to_int ((x)) < box->x1)			\
-	    box->x1 = pixman_fixed_to_int ((x));
-#define EXTEND_MAX(x)							\
-	if (pixman_fixed_to_int (pixman_fixed_ceil ((x))) > box->x2)	\
-	    box->x2 = pixman_fixed_to_int (pixman_fixed_ceil ((x)));
-	    
-#define EXTEND(x)							\
-	EXTEND_MIN(x);							\
-	EXTEND_MAX(x);
-	    
-	EXTEND(trap->left.p1.x);
-	EXTEND(trap->left.p2.x);
-	EXTEND(trap->right.p1.x);
-	EXTEND(trap->right.p2.x);
+	extend_box_x (box, trap->left.p1.x);
+	extend_box_x (box, trap->left.p2.x);
+	extend_box_x (box, trap->right.p1.x);
+	extend_box_x (box, trap->right.p2.x);
     }
 	
     if (box->x1 >= box->x2 || box->y1 >= box->y2)
@@ -469,81 +499,107 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
 }
 
 /*
- * pixman_composite_trapezoids()
- *
- * All the trapezoids are conceptually rendered to an infinitely big image.
- * The (0, 0) coordinates of this image are then aligned with the (x, y)
- * coordinates of the source image, and then both images are aligned with
- * the (x, y) coordinates of the destination. Then these three images are
- * composited across the entire destination.
+ * Step an edge from the sample row 'from' down to the sample row 'to'.
+ * This gives exactly the same result as stepping it one sample row at a
+ * time, but in constant time.
  */
-PIXMAN_EXPORT void
-pixman_composite_trapezoids (pixman_op_t		op,
-			     pixman_image_t *		src,
-			     pixman_image_t *		dst,
-			     pixman_format_code_t	mask_format,
-			     int			x_src,
-			     int			y_src,
-			     int			x_dst,
-			     int			y_dst,
-			     int			n_traps,
-			     const pixman_trapezoid_t *	traps)
+static void
+edge_step_samples (pixman_edge_t *e,
+		   int            n,
+		   pixman_fixed_t from,
+		   pixman_fixed_t to)
 {
-    int i;
+    pixman_fixed_48_16_t n_big, n_small, ne;
 
-    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
-    
-    if (n_traps <= 0)
+    if (to <= from)
 	return;
 
-    _pixman_image_validate (src);
-    _pixman_image_validate (dst);
+    n_big = pixman_fixed_to_int (to) - pixman_fixed_to_int (from);
+    n_small = n_big * (N_Y_FRAC (n) - 1) +
+	(pixman_fixed_frac (to) - pixman_fixed_frac (from)) / STEP_Y_SMALL (n);
 
-    if (op == PIXMAN_OP_ADD &&
-	(src->common.flags & FAST_PATH_IS_OPAQUE)		&&
-	(mask_format == dst->common.extended_format_code)	&&
-	!(dst->common.have_clip_region))
+    e->x += n_small * e->stepx_small + n_big * e->stepx_big;
+
+    ne = e->e + n_small * e->dx_small + n_big * e->dx_big;
+    if (ne > 0 && e->dy)
     {
-	for (i = 0; i < n_traps; ++i)
-	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
-		continue;
-	    
-	    pixman_rasterize_trapezoid (dst, trap, x_dst, y_dst);
-	}
+	pixman_fixed_48_16_t nx = (ne + e->dy - 1) / e->dy;
+
+	ne -= nx * e->dy;
+	e->x += nx * e->signdx;
     }
-    else
+
+    e->e = ne;
+}
+
+/*
+ * Rasterize the edges between t and b, which are in the coordinates of
+ * the full mask, into 'band', which is the part of the mask starting
+ * at row 'band_y'. The edges must have been initialized at t.
+ */
+static void
+rasterize_edges_in_band (pixman_image_t *band,
+			 int             band_y,
+			 pixman_edge_t * l,
+			 pixman_edge_t * r,
+			 pixman_fixed_t  t,
+			 pixman_fixed_t  b)
+{
+    int bpp = PIXMAN_FORMAT_BPP (band->bits.format);
+    pixman_fixed_t first, last;
+
+    t -= pixman_int_to_fixed (band_y);
+    b -= pixman_int_to_fixed (band_y);
+
+    /* The exact rasterizer clips to the image itself */
+    if (bpp == 8 && band->bits.exact_coverage)
     {
-	pixman_image_t *tmp;
-	pixman_box32_t box;
-	int i;
+	pixman_rasterize_edges (band, l, r, t, b);
+	return;
+    }
 
-	if (!get_trap_extents (op, dst, traps, n_traps, &box))
-	    return;
-	
-	if (!(tmp = pixman_image_create_bits (
-		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
+    first = Y_FRAC_FIRST (bpp);
+    last = pixman_int_to_fixed (band->bits.height - 1) + Y_FRAC_LAST (bpp);
+
+    if (b > last)
+	b = last;
+
+    if (t < first)
+    {
+	if (b < first)
 	    return;
-	
-	for (i = 0; i < n_traps; ++i)
-	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
-		continue;
-	    
-	    pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
-	}
-	
-	pixman_image_composite (op, src, tmp, dst,
-				x_src + box.x1, y_src + box.y1,
-				0, 0,
-				x_dst + box.x1, y_dst + box.y1,
-				box.x2 - box.x1, box.y2 - box.y1);
-	
-	pixman_image_unref (tmp);
+
+	edge_step_samples (l, bpp, t, first);
+	edge_step_samples (r, bpp, t, first);
+	t = first;
+    }
+
+    if (b >= t)
+	pixman_rasterize_edges (band, l, r, t, b);
+}
+
+static void
+rasterize_trapezoid_in_band (pixman_image_t *           image,
+			     pixman_image_t *           band,
+			     int                        band_y,
+			     const pixman_trapezoid_t * trap,
+			     int                        x_off,
+			     int                        y_off)
+{
+    int bpp = PIXMAN_FORMAT_BPP (image->bits.format);
+    pixman_fixed_t y_off_fixed = pixman_int_to_fixed (y_off);
+    pixman_edge_t l, r;
+    pixman_fixed_t t, b;
+
+    if (get_trap_y_range (image,
+			  trap->top + y_off_fixed,
+			  trap->bottom + y_off_fixed,
+			  &t, &b))
+    {
+	pixman_line_fixed_edge_init (&l, bpp, t, &trap->left, x_off, y_off);
+	pixman_line_fixed_edge_init (&r, bpp, t, &trap->right, x_off, y_off);
+
+	rasterize_edges_in_band (band, band_y, &l, &r, t, b);
     }
 }
 
@@ -556,156 +612,1146 @@ greater_y (const pixman_point_fixed_t *a, const pixman_point_fixed_t *b)
 }
 
 /*
- * Note that the definition of this function is a bit odd because
- * of the X coordinate space (y increasing downwards).
+ * Triangles are rasterized directly, as an upper and a lower part that
+ * share the long edge:
+ *
+ *		+		+
+ *	       / \             / \
+ *	      /   \           /	  \
+ *	     /     +         +	   \
+ *      /    --           --    \
+ *     /   --               --   \
+ *    / ---                   --- \
+ *	 +--                         --+
+ *
+ * The long edge is stepped straight from the upper part into the lower
+ * part, so it is only initialized once.
+ *
+ * 'band' is the part of 'image' starting at row 'band_y' that is written
+ * to; see rasterize_edges_in_band().
  */
-static int
-clockwise (const pixman_point_fixed_t *ref,
-	   const pixman_point_fixed_t *a,
-	   const pixman_point_fixed_t *b)
+static void
+rasterize_triangle (pixman_image_t *         image,
+		    pixman_image_t *         band,
+		    int                      band_y,
+		    const pixman_triangle_t *tri,
+		    int                      x_off,
+		    int                      y_off)
 {
-    pixman_point_fixed_t	ad, bd;
+    const pixman_point_fixed_t *pts[3], *tmp;
+    pixman_point_fixed_t top, mid, bot;
+    pixman_edge_t e_long, e_upper, e_short;
+    pixman_fixed_t t, b, t_long = 0;
+    pixman_bool_t have_long = FALSE;
+    pixman_bool_t mid_right;
+    int bpp = PIXMAN_FORMAT_BPP (image->bits.format);
+
+    pts[0] = &tri->p1;
+    pts[1] = &tri->p2;
+    pts[2] = &tri->p3;
+
+#define SORT(a, b)							\
+    if (greater_y (pts[a], pts[b]))					\
+    {									\
+	tmp = pts[a];							\
+	pts[a] = pts[b];						\
+	pts[b] = tmp;							\
+    }
 
-    ad.x = a->x - ref->x;
-    ad.y = a->y - ref->y;
-    bd.x = b->x - ref->x;
-    bd.y = b->y - ref->y;
+    SORT (0, 1);
+    SORT (1, 2);
+    SORT (0, 1);
 
-    return ((pixman_fixed_32_32_t) bd.y * ad.x -
-	    (pixman_fixed_32_32_t) ad.y * bd.x) < 0;
-}
+#undef SORT
 
-static void
-triangle_to_trapezoids (const pixman_triangle_t *tri, pixman_trapezoid_t *traps)
-{
-    const pixman_point_fixed_t *top, *left, *right, *tmp;
+    top.x = pts[0]->x + pixman_int_to_fixed (x_off);
+    top.y = pts[0]->y + pixman_int_to_fixed (y_off);
+    mid.x = pts[1]->x + pixman_int_to_fixed (x_off);
+    mid.y = pts[1]->y + pixman_int_to_fixed (y_off);
+    bot.x = pts[2]->x + pixman_int_to_fixed (x_off);
+    bot.y = pts[2]->y + pixman_int_to_fixed (y_off);
 
-    top = &tri->p1;
-    left = &tri->p2;
-    right = &tri->p3;
+    if (top.y == bot.y)
+	return;
 
-    if (greater_y (top, left))
-    {
-	tmp = left;
-	left = top;
-	top = tmp;
-    }
+    /* Is the middle vertex to the right of the long edge? */
+    mid_right =
+	(pixman_fixed_32_32_t) (mid.x - top.x) * (bot.y - top.y) >
+	(pixman_fixed_32_32_t) (bot.x - top.x) * (mid.y - top.y);
 
-    if (greater_y (top, right))
+    if (mid.y > top.y && get_trap_y_range (image, top.y, mid.y, &t, &b))
     {
-	tmp = right;
-	right = top;
-	top = tmp;
+	pixman_edge_init (&e_long, bpp, t, top.x, top.y, bot.x, bot.y);
+	pixman_edge_init (&e_short, bpp, t, top.x, top.y, mid.x, mid.y);
+
+	/* The rasterizer steps the edges it is given, so keep the long
+	 * edge as it is at t. With exact coverage, edges are evaluated
+	 * rather than stepped, so it is simply initialized again.
+	 */
+	e_upper = e_long;
+
+	if (mid_right)
+	    rasterize_edges_in_band (band, band_y, &e_upper, &e_short, t, b);
+	else
+	    rasterize_edges_in_band (band, band_y, &e_short, &e_upper, t, b);
+
+	if (bpp != 8 || !image->bits.exact_coverage)
+	{
+	    t_long = t;
+	    have_long = TRUE;
+	}
     }
 
-    if (clockwise (top, right, left))
+    if (bot.y > mid.y && get_trap_y_range (image, mid.y, bot.y, &t, &b))
     {
-	tmp = right;
-	right = left;
-	left = tmp;
-    }
-    
-    /*
-     * Two cases:
-     *
-     *		+		+
-     *	       / \             / \
-     *	      /   \           /	  \
-     *	     /     +         +	   \
-     *      /    --           --    \
-     *     /   --               --   \
-     *    / ---                   --- \
-     *	 +--                         --+
-     */
+	if (have_long)
+	    edge_step_samples (&e_long, bpp, t_long, t);
+	else
+	    pixman_edge_init (&e_long, bpp, t, top.x, top.y, bot.x, bot.y);
+	pixman_edge_init (&e_short, bpp, t, mid.x, mid.y, bot.x, bot.y);
 
-    traps->top = top->y;
-    traps->left.p1 = *top;
-    traps->left.p2 = *left;
-    traps->right.p1 = *top;
-    traps->right.p2 = *right;
+	if (mid_right)
+	    rasterize_edges_in_band (band, band_y, &e_long, &e_short, t, b);
+	else
+	    rasterize_edges_in_band (band, band_y, &e_short, &e_long, t, b);
+    }
+}
 
-    if (right->y < left->y)
-	traps->bottom = right->y;
-    else
-	traps->bottom = left->y;
+/*
+ * Parallel rasterization
+ *
+ * With more than one rasterization thread, the mask is split into bands
+ * of rows. The trapezoids or triangles are sorted into the bands they
+ * touch, and each band is rasterized, and composited if there is a
+ * temporary mask, by a single job. Jobs write to their own rows only.
+ *
+ * Within a band, the edges are initialized where the shape starts and
+ * then stepped to the first row of the band, so the result is the same
+ * as with a single thread.
+ */
+#define MIN_PARALLEL_SHAPES	64
+#define MIN_BAND_HEIGHT		16
+#define BANDS_PER_THREAD	4
 
-    traps++;
+typedef struct
+{
+    pixman_image_t *		image;
+    pixman_image_t **		bands;
+    int				band_height;
+    int				x_off;
+    int				y_off;
+
+    const pixman_trapezoid_t *	traps;
+    const pixman_triangle_t *	tris;
+    int *			bin_start;
+    int *			bins;
+
+    /* If src is not NULL, each band is composited onto dst */
+    pixman_op_t			op;
+    pixman_image_t *		src;
+    pixman_image_t *		dst;
+    int				x_src;
+    int				y_src;
+    int				x_dst;
+    int				y_dst;
+} band_jobs_t;
+
+/* Returns the rows of the mask that a shape can touch */
+static pixman_bool_t
+get_shape_rows (band_jobs_t *jobs, int i, int *y1, int *y2)
+{
+    pixman_fixed_t top, bottom;
 
-    *traps = *(traps - 1);
-    
-    if (right->y < left->y)
+    if (jobs->traps)
     {
-	traps->top = right->y;
-	traps->bottom = left->y;
-	traps->right.p1 = *right;
-	traps->right.p2 = *left;
+	const pixman_trapezoid_t *trap = &jobs->traps[i];
+
+	if (!pixman_trapezoid_valid (trap))
+	    return FALSE;
+
+	top = trap->top;
+	bottom = trap->bottom;
     }
     else
     {
-	traps->top = left->y;
-	traps->bottom = right->y;
-	traps->left.p1 = *left;
-	traps->left.p2 = *right;
+	const pixman_triangle_t *tri = &jobs->tris[i];
+
+	top = bottom = tri->p1.y;
+
+	if (tri->p2.y < top)
+	    top = tri->p2.y;
+	if (tri->p3.y < top)
+	    top = tri->p3.y;
+	if (tri->p2.y > bottom)
+	    bottom = tri->p2.y;
+	if (tri->p3.y > bottom)
+	    bottom = tri->p3.y;
     }
+
+    *y1 = pixman_fixed_to_int (top) + jobs->y_off;
+    *y2 = pixman_fixed_to_int (pixman_fixed_ceil (bottom)) + jobs->y_off;
+
+    if (*y1 < 0)
+	*y1 = 0;
+    if (*y2 > jobs->image->bits.height)
+	*y2 = jobs->image->bits.height;
+
+    return *y2 > *y1;
 }
 
-static pixman_trapezoid_t *
-convert_triangles (int n_tris, const pixman_triangle_t *tris)
+static void
+run_band_job (void *data, int job)
 {
-    pixman_trapezoid_t *traps;
+    band_jobs_t *jobs = data;
+    pixman_image_t *band = jobs->bands[job];
+    int band_y = job * jobs->band_height;
     int i;
 
-    if (n_tris <= 0)
-	return NULL;
-    
-    traps = pixman_malloc_ab (n_tris, 2 * sizeof (pixman_trapezoid_t));
-    if (!traps)
-	return NULL;
+    for (i = jobs->bin_start[job]; i < jobs->bin_start[job + 1]; ++i)
+    {
+	if (jobs->traps)
+	{
+	    rasterize_trapezoid_in_band (jobs->image, band, band_y,
+					 &jobs->traps[jobs->bins[i]],
+					 jobs->x_off, jobs->y_off);
+	}
+	else
+	{
+	    rasterize_triangle (jobs->image, band, band_y,
+				&jobs->tris[jobs->bins[i]],
+				jobs->x_off, jobs->y_off);
+	}
+    }
 
-    for (i = 0; i < n_tris; ++i)
-	triangle_to_trapezoids (&(tris[i]), traps + 2 * i);
+    if (jobs->src)
+    {
+	if (jobs->bin_start[job] == jobs->bin_start[job + 1] &&
+	    zero_src_has_no_effect[jobs->op])
+	{
+	    return;
+	}
 
-    return traps;
+	pixman_image_composite32 (jobs->op, jobs->src, band, jobs->dst,
+				  jobs->x_src, jobs->y_src + band_y,
+				  0, 0,
+				  jobs->x_dst, jobs->y_dst + band_y,
+				  band->bits.width, band->bits.height);
+    }
 }
 
-PIXMAN_EXPORT void
-pixman_composite_triangles (pixman_op_t			op,
-			    pixman_image_t *		src,
-			    pixman_image_t *		dst,
-			    pixman_format_code_t	mask_format,
-			    int				x_src,
-			    int				y_src,
-			    int				x_dst,
-			    int				y_dst,
-			    int				n_tris,
-			    const pixman_triangle_t *	tris)
+static void
+get_bits_range (pixman_image_t *image, uint8_t **start, uint8_t **end)
 {
-    pixman_trapezoid_t *traps;
+    ptrdiff_t stride = image->bits.rowstride * (ptrdiff_t) sizeof (uint32_t);
+    uint8_t *bits = (uint8_t *)image->bits.bits;
 
-    if ((traps = convert_triangles (n_tris, tris)))
+    /* With a negative stride, the first row is the last one in memory */
+    if (stride >= 0)
     {
-	pixman_composite_trapezoids (op, src, dst, mask_format,
-				     x_src, y_src, x_dst, y_dst,
-				     n_tris * 2, traps);
-	
-	free (traps);
+	*start = bits;
+	*end = bits + stride * image->bits.height;
+    }
+    else
+    {
+	*start = bits + stride * (image->bits.height - 1);
+	*end = bits - stride;
     }
 }
 
-PIXMAN_EXPORT void
-pixman_add_triangles (pixman_image_t          *image,
-		      int32_t	               x_off,
-		      int32_t	               y_off,
-		      int	               n_tris,
-		      const pixman_triangle_t *tris)
+static pixman_bool_t
+bits_overlap (pixman_image_t *a, pixman_image_t *b)
+{
+    uint8_t *a_start, *a_end, *b_start, *b_end;
+
+    if (!a || !b || a->type != BITS || b->type != BITS)
+	return FALSE;
+
+    get_bits_range (a, &a_start, &a_end);
+    get_bits_range (b, &b_start, &b_end);
+
+    return a_start < b_end && b_start < a_end;
+}
+
+/* Whether compositing one band can read what another band writes, in
+ * which case the bands have to be composited in order.
+ */
+static pixman_bool_t
+src_aliases_dst (pixman_image_t *src, pixman_image_t *dst)
+{
+    pixman_image_t *src_alpha = src->type == BITS ?
+	(pixman_image_t *)src->common.alpha_map : NULL;
+    pixman_image_t *dst_alpha = (pixman_image_t *)dst->common.alpha_map;
+
+    return bits_overlap (src, dst) || bits_overlap (src, dst_alpha) ||
+	bits_overlap (src_alpha, dst) || bits_overlap (src_alpha, dst_alpha);
+}
+
+/* Whether compositing with the image would call user accessors, which
+ * can't be called from several threads at the same time.
+ */
+static pixman_bool_t
+has_accessors (pixman_image_t *image)
+{
+    pixman_image_t *alpha_map;
+
+    _pixman_image_validate (image);
+
+    if (!(image->common.flags & FAST_PATH_NO_ACCESSORS))
+	return TRUE;
+
+    alpha_map = (pixman_image_t *)image->common.alpha_map;
+
+    return alpha_map && !(alpha_map->common.flags & FAST_PATH_NO_ACCESSORS);
+}
+
+/*
+ * Rasterizes the n_shapes shapes in jobs into jobs->image using several
+ * threads. Returns FALSE without touching the image if it isn't worth it
+ * or if there isn't enough memory; the caller then does the work itself.
+ */
+static pixman_bool_t
+rasterize_in_bands (band_jobs_t *jobs, int n_shapes)
 {
-    pixman_trapezoid_t *traps;
+    pixman_image_t *image = jobs->image;
+    int n_threads = _pixman_get_rasterization_threads ();
+    int height = image->bits.height;
+    int n_bands, n_bins, i, j;
+    pixman_bool_t result = FALSE;
+    int *count;
+
+    if (n_threads <= 1 || n_shapes < MIN_PARALLEL_SHAPES)
+	return FALSE;
+
+    if (jobs->src &&
+	(has_accessors (jobs->src) || has_accessors (jobs->dst) ||
+	 src_aliases_dst (jobs->src, jobs->dst)))
+    {
+	return FALSE;
+    }
+
+    /* The band images share the bits of the image, which can't be
+     * done with accessors.
+     */
+    if (image->bits.read_func || image->bits.write_func)
+	return FALSE;
+
+    n_bands = n_threads * BANDS_PER_THREAD;
+    if (n_bands > height / MIN_BAND_HEIGHT)
+	n_bands = height / MIN_BAND_HEIGHT;
+    if (n_bands < 2)
+	return FALSE;
+
+    jobs->band_height = (height + n_bands - 1) / n_bands;
+    n_bands = (height + jobs->band_height - 1) / jobs->band_height;
+
+    jobs->bands = calloc (n_bands, sizeof (pixman_image_t *));
+    jobs->bin_start = calloc (n_bands + 1, sizeof (int));
+    count = calloc (n_bands, sizeof (int));
+    jobs->bins = NULL;
+
+    if (!jobs->bands || !jobs->bin_start || !count)
+	goto out;
+
+    /* Sort the shapes into bins, one per band */
+    n_bins = 0;
+    for (i = 0; i < n_shapes; ++i)
+    {
+	int y1, y2;
+
+	if (!get_shape_rows (jobs, i, &y1, &y2))
+	    continue;
+
+	for (j = y1 / jobs->band_height; j <= (y2 - 1) / jobs->band_height; ++j)
+	{
+	    count[j]++;
+	    n_bins++;
+	}
+    }
+
+    for (j = 0; j < n_bands; ++j)
+	jobs->bin_start[j + 1] = jobs->bin_start[j] + count[j];
 
-    if ((traps = convert_triangles (n_tris, tris)))
+    if (!(jobs->bins = pixman_malloc_ab (n_bins + 1, sizeof (int))))
+	goto out;
+
+    memset (count, 0, n_bands * sizeof (int));
+    for (i = 0; i < n_shapes; ++i)
     {
-	pixman_add_trapezoids (image, x_off, y_off,
-			       n_tris * 2, traps);
+	int y1, y2;
+
+	if (!get_shape_rows (jobs, i, &y1, &y2))
+	    continue;
 
-	free (traps);
+	for (j = y1 / jobs->band_height; j <= (y2 - 1) / jobs->band_height; ++j)
+	    jobs->bins[jobs->bin_start[j] + count[j]++] = i;
     }
+
+    for (j = 0; j < n_bands; ++j)
+    {
+	int y = j * jobs->band_height;
+	int h = jobs->band_height;
+
+	if (y + h > height)
+	    h = height - y;
+
+	jobs->bands[j] = pixman_image_create_bits (
+	    image->bits.format, image->bits.width, h,
+	    image->bits.bits + y * image->bits.rowstride,
+	    image->bits.rowstride * (int) sizeof (uint32_t));
+
+	if (!jobs->bands[j])
+	    goto out;
+
+	jobs->bands[j]->bits.exact_coverage = image->bits.exact_coverage;
+    }
+
+    _pixman_run_jobs (n_threads, n_bands, run_band_job, jobs);
+
+    result = TRUE;
+
+out:
+    if (jobs->bands)
+    {
+	for (j = 0; j < n_bands; ++j)
+	{
+	    if (jobs->bands[j])
+		pixman_image_unref (jobs->bands[j]);
+	}
+    }
+
+    free (jobs->bands);
+    free (jobs->bin_start);
+    free (jobs->bins);
+    free (count);
+
+    return result;
+}
+
+/*
+ * pixman_composite_trapezoids()
+ *
+ * All the trapezoids are conceptually rendered to an infinitely big image.
+ * The (0, 0) coordinates of this image are then aligned with the (x, y)
+ * coordinates of the source image, and then both images are aligned with
+ * the (x, y) coordinates of the destination. Then these three images are
+ * composited across the entire destination.
+ */
+PIXMAN_EXPORT void
+pixman_composite_trapezoids (pixman_op_t		op,
+			     pixman_image_t *		src,
+			     pixman_image_t *		dst,
+			     pixman_format_code_t	mask_format,
+			     int			x_src,
+			     int			y_src,
+			     int			x_dst,
+			     int			y_dst,
+			     int			n_traps,
+			     const pixman_trapezoid_t *	traps)
+{
+    band_jobs_t jobs;
+    int i;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+    
+    if (n_traps <= 0)
+	return;
+
+    _pixman_image_validate (src);
+    _pixman_image_validate (dst);
+
+    memset (&jobs, 0, sizeof (jobs));
+    jobs.traps = traps;
+
+    if (op == PIXMAN_OP_ADD &&
+	(src->common.flags & FAST_PATH_IS_OPAQUE)		&&
+	(mask_format == dst->common.extended_format_code)	&&
+	!(dst->common.have_clip_region))
+    {
+	jobs.image = dst;
+	jobs.x_off = x_dst;
+	jobs.y_off = y_dst;
+
+	if (rasterize_in_bands (&jobs, n_traps))
+	    return;
+
+	for (i = 0; i < n_traps; ++i)
+	{
+	    const pixman_trapezoid_t *trap = &(traps[i]);
+	    
+	    if (!pixman_trapezoid_valid (trap))
+		continue;
+	    
+	    pixman_rasterize_trapezoid (dst, trap, x_dst, y_dst);
+	}
+    }
+    else
+    {
+	pixman_image_t *tmp;
+	pixman_box32_t box;
+	int i;
+
+	if (!get_trap_extents (op, dst, traps, n_traps, &box))
+	    return;
+	
+	if (!(tmp = pixman_image_create_bits (
+		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
+	    return;
+
+	tmp->bits.exact_coverage = dst->bits.exact_coverage;
+
+	jobs.image = tmp;
+	jobs.x_off = - box.x1;
+	jobs.y_off = - box.y1;
+	jobs.op = op;
+	jobs.src = src;
+	jobs.dst = dst;
+	jobs.x_src = x_src + box.x1;
+	jobs.y_src = y_src + box.y1;
+	jobs.x_dst = x_dst + box.x1;
+	jobs.y_dst = y_dst + box.y1;
+
+	if (!rasterize_in_bands (&jobs, n_traps))
+	{
+	    for (i = 0; i < n_traps; ++i)
+	    {
+		const pixman_trapezoid_t *trap = &(traps[i]);
+
+		if (!pixman_trapezoid_valid (trap))
+		    continue;
+
+		pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
+	    }
+
+	    pixman_image_composite (op, src, tmp, dst,
+				    x_src + box.x1, y_src + box.y1,
+				    0, 0,
+				    x_dst + box.x1, y_dst + box.y1,
+				    box.x2 - box.x1, box.y2 - box.y1);
+	}
+
+	pixman_image_unref (tmp);
+    }
+}
+
+static pixman_bool_t
+get_triangle_extents (pixman_op_t op, pixman_image_t *dest,
+		      const pixman_triangle_t *tris, int n_tris,
+		      pixman_box32_t *box)
+{
+    int i;
+
+    /* See get_trap_extents() */
+    if (!zero_src_has_no_effect [op])
+    {
+	box->x1 = 0;
+	box->y1 = 0;
+	box->x2 = dest->bits.width;
+	box->y2 = dest->bits.height;
+	return TRUE;
+    }
+
+    box->x1 = INT32_MAX;
+    box->y1 = INT32_MAX;
+    box->x2 = INT32_MIN;
+    box->y2 = INT32_MIN;
+
+    for (i = 0; i < n_tris; ++i)
+    {
+	const pixman_triangle_t *tri = &(tris[i]);
+
+	extend_box_x (box, tri->p1.x);
+	extend_box_x (box, tri->p2.x);
+	extend_box_x (box, tri->p3.x);
+
+	extend_box_y (box, tri->p1.y);
+	extend_box_y (box, tri->p2.y);
+	extend_box_y (box, tri->p3.y);
+    }
+
+    if (box->x1 >= box->x2 || box->y1 >= box->y2)
+	return FALSE;
+
+    return TRUE;
+}
+
+PIXMAN_EXPORT void
+pixman_composite_triangles (pixman_op_t			op,
+			    pixman_image_t *		src,
+			    pixman_image_t *		dst,
+			    pixman_format_code_t	mask_format,
+			    int				x_src,
+			    int				y_src,
+			    int				x_dst,
+			    int				y_dst,
+			    int				n_tris,
+			    const pixman_triangle_t *	tris)
+{
+    band_jobs_t jobs;
+    int i;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+
+    if (n_tris <= 0)
+	return;
+
+    _pixman_image_validate (src);
+    _pixman_image_validate (dst);
+
+    memset (&jobs, 0, sizeof (jobs));
+    jobs.tris = tris;
+
+    if (op == PIXMAN_OP_ADD &&
+	(src->common.flags & FAST_PATH_IS_OPAQUE)		&&
+	(mask_format == dst->common.extended_format_code)	&&
+	!(dst->common.have_clip_region))
+    {
+	jobs.image = dst;
+	jobs.x_off = x_dst;
+	jobs.y_off = y_dst;
+
+	if (rasterize_in_bands (&jobs, n_tris))
+	    return;
+
+	for (i = 0; i < n_tris; ++i)
+	    rasterize_triangle (dst, dst, 0, &(tris[i]), x_dst, y_dst);
+    }
+    else
+    {
+	pixman_image_t *tmp;
+	pixman_box32_t box;
+
+	if (!get_triangle_extents (op, dst, tris, n_tris, &box))
+	    return;
+
+	if (!(tmp = pixman_image_create_bits (
+		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
+	    return;
+
+	tmp->bits.exact_coverage = dst->bits.exact_coverage;
+
+	jobs.image = tmp;
+	jobs.x_off = - box.x1;
+	jobs.y_off = - box.y1;
+	jobs.op = op;
+	jobs.src = src;
+	jobs.dst = dst;
+	jobs.x_src = x_src + box.x1;
+	jobs.y_src = y_src + box.y1;
+	jobs.x_dst = x_dst + box.x1;
+	jobs.y_dst = y_dst + box.y1;
+
+	if (!rasterize_in_bands (&jobs, n_tris))
+	{
+	    for (i = 0; i < n_tris; ++i)
+		rasterize_triangle (tmp, tmp, 0, &(tris[i]), - box.x1, - box.y1);
+
+	    pixman_image_composite (op, src, tmp, dst,
+				    x_src + box.x1, y_src + box.y1,
+				    0, 0,
+				    x_dst + box.x1, y_dst + box.y1,
+				    box.x2 - box.x1, box.y2 - box.y1);
+	}
+
+	pixman_image_unref (tmp);
+    }
+}
+
+PIXMAN_EXPORT void
+pixman_add_triangles (pixman_image_t          *image,
+		      int32_t	               x_off,
+		      int32_t	               y_off,
+		      int	               n_tris,
+		      const pixman_triangle_t *tris)
+{
+    int i;
+
+    return_if_fail (image->type == BITS);
+
+    _pixman_image_validate (image);
+
+    for (i = 0; i < n_tris; ++i)
+	rasterize_triangle (image, image, 0, &(tris[i]), x_off, y_off);
+}
+
+/*
+ * Polygons
+ *
+ * A polygon is given as an unordered set of directed edges and is
+ * rasterized with an active edge table, sampling on the same grid as
+ * the trapezoid rasterizer. This means that a polygon produces exactly
+ * the same coverage as a non-overlapping tessellation of it into
+ * trapezoids, without the cost of the tessellation and without double
+ * counting along shared edges.
+ *
+ * Coverage for a pixel row is accumulated in two arrays: 'cells' holds
+ * the partial coverage of the pixels that contain a span end point,
+ * and 'cover' holds the coverage of the interior of spans as deltas,
+ * which are prefix-summed once the row is complete. That way the cost
+ * of a span does not depend on its length. The mask is only a band of
+ * rows high; each band is composited as soon as it has been rasterized.
+ */
+#define POLYGON_BAND_HEIGHT 32
+
+typedef struct
+{
+    pixman_edge_t	edge;
+    pixman_point_fixed_t top, bot;
+    pixman_fixed_t	y_first;	/* first sample row on the edge */
+    pixman_fixed_t	y_last;		/* last sample row on the edge */
+    int			dir;
+} polygon_edge_t;
+
+typedef struct
+{
+    int			n;		/* bits per pixel of the mask */
+    int			width;
+    pixman_fill_rule_t	fill_rule;
+
+    polygon_edge_t *	edges;		/* sorted by y_first */
+    int			n_edges;
+    int			next_edge;
+
+    polygon_edge_t **	active;		/* sorted by x */
+    int			n_active;
+
+    int32_t *		cells;
+    int32_t *		cover;
+    int			x1, x2;		/* dirty range of cells/cover */
+} polygon_rasterizer_t;
+
+static int
+compare_polygon_edges (const void *a, const void *b)
+{
+    const polygon_edge_t *ea = a;
+    const polygon_edge_t *eb = b;
+
+    if (ea->y_first != eb->y_first)
+	return ea->y_first < eb->y_first ? -1 : 1;
+
+    return 0;
+}
+
+static pixman_bool_t
+polygon_inside (pixman_fill_rule_t fill_rule, int winding)
+{
+    if (fill_rule == PIXMAN_FILL_RULE_EVEN_ODD)
+	return winding & 1;
+    else
+	return winding != 0;
+}
+
+static void
+polygon_add_span (polygon_rasterizer_t *rast,
+		  pixman_fixed_t        lx,
+		  pixman_fixed_t        rx)
+{
+    int n = rast->n;
+    int lxi, rxi;
+
+    if (n == 1)
+    {
+	/* See the comment in pixman-edge-imp.h */
+	lx += X_FRAC_FIRST (1) - pixman_fixed_e;
+	rx += X_FRAC_FIRST (1) - pixman_fixed_e;
+    }
+
+    /* clip X */
+    if (lx < 0)
+	lx = 0;
+    if (rx > pixman_int_to_fixed (rast->width))
+	rx = pixman_int_to_fixed (rast->width);
+
+    if (rx <= lx)
+	return;
+
+    lxi = pixman_fixed_to_int (lx);
+    rxi = pixman_fixed_to_int (rx);
+
+    if (n == 1)
+    {
+	rast->cover[lxi] += 1;
+	rast->cover[rxi] -= 1;
+    }
+    else
+    {
+	int lxs = RENDER_SAMPLES_X (lx, n);
+	int rxs = RENDER_SAMPLES_X (rx, n);
+
+	if (lxi == rxi)
+	{
+	    rast->cells[lxi] += rxs - lxs;
+	}
+	else
+	{
+	    rast->cells[lxi] += N_X_FRAC (n) - lxs;
+	    rast->cover[lxi + 1] += N_X_FRAC (n);
+	    rast->cover[rxi] -= N_X_FRAC (n);
+	    rast->cells[rxi] += rxs;
+	}
+    }
+
+    if (lxi < rast->x1)
+	rast->x1 = lxi;
+    if (rxi + 1 > rast->x2)
+	rast->x2 = rxi + 1;
+}
+
+static void
+polygon_rasterize_sample_row (polygon_rasterizer_t *rast,
+			      pixman_fixed_t        y)
+{
+    int i, j, winding;
+    pixman_fixed_t lx;
+
+    /* Retire edges that end above this sample row */
+    for (i = 0, j = 0; i < rast->n_active; ++i)
+    {
+	if (rast->active[i]->y_last >= y)
+	    rast->active[j++] = rast->active[i];
+    }
+    rast->n_active = j;
+
+    /* Activate the edges that start at or above it */
+    while (rast->next_edge < rast->n_edges &&
+	   rast->edges[rast->next_edge].y_first <= y)
+    {
+	polygon_edge_t *e = &rast->edges[rast->next_edge++];
+
+	if (e->y_last < y)
+	    continue;
+
+	pixman_edge_init (&e->edge, rast->n, y,
+			  e->top.x, e->top.y, e->bot.x, e->bot.y);
+
+	rast->active[rast->n_active++] = e;
+    }
+
+    /* The active edges only move a little from one sample row to
+     * the next, so an insertion sort is close to linear here.
+     */
+    for (i = 1; i < rast->n_active; ++i)
+    {
+	polygon_edge_t *e = rast->active[i];
+
+	for (j = i; j > 0 && rast->active[j - 1]->edge.x > e->edge.x; --j)
+	    rast->active[j] = rast->active[j - 1];
+
+	rast->active[j] = e;
+    }
+
+    winding = 0;
+    lx = 0;
+    for (i = 0; i < rast->n_active; ++i)
+    {
+	polygon_edge_t *e = rast->active[i];
+	pixman_bool_t was_inside = polygon_inside (rast->fill_rule, winding);
+
+	winding += e->dir;
+
+	if (polygon_inside (rast->fill_rule, winding) != was_inside)
+	{
+	    if (was_inside)
+		polygon_add_span (rast, lx, e->edge.x);
+	    else
+		lx = e->edge.x;
+	}
+    }
+}
+
+/*
+ * Rasterize pixel row 'y' into 'line', which must be cleared. Returns
+ * FALSE if nothing was written.
+ */
+static pixman_bool_t
+polygon_rasterize_row (polygon_rasterizer_t *rast,
+		       int                   y,
+		       uint8_t *             line)
+{
+    int n = rast->n;
+    pixman_fixed_t sample_y;
+    int32_t c;
+    int i, x;
+
+    if (rast->n_active == 0 &&
+	(rast->next_edge == rast->n_edges ||
+	 rast->edges[rast->next_edge].y_first >= pixman_int_to_fixed (y + 1)))
+    {
+	return FALSE;
+    }
+
+    rast->x1 = rast->width;
+    rast->x2 = 0;
+
+    sample_y = pixman_int_to_fixed (y) + Y_FRAC_FIRST (n);
+    for (i = 0; i < N_Y_FRAC (n); ++i)
+    {
+	polygon_rasterize_sample_row (rast, sample_y);
+
+	for (x = 0; x < rast->n_active; ++x)
+	{
+	    pixman_edge_t *edge = &rast->active[x]->edge;
+
+	    if (i < N_Y_FRAC (n) - 1)
+	    {
+		RENDER_EDGE_STEP_SMALL (edge);
+	    }
+	    else
+	    {
+		RENDER_EDGE_STEP_BIG (edge);
+	    }
+	}
+
+	sample_y += STEP_Y_SMALL (n);
+    }
+
+    if (rast->x2 > rast->width)
+	rast->x2 = rast->width;
+
+    if (rast->x1 >= rast->x2)
+	return FALSE;
+
+    c = 0;
+    for (x = rast->x1; x < rast->x2; ++x)
+    {
+	int32_t a;
+
+	c += rast->cover[x];
+	a = c + rast->cells[x];
+
+	if (!a)
+	    continue;
+
+	switch (n)
+	{
+	case 8:
+	    line[x] = a > MAX_ALPHA (8) ? MAX_ALPHA (8) : a;
+	    break;
+
+	case 4:
+	    if (a > MAX_ALPHA (4))
+		a = MAX_ALPHA (4);
+#ifdef WORDS_BIGENDIAN
+	    line[x >> 1] |= (x & 1) ? a : a << 4;
+#else
+	    line[x >> 1] |= (x & 1) ? a << 4 : a;
+#endif
+	    break;
+
+	case 1:
+#ifdef WORDS_BIGENDIAN
+	    ((uint32_t *)line)[x >> 5] |= 0x80000000U >> (x & 0x1f);
+#else
+	    ((uint32_t *)line)[x >> 5] |= 1U << (x & 0x1f);
+#endif
+	    break;
+	}
+    }
+
+    memset (rast->cells + rast->x1, 0,
+	    (rast->x2 - rast->x1 + 1) * sizeof (int32_t));
+    memset (rast->cover + rast->x1, 0,
+	    (rast->x2 - rast->x1 + 1) * sizeof (int32_t));
+
+    return TRUE;
+}
+
+static pixman_bool_t
+get_polygon_extents (pixman_op_t op, pixman_image_t *dest,
+		     int x_dst, int y_dst,
+		     const pixman_line_fixed_t *edges, int n_edges,
+		     pixman_box32_t *box)
+{
+    int i;
+
+    /* See get_trap_extents() */
+    if (!zero_src_has_no_effect [op])
+    {
+	box->x1 = 0;
+	box->y1 = 0;
+	box->x2 = dest->bits.width;
+	box->y2 = dest->bits.height;
+	return TRUE;
+    }
+
+    box->x1 = INT32_MAX;
+    box->y1 = INT32_MAX;
+    box->x2 = INT32_MIN;
+    box->y2 = INT32_MIN;
+
+    for (i = 0; i < n_edges; ++i)
+    {
+	const pixman_line_fixed_t *line = &(edges[i]);
+
+	if (line->p1.y == line->p2.y)
+	    continue;
+
+	extend_box_x (box, line->p1.x);
+	extend_box_x (box, line->p2.x);
+
+	extend_box_y (box, line->p1.y);
+	extend_box_y (box, line->p2.y);
+    }
+
+    /* Nothing outside the destination can be affected */
+    if (box->x1 < -x_dst)
+	box->x1 = -x_dst;
+    if (box->y1 < -y_dst)
+	box->y1 = -y_dst;
+    if (box->x2 > dest->bits.width - x_dst)
+	box->x2 = dest->bits.width - x_dst;
+    if (box->y2 > dest->bits.height - y_dst)
+	box->y2 = dest->bits.height - y_dst;
+
+    if (box->x1 >= box->x2 || box->y1 >= box->y2)
+	return FALSE;
+
+    return TRUE;
+}
+
+/*
+ * pixman_composite_polygon()
+ *
+ * The polygon is described by 'n_edges' directed line segments that
+ * together form one or more closed contours; their order doesn't
+ * matter. Whether a point is inside the polygon is determined from the
+ * winding numbers of the contours according to 'fill_rule'.
+ *
+ * The coordinate system is the same as the one of
+ * pixman_composite_trapezoids().
+ */
+PIXMAN_EXPORT void
+pixman_composite_polygon (pixman_op_t			op,
+			  pixman_image_t *		src,
+			  pixman_image_t *		dst,
+			  pixman_format_code_t		mask_format,
+			  int				x_src,
+			  int				y_src,
+			  int				x_dst,
+			  int				y_dst,
+			  int				n_edges,
+			  const pixman_line_fixed_t *	edges,
+			  pixman_fill_rule_t		fill_rule)
+{
+    polygon_rasterizer_t rast;
+    pixman_image_t *mask = NULL;
+    pixman_box32_t box;
+    pixman_fixed_t x_off, y_off;
+    int band_height;
+    int i, y;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+
+    if (n_edges <= 0)
+	return;
+
+    _pixman_image_validate (src);
+    _pixman_image_validate (dst);
+
+    if (!get_polygon_extents (op, dst, x_dst, y_dst, edges, n_edges, &box))
+	return;
+
+    rast.n = PIXMAN_FORMAT_BPP (mask_format);
+    rast.width = box.x2 - box.x1;
+    rast.fill_rule = fill_rule;
+    rast.n_edges = 0;
+    rast.next_edge = 0;
+    rast.n_active = 0;
+
+    rast.edges = pixman_malloc_ab (n_edges, sizeof (polygon_edge_t));
+    rast.active = pixman_malloc_ab (n_edges, sizeof (polygon_edge_t *));
+    rast.cells = pixman_malloc_ab (rast.width + 1, 2 * sizeof (int32_t));
+
+    if (!rast.edges || !rast.active || !rast.cells)
+	goto out;
+
+    rast.cover = rast.cells + rast.width + 1;
+    memset (rast.cells, 0, (rast.width + 1) * 2 * sizeof (int32_t));
+
+    x_off = pixman_int_to_fixed (box.x1);
+    y_off = pixman_int_to_fixed (box.y1);
+
+    for (i = 0; i < n_edges; ++i)
+    {
+	const pixman_line_fixed_t *line = &(edges[i]);
+	polygon_edge_t *e = &rast.edges[rast.n_edges];
+
+	if (line->p1.y == line->p2.y)
+	    continue;
+
+	if (line->p1.y < line->p2.y)
+	{
+	    e->top = line->p1;
+	    e->bot = line->p2;
+	    e->dir = 1;
+	}
+	else
+	{
+	    e->top = line->p2;
+	    e->bot = line->p1;
+	    e->dir = -1;
+	}
+
+	e->top.x -= x_off;
+	e->top.y -= y_off;
+	e->bot.x -= x_off;
+	e->bot.y -= y_off;
+
+	e->y_first = pixman_sample_ceil_y (e->top.y, rast.n);
+	e->y_last = pixman_sample_floor_y (e->bot.y, rast.n);
+
+	if (e->y_last >= e->y_first)
+	    rast.n_edges++;
+    }
+
+    qsort (rast.edges, rast.n_edges, sizeof (polygon_edge_t),
+	   compare_polygon_edges);
+
+    band_height = box.y2 - box.y1;
+    if (band_height > POLYGON_BAND_HEIGHT)
+	band_height = POLYGON_BAND_HEIGHT;
+
+    if (!(mask = pixman_image_create_bits (
+	      mask_format, rast.width, band_height, NULL, -1)))
+    {
+	goto out;
+    }
+
+    for (y = 0; y < box.y2 - box.y1; y += band_height)
+    {
+	uint8_t *line = (uint8_t *)mask->bits.bits;
+	int stride = mask->bits.rowstride * 4;
+	int height = box.y2 - box.y1 - y;
+	pixman_bool_t empty = TRUE;
+
+	if (height > band_height)
+	    height = band_height;
+
+	for (i = 0; i < height; ++i)
+	{
+	    if (polygon_rasterize_row (&rast, y + i, line))
+		empty = FALSE;
+
+	    line += stride;
+	}
+
+	if (!empty || !zero_src_has_no_effect[op])
+	{
+	    pixman_image_composite32 (op, src, mask, dst,
+				      x_src + box.x1, y_src + box.y1 + y,
+				      0, 0,
+				      x_dst + box.x1, y_dst + box.y1 + y,
+				      rast.width, height);
+	}
+
+	if (!empty)
+	    memset (mask->bits.bits, 0, height * stride);
+    }
+
+out:
+    if (mask)
+	pixman_image_unref (mask);
+
+    free (rast.edges);
+    free (rast.active);
+    free (rast.cells);
 }
@@ -80,6 +80,89 @@ pixman_malloc_abc (unsigned int a,
 	return malloc (a * b * c);
 }
 
+/* Allocation of 32 bit region data; see pixman_set_region_allocator().
+ * The allocator is fixed the first time region data is allocated, after
+ * which it can no longer be set.
+ */
+typedef struct
+{
+    void *(*alloc_func) (size_t size);
+    void *(*realloc_func) (void *ptr, size_t size);
+    void  (*free_func) (void *ptr);
+} region_allocator_t;
+
+static const region_allocator_t default_region_allocator =
+{
+    malloc, realloc, free
+};
+
+static const region_allocator_t *region_allocator;
+
+static const region_allocator_t *
+get_region_allocator (void)
+{
+    const region_allocator_t *allocator =
+	PIXMAN_ATOMIC_LOAD_PTR (&region_allocator);
+
+    if (!allocator)
+    {
+	PIXMAN_ATOMIC_CAS_PTR (&region_allocator, NULL,
+			       (region_allocator_t *)&default_region_allocator);
+
+	allocator = PIXMAN_ATOMIC_LOAD_PTR (&region_allocator);
+    }
+
+    return allocator;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+pixman_set_region_allocator (void *(*alloc_func) (size_t size),
+			     void *(*realloc_func) (void *ptr, size_t size),
+			     void  (*free_func) (void *ptr))
+{
+    region_allocator_t *allocator;
+
+    if (!alloc_func || !realloc_func || !free_func)
+	return FALSE;
+
+    if (PIXMAN_ATOMIC_LOAD_PTR (&region_allocator))
+	return FALSE;
+
+    if (!(allocator = malloc (sizeof (region_allocator_t))))
+	return FALSE;
+
+    allocator->alloc_func = alloc_func;
+    allocator->realloc_func = realloc_func;
+    allocator->free_func = free_func;
+
+    /* Another thread may have set it, or allocated region data, since */
+    if (!PIXMAN_ATOMIC_CAS_PTR (&region_allocator, NULL, allocator))
+    {
+	free (allocator);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+void *
+_pixman_region_alloc (size_t size)
+{
+    return get_region_allocator ()->alloc_func (size);
+}
+
+void *
+_pixman_region_realloc (void *ptr, size_t size)
+{
+    return get_region_allocator ()->realloc_func (ptr, size);
+}
+
+void
+_pixman_region_free (void *ptr)
+{
+    get_region_allocator ()->free_func (ptr);
+}
+
 static force_inline uint16_t
 float_to_unorm (float f, int n_bits)
 {
@@ -197,6 +280,70 @@ pixman_unorm_to_float (uint16_t u, int n_bits)
     return unorm_to_float (u, n_bits);
 }
 
+/* 255 / a as a float, and 0 for a = 0 */
+const float _pixman_unpremultiply_factors[256] =
+{
+    0.0f, 255.f, 127.5f, 85.f, 63.75f, 51.f,
+    42.5f, 36.4285698f, 31.875f, 28.333334f, 25.5f, 23.181818f,
+    21.25f, 19.6153851f, 18.2142849f, 17.f, 15.9375f, 15.f,
+    14.166667f, 13.4210529f, 12.75f, 12.1428576f, 11.590909f, 11.086957f,
+    10.625f, 10.1999998f, 9.80769253f, 9.44444466f, 9.10714245f, 8.79310322f,
+    8.5f, 8.22580624f, 7.96875f, 7.72727251f, 7.5f, 7.28571415f,
+    7.08333349f, 6.89189196f, 6.71052647f, 6.53846169f, 6.375f, 6.21951199f,
+    6.07142878f, 5.93023252f, 5.7954545f, 5.66666651f, 5.54347849f, 5.42553186f,
+    5.3125f, 5.20408154f, 5.0999999f, 5.f, 4.90384626f, 4.81132078f,
+    4.72222233f, 4.63636351f, 4.55357122f, 4.47368431f, 4.39655161f, 4.32203388f,
+    4.25f, 4.18032789f, 4.11290312f, 4.04761887f, 3.984375f, 3.92307687f,
+    3.86363626f, 3.80597019f, 3.75f, 3.69565225f, 3.64285707f, 3.5915494f,
+    3.54166675f, 3.49315071f, 3.44594598f, 3.4000001f, 3.35526323f, 3.31168842f,
+    3.26923084f, 3.22784805f, 3.1875f, 3.14814806f, 3.10975599f, 3.07228923f,
+    3.03571439f, 3.f, 2.96511626f, 2.93103456f, 2.89772725f, 2.86516857f,
+    2.83333325f, 2.80219769f, 2.77173924f, 2.74193549f, 2.71276593f, 2.68421054f,
+    2.65625f, 2.62886596f, 2.60204077f, 2.5757575f, 2.54999995f, 2.52475238f,
+    2.5f, 2.47572827f, 2.45192313f, 2.42857146f, 2.40566039f, 2.38317752f,
+    2.36111116f, 2.33944964f, 2.31818175f, 2.29729724f, 2.27678561f, 2.2566371f,
+    2.23684216f, 2.21739125f, 2.1982758f, 2.17948723f, 2.16101694f, 2.14285707f,
+    2.125f, 2.10743809f, 2.09016395f, 2.07317066f, 2.05645156f, 2.03999996f,
+    2.02380943f, 2.00787401f, 1.9921875f, 1.97674417f, 1.96153843f, 1.94656491f,
+    1.93181813f, 1.91729319f, 1.9029851f, 1.88888884f, 1.875f, 1.86131382f,
+    1.84782612f, 1.83453238f, 1.82142854f, 1.80851066f, 1.7957747f, 1.78321683f,
+    1.77083337f, 1.75862074f, 1.74657536f, 1.73469388f, 1.72297299f, 1.71140945f,
+    1.70000005f, 1.68874168f, 1.67763162f, 1.66666663f, 1.65584421f, 1.64516127f,
+    1.63461542f, 1.6242038f, 1.61392403f, 1.60377359f, 1.59375f, 1.58385098f,
+    1.57407403f, 1.56441712f, 1.554878f, 1.5454545f, 1.53614461f, 1.52694607f,
+    1.51785719f, 1.50887573f, 1.5f, 1.4912281f, 1.48255813f, 1.47398841f,
+    1.46551728f, 1.45714283f, 1.44886363f, 1.440678f, 1.43258429f, 1.42458105f,
+    1.41666663f, 1.40883982f, 1.40109885f, 1.39344263f, 1.38586962f, 1.37837839f,
+    1.37096775f, 1.36363637f, 1.35638297f, 1.34920633f, 1.34210527f, 1.33507848f,
+    1.328125f, 1.32124352f, 1.31443298f, 1.30769229f, 1.30102038f, 1.29441619f,
+    1.28787875f, 1.281407f, 1.27499998f, 1.26865673f, 1.26237619f, 1.25615764f,
+    1.25f, 1.24390244f, 1.23786414f, 1.231884f, 1.22596157f, 1.22009563f,
+    1.21428573f, 1.20853078f, 1.2028302f, 1.19718313f, 1.19158876f, 1.18604648f,
+    1.18055558f, 1.17511523f, 1.16972482f, 1.16438353f, 1.15909088f, 1.15384614f,
+    1.14864862f, 1.14349771f, 1.13839281f, 1.13333333f, 1.12831855f, 1.123348f,
+    1.11842108f, 1.11353707f, 1.10869563f, 1.10389614f, 1.0991379f, 1.09442055f,
+    1.08974361f, 1.08510637f, 1.08050847f, 1.07594931f, 1.07142854f, 1.06694555f,
+    1.0625f, 1.05809128f, 1.05371904f, 1.04938269f, 1.04508197f, 1.04081631f,
+    1.03658533f, 1.03238869f, 1.02822578f, 1.02409637f, 1.01999998f, 1.01593626f,
+    1.01190472f, 1.00790513f, 1.00393701f, 1.f,
+};
+
+/* Indexed by pixman_yuv_color_space_t. The BT.601 limited range entry
+ * keeps the constants that yuy2 and yv12 images have always been
+ * converted with.
+ */
+const pixman_yuv_coefficients_t _pixman_yuv_coefficients[] =
+{
+    /* BT.601 limited range */
+    { 16, 0x012b27, 0x019a2e, 0x00647e, 0x00d0f2, 0x0206a2 },
+    /* BT.601 full range */
+    {  0, 0x010000, 0x0166e9, 0x005819, 0x00b6d2, 0x01c5a2 },
+    /* BT.709 limited range */
+    { 16, 0x012a15, 0x01caf1, 0x003697, 0x00886d, 0x021cc6 },
+    /* BT.709 full range */
+    {  0, 0x010000, 0x019326, 0x002ff4, 0x0077d7, 0x01db09 },
+};
+
 void
 pixman_contract_from_float (uint32_t     *dst,
 			    const argb_t *src,
@@ -217,6 +364,55 @@ pixman_contract_from_float (uint32_t     *dst,
     }
 }
 
+/*
+ * These convert between a8r8g8b8 and the a16r16g16b16 pixels of medium
+ * iterators. Expanding is exact, and contracting rounds to the nearest
+ * 8 bit value, so a8r8g8b8 survives the round trip.
+ */
+void
+pixman_expand_to_64 (uint64_t       *dst,
+		     const uint32_t *src,
+		     int             width)
+{
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	uint64_t p = src[i];
+
+	p = ((p & 0xff000000) << 24) | ((p & 0x00ff0000) << 16) |
+	    ((p & 0x0000ff00) <<  8) |  (p & 0x000000ff);
+
+	dst[i] = p * 0x101;
+    }
+}
+
+static force_inline uint32_t
+un16_to_un8 (uint32_t u)
+{
+    u += 0x80;
+
+    return (u - (u >> 8)) >> 8;
+}
+
+void
+pixman_contract_from_64 (uint32_t       *dst,
+			 const uint64_t *src,
+			 int             width)
+{
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	uint64_t p = src[i];
+
+	dst[i] = (un16_to_un8 (p >> 48) << 24)			|
+		 (un16_to_un8 ((p >> 32) & 0xffff) << 16)	|
+		 (un16_to_un8 ((p >> 16) & 0xffff) << 8)	|
+		 (un16_to_un8 (p & 0xffff));
+    }
+}
+
 uint32_t *
 _pixman_iter_get_scanline_noop (pixman_iter_t *iter, const uint32_t *mask)
 {
@@ -25,7 +25,8 @@
 
 #include "pixman-private.h"
 
-#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3)
+#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3) || \
+    defined (USE_F16C)
 
 /* The CPU detection code needs to be in a file not compiled with
  * "-mmmx -msse", as gcc would generate CMOV instructions otherwise
@@ -40,7 +41,8 @@ typedef enum
     X86_SSE			= (1 << 2) | X86_MMX_EXTENSIONS,
     X86_SSE2			= (1 << 3),
     X86_CMOV			= (1 << 4),
-    X86_SSSE3			= (1 << 5)
+    X86_SSSE3			= (1 << 5),
+    X86_F16C			= (1 << 6)
 } cpu_features_t;
 
 #ifdef HAVE_GETISAX
@@ -67,6 +69,10 @@ detect_cpu_features (void)
 	    features |= X86_SSE2;
 	if (result & AV_386_SSSE3)
 	    features |= X86_SSSE3;
+#ifdef AV_386_F16C
+	if (result & AV_386_F16C)
+	    features |= X86_F16C;
+#endif
     }
 
     return features;
@@ -101,6 +107,28 @@ pixman_cpuid (uint32_t feature,
 #endif
 }
 
+/* The F16C instructions are VEX encoded, so the operating system must
+ * also save the AVX state on context switches.
+ */
+static pixman_bool_t
+pixman_have_avx_state (void)
+{
+    uint32_t xcr0;
+
+#if defined (__GNUC__)
+    uint32_t edx;
+
+    /* xgetbv, spelled out for assemblers that do not know it */
+    __asm__ (".byte 0x0f, 0x01, 0xd0" : "=a" (xcr0), "=d" (edx) : "c" (0));
+#elif defined (_MSC_VER)
+    xcr0 = (uint32_t)_xgetbv (0);
+#else
+#error Unknown compiler
+#endif
+
+    return (xcr0 & 0x6) == 0x6;
+}
+
 static cpu_features_t
 detect_cpu_features (void)
 {
@@ -120,6 +148,10 @@ detect_cpu_features (void)
     if (c & (1 << 9))
 	features |= X86_SSSE3;
 
+    /* F16C, AVX and OSXSAVE */
+    if ((c & (0x7 << 27)) == (0x7 << 27) && pixman_have_avx_state ())
+	features |= X86_F16C;
+
     /* Check for AMD specific features */
     if ((features & X86_MMX) && !(features & X86_SSE))
     {
@@ -176,6 +208,7 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 #define MMX_BITS  (X86_MMX | X86_MMX_EXTENSIONS)
 #define SSE2_BITS (X86_MMX | X86_MMX_EXTENSIONS | X86_SSE | X86_SSE2)
 #define SSSE3_BITS (X86_SSE | X86_SSE2 | X86_SSSE3)
+#define F16C_BITS (X86_SSE | X86_SSE2 | X86_F16C)
 
 #ifdef USE_X86_MMX
     if (!_pixman_disabled ("mmx") && have_feature (MMX_BITS))
@@ -192,5 +225,10 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 	imp = _pixman_implementation_create_ssse3 (imp);
 #endif
 
+#ifdef USE_F16C
+    if (!_pixman_disabled ("f16c") && have_feature (F16C_BITS))
+	imp = _pixman_implementation_create_f16c (imp);
+#endif
+
     return imp;
 }
@@ -46,6 +46,9 @@ pixman_destructor (void)
 {
     pixman_implementation_t *imp = global_implementation;
 
+    _pixman_stop_threads ();
+    _pixman_region32_fini_data_pool ();
+
     while (imp)
     {
         pixman_implementation_t *cur = imp;
@@ -555,6 +558,25 @@ analyze_extent (pixman_image_t       *image,
     return TRUE;
 }
 
+/* An image's alpha map can change without the image becoming dirty, so
+ * this flag is computed for each composite operation instead of being
+ * stored in the image's flags, which would then have to be written on
+ * every validate.
+ */
+static uint32_t
+get_alpha_map_flags (pixman_image_t *image)
+{
+    bits_image_t *alpha_map = image->common.alpha_map;
+
+    if (alpha_map && alpha_map->format == PIXMAN_a8 &&
+	(alpha_map->common.flags & FAST_PATH_NO_ACCESSORS))
+    {
+	return FAST_PATH_A8_ALPHA_MAP;
+    }
+
+    return 0;
+}
+
 /*
  * Work around GCC bug causing crashes in Mozilla with SSE2
  *
@@ -603,12 +625,12 @@ pixman_image_composite32 (pixman_op_t      op,
     _pixman_image_validate (dest);
 
     src_format = src->common.extended_format_code;
-    info.src_flags = src->common.flags;
+    info.src_flags = src->common.flags | get_alpha_map_flags (src);
 
     if (mask && !(mask->common.flags & FAST_PATH_IS_OPAQUE))
     {
 	mask_format = mask->common.extended_format_code;
-	info.mask_flags = mask->common.flags;
+	info.mask_flags = mask->common.flags | get_alpha_map_flags (mask);
     }
     else
     {
@@ -775,6 +797,181 @@ pixman_fill (uint32_t *bits,
 	get_implementation(), bits, stride, bpp, x, y, width, height, filler);
 }
 
+static pixman_bool_t
+format_needs_palette (pixman_format_code_t format)
+{
+    return PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR ||
+	   PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY;
+}
+
+/**
+ * pixman_convert_pixels:
+ * @src_format: format of the source pixels
+ * @src_bits: the source pixels
+ * @src_stride: distance in bytes between two source rows
+ * @dst_format: format of the destination pixels
+ * @dst_bits: where to store the converted pixels
+ * @dst_stride: distance in bytes between two destination rows
+ * @width: number of pixels per row
+ * @height: number of rows
+ *
+ * Converts a rectangle of pixels from one format to another. The result
+ * is the same as that of a PIXMAN_OP_SRC composite between two images
+ * created with pixman_image_create_bits() on the two buffers, except
+ * that the unused bits of the destination pixels are undefined. As with
+ * pixman_image_create_bits(), the strides must be multiples of 4.
+ *
+ * Return value: FALSE if one of the formats is not supported. Formats
+ * that need a palette, such as PIXMAN_c8 and PIXMAN_g8, are not.
+ **/
+PIXMAN_EXPORT pixman_bool_t
+pixman_convert_pixels (pixman_format_code_t src_format,
+		       const uint32_t *     src_bits,
+		       int                  src_stride,
+		       pixman_format_code_t dst_format,
+		       uint32_t *           dst_bits,
+		       int                  dst_stride,
+		       int                  width,
+		       int                  height)
+{
+    pixman_image_t *src, *dst;
+
+    if (!pixman_format_supported_source (src_format)		||
+	!pixman_format_supported_destination (dst_format)	||
+	format_needs_palette (src_format)			||
+	format_needs_palette (dst_format))
+    {
+	return FALSE;
+    }
+
+    return_val_if_fail (src_stride % sizeof (uint32_t) == 0, FALSE);
+    return_val_if_fail (dst_stride % sizeof (uint32_t) == 0, FALSE);
+
+    if (width <= 0 || height <= 0)
+	return TRUE;
+
+    if (_pixman_implementation_convert (
+	    get_implementation (), src_format, (const uint8_t *)src_bits,
+	    src_stride, dst_format, (uint8_t *)dst_bits, dst_stride,
+	    width, height))
+    {
+	return TRUE;
+    }
+
+    src = pixman_image_create_bits (src_format, width, height,
+				    (uint32_t *)src_bits, src_stride);
+    dst = pixman_image_create_bits (dst_format, width, height,
+				    dst_bits, dst_stride);
+
+    if (src && dst)
+    {
+	pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dst,
+				  0, 0, 0, 0, 0, 0, width, height);
+    }
+
+    if (src)
+	pixman_image_unref (src);
+    if (dst)
+	pixman_image_unref (dst);
+
+    return src && dst;
+}
+
+static pixman_bool_t
+premultiply_pixels (pixman_format_code_t format,
+		    const uint32_t *     src_bits,
+		    int                  src_stride,
+		    uint32_t *           dst_bits,
+		    int                  dst_stride,
+		    int                  width,
+		    int                  height,
+		    pixman_bool_t        unpremultiply)
+{
+    switch (format)
+    {
+    case PIXMAN_a8r8g8b8:
+    case PIXMAN_a8b8g8r8:
+    case PIXMAN_b8g8r8a8:
+    case PIXMAN_r8g8b8a8:
+    case PIXMAN_a16b16g16r16:
+	break;
+
+    default:
+	return FALSE;
+    }
+
+    return_val_if_fail (src_stride % sizeof (uint32_t) == 0, FALSE);
+    return_val_if_fail (dst_stride % sizeof (uint32_t) == 0, FALSE);
+
+    if (width <= 0 || height <= 0)
+	return TRUE;
+
+    return _pixman_implementation_premultiply (
+	get_implementation (), format, (const uint8_t *)src_bits, src_stride,
+	(uint8_t *)dst_bits, dst_stride, width, height, unpremultiply);
+}
+
+/**
+ * pixman_premultiply_pixels:
+ * @format: format of the pixels
+ * @src_bits: pixels with straight alpha
+ * @src_stride: distance in bytes between two source rows
+ * @dst_bits: where to store the premultiplied pixels
+ * @dst_stride: distance in bytes between two destination rows
+ * @width: number of pixels per row
+ * @height: number of rows
+ *
+ * Multiplies the color channels of each pixel with its alpha, rounding
+ * like the combiners do. @src_bits and @dst_bits can be the same
+ * buffer, but must not overlap otherwise.
+ *
+ * Return value: FALSE if @format is not PIXMAN_a8r8g8b8,
+ * PIXMAN_a8b8g8r8, PIXMAN_b8g8r8a8, PIXMAN_r8g8b8a8 or
+ * PIXMAN_a16b16g16r16.
+ **/
+PIXMAN_EXPORT pixman_bool_t
+pixman_premultiply_pixels (pixman_format_code_t format,
+			   const uint32_t *     src_bits,
+			   int                  src_stride,
+			   uint32_t *           dst_bits,
+			   int                  dst_stride,
+			   int                  width,
+			   int                  height)
+{
+    return premultiply_pixels (format, src_bits, src_stride,
+			       dst_bits, dst_stride, width, height, FALSE);
+}
+
+/**
+ * pixman_unpremultiply_pixels:
+ * @format: format of the pixels
+ * @src_bits: premultiplied pixels
+ * @src_stride: distance in bytes between two source rows
+ * @dst_bits: where to store the pixels with straight alpha
+ * @dst_stride: distance in bytes between two destination rows
+ * @width: number of pixels per row
+ * @height: number of rows
+ *
+ * Divides the color channels of each pixel by its alpha, rounding to
+ * the nearest value. Channels larger than alpha become the maximum,
+ * and pixels with an alpha of zero become zero.
+ *
+ * Return value: FALSE if the format is not supported, see
+ * pixman_premultiply_pixels().
+ **/
+PIXMAN_EXPORT pixman_bool_t
+pixman_unpremultiply_pixels (pixman_format_code_t format,
+			     const uint32_t *     src_bits,
+			     int                  src_stride,
+			     uint32_t *           dst_bits,
+			     int                  dst_stride,
+			     int                  width,
+			     int                  height)
+{
+    return premultiply_pixels (format, src_bits, src_stride,
+			       dst_bits, dst_stride, width, height, TRUE);
+}
+
 static uint32_t
 color_to_uint32 (const pixman_color_t *color)
 {
@@ -1028,6 +1225,9 @@ pixman_format_supported_source (pixman_format_code_t format)
 {
     switch (format)
     {
+    /* 64 bpp formats */
+    case PIXMAN_a16b16g16r16:
+    case PIXMAN_x16b16g16r16:
     /* 32 bpp formats */
     case PIXMAN_a2b10g10r10:
     case PIXMAN_x2b10g10r10:
@@ -1086,6 +1286,8 @@ pixman_format_supported_source (pixman_format_code_t format)
     /* YUV formats */
     case PIXMAN_yuy2:
     case PIXMAN_yv12:
+    case PIXMAN_i420:
+    case PIXMAN_nv12:
 	return TRUE;
 
     default:
@@ -1108,8 +1310,11 @@ PIXMAN_EXPORT pixman_bool_t
 pixman_format_supported_destination (pixman_format_code_t format)
 {
     /* YUV formats cannot be written to at the moment */
-    if (format == PIXMAN_yuy2 || format == PIXMAN_yv12)
+    if (format == PIXMAN_yuy2 || format == PIXMAN_yv12 ||
+	format == PIXMAN_i420 || format == PIXMAN_nv12)
+    {
 	return FALSE;
+    }
 
     return pixman_format_supported_source (format);
 }
@@ -107,6 +107,8 @@ typedef unsigned __int64 uint64_t;
 
 #endif
 
+#include <stddef.h>
+
 /*
  * Boolean
  */
@@ -354,6 +356,14 @@ typedef enum
     PIXMAN_DITHER_ORDERED_BLUE_NOISE_64,
 } pixman_dither_t;
 
+typedef enum
+{
+    PIXMAN_YUV_BT601_LIMITED,
+    PIXMAN_YUV_BT601_FULL,
+    PIXMAN_YUV_BT709_LIMITED,
+    PIXMAN_YUV_BT709_FULL
+} pixman_yuv_color_space_t;
+
 typedef enum
 {
     PIXMAN_FILTER_FAST,
@@ -513,14 +523,34 @@ pixman_bool_t           pixman_region_init_rects         (pixman_region16_t *reg
 							  const pixman_box16_t *boxes,
 							  int                count);
 
+/* Like pixman_region_init_rects(), but builds the region in one sweep
+ * over the sorted boxes, which is much faster for large sets of
+ * overlapping boxes.
+ */
+PIXMAN_API
+pixman_bool_t           pixman_region_init_from_boxes_unsorted (pixman_region16_t    *region,
+								const pixman_box16_t *boxes,
+								int                   count);
+
 PIXMAN_API
 void                    pixman_region_init_with_extents  (pixman_region16_t    *region,
 							  const pixman_box16_t *extents);
 
+/* The region covers the set pixels of an a1 image, or the pixels of an
+ * a8 image that are not fully transparent.
+ */
 PIXMAN_API
 void                    pixman_region_init_from_image    (pixman_region16_t *region,
 							  pixman_image_t    *image);
 
+/* Like pixman_region_init_from_image(), but a8 pixels are only in the
+ * region if their alpha is at least threshold (1 to 255).
+ */
+PIXMAN_API
+void                    pixman_region_init_from_image_threshold (pixman_region16_t *region,
+								 pixman_image_t    *image,
+								 int                threshold);
+
 PIXMAN_API
 void                    pixman_region_fini               (pixman_region16_t *region);
 
@@ -545,6 +575,14 @@ pixman_bool_t           pixman_region_union              (pixman_region16_t
 							  const pixman_region16_t *reg1,
 							  const pixman_region16_t *reg2);
 
+/* Sets dest to the union of n_regions regions in one pass. dest may be
+ * one of them.
+ */
+PIXMAN_API
+pixman_bool_t           pixman_region_union_many         (pixman_region16_t       *dest,
+							  const pixman_region16_t *regions,
+							  int                      n_regions);
+
 PIXMAN_API
 pixman_bool_t           pixman_region_union_rect         (pixman_region16_t       *dest,
 							  const pixman_region16_t *source,
@@ -641,6 +679,17 @@ struct pixman_region32
     pixman_region32_data_t  *data;
 };
 
+/* Sets the functions used to allocate the box storage of 32 bit regions.
+ * 16 bit regions always use malloc(), realloc() and free(), since their
+ * data may be freed by callers. The allocator can only be set once, and
+ * only before any 32 bit region data has been allocated; it returns FALSE
+ * if that is no longer possible.
+ */
+PIXMAN_API
+pixman_bool_t pixman_set_region_allocator (void *(*alloc_func) (size_t size),
+					   void *(*realloc_func) (void *ptr, size_t size),
+					   void  (*free_func) (void *ptr));
+
 /* creation/destruction */
 PIXMAN_API
 void                    pixman_region32_init               (pixman_region32_t *region);
@@ -657,14 +706,34 @@ pixman_bool_t           pixman_region32_init_rects         (pixman_region32_t *r
 							    const pixman_box32_t *boxes,
 							    int                count);
 
+/* Like pixman_region32_init_rects(), but builds the region in one sweep
+ * over the sorted boxes, which is much faster for large sets of
+ * overlapping boxes.
+ */
+PIXMAN_API
+pixman_bool_t           pixman_region32_init_from_boxes_unsorted (pixman_region32_t    *region,
+								  const pixman_box32_t *boxes,
+								  int                   count);
+
 PIXMAN_API
 void                    pixman_region32_init_with_extents  (pixman_region32_t    *region,
 							    const pixman_box32_t *extents);
 
+/* The region covers the set pixels of an a1 image, or the pixels of an
+ * a8 image that are not fully transparent.
+ */
 PIXMAN_API
 void                    pixman_region32_init_from_image    (pixman_region32_t *region,
 							    pixman_image_t    *image);
 
+/* Like pixman_region32_init_from_image(), but a8 pixels are only in the
+ * region if their alpha is at least threshold (1 to 255).
+ */
+PIXMAN_API
+void                    pixman_region32_init_from_image_threshold (pixman_region32_t *region,
+								   pixman_image_t    *image,
+								   int                threshold);
+
 PIXMAN_API
 void                    pixman_region32_fini               (pixman_region32_t *region);
 
@@ -689,6 +758,14 @@ pixman_bool_t           pixman_region32_union              (pixman_region32_t
 							    const pixman_region32_t *reg1,
 							    const pixman_region32_t *reg2);
 
+/* Sets dest to the union of n_regions regions in one pass. dest may be
+ * one of them.
+ */
+PIXMAN_API
+pixman_bool_t           pixman_region32_union_many         (pixman_region32_t       *dest,
+							    const pixman_region32_t *regions,
+							    int                      n_regions);
+
 PIXMAN_API
 pixman_bool_t		pixman_region32_intersect_rect     (pixman_region32_t       *dest,
 							    const pixman_region32_t *source,
@@ -737,6 +814,9 @@ pixman_box32_t *        pixman_region32_extents            (const pixman_region3
 PIXMAN_API
 int                     pixman_region32_n_rects            (const pixman_region32_t *region);
 
+/* The boxes may be shared with copies of the region, so they must not be
+ * modified.
+ */
 PIXMAN_API
 pixman_box32_t *        pixman_region32_rectangles         (const pixman_region32_t *region,
 							    int                     *n_rects);
@@ -866,6 +946,8 @@ struct pixman_indexed
 #define PIXMAN_TYPE_RGBA	9
 #define PIXMAN_TYPE_ARGB_SRGB	10
 #define PIXMAN_TYPE_RGBA_FLOAT	11
+#define PIXMAN_TYPE_NV12	12
+#define PIXMAN_TYPE_I420	13
 
 #define PIXMAN_FORMAT_COLOR(f)				\
 	(PIXMAN_FORMAT_TYPE(f) == PIXMAN_TYPE_ARGB ||	\
@@ -879,6 +961,11 @@ typedef enum {
     PIXMAN_rgba_float =	PIXMAN_FORMAT_BYTE(128,PIXMAN_TYPE_RGBA_FLOAT,32,32,32,32),
 /* 96bpp formats */
     PIXMAN_rgb_float =	PIXMAN_FORMAT_BYTE(96,PIXMAN_TYPE_RGBA_FLOAT,0,32,32,32),
+/* 64bpp formats */
+    /* IEEE half precision floats, stored in r, g, b, a order */
+    PIXMAN_rgba_half =	PIXMAN_FORMAT_BYTE(64,PIXMAN_TYPE_RGBA_FLOAT,16,16,16,16),
+    PIXMAN_a16b16g16r16 = PIXMAN_FORMAT_BYTE(64,PIXMAN_TYPE_ABGR,16,16,16,16),
+    PIXMAN_x16b16g16r16 = PIXMAN_FORMAT_BYTE(64,PIXMAN_TYPE_ABGR,0,16,16,16),
 
 /* 32bpp formats */
     PIXMAN_a8r8g8b8 =	 PIXMAN_FORMAT(32,PIXMAN_TYPE_ARGB,8,8,8,8),
@@ -946,9 +1033,17 @@ typedef enum {
 
     PIXMAN_g1 =		 PIXMAN_FORMAT(1,PIXMAN_TYPE_GRAY,0,0,0,0),
 
-/* YUV formats */
+/* YUV formats
+ *
+ * The planar formats store a luma plane using the stride of the image,
+ * followed by 2x2 subsampled chroma planes: V then U at half the stride
+ * for yv12, U then V for i420, and a single plane of interleaved U and V
+ * at the full stride for nv12.
+ */
     PIXMAN_yuy2 =	 PIXMAN_FORMAT(16,PIXMAN_TYPE_YUY2,0,0,0,0),
-    PIXMAN_yv12 =	 PIXMAN_FORMAT(12,PIXMAN_TYPE_YV12,0,0,0,0)
+    PIXMAN_yv12 =	 PIXMAN_FORMAT(12,PIXMAN_TYPE_YV12,0,0,0,0),
+    PIXMAN_nv12 =	 PIXMAN_FORMAT(12,PIXMAN_TYPE_NV12,0,0,0,0),
+    PIXMAN_i420 =	 PIXMAN_FORMAT(12,PIXMAN_TYPE_I420,0,0,0,0)
 } pixman_format_code_t;
 
 /* Querying supported format values. */
@@ -958,6 +1053,34 @@ pixman_bool_t pixman_format_supported_destination (pixman_format_code_t format);
 PIXMAN_API
 pixman_bool_t pixman_format_supported_source      (pixman_format_code_t format);
 
+PIXMAN_API
+pixman_bool_t pixman_convert_pixels (pixman_format_code_t  src_format,
+				     const uint32_t       *src_bits,
+				     int                   src_stride,
+				     pixman_format_code_t  dst_format,
+				     uint32_t             *dst_bits,
+				     int                   dst_stride,
+				     int                   width,
+				     int                   height);
+
+PIXMAN_API
+pixman_bool_t pixman_premultiply_pixels   (pixman_format_code_t  format,
+					   const uint32_t       *src_bits,
+					   int                   src_stride,
+					   uint32_t             *dst_bits,
+					   int                   dst_stride,
+					   int                   width,
+					   int                   height);
+
+PIXMAN_API
+pixman_bool_t pixman_unpremultiply_pixels (pixman_format_code_t  format,
+					   const uint32_t       *src_bits,
+					   int                   src_stride,
+					   uint32_t             *dst_bits,
+					   int                   dst_stride,
+					   int                   width,
+					   int                   height);
+
 /* Constructors */
 PIXMAN_API
 pixman_image_t *pixman_image_create_solid_fill       (const pixman_color_t         *color);
@@ -1042,6 +1165,27 @@ void            pixman_image_set_dither_offset       (pixman_image_t
 						      int                           offset_x,
 						      int                           offset_y);
 
+/* The matrix and range used to convert the samples of a YUV image to
+ * RGB. The default is PIXMAN_YUV_BT601_LIMITED.
+ */
+PIXMAN_API
+void            pixman_image_set_yuv_color_space     (pixman_image_t               *image,
+						      pixman_yuv_color_space_t      color_space);
+
+/* When exact coverage is enabled on an a8 image, trapezoids and edges
+ * rasterized into it get the exact area of each pixel they cover, rather
+ * than a count of the covered points of the sample grid. In this mode,
+ * the t and b arguments of pixman_rasterize_edges() are the exact top
+ * and bottom of the area to fill. Trapezoids and triangles composited
+ * onto an image with exact coverage are also rasterized this way.
+ */
+PIXMAN_API
+void            pixman_image_set_exact_coverage      (pixman_image_t               *image,
+						      pixman_bool_t                 exact_coverage);
+
+PIXMAN_API
+pixman_bool_t   pixman_image_get_exact_coverage      (pixman_image_t               *image);
+
 PIXMAN_API
 pixman_bool_t   pixman_image_set_filter              (pixman_image_t               *image,
 						      pixman_filter_t               filter,
@@ -1208,9 +1352,71 @@ typedef struct
     const void *glyph;
 } pixman_glyph_t;
 
+typedef struct
+{
+    uint64_t	hits;
+    uint64_t	misses;
+    uint64_t	evictions;
+    uint64_t	n_bytes;	/* memory used by the glyph images,
+				 * including all of the atlases */
+    uint64_t	atlas_bytes;	/* memory used by the atlases */
+    uint32_t	n_glyphs;
+    uint32_t	n_tombstones;
+} pixman_glyph_cache_stats_t;
+
+/* A glyph positioned in 24.8 fixed point, for drawing with subpixel
+ * variants from the cache.
+ */
+#define PIXMAN_GLYPH_MAX_PHASES 16
+
+typedef struct
+{
+    int32_t	x, y;
+    void *	font_key;
+    void *	glyph_key;
+} pixman_subpixel_glyph_t;
+
 PIXMAN_API
 pixman_glyph_cache_t *pixman_glyph_cache_create       (void);
 
+/* A cache that can be used by several threads at the same time. Each
+ * thread must freeze it before looking up or inserting glyphs and thaw
+ * it when it is done with them; the glyphs stay valid until then. The
+ * cache is trimmed when glyphs are inserted rather than when it is
+ * thawed, and an evicted glyph is freed once every thread that had the
+ * cache frozen at the time has thawed it.
+ */
+PIXMAN_API
+pixman_glyph_cache_t *pixman_glyph_cache_create_shared (void);
+
+/* When a cache holds more than max_glyphs glyphs or more than max_bytes
+ * bytes of glyph images (counting the whole of each atlas, which may
+ * take up at most half of max_bytes), the least recently used glyphs are evicted the
+ * next time it is thawed (for a shared cache, as soon as a glyph is
+ * inserted), until it is down to half of the limits. A
+ * max_bytes of 0 means that there is no byte limit, and a max_glyphs of
+ * 0 means the default of 16384 glyphs.
+ */
+PIXMAN_API
+pixman_glyph_cache_t *pixman_glyph_cache_create_with_limits (uint64_t max_bytes,
+							     int      max_glyphs);
+
+PIXMAN_API
+void                  pixman_glyph_cache_set_limits   (pixman_glyph_cache_t *cache,
+						       uint64_t              max_bytes,
+						       int                   max_glyphs);
+
+PIXMAN_API
+void                  pixman_glyph_cache_get_stats    (pixman_glyph_cache_t       *cache,
+						       pixman_glyph_cache_stats_t *stats);
+
+/* In atlas mode, small a8 and a8r8g8b8 glyphs inserted from then on are
+ * packed into large shared images instead of getting an image each.
+ */
+PIXMAN_API
+void                  pixman_glyph_cache_set_use_atlas (pixman_glyph_cache_t *cache,
+							pixman_bool_t         use_atlas);
+
 PIXMAN_API
 void                  pixman_glyph_cache_destroy      (pixman_glyph_cache_t *cache);
 
@@ -1278,6 +1484,67 @@ void                  pixman_composite_glyphs_no_mask (pixman_op_t           op,
 						       int		     n_glyphs,
 						       const pixman_glyph_t *glyphs);
 
+/* Subpixel variants. A glyph can be stored once for each horizontal
+ * phase 0 <= phase < PIXMAN_GLYPH_MAX_PHASES; the plain lookup, insert
+ * and remove functions above act on phase 0.
+ */
+PIXMAN_API
+const void *          pixman_glyph_cache_lookup_subpixel (pixman_glyph_cache_t *cache,
+							  void                 *font_key,
+							  void                 *glyph_key,
+							  int                   phase);
+
+PIXMAN_API
+const void *          pixman_glyph_cache_insert_subpixel (pixman_glyph_cache_t *cache,
+							  void                 *font_key,
+							  void                 *glyph_key,
+							  int                   phase,
+							  int                   origin_x,
+							  int                   origin_y,
+							  pixman_image_t       *glyph_image);
+
+PIXMAN_API
+void                  pixman_glyph_cache_remove_subpixel (pixman_glyph_cache_t *cache,
+							  void                 *font_key,
+							  void                 *glyph_key,
+							  int                   phase);
+
+/* Like pixman_composite_glyphs(), but each glyph is drawn with the
+ * variant for the nearest of n_phases horizontal phases. y is rounded
+ * to the nearest pixel. A missing variant falls back to phase 0, and
+ * glyphs that aren't in the cache at all are skipped.
+ */
+PIXMAN_API
+void                  pixman_composite_subpixel_glyphs (pixman_op_t                    op,
+							pixman_image_t                *src,
+							pixman_image_t                *dest,
+							pixman_format_code_t           mask_format,
+							int32_t                        src_x,
+							int32_t                        src_y,
+							int32_t                        mask_x,
+							int32_t                        mask_y,
+							int32_t                        dest_x,
+							int32_t                        dest_y,
+							int32_t                        width,
+							int32_t                        height,
+							pixman_glyph_cache_t          *cache,
+							int                            n_phases,
+							int                            n_glyphs,
+							const pixman_subpixel_glyph_t *glyphs);
+
+PIXMAN_API
+void                  pixman_composite_subpixel_glyphs_no_mask (pixman_op_t                    op,
+								pixman_image_t                *src,
+								pixman_image_t                *dest,
+								int32_t                        src_x,
+								int32_t                        src_y,
+								int32_t                        dest_x,
+								int32_t                        dest_y,
+								pixman_glyph_cache_t          *cache,
+								int                            n_phases,
+								int                            n_glyphs,
+								const pixman_subpixel_glyph_t *glyphs);
+
 /*
  * Trapezoids
  */
@@ -1287,6 +1554,15 @@ typedef struct pixman_trap pixman_trap_t;
 typedef struct pixman_span_fix pixman_span_fix_t;
 typedef struct pixman_triangle pixman_triangle_t;
 
+/*
+ * Fill rules for polygons
+ */
+typedef enum
+{
+    PIXMAN_FILL_RULE_NONZERO,
+    PIXMAN_FILL_RULE_EVEN_ODD
+} pixman_fill_rule_t;
+
 /*
  * An edge structure.  This represents a single polygon edge
  * and can be quickly stepped across small or large gaps in the
@@ -1421,6 +1697,30 @@ void	      pixman_add_triangles       (pixman_image_t              *image,
 					  int	                       n_tris,
 					  const pixman_triangle_t     *tris);
 
+/* Allow pixman_composite_trapezoids() and pixman_composite_triangles()
+ * to split large amounts of work into bands of rows that are rasterized
+ * and composited by up to n_threads threads. The default is 1, which
+ * means that everything happens in the calling thread. The threads are
+ * started when they are first needed and are then kept for later calls.
+ * Only one call at a time gets to use them; a call from another thread
+ * in the meantime does all of its work in its own thread.
+ */
+PIXMAN_API
+void          pixman_set_rasterization_threads (int n_threads);
+
+PIXMAN_API
+void          pixman_composite_polygon   (pixman_op_t		       op,
+					  pixman_image_t *	       src,
+					  pixman_image_t *	       dst,
+					  pixman_format_code_t	       mask_format,
+					  int			       x_src,
+					  int			       y_src,
+					  int			       x_dst,
+					  int			       y_dst,
+					  int			       n_edges,
+					  const pixman_line_fixed_t *  edges,
+					  pixman_fill_rule_t	       fill_rule);
+
 PIXMAN_END_DECLS
 
 #endif /* PIXMAN_H__ */
@@ -0,0 +1,201 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* SRC and OVER onto the 2101010 formats, from 8888 and 2101010 images,
+ * solid colors and bilinearly scaled images, must give the same results
+ * as compositing through an rgba_float image.
+ */
+
+static const pixman_format_code_t dest_formats[] =
+{
+    PIXMAN_a2r10g10b10, PIXMAN_x2r10g10b10,
+    PIXMAN_a2b10g10r10, PIXMAN_x2b10g10r10,
+};
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE, PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD, PIXMAN_REPEAT_REFLECT,
+};
+
+static pixman_image_t *
+convert (pixman_image_t *src, pixman_format_code_t format)
+{
+    int width = pixman_image_get_width (src);
+    int height = pixman_image_get_height (src);
+    pixman_image_t *dest =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, width, height);
+
+    return dest;
+}
+
+static pixman_image_t *
+create_random_image (pixman_format_code_t format, int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+    uint32_t *p = pixman_image_get_data (image);
+    int i;
+
+    prng_randmemset (p, width * height * 4, 0);
+
+    /* Some transparent and opaque pixels, and some runs of them */
+    for (i = 0; i < width * height; ++i)
+    {
+	int n = prng_rand_n (16);
+
+	if (n == 0)
+	    p[i] = 0;
+	else if (n == 1)
+	    p[i] |= 0xff000000;
+	else if (n == 2 && i >= 4)
+	    p[i] = p[i - 4];
+    }
+
+    return image;
+}
+
+static pixman_image_t *
+create_source (pixman_format_code_t dest_format, int width, int height,
+	       const char **name)
+{
+    pixman_bool_t bgr =
+	PIXMAN_FORMAT_TYPE (dest_format) == PIXMAN_TYPE_ABGR;
+    pixman_format_code_t format;
+    pixman_image_t *image;
+
+    switch (prng_rand_n (5))
+    {
+    case 0:
+    {
+	pixman_color_t color;
+
+	color.red = prng_rand ();
+	color.green = prng_rand ();
+	color.blue = prng_rand ();
+	color.alpha = prng_rand_n (3) ? 0xffff : prng_rand ();
+
+	*name = "solid";
+	return pixman_image_create_solid_fill (&color);
+    }
+
+    case 1:
+	format = bgr ? PIXMAN_a2b10g10r10 : PIXMAN_a2r10g10b10;
+	break;
+
+    case 2:
+	format = bgr ? PIXMAN_x2b10g10r10 : PIXMAN_x2r10g10b10;
+	break;
+
+    case 3:
+	format = bgr ? PIXMAN_x8b8g8r8 : PIXMAN_x8r8g8b8;
+	break;
+
+    default:
+	format = bgr ? PIXMAN_a8b8g8r8 : PIXMAN_a8r8g8b8;
+	break;
+    }
+
+    *name = format_name (format);
+
+    if (prng_rand_n (8) == 0)
+    {
+	image = create_random_image (format, 1, 1);
+	pixman_image_set_repeat (image, PIXMAN_REPEAT_NORMAL);
+	return image;
+    }
+
+    image = create_random_image (format, width, height);
+
+    if (PIXMAN_FORMAT_BPP (format) == 32 && PIXMAN_FORMAT_R (format) == 8 &&
+	prng_rand_n (2))
+    {
+	pixman_transform_t t;
+
+	pixman_transform_init_scale (
+	    &t,
+	    pixman_double_to_fixed (0.3 + prng_rand_n (2000) / 1000.0),
+	    pixman_double_to_fixed (0.3 + prng_rand_n (2000) / 1000.0));
+	t.matrix[0][2] = prng_rand_n (0x40000) - 0x20000;
+	t.matrix[1][2] = prng_rand_n (0x40000) - 0x20000;
+
+	pixman_image_set_transform (image, &t);
+	pixman_image_set_filter (image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+	pixman_image_set_repeat (
+	    image, repeats[prng_rand_n (ARRAY_LENGTH (repeats))]);
+
+	*name = PIXMAN_FORMAT_A (format) ?
+	    "scaled a8 8888" : "scaled x8 8888";
+    }
+
+    return image;
+}
+
+static pixman_bool_t
+check_composite (int iter)
+{
+    pixman_format_code_t format =
+	dest_formats[prng_rand_n (ARRAY_LENGTH (dest_formats))];
+    pixman_op_t op = prng_rand_n (2) ? PIXMAN_OP_OVER : PIXMAN_OP_SRC;
+    int width = 1 + prng_rand_n (40), height = 1 + prng_rand_n (4);
+    uint32_t mask = PIXMAN_FORMAT_A (format) ? 0xffffffff : 0x3fffffff;
+    pixman_image_t *src, *dest, *fdest, *expected;
+    uint32_t *d, *e;
+    const char *name;
+    pixman_bool_t ok = TRUE;
+    int i;
+
+    src = create_source (format, width, height, &name);
+    dest = create_random_image (format, width, height);
+
+    fdest = convert (dest, PIXMAN_rgba_float);
+    pixman_image_composite32 (op, src, NULL, fdest,
+			      0, 0, 0, 0, 0, 0, width, height);
+    expected = convert (fdest, format);
+
+    pixman_image_composite32 (op, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, width, height);
+
+    d = pixman_image_get_data (dest);
+    e = pixman_image_get_data (expected);
+
+    for (i = 0; i < width * height; ++i)
+    {
+	if ((d[i] & mask) != (e[i] & mask))
+	{
+	    printf ("iteration %d: %s %s onto %s, pixel %d is %08x "
+		    "instead of %08x\n", iter, operator_name (op), name,
+		    format_name (format), i, d[i] & mask, e[i] & mask);
+	    ok = FALSE;
+	    break;
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    pixman_image_unref (fdest);
+    pixman_image_unref (expected);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    for (i = 0; i < 20000; ++i)
+    {
+	if (!check_composite (i))
+	    return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* Compositing an image with an alpha map must give the same results as
+ * compositing an a8r8g8b8 image that has the alpha of the alpha map, or
+ * 0 outside of it, and the color of the image.
+ */
+
+static const pixman_format_code_t alpha_formats[] =
+{
+    PIXMAN_a8, PIXMAN_a8, PIXMAN_a8r8g8b8,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_OVER, PIXMAN_OP_SRC, PIXMAN_OP_ADD, PIXMAN_OP_OVER_REVERSE,
+};
+
+static pixman_image_t *
+create_random_image (pixman_format_code_t format, int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * height, 0);
+
+    return image;
+}
+
+static uint32_t
+get_alpha (pixman_image_t *alpha_map, int x, int y)
+{
+    int stride = pixman_image_get_stride (alpha_map);
+    uint8_t *bits = (uint8_t *)pixman_image_get_data (alpha_map);
+
+    if (x < 0 || x >= pixman_image_get_width (alpha_map) ||
+	y < 0 || y >= pixman_image_get_height (alpha_map))
+    {
+	return 0;
+    }
+
+    if (pixman_image_get_format (alpha_map) == PIXMAN_a8)
+	return bits[y * stride + x];
+    else
+	return ((uint32_t *)(bits + y * stride))[x] >> 24;
+}
+
+static pixman_bool_t
+check_alpha_map (int iter)
+{
+    pixman_format_code_t format =
+	prng_rand_n (2) ? PIXMAN_x8r8g8b8 : PIXMAN_a8r8g8b8;
+    pixman_format_code_t dest_format =
+	prng_rand_n (2) ? PIXMAN_x8r8g8b8 : PIXMAN_a8r8g8b8;
+    pixman_format_code_t alpha_format =
+	alpha_formats[prng_rand_n (ARRAY_LENGTH (alpha_formats))];
+    pixman_op_t op = ops[prng_rand_n (ARRAY_LENGTH (ops))];
+    pixman_repeat_t repeat =
+	prng_rand_n (2) ? PIXMAN_REPEAT_NONE : PIXMAN_REPEAT_NORMAL;
+    int width = 1 + prng_rand_n (100), height = 1 + prng_rand_n (8);
+    int alpha_width = 1 + prng_rand_n (120);
+    int alpha_height = 1 + prng_rand_n (10);
+    int origin_x = prng_rand_n (40) - 20, origin_y = prng_rand_n (6) - 3;
+    int src_x = prng_rand_n (8) - 2, src_y = prng_rand_n (4) - 1;
+    int composite_width = prng_rand_n (width + 4);
+    int composite_height = prng_rand_n (height + 2);
+    uint32_t mask = PIXMAN_FORMAT_A (dest_format) ? 0xffffffff : 0x00ffffff;
+    pixman_image_t *src, *alpha, *merged, *dest, *expected;
+    uint32_t *s, *m, *d, *e;
+    pixman_bool_t ok = TRUE;
+    int x, y;
+
+    src = create_random_image (format, width, height);
+    alpha = create_random_image (alpha_format, alpha_width, alpha_height);
+    merged = pixman_image_create_bits (PIXMAN_a8r8g8b8, width, height, NULL, -1);
+
+    /* Some transparent and opaque runs */
+    if (prng_rand_n (2))
+    {
+	uint8_t *a = (uint8_t *)pixman_image_get_data (alpha);
+	int size = pixman_image_get_stride (alpha) * alpha_height;
+	int n = prng_rand_n (size);
+
+	memset (a + prng_rand_n (size - n + 1), prng_rand_n (2) ? 0xff : 0, n);
+    }
+
+    pixman_image_set_alpha_map (src, alpha, origin_x, origin_y);
+    pixman_image_set_repeat (src, repeat);
+    pixman_image_set_repeat (merged, repeat);
+
+    s = pixman_image_get_data (src);
+    m = pixman_image_get_data (merged);
+
+    for (y = 0; y < height; ++y)
+    {
+	for (x = 0; x < width; ++x)
+	{
+	    m[y * width + x] = (s[y * width + x] & 0x00ffffff) |
+		(get_alpha (alpha, x - origin_x, y - origin_y) << 24);
+	}
+    }
+
+    dest = create_random_image (dest_format, width, height);
+    expected = pixman_image_create_bits (dest_format, width, height, NULL, -1);
+    d = pixman_image_get_data (dest);
+    e = pixman_image_get_data (expected);
+    memcpy (e, d, width * height * 4);
+
+    pixman_image_composite32 (op, src, NULL, dest, src_x, src_y, 0, 0,
+			      0, 0, composite_width, composite_height);
+    pixman_image_composite32 (op, merged, NULL, expected, src_x, src_y, 0, 0,
+			      0, 0, composite_width, composite_height);
+
+    for (x = 0; x < width * height; ++x)
+    {
+	if ((d[x] & mask) != (e[x] & mask))
+	{
+	    printf ("iteration %d: %s of %s with %s alpha map onto %s, "
+		    "pixel %d is %08x instead of %08x\n",
+		    iter, operator_name (op), format_name (format),
+		    format_name (alpha_format), format_name (dest_format),
+		    x, d[x] & mask, e[x] & mask);
+	    ok = FALSE;
+	    break;
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (alpha);
+    pixman_image_unref (merged);
+    pixman_image_unref (dest);
+    pixman_image_unref (expected);
+
+    return ok;
+}
+
+static int n_reads;
+
+static uint32_t
+reader (const void *src, int size)
+{
+    n_reads++;
+
+    switch (size)
+    {
+    case 1:
+	return *(uint8_t *)src;
+    case 2:
+	return *(uint16_t *)src;
+    default:
+	return *(uint32_t *)src;
+    }
+}
+
+static void
+writer (void *src, uint32_t value, int size)
+{
+    switch (size)
+    {
+    case 1:
+	*(uint8_t *)src = value;
+	break;
+    case 2:
+	*(uint16_t *)src = value;
+	break;
+    default:
+	*(uint32_t *)src = value;
+	break;
+    }
+}
+
+/* Accessors that are set on the alpha map after the image has been
+ * used must be called, even though the image itself didn't change.
+ */
+static pixman_bool_t
+check_alpha_map_accessors (void)
+{
+    pixman_image_t *src = create_random_image (PIXMAN_x8r8g8b8, 32, 8);
+    pixman_image_t *alpha = create_random_image (PIXMAN_a8, 32, 8);
+    pixman_image_t *dest = create_random_image (PIXMAN_a8r8g8b8, 32, 8);
+
+    pixman_image_set_alpha_map (src, alpha, 0, 0);
+
+    pixman_image_composite32 (PIXMAN_OP_OVER, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 32, 8);
+
+    pixman_image_set_accessors (alpha, reader, writer);
+
+    pixman_image_composite32 (PIXMAN_OP_OVER, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 32, 8);
+
+    pixman_image_unref (src);
+    pixman_image_unref (alpha);
+    pixman_image_unref (dest);
+
+    if (n_reads == 0)
+    {
+	printf ("the accessors of the alpha map were not used\n");
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    if (!check_alpha_map_accessors ())
+	return 1;
+
+    for (i = 0; i < 20000; ++i)
+    {
+	if (!check_alpha_map (i))
+	    return 1;
+    }
+
+    return 0;
+}
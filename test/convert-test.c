@@ -0,0 +1,154 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* pixman_convert_pixels() must give the same pixels as a SRC composite
+ * between two images on the same buffers, apart from the unused bits,
+ * and must not write outside of the rectangle.
+ */
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8, PIXMAN_a8b8g8r8, PIXMAN_x8b8g8r8,
+    PIXMAN_b8g8r8a8, PIXMAN_b8g8r8x8, PIXMAN_r8g8b8a8, PIXMAN_r8g8b8x8,
+    PIXMAN_r8g8b8, PIXMAN_b8g8r8, PIXMAN_r5g6b5, PIXMAN_b5g6r5,
+    PIXMAN_a2r10g10b10, PIXMAN_x2r10g10b10,
+    PIXMAN_a2b10g10r10, PIXMAN_x2b10g10r10, PIXMAN_a8,
+
+    /* These have no converters of their own */
+    PIXMAN_a1r5g5b5, PIXMAN_a4r4g4b4, PIXMAN_a8r8g8b8_sRGB,
+    PIXMAN_a16b16g16r16, PIXMAN_x16b16g16r16,
+};
+
+/* The bits of a pixel that have to be the same */
+static uint64_t
+used_bits (pixman_format_code_t format)
+{
+    int bpp = PIXMAN_FORMAT_BPP (format);
+    int unused = bpp - PIXMAN_FORMAT_DEPTH (format);
+    uint64_t all = bpp == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bpp) - 1;
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_BGRA ||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_RGBA)
+    {
+	return all & (all << unused);
+    }
+
+    return all >> unused;
+}
+
+static uint64_t
+get_pixel (const uint8_t *row, int x, int bytes)
+{
+    uint64_t p = 0;
+
+    memcpy (&p, row + x * bytes, bytes);
+
+    return p;
+}
+
+static pixman_bool_t
+check_convert (int iter)
+{
+    pixman_format_code_t src_format =
+	formats[prng_rand_n (ARRAY_LENGTH (formats))];
+    pixman_format_code_t dst_format =
+	formats[prng_rand_n (ARRAY_LENGTH (formats))];
+    int src_bytes = PIXMAN_FORMAT_BPP (src_format) / 8;
+    int dst_bytes = PIXMAN_FORMAT_BPP (dst_format) / 8;
+    int width = 1 + prng_rand_n (67);
+    int height = 1 + prng_rand_n (5);
+    int src_stride = (width * src_bytes + 3 + 4 * prng_rand_n (3)) & ~3;
+    int dst_stride = (width * dst_bytes + 3 + 4 * prng_rand_n (3)) & ~3;
+    uint64_t mask = used_bits (dst_format);
+    uint32_t *src, *expected, *dst;
+    pixman_image_t *s, *d;
+    pixman_bool_t ok = TRUE;
+    int x, y;
+
+    src = aligned_malloc (16, src_stride * height);
+    expected = aligned_malloc (16, dst_stride * height);
+    dst = aligned_malloc (16, dst_stride * height);
+
+    prng_randmemset (src, src_stride * height, 0);
+    prng_randmemset (expected, dst_stride * height, 0);
+    memcpy (dst, expected, dst_stride * height);
+
+    s = pixman_image_create_bits (src_format, width, height, src, src_stride);
+    d = pixman_image_create_bits (dst_format, width, height,
+				  expected, dst_stride);
+    pixman_image_composite32 (PIXMAN_OP_SRC, s, NULL, d,
+			      0, 0, 0, 0, 0, 0, width, height);
+    pixman_image_unref (s);
+    pixman_image_unref (d);
+
+    if (!pixman_convert_pixels (src_format, src, src_stride,
+				dst_format, dst, dst_stride, width, height))
+    {
+	printf ("iteration %d: %s to %s not supported\n",
+		iter, format_name (src_format), format_name (dst_format));
+	ok = FALSE;
+    }
+
+    for (y = 0; y < height && ok; ++y)
+    {
+	const uint8_t *e = (uint8_t *)expected + y * dst_stride;
+	const uint8_t *r = (uint8_t *)dst + y * dst_stride;
+
+	for (x = 0; x < width; ++x)
+	{
+	    uint64_t ep = get_pixel (e, x, dst_bytes);
+	    uint64_t rp = get_pixel (r, x, dst_bytes);
+
+	    if ((ep & mask) != (rp & mask))
+	    {
+		printf ("iteration %d: %s to %s, pixel %d, %d is "
+			"%llx instead of %llx\n",
+			iter, format_name (src_format), format_name (dst_format),
+			x, y, (unsigned long long)(rp & mask),
+			(unsigned long long)(ep & mask));
+		ok = FALSE;
+		break;
+	    }
+	}
+
+	if (ok && memcmp (e + width * dst_bytes, r + width * dst_bytes,
+			  dst_stride - width * dst_bytes) != 0)
+	{
+	    printf ("iteration %d: %s to %s wrote past the end of row %d\n",
+		    iter, format_name (src_format), format_name (dst_format), y);
+	    ok = FALSE;
+	}
+    }
+
+    free (src);
+    free (expected);
+    free (dst);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t bits[4] = { 0 };
+    int i;
+
+    prng_srand (0);
+
+    if (pixman_convert_pixels (PIXMAN_g8, bits, 4, PIXMAN_a8r8g8b8, bits, 16, 1, 1) ||
+	pixman_convert_pixels (PIXMAN_a8r8g8b8, bits, 16, PIXMAN_c8, bits, 4, 1, 1))
+    {
+	printf ("formats that need a palette are accepted\n");
+	return 1;
+    }
+
+    for (i = 0; i < 20000; ++i)
+    {
+	if (!check_convert (i))
+	    return 1;
+    }
+
+    return 0;
+}
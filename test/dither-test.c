@@ -0,0 +1,342 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+#include "dither/blue-noise-64x64.h"
+
+/* Dithered destinations must give the same results as the general path,
+ * which is what they take when they have accessors. SRC from 8888 onto
+ * 565 and 2101010 is done with exact integer math instead, which can be
+ * off by one from it, unless only the general path is enabled. Every
+ * implementation that does so must match the integer math here exactly,
+ * so that the output doesn't depend on which of them is in use.
+ */
+
+static const pixman_format_code_t wide_formats[] =
+{
+    PIXMAN_r5g6b5, PIXMAN_b5g6r5,
+    PIXMAN_a1r5g5b5, PIXMAN_x1r5g5b5,
+    PIXMAN_a4r4g4b4, PIXMAN_x4b4g4r4,
+    PIXMAN_a8r8g8b8, PIXMAN_x8b8g8r8,
+    PIXMAN_b8g8r8a8, PIXMAN_r8g8b8a8,
+    PIXMAN_a2r10g10b10, PIXMAN_x2b10g10r10,
+};
+
+static const pixman_format_code_t narrow_formats[] =
+{
+    PIXMAN_r5g6b5, PIXMAN_b5g6r5,
+    PIXMAN_a2r10g10b10, PIXMAN_x2r10g10b10,
+    PIXMAN_a2b10g10r10, PIXMAN_x2b10g10r10,
+};
+
+static const pixman_dither_t dithers[] =
+{
+    PIXMAN_DITHER_ORDERED_BAYER_8,
+    PIXMAN_DITHER_ORDERED_BLUE_NOISE_64,
+    PIXMAN_DITHER_FAST,
+    PIXMAN_DITHER_GOOD,
+    PIXMAN_DITHER_BEST,
+};
+
+static uint32_t
+reader (const void *src, int size)
+{
+    switch (size)
+    {
+    case 1:
+	return *(uint8_t *)src;
+    case 2:
+	return *(uint16_t *)src;
+    case 4:
+	return *(uint32_t *)src;
+    default:
+	assert (0);
+	return 0;
+    }
+}
+
+static void
+writer (void *src, uint32_t value, int size)
+{
+    switch (size)
+    {
+    case 1:
+	*(uint8_t *)src = value;
+	break;
+    case 2:
+	*(uint16_t *)src = value;
+	break;
+    case 4:
+	*(uint32_t *)src = value;
+	break;
+    default:
+	assert (0);
+    }
+}
+
+static pixman_image_t *
+create_float_image (int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (PIXMAN_rgba_float, width, height, NULL, -1);
+    float *p = (float *)pixman_image_get_data (image);
+    int i;
+
+    for (i = 0; i < width * height * 4; ++i)
+    {
+	/* Some values that are exact in the destination */
+	if (prng_rand_n (8) == 0)
+	    p[i] = prng_rand_n (32) / 31.f;
+	else
+	    p[i] = prng_rand () / (float)0xffffffff;
+    }
+
+    return image;
+}
+
+static pixman_image_t *
+create_8888_image (pixman_format_code_t dest_format, int width, int height)
+{
+    pixman_format_code_t format =
+	PIXMAN_FORMAT_TYPE (dest_format) == PIXMAN_TYPE_ABGR ?
+	PIXMAN_a8b8g8r8 : PIXMAN_a8r8g8b8;
+    pixman_image_t *image =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+
+    prng_randmemset (pixman_image_get_data (image), width * height * 4, 0);
+
+    return image;
+}
+
+static pixman_image_t *
+create_dest (pixman_format_code_t format, int width, int height,
+	     pixman_dither_t dither, int offset_x, int offset_y,
+	     uint32_t *bits)
+{
+    pixman_image_t *image;
+    int stride = (width * PIXMAN_FORMAT_BPP (format) / 8 + 3) & ~3;
+
+    image = pixman_image_create_bits (format, width, height, bits, stride);
+    pixman_image_set_dither (image, dither);
+    pixman_image_set_dither_offset (image, offset_x, offset_y);
+
+    return image;
+}
+
+static uint32_t
+bayer_threshold (int x, int y)
+{
+    uint32_t m;
+
+    y ^= x;
+    m = ((y & 0x1) << 5) | ((x & 0x1) << 4) |
+	((y & 0x2) << 2) | ((x & 0x2) << 1) |
+	((y & 0x4) >> 1) | ((x & 0x4) >> 2);
+
+    /* floor (255 * (2 * m + 1) / 128) */
+    return (255 * (2 * m + 1)) >> 7;
+}
+
+/* The same float math as pixman, since these aren't exact */
+static uint32_t
+blue_noise_threshold (int x, int y)
+{
+    float m = dither_blue_noise_64x64[((y & 0x3f) << 6) | (x & 0x3f)];
+    float f = m * (1. / 4096.f) + (1. / 8192.f);
+
+    return (uint16_t)(255.f * f);
+}
+
+static uint32_t
+dither_threshold (pixman_dither_t dither, int x, int y)
+{
+    if (dither == PIXMAN_DITHER_ORDERED_BAYER_8 || dither == PIXMAN_DITHER_FAST)
+	return bayer_threshold (x, y);
+    else
+	return blue_noise_threshold (x, y);
+}
+
+static uint32_t
+dither_channel (uint32_t s, int shift, int n_bits, uint32_t t)
+{
+    uint32_t c = (s >> shift) & 0xff;
+
+    return (c * ((1 << n_bits) - 1) + t) / 255;
+}
+
+/* The result of dithering the 8888 pixel s with integer math */
+static uint32_t
+dither_pixel (pixman_format_code_t format, pixman_dither_t dither,
+	      uint32_t s, int x, int y)
+{
+    uint32_t t = dither_threshold (dither, x, y);
+    uint32_t r = dither_channel (s, 16, PIXMAN_FORMAT_R (format), t);
+    uint32_t g = dither_channel (s, 8, PIXMAN_FORMAT_G (format), t);
+    uint32_t b = dither_channel (s, 0, PIXMAN_FORMAT_B (format), t);
+
+    if (PIXMAN_FORMAT_BPP (format) == 16)
+	return (r << 11) | (g << 5) | b;
+    else
+	return (dither_channel (s, 24, 2, t) << 30) | (r << 20) | (g << 10) | b;
+}
+
+/* Whether the channels of two 565 or 2101010 pixels differ by one at most */
+static pixman_bool_t
+within_one (pixman_format_code_t format, uint32_t a, uint32_t b)
+{
+    static const int bits_565[] = { 5, 6, 5, 0 };
+    static const int bits_2101010[] = { 10, 10, 10, 2 };
+    const int *bits =
+	PIXMAN_FORMAT_BPP (format) == 16 ? bits_565 : bits_2101010;
+    int shift = 0;
+    int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+	int ca = (a >> shift) & ((1 << bits[i]) - 1);
+	int cb = (b >> shift) & ((1 << bits[i]) - 1);
+
+	if (abs (ca - cb) > 1)
+	    return FALSE;
+
+	shift += bits[i];
+    }
+
+    return TRUE;
+}
+
+static pixman_bool_t
+check_dither (int iter, pixman_bool_t narrow)
+{
+    pixman_format_code_t format = narrow ?
+	narrow_formats[prng_rand_n (ARRAY_LENGTH (narrow_formats))] :
+	wide_formats[prng_rand_n (ARRAY_LENGTH (wide_formats))];
+    pixman_dither_t dither = dithers[prng_rand_n (ARRAY_LENGTH (dithers))];
+    int width = 1 + prng_rand_n (150), height = 1 + prng_rand_n (4);
+    int dest_x = prng_rand_n (4), dest_y = prng_rand_n (2);
+    int dest_width = dest_x + width, dest_height = dest_y + height;
+    int offset_x = prng_rand_n (200) - 100, offset_y = prng_rand_n (200) - 100;
+    int bpp = PIXMAN_FORMAT_BPP (format);
+    uint32_t mask = PIXMAN_FORMAT_A (format) ?
+	0xffffffff : ((1u << PIXMAN_FORMAT_DEPTH (format)) - 1);
+    pixman_op_t op = PIXMAN_OP_SRC;
+    pixman_image_t *src, *dest, *ref;
+    uint32_t *d, *r;
+    pixman_bool_t ok = TRUE;
+    int integer = -1;	/* whether dest got the integer math, if known */
+    int size;
+    int x, y;
+
+    if (narrow)
+    {
+	src = create_8888_image (format, width, height);
+    }
+    else if (prng_rand_n (2))
+    {
+	src = create_float_image (width, height);
+    }
+    else
+    {
+	src = create_8888_image (format, width, height);
+	op = PIXMAN_OP_OVER;
+    }
+
+    size = ((dest_width * bpp / 8 + 3) & ~3) * dest_height;
+    d = malloc (size);
+    r = malloc (size);
+    prng_randmemset (d, size, 0);
+    memcpy (r, d, size);
+
+    dest = create_dest (format, dest_width, dest_height, dither,
+			offset_x, offset_y, d);
+    ref = create_dest (format, dest_width, dest_height, dither,
+		       offset_x, offset_y, r);
+    pixman_image_set_accessors (ref, reader, writer);
+
+    pixman_image_composite32 (op, src, NULL, dest,
+			      0, 0, 0, 0, dest_x, dest_y, width, height);
+    pixman_image_composite32 (op, src, NULL, ref,
+			      0, 0, 0, 0, dest_x, dest_y, width, height);
+
+    for (y = 0; y < dest_height && ok; ++y)
+    {
+	for (x = 0; x < dest_width; ++x)
+	{
+	    uint32_t dp, rp, sp;
+	    pixman_bool_t inside = x >= dest_x && y >= dest_y;
+
+	    if (bpp == 16)
+	    {
+		dp = ((uint16_t *)pixman_image_get_data (dest))[
+		    y * pixman_image_get_stride (dest) / 2 + x];
+		rp = ((uint16_t *)r)[y * pixman_image_get_stride (ref) / 2 + x];
+	    }
+	    else
+	    {
+		dp = d[y * pixman_image_get_stride (dest) / 4 + x];
+		rp = r[y * pixman_image_get_stride (ref) / 4 + x];
+	    }
+
+	    dp &= mask;
+	    rp &= mask;
+
+	    /* The integer math may be off by one from the general path,
+	     * but all of the pixels must come from one or the other.
+	     */
+	    if (narrow && inside)
+	    {
+		uint32_t ip;
+
+		sp = pixman_image_get_data (src)[
+		    (y - dest_y) * width + x - dest_x];
+		ip = dither_pixel (format, dither, sp,
+				   x + offset_x, y + offset_y) & mask;
+
+		if (ip != rp && within_one (format, ip, rp))
+		{
+		    if (integer < 0 && (dp == ip || dp == rp))
+			integer = dp == ip;
+
+		    if (integer > 0)
+			rp = ip;
+		}
+	    }
+
+	    if (dp != rp)
+	    {
+		printf ("iteration %d: %s %s onto %s dithered with %s, "
+			"pixel %d, %d is %08x instead of %08x\n",
+			iter, operator_name (op),
+			format_name (pixman_image_get_format (src)),
+			format_name (format), dither_name (dither),
+			x, y, dp, rp);
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    pixman_image_unref (ref);
+    free (d);
+    free (r);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    for (i = 0; i < 10000; ++i)
+    {
+	if (!check_dither (i, i & 1))
+	    return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH  64
+#define HEIGHT 64
+
+static double
+triangle_area (const pixman_triangle_t *tri)
+{
+    double x1 = pixman_fixed_to_double (tri->p1.x);
+    double y1 = pixman_fixed_to_double (tri->p1.y);
+    double x2 = pixman_fixed_to_double (tri->p2.x);
+    double y2 = pixman_fixed_to_double (tri->p2.y);
+    double x3 = pixman_fixed_to_double (tri->p3.x);
+    double y3 = pixman_fixed_to_double (tri->p3.y);
+
+    return fabs ((x2 - x1) * (y3 - y1) - (x3 - x1) * (y2 - y1)) / 2;
+}
+
+static double
+mask_area (pixman_image_t *mask, int *n_pixels)
+{
+    uint8_t *bits = (uint8_t *)pixman_image_get_data (mask);
+    int stride = pixman_image_get_stride (mask);
+    double area = 0;
+    int x, y;
+
+    *n_pixels = 0;
+
+    for (y = 0; y < HEIGHT; ++y)
+    {
+	for (x = 0; x < WIDTH; ++x)
+	{
+	    if (bits[y * stride + x])
+	    {
+		area += bits[y * stride + x] / 255.0;
+		(*n_pixels)++;
+	    }
+	}
+    }
+
+    return area;
+}
+
+static void
+test_rectangle (void)
+{
+    pixman_image_t *mask;
+    pixman_trapezoid_t trap;
+    uint8_t *bits;
+    int stride;
+
+    mask = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, -1);
+    pixman_image_set_exact_coverage (mask, TRUE);
+    assert (pixman_image_get_exact_coverage (mask));
+
+    bits = (uint8_t *)pixman_image_get_data (mask);
+    stride = pixman_image_get_stride (mask);
+
+    trap.top = pixman_double_to_fixed (5.5);
+    trap.bottom = pixman_double_to_fixed (8.5);
+    trap.left.p1.x = trap.left.p2.x = pixman_double_to_fixed (10.25);
+    trap.left.p1.y = trap.top;
+    trap.left.p2.y = trap.bottom;
+    trap.right.p1.x = trap.right.p2.x = pixman_double_to_fixed (20.75);
+    trap.right.p1.y = trap.top;
+    trap.right.p2.y = trap.bottom;
+
+    pixman_rasterize_trapezoid (mask, &trap, 0, 0);
+
+    assert (bits[4 * stride + 15] == 0);
+    assert (bits[5 * stride + 9] == 0);
+    assert (bits[5 * stride + 10] == 96);
+    assert (bits[5 * stride + 15] == 128);
+    assert (bits[6 * stride + 10] == 191);
+    assert (bits[6 * stride + 15] == 255);
+    assert (bits[6 * stride + 20] == 191);
+    assert (bits[6 * stride + 21] == 0);
+    assert (bits[8 * stride + 15] == 128);
+    assert (bits[9 * stride + 15] == 0);
+
+    pixman_image_unref (mask);
+}
+
+static void
+test_triangles (void)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src = pixman_image_create_solid_fill (&white);
+    int i;
+
+    for (i = 0; i < 1000; ++i)
+    {
+	pixman_image_t *mask;
+	pixman_triangle_t tri;
+	double area, expected;
+	int n_pixels;
+
+	tri.p1.x = prng_rand_n (WIDTH << 16);
+	tri.p1.y = prng_rand_n (HEIGHT << 16);
+	tri.p2.x = prng_rand_n (WIDTH << 16);
+	tri.p2.y = prng_rand_n (HEIGHT << 16);
+	tri.p3.x = prng_rand_n (WIDTH << 16);
+	tri.p3.y = prng_rand_n (HEIGHT << 16);
+
+	expected = triangle_area (&tri);
+
+	mask = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, -1);
+	pixman_image_set_exact_coverage (mask, TRUE);
+
+	if (i & 1)
+	{
+	    pixman_add_triangles (mask, 0, 0, 1, &tri);
+	}
+	else
+	{
+	    pixman_composite_triangles (PIXMAN_OP_ADD, src, mask, PIXMAN_a8,
+					0, 0, 0, 0, 1, &tri);
+	}
+
+	area = mask_area (mask, &n_pixels);
+
+	/* Each pixel can be off by the rounding to 8 bits, plus the
+	 * rounding of the two trapezoids of a triangle in the same row.
+	 */
+	if (fabs (area - expected) > n_pixels * 1.5 / 255 + 0.01)
+	{
+	    printf ("triangle %d: area is %f, expected %f (%d pixels)\n",
+		    i, area, expected, n_pixels);
+	    exit (1);
+	}
+
+	pixman_image_unref (mask);
+    }
+
+    pixman_image_unref (src);
+}
+
+int
+main (int argc, char **argv)
+{
+    prng_srand (0);
+
+    test_rectangle ();
+    test_triangles ();
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+/* Glyphs stored in atlases must composite exactly like glyphs that
+ * have an image of their own, the atlases must count against the byte
+ * limit of the cache, and their space must be reused as glyphs come
+ * and go.
+ */
+
+#define WIDTH 160
+#define HEIGHT 120
+#define N_KEYS 300
+#define N_GLYPHS 100
+#define N_FONTS 20
+#define MAX_BYTES (1024 * 1024)
+#define MAX_ATLAS_BYTES (2 * 1024 * 1024)
+
+static const pixman_format_code_t glyph_formats[] =
+{
+    PIXMAN_a8, PIXMAN_a8r8g8b8, PIXMAN_a4,
+};
+
+static pixman_image_t *glyph_images[N_KEYS];
+
+static pixman_image_t *
+create_glyph_image (void)
+{
+    pixman_format_code_t format =
+	glyph_formats[prng_rand_n (ARRAY_LENGTH (glyph_formats))];
+    int width, height, stride;
+    pixman_image_t *image;
+
+    /* Mostly small glyphs, and a few too large for an atlas */
+    if (prng_rand_n (10) == 0)
+    {
+	width = 60 + prng_rand_n (40);
+	height = 60 + prng_rand_n (40);
+    }
+    else
+    {
+	width = 1 + prng_rand_n (30);
+	height = 1 + prng_rand_n (30);
+    }
+
+    image = pixman_image_create_bits (format, width, height, NULL, -1);
+    stride = pixman_image_get_stride (image);
+    prng_randmemset (pixman_image_get_data (image), stride * height, 0);
+
+    return image;
+}
+
+static const void *
+get_glyph (pixman_glyph_cache_t *cache, int key)
+{
+    const void *glyph;
+
+    if (!(glyph = pixman_glyph_cache_lookup (cache, NULL, (void *)(uintptr_t)(key + 1))))
+    {
+	glyph = pixman_glyph_cache_insert (cache, NULL, (void *)(uintptr_t)(key + 1),
+					   prng_rand_n (10), prng_rand_n (10),
+					   glyph_images[key]);
+    }
+
+    return glyph;
+}
+
+static pixman_image_t *
+create_dest (pixman_format_code_t format)
+{
+    pixman_image_t *dest;
+
+    dest = pixman_image_create_bits (format, WIDTH, HEIGHT, NULL, -1);
+    memset (pixman_image_get_data (dest), 0x40,
+	    pixman_image_get_stride (dest) * HEIGHT);
+
+    return dest;
+}
+
+/* Looks up or inserts N_GLYPHS random glyphs from N_FONTS fonts */
+static void
+churn (pixman_glyph_cache_t *cache)
+{
+    int i;
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < N_GLYPHS; ++i)
+    {
+	void *font_key = (void *)(uintptr_t)(prng_rand_n (N_FONTS) + 1);
+	int key = prng_rand_n (N_KEYS);
+
+	if (!pixman_glyph_cache_lookup (cache, font_key, (void *)(uintptr_t)(key + 1)))
+	{
+	    pixman_glyph_cache_insert (cache, font_key, (void *)(uintptr_t)(key + 1),
+				       0, 0, glyph_images[key]);
+	}
+    }
+
+    pixman_glyph_cache_thaw (cache);
+}
+
+static int
+check_byte_limit (void)
+{
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    uint64_t max_atlas_bytes = 0;
+    int i;
+
+    cache = pixman_glyph_cache_create_with_limits (MAX_BYTES, 0);
+    pixman_glyph_cache_set_use_atlas (cache, TRUE);
+
+    for (i = 0; i < 200; ++i)
+    {
+	churn (cache);
+
+	pixman_glyph_cache_get_stats (cache, &stats);
+
+	if (stats.n_bytes > MAX_BYTES || stats.atlas_bytes > stats.n_bytes)
+	{
+	    printf ("iteration %d: cache uses %llu bytes, %llu of them in atlases\n",
+		    i, (unsigned long long)stats.n_bytes,
+		    (unsigned long long)stats.atlas_bytes);
+	    return 1;
+	}
+
+	max_atlas_bytes = MAX (max_atlas_bytes, stats.atlas_bytes);
+    }
+
+    pixman_glyph_cache_destroy (cache);
+
+    if (max_atlas_bytes == 0)
+    {
+	printf ("no atlases were used\n");
+	return 1;
+    }
+
+    return 0;
+}
+
+/* A cache that only holds a few glyphs at a time must not keep
+ * allocating atlases.
+ */
+static int
+check_space_reuse (void)
+{
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    int i;
+
+    cache = pixman_glyph_cache_create_with_limits (0, 2 * N_GLYPHS);
+    pixman_glyph_cache_set_use_atlas (cache, TRUE);
+
+    for (i = 0; i < 2000; ++i)
+    {
+	churn (cache);
+
+	pixman_glyph_cache_get_stats (cache, &stats);
+
+	if (stats.atlas_bytes > MAX_ATLAS_BYTES)
+	{
+	    printf ("iteration %d: %llu bytes of atlases for %u glyphs\n",
+		    i, (unsigned long long)stats.atlas_bytes, stats.n_glyphs);
+	    return 1;
+	}
+    }
+
+    pixman_glyph_cache_destroy (cache);
+
+    return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_color_t color = { 0x8000, 0x4000, 0xc000, 0xe000 };
+    pixman_glyph_cache_t *caches[2];
+    pixman_image_t *src;
+    int i, j, k;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_KEYS; ++i)
+	glyph_images[i] = create_glyph_image ();
+
+    if (check_byte_limit () || check_space_reuse ())
+	return 1;
+
+    caches[0] = pixman_glyph_cache_create ();
+    caches[1] = pixman_glyph_cache_create ();
+    pixman_glyph_cache_set_use_atlas (caches[1], TRUE);
+
+    src = pixman_image_create_solid_fill (&color);
+
+    for (i = 0; i < 300; ++i)
+    {
+	pixman_glyph_t glyphs[2][N_GLYPHS];
+	pixman_image_t *dests[2];
+	pixman_format_code_t mask_format = PIXMAN_null;
+	pixman_bool_t use_mask = prng_rand_n (2);
+	int keys[N_GLYPHS];
+
+	for (j = 0; j < N_GLYPHS; ++j)
+	{
+	    keys[j] = prng_rand_n (N_KEYS);
+	    glyphs[0][j].x = glyphs[1][j].x = prng_rand_n (WIDTH + 20) - 10;
+	    glyphs[0][j].y = glyphs[1][j].y = prng_rand_n (HEIGHT + 20) - 10;
+	}
+
+	for (k = 0; k < 2; ++k)
+	{
+	    /* Both caches get the same origins */
+	    prng_srand (i);
+
+	    pixman_glyph_cache_freeze (caches[k]);
+
+	    for (j = 0; j < N_GLYPHS; ++j)
+		glyphs[k][j].glyph = get_glyph (caches[k], keys[j]);
+
+	    if (use_mask)
+		mask_format = pixman_glyph_get_mask_format (caches[k], N_GLYPHS, glyphs[k]);
+
+	    dests[k] = create_dest (PIXMAN_a8r8g8b8);
+
+	    if (use_mask)
+	    {
+		pixman_composite_glyphs (PIXMAN_OP_OVER, src, dests[k], mask_format,
+					 0, 0, 0, 0, 0, 0, WIDTH, HEIGHT,
+					 caches[k], N_GLYPHS, glyphs[k]);
+	    }
+	    else
+	    {
+		pixman_composite_glyphs_no_mask (PIXMAN_OP_OVER, src, dests[k],
+						 0, 0, 0, 0,
+						 caches[k], N_GLYPHS, glyphs[k]);
+	    }
+
+	    /* Remove some glyphs, so that atlas space gets released */
+	    for (j = 0; j < 5; ++j)
+	    {
+		pixman_glyph_cache_remove (caches[k], NULL,
+					   (void *)(uintptr_t)(prng_rand_n (N_KEYS) + 1));
+	    }
+
+	    pixman_glyph_cache_thaw (caches[k]);
+	}
+
+	prng_srand (1000 + i);
+
+	if (memcmp (pixman_image_get_data (dests[0]),
+		    pixman_image_get_data (dests[1]),
+		    pixman_image_get_stride (dests[0]) * HEIGHT) != 0)
+	{
+	    printf ("iteration %d: atlas glyphs differ (%s)\n", i,
+		    use_mask ? "with mask" : "without mask");
+	    return 1;
+	}
+
+	pixman_image_unref (dests[0]);
+	pixman_image_unref (dests[1]);
+    }
+
+    pixman_glyph_cache_destroy (caches[0]);
+    pixman_glyph_cache_destroy (caches[1]);
+
+    for (i = 0; i < N_KEYS; ++i)
+	pixman_image_unref (glyph_images[i]);
+
+    pixman_image_unref (src);
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "utils.h"
+
+static pixman_image_t *
+create_glyph_image (int size)
+{
+    pixman_image_t *image;
+
+    image = pixman_image_create_bits (PIXMAN_a8, size, size, NULL, -1);
+    memset (pixman_image_get_data (image), 0xff,
+	    pixman_image_get_stride (image) * size);
+
+    return image;
+}
+
+static void
+insert_glyphs (pixman_glyph_cache_t *cache, pixman_image_t *image,
+	       int first, int n)
+{
+    int i;
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = first; i < first + n; ++i)
+    {
+	void *key = (void *)(uintptr_t)(i + 1);
+	const void *glyph = pixman_glyph_cache_lookup (cache, NULL, key);
+
+	if (!glyph)
+	    glyph = pixman_glyph_cache_insert (cache, NULL, key, 0, 0, image);
+
+	assert (glyph != NULL);
+    }
+
+    pixman_glyph_cache_thaw (cache);
+}
+
+/* A byte budget evicts by size, not by glyph count */
+static void
+test_byte_limit (void)
+{
+    pixman_image_t *image = create_glyph_image (64);
+    int stride = pixman_image_get_stride (image);
+    uint64_t glyph_bytes = (uint64_t)stride * 64;
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+
+    cache = pixman_glyph_cache_create_with_limits (100 * glyph_bytes, 0);
+
+    insert_glyphs (cache, image, 0, 100);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == 100);
+    assert (stats.n_bytes == 100 * glyph_bytes);
+    assert (stats.evictions == 0);
+    assert (stats.misses == 100);
+    assert (stats.hits == 0);
+
+    /* Going over the limit evicts down to half of it */
+    insert_glyphs (cache, image, 100, 1);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == 50);
+    assert (stats.n_bytes == 50 * glyph_bytes);
+    assert (stats.evictions == 51);
+
+    /* The most recently used glyphs are the ones that are kept */
+    insert_glyphs (cache, image, 51, 50);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.hits == 50);
+    assert (stats.n_glyphs == 50);
+
+    pixman_glyph_cache_destroy (cache);
+    pixman_image_unref (image);
+}
+
+/* The hash table grows as needed */
+static void
+test_many_glyphs (void)
+{
+    pixman_image_t *image = create_glyph_image (1);
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    int i;
+
+    cache = pixman_glyph_cache_create_with_limits (0, 100000);
+
+    insert_glyphs (cache, image, 0, 70000);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == 70000);
+    assert (stats.evictions == 0);
+
+    /* Removals leave tombstones that are cleaned up when the table
+     * needs room.
+     */
+    for (i = 0; i < 70000; i += 2)
+	pixman_glyph_cache_remove (cache, NULL, (void *)(uintptr_t)(i + 1));
+
+    insert_glyphs (cache, image, 70000, 20000);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == 55000);
+    assert (stats.n_tombstones < stats.n_glyphs);
+
+    pixman_glyph_cache_freeze (cache);
+    for (i = 0; i < 90000; ++i)
+    {
+	const void *glyph =
+	    pixman_glyph_cache_lookup (cache, NULL, (void *)(uintptr_t)(i + 1));
+
+	assert ((glyph != NULL) == (i >= 70000 || (i & 1)));
+    }
+    pixman_glyph_cache_thaw (cache);
+
+    pixman_glyph_cache_destroy (cache);
+    pixman_image_unref (image);
+}
+
+int
+main (int argc, char **argv)
+{
+    test_byte_limit ();
+    test_many_glyphs ();
+
+    return 0;
+}
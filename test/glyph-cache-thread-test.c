@@ -0,0 +1,449 @@
+#include "utils.h"
+
+#if !defined (HAVE_PTHREADS) && !defined (_WIN32)
+
+int main ()
+{
+    printf ("Skipped glyph-cache-thread-test - pthreads or Windows Threads not supported\n");
+    return 0;
+}
+
+#else
+
+#include <stdlib.h>
+
+#ifdef HAVE_PTHREADS
+# include <pthread.h>
+#elif defined (_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#endif
+
+#define THREADS 8
+#define N_ROUNDS 200
+#define GLYPHS_PER_ROUND 400
+
+/* More distinct glyphs than the cache keeps, so that glyphs get evicted
+ * while other threads are using the cache.
+ */
+#define N_KEYS 40000
+
+/* The first thread of the first run keeps the glyphs of one round
+ * frozen for this many rounds and then checks them again, after the
+ * other threads have frozen and thawed the cache many times.
+ */
+#define KEEP_ROUNDS 20
+
+/* The limits of the second run, in which the freezes of the threads
+ * always overlap.
+ */
+#define MAX_GLYPHS 2048
+#define MAX_BYTES (64 * 1024)
+
+static pixman_glyph_cache_t *cache;
+
+typedef struct
+{
+    int		thread_no;
+    prng_t	prng_state;
+    int		relay;		/* -1 unless this is a relay thread */
+    int		keep_rounds;
+    int		check_limits;
+    int		failed;
+} info_t;
+
+/* Two relay threads take turns keeping the cache frozen. Each freezes
+ * it again before handing over to the other, which only then thaws its
+ * own freeze, so some thread always has the cache frozen.
+ */
+#ifdef HAVE_PTHREADS
+static pthread_mutex_t relay_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t relay_cond = PTHREAD_COND_INITIALIZER;
+# define relay_lock()	pthread_mutex_lock (&relay_mutex)
+# define relay_unlock()	pthread_mutex_unlock (&relay_mutex)
+# define relay_wait()	pthread_cond_wait (&relay_cond, &relay_mutex)
+# define relay_wake()	pthread_cond_broadcast (&relay_cond)
+#elif defined (_WIN32)
+static SRWLOCK relay_mutex = SRWLOCK_INIT;
+static CONDITION_VARIABLE relay_cond = CONDITION_VARIABLE_INIT;
+# define relay_lock()	AcquireSRWLockExclusive (&relay_mutex)
+# define relay_unlock()	ReleaseSRWLockExclusive (&relay_mutex)
+# define relay_wait()	SleepConditionVariableSRW (&relay_cond, &relay_mutex, INFINITE, 0)
+# define relay_wake()	WakeAllConditionVariable (&relay_cond)
+#endif
+
+static int relay_turn;
+static int relay_handovers;
+static int relay_stop;
+
+/* The size and the contents of a glyph are derived from its key, so a
+ * glyph that was inserted by another thread can be checked.
+ */
+static int
+glyph_size (uintptr_t key)
+{
+    return 1 + key % 13;
+}
+
+static uint8_t
+glyph_value (uintptr_t key)
+{
+    return 1 + key % 251;
+}
+
+static const void *
+get_glyph (uintptr_t key)
+{
+    pixman_image_t *image;
+    const void *glyph;
+    int size;
+
+    if ((glyph = pixman_glyph_cache_lookup (cache, NULL, (void *)key)))
+	return glyph;
+
+    size = glyph_size (key);
+    image = pixman_image_create_bits (PIXMAN_a8, size, size, NULL, -1);
+    memset (pixman_image_get_data (image), glyph_value (key),
+	    pixman_image_get_stride (image) * size);
+
+    glyph = pixman_glyph_cache_insert (cache, NULL, (void *)key, 0, 0, image);
+
+    pixman_image_unref (image);
+
+    return glyph;
+}
+
+/* Check all the glyphs after they have been looked up, so that glyphs
+ * evicted by other threads in the meantime are caught.
+ */
+static void
+check_glyphs (info_t          *info,
+	      pixman_glyph_t  *glyphs,
+	      const uintptr_t *keys,
+	      int              n_glyphs)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    uint32_t mask_bits[16 * 16 / 4];
+    pixman_image_t *src, *mask;
+    int i;
+
+    src = pixman_image_create_solid_fill (&white);
+    mask = pixman_image_create_bits (PIXMAN_a8, 16, 16, mask_bits, 16);
+
+    for (i = 0; i < n_glyphs && !info->failed; ++i)
+    {
+	pixman_box32_t extents;
+	int size = glyph_size (keys[i]);
+
+	pixman_glyph_get_extents (cache, 1, &glyphs[i], &extents);
+
+	if (extents.x2 - extents.x1 != size ||
+	    extents.y2 - extents.y1 != size)
+	{
+	    printf ("thread %d: glyph %lu has the wrong size\n",
+		    info->thread_no, (unsigned long)keys[i]);
+	    info->failed = TRUE;
+	    break;
+	}
+
+	memset (mask_bits, 0, sizeof (mask_bits));
+	pixman_composite_glyphs (PIXMAN_OP_SRC, src, mask, PIXMAN_a8,
+				 0, 0, 0, 0, 0, 0, 16, 16,
+				 cache, 1, &glyphs[i]);
+
+	if (((uint8_t *)mask_bits)[(size - 1) * 16 + size - 1] !=
+	    glyph_value (keys[i]))
+	{
+	    printf ("thread %d: glyph %lu has the wrong contents\n",
+		    info->thread_no, (unsigned long)keys[i]);
+	    info->failed = TRUE;
+	    break;
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (mask);
+}
+
+static void
+check_limits (info_t *info)
+{
+    pixman_glyph_cache_stats_t stats;
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+
+    if (stats.n_glyphs > MAX_GLYPHS || stats.n_bytes > MAX_BYTES)
+    {
+	printf ("thread %d: the cache has %lu glyphs and %lu bytes\n",
+		info->thread_no, (unsigned long)stats.n_glyphs,
+		(unsigned long)stats.n_bytes);
+	info->failed = TRUE;
+    }
+}
+
+static void
+run (info_t *info)
+{
+    pixman_glyph_t glyphs[GLYPHS_PER_ROUND];
+    uintptr_t keys[GLYPHS_PER_ROUND];
+    pixman_glyph_t kept_glyphs[GLYPHS_PER_ROUND];
+    uintptr_t kept_keys[GLYPHS_PER_ROUND];
+    int round, i;
+
+    for (round = 0; round < N_ROUNDS && !info->failed; ++round)
+    {
+	pixman_bool_t keep = info->keep_rounds && round % KEEP_ROUNDS == 0;
+
+	if (keep)
+	{
+	    if (round > 0)
+	    {
+		check_glyphs (info, kept_glyphs, kept_keys, GLYPHS_PER_ROUND);
+		pixman_glyph_cache_thaw (cache);
+	    }
+
+	    pixman_glyph_cache_freeze (cache);
+	}
+
+	pixman_glyph_cache_freeze (cache);
+
+	for (i = 0; i < GLYPHS_PER_ROUND; ++i)
+	{
+	    keys[i] = 1 + prng_rand_r (&info->prng_state) % N_KEYS;
+
+	    glyphs[i].x = 0;
+	    glyphs[i].y = 0;
+	    if (!(glyphs[i].glyph = get_glyph (keys[i])))
+	    {
+		printf ("thread %d: insertion failed\n", info->thread_no);
+		info->failed = TRUE;
+		break;
+	    }
+	}
+
+	if (!info->failed)
+	    check_glyphs (info, glyphs, keys, GLYPHS_PER_ROUND);
+
+	if (keep)
+	{
+	    memcpy (kept_glyphs, glyphs, sizeof (glyphs));
+	    memcpy (kept_keys, keys, sizeof (keys));
+	}
+
+	pixman_glyph_cache_thaw (cache);
+
+	if (info->check_limits)
+	    check_limits (info);
+    }
+
+    if (info->keep_rounds)
+    {
+	check_glyphs (info, kept_glyphs, kept_keys, GLYPHS_PER_ROUND);
+	pixman_glyph_cache_thaw (cache);
+    }
+}
+
+static void
+relay (int k)
+{
+    pixman_bool_t frozen = FALSE;
+
+    relay_lock ();
+
+    for (;;)
+    {
+	while (relay_turn != k)
+	    relay_wait ();
+
+	/* The other relay has the cache frozen, unless it has stopped */
+	if (frozen)
+	    pixman_glyph_cache_thaw (cache);
+
+	if (!relay_stop)
+	    pixman_glyph_cache_freeze (cache);
+
+	frozen = !relay_stop;
+	relay_turn = !k;
+	relay_handovers++;
+	relay_wake ();
+
+	if (!frozen)
+	    break;
+    }
+
+    relay_unlock ();
+}
+
+#ifdef HAVE_PTHREADS
+typedef pthread_t thread_t;
+
+static void *
+thread (void *data)
+{
+    info_t *info = data;
+
+    if (info->relay >= 0)
+	relay (info->relay);
+    else
+	run (info);
+
+    return NULL;
+}
+
+static pixman_bool_t
+start_thread (thread_t *thread_id, info_t *info)
+{
+    return pthread_create (thread_id, NULL, thread, info) == 0;
+}
+
+static void
+join_thread (thread_t *thread_id)
+{
+    pthread_join (*thread_id, NULL);
+}
+#elif defined (_WIN32)
+typedef HANDLE thread_t;
+
+DWORD WINAPI
+thread (LPVOID data)
+{
+    info_t *info = data;
+
+    if (info->relay >= 0)
+	relay (info->relay);
+    else
+	run (info);
+
+    return 0;
+}
+
+static pixman_bool_t
+start_thread (thread_t *thread_id, info_t *info)
+{
+    *thread_id = CreateThread (NULL, 0, thread, info, 0, NULL);
+
+    return *thread_id != NULL;
+}
+
+static void
+join_thread (thread_t *thread_id)
+{
+    WaitForSingleObject (*thread_id, INFINITE);
+    CloseHandle (*thread_id);
+}
+#endif
+
+/* With overlap, the relay threads keep the cache frozen during the
+ * whole run, so it must be trimmed and its glyphs freed without ever
+ * being completely thawed.
+ */
+static pixman_bool_t
+run_threads (pixman_bool_t overlap)
+{
+    info_t info[THREADS + 2] = { { 0 } };
+    thread_t threads[THREADS + 2];
+    pixman_glyph_cache_stats_t stats;
+    int n_threads = overlap ? THREADS + 2 : THREADS;
+    pixman_bool_t ok = TRUE;
+    int i;
+
+    cache = pixman_glyph_cache_create_shared ();
+    pixman_glyph_cache_set_use_atlas (cache, TRUE);
+
+    if (overlap)
+	pixman_glyph_cache_set_limits (cache, MAX_BYTES, MAX_GLYPHS);
+
+    relay_turn = 0;
+    relay_handovers = 0;
+    relay_stop = FALSE;
+
+    for (i = 0; i < n_threads; ++i)
+    {
+	info[i].thread_no = i;
+	info[i].relay = i >= THREADS ? i - THREADS : -1;
+	info[i].keep_rounds = !overlap && i == 0;
+	info[i].check_limits = overlap;
+	prng_srand_r (&info[i].prng_state, i);
+    }
+
+    /* The relays go first, and have the cache frozen before any other
+     * thread starts.
+     */
+    for (i = THREADS; i < n_threads; ++i)
+    {
+	if (!start_thread (&threads[i], &info[i]))
+	{
+	    printf ("Thread creation failed!\n");
+	    exit (1);
+	}
+    }
+
+    relay_lock ();
+    while (overlap && relay_handovers < 2)
+	relay_wait ();
+    relay_unlock ();
+
+    for (i = 0; i < THREADS; ++i)
+    {
+	if (!start_thread (&threads[i], &info[i]))
+	{
+	    printf ("Thread creation failed!\n");
+	    exit (1);
+	}
+    }
+
+    for (i = 0; i < THREADS; ++i)
+	join_thread (&threads[i]);
+
+    relay_lock ();
+    relay_stop = TRUE;
+    relay_unlock ();
+
+    for (i = THREADS; i < n_threads; ++i)
+	join_thread (&threads[i]);
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    if (stats.n_glyphs > (overlap ? MAX_GLYPHS : 16384))
+    {
+	printf ("%lu glyphs are left in the cache\n",
+		(unsigned long)stats.n_glyphs);
+	ok = FALSE;
+    }
+
+    pixman_glyph_cache_destroy (cache);
+
+    for (i = 0; i < THREADS; ++i)
+    {
+	if (info[i].failed)
+	    ok = FALSE;
+    }
+
+    return ok;
+}
+
+int
+main (void)
+{
+    pixman_image_t *image;
+
+    /* Glyphs can't be looked up or inserted without freezing the cache,
+     * since they could be evicted at any time.
+     */
+    cache = pixman_glyph_cache_create_shared ();
+    image = pixman_image_create_bits (PIXMAN_a8, 4, 4, NULL, -1);
+    if (pixman_glyph_cache_insert (cache, NULL, (void *)1, 0, 0, image) ||
+	pixman_glyph_cache_lookup (cache, NULL, (void *)1))
+    {
+	printf ("glyphs were inserted or looked up without a freeze\n");
+	return 1;
+    }
+    pixman_image_unref (image);
+    pixman_glyph_cache_destroy (cache);
+
+    if (!run_threads (FALSE) || !run_threads (TRUE))
+	return 1;
+
+    return 0;
+}
+
+#endif
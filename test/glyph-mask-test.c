@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+/* pixman_composite_glyphs() with a8 glyphs and an a8 mask must give the
+ * same result as adding the glyphs to a mask one by one and then
+ * compositing the mask.
+ */
+
+#define WIDTH 100
+#define HEIGHT 120
+#define N_KEYS 50
+#define N_GLYPHS 200
+
+static const pixman_op_t operators[] =
+{
+    PIXMAN_OP_OVER, PIXMAN_OP_ADD, PIXMAN_OP_SRC, PIXMAN_OP_IN,
+    PIXMAN_OP_OUT_REVERSE,
+};
+
+static pixman_image_t *glyph_images[N_KEYS];
+static int origins[N_KEYS][2];
+
+static pixman_image_t *
+create_dest (void)
+{
+    pixman_image_t *dest;
+
+    dest = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, -1);
+    prng_srand (1);
+    prng_randmemset (pixman_image_get_data (dest),
+		     pixman_image_get_stride (dest) * HEIGHT, 0);
+
+    return dest;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_color_t color = { 0x8000, 0x4000, 0xc000, 0xe000 };
+    pixman_glyph_cache_t *cache;
+    pixman_image_t *src;
+    int i, j;
+
+    prng_srand (0);
+
+    cache = pixman_glyph_cache_create ();
+    pixman_glyph_cache_set_use_atlas (cache, TRUE);
+    src = pixman_image_create_solid_fill (&color);
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < N_KEYS; ++i)
+    {
+	int w = 1 + prng_rand_n (40);
+	int h = 1 + prng_rand_n (40);
+
+	glyph_images[i] = pixman_image_create_bits (PIXMAN_a8, w, h, NULL, -1);
+	prng_randmemset (pixman_image_get_data (glyph_images[i]),
+			 pixman_image_get_stride (glyph_images[i]) * h, 0);
+
+	origins[i][0] = prng_rand_n (10);
+	origins[i][1] = prng_rand_n (10);
+
+	pixman_glyph_cache_insert (cache, NULL, (void *)(uintptr_t)(i + 1),
+				   origins[i][0], origins[i][1],
+				   glyph_images[i]);
+    }
+
+    for (i = 0; i < 500; ++i)
+    {
+	pixman_op_t op = operators[prng_rand_n (ARRAY_LENGTH (operators))];
+	int mask_x = prng_rand_n (40) - 20;
+	int mask_y = prng_rand_n (40) - 20;
+	int dest_x = prng_rand_n (40) - 20;
+	int dest_y = prng_rand_n (40) - 20;
+	int width = 1 + prng_rand_n (WIDTH);
+	int height = 1 + prng_rand_n (HEIGHT);
+	int n_glyphs = 1 + prng_rand_n (N_GLYPHS);
+	pixman_glyph_t glyphs[N_GLYPHS];
+	int keys[N_GLYPHS];
+	pixman_image_t *ref, *res, *mask;
+
+	for (j = 0; j < n_glyphs; ++j)
+	{
+	    keys[j] = prng_rand_n (N_KEYS);
+	    glyphs[j].x = prng_rand_n (WIDTH + 40) - 20;
+	    glyphs[j].y = prng_rand_n (HEIGHT + 40) - 20;
+	    glyphs[j].glyph = pixman_glyph_cache_lookup (
+		cache, NULL, (void *)(uintptr_t)(keys[j] + 1));
+	}
+
+	mask = pixman_image_create_bits (PIXMAN_a8, width, height, NULL, -1);
+
+	for (j = 0; j < n_glyphs; ++j)
+	{
+	    pixman_image_composite32 (PIXMAN_OP_ADD,
+				      glyph_images[keys[j]], NULL, mask,
+				      0, 0, 0, 0,
+				      glyphs[j].x - origins[keys[j]][0] - mask_x,
+				      glyphs[j].y - origins[keys[j]][1] - mask_y,
+				      pixman_image_get_width (glyph_images[keys[j]]),
+				      pixman_image_get_height (glyph_images[keys[j]]));
+	}
+
+	ref = create_dest ();
+	pixman_image_composite32 (op, src, mask, ref, 0, 0, 0, 0,
+				  dest_x, dest_y, width, height);
+
+	res = create_dest ();
+	pixman_composite_glyphs (op, src, res, PIXMAN_a8,
+				 0, 0, mask_x, mask_y, dest_x, dest_y,
+				 width, height, cache, n_glyphs, glyphs);
+
+	prng_srand (100 + i);
+
+	if (memcmp (pixman_image_get_data (ref), pixman_image_get_data (res),
+		    pixman_image_get_stride (ref) * HEIGHT) != 0)
+	{
+	    printf ("iteration %d: glyph mask differs\n", i);
+	    return 1;
+	}
+
+	pixman_image_unref (mask);
+	pixman_image_unref (ref);
+	pixman_image_unref (res);
+    }
+
+    pixman_glyph_cache_thaw (cache);
+    pixman_glyph_cache_destroy (cache);
+
+    for (i = 0; i < N_KEYS; ++i)
+	pixman_image_unref (glyph_images[i]);
+
+    pixman_image_unref (src);
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+/* pixman_composite_subpixel_glyphs() must pick the variant for the
+ * nearest phase, and fall back to phase 0 for variants that are not in
+ * the cache.
+ */
+
+#define WIDTH 100
+#define HEIGHT 80
+#define N_KEYS 20
+#define N_PHASES 4
+#define N_GLYPHS 50
+
+/* Only some of the variants are inserted */
+static pixman_image_t *glyph_images[N_KEYS][N_PHASES];
+static int origins[N_KEYS][N_PHASES][2];
+
+static pixman_image_t *
+create_dest (void)
+{
+    pixman_image_t *dest;
+
+    dest = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, -1);
+    memset (pixman_image_get_data (dest), 0x20,
+	    pixman_image_get_stride (dest) * HEIGHT);
+
+    return dest;
+}
+
+/* The variant and pixel position a glyph at x is expected to be drawn with */
+static int
+expected_phase (int key, int32_t x, int *ix)
+{
+    int phase = ((x & 0xff) * N_PHASES + 0x80) >> 8;
+
+    *ix = x >> 8;
+    if (phase == N_PHASES)
+    {
+	(*ix)++;
+	phase = 0;
+    }
+
+    if (!glyph_images[key][phase])
+    {
+	*ix = (x + 0x80) >> 8;
+	phase = 0;
+    }
+
+    return phase;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_color_t color = { 0x8000, 0x4000, 0xc000, 0xe000 };
+    pixman_glyph_cache_t *cache;
+    pixman_image_t *src;
+    int i, j, k;
+
+    prng_srand (0);
+
+    cache = pixman_glyph_cache_create ();
+    src = pixman_image_create_solid_fill (&color);
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < N_KEYS; ++i)
+    {
+	for (k = 0; k < N_PHASES; ++k)
+	{
+	    int w = 1 + prng_rand_n (20);
+	    int h = 1 + prng_rand_n (20);
+	    pixman_image_t *image;
+
+	    if (k != 0 && prng_rand_n (3) == 0)
+		continue;
+
+	    image = pixman_image_create_bits (PIXMAN_a8, w, h, NULL, -1);
+	    prng_randmemset (pixman_image_get_data (image),
+			     pixman_image_get_stride (image) * h, 0);
+
+	    origins[i][k][0] = prng_rand_n (5);
+	    origins[i][k][1] = prng_rand_n (5);
+
+	    glyph_images[i][k] = image;
+	    pixman_glyph_cache_insert_subpixel (
+		cache, NULL, (void *)(uintptr_t)(i + 1), k,
+		origins[i][k][0], origins[i][k][1], image);
+	}
+    }
+
+    /* Variants are separate entries */
+    for (i = 0; i < N_KEYS; ++i)
+    {
+	for (k = 0; k < N_PHASES; ++k)
+	{
+	    const void *glyph = pixman_glyph_cache_lookup_subpixel (
+		cache, NULL, (void *)(uintptr_t)(i + 1), k);
+
+	    assert ((glyph != NULL) == (glyph_images[i][k] != NULL));
+	}
+
+	assert (pixman_glyph_cache_lookup (cache, NULL, (void *)(uintptr_t)(i + 1)) ==
+		pixman_glyph_cache_lookup_subpixel (cache, NULL, (void *)(uintptr_t)(i + 1), 0));
+    }
+
+    for (i = 0; i < 200; ++i)
+    {
+	pixman_subpixel_glyph_t glyphs[N_GLYPHS + 1];
+	pixman_bool_t use_mask = prng_rand_n (2);
+	pixman_image_t *ref, *res;
+
+	for (j = 0; j < N_GLYPHS; ++j)
+	{
+	    glyphs[j].x = prng_rand_n ((WIDTH + 20) << 8) - (10 << 8);
+	    glyphs[j].y = prng_rand_n ((HEIGHT + 20) << 8) - (10 << 8);
+	    glyphs[j].font_key = NULL;
+	    glyphs[j].glyph_key = (void *)(uintptr_t)(prng_rand_n (N_KEYS) + 1);
+	}
+
+	/* A glyph that is not in the cache is skipped */
+	glyphs[N_GLYPHS].x = 0;
+	glyphs[N_GLYPHS].y = 0;
+	glyphs[N_GLYPHS].font_key = NULL;
+	glyphs[N_GLYPHS].glyph_key = (void *)(uintptr_t)(N_KEYS + 1);
+
+	ref = create_dest ();
+
+	for (j = 0; j < N_GLYPHS; ++j)
+	{
+	    int key = (uintptr_t)glyphs[j].glyph_key - 1;
+	    int x, y = (glyphs[j].y + 0x80) >> 8;
+	    int phase = expected_phase (key, glyphs[j].x, &x);
+	    pixman_image_t *image = glyph_images[key][phase];
+
+	    pixman_image_composite32 (PIXMAN_OP_OVER, src, image, ref,
+				      0, 0, 0, 0,
+				      x - origins[key][phase][0],
+				      y - origins[key][phase][1],
+				      pixman_image_get_width (image),
+				      pixman_image_get_height (image));
+	}
+
+	res = create_dest ();
+
+	if (use_mask)
+	{
+	    /* Overlapping glyphs are added together in the mask, so the
+	     * reference is pixman_composite_glyphs() with the expected
+	     * variants.
+	     */
+	    pixman_glyph_t resolved[N_GLYPHS];
+
+	    for (j = 0; j < N_GLYPHS; ++j)
+	    {
+		int key = (uintptr_t)glyphs[j].glyph_key - 1;
+		int phase = expected_phase (key, glyphs[j].x, &resolved[j].x);
+
+		resolved[j].y = (glyphs[j].y + 0x80) >> 8;
+		resolved[j].glyph = pixman_glyph_cache_lookup_subpixel (
+		    cache, NULL, glyphs[j].glyph_key, phase);
+	    }
+
+	    pixman_image_unref (ref);
+	    ref = create_dest ();
+	    pixman_composite_glyphs (PIXMAN_OP_OVER, src, ref, PIXMAN_a8,
+				     0, 0, 0, 0, 0, 0, WIDTH, HEIGHT,
+				     cache, N_GLYPHS, resolved);
+
+	    pixman_composite_subpixel_glyphs (PIXMAN_OP_OVER, src, res, PIXMAN_a8,
+					      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT,
+					      cache, N_PHASES, N_GLYPHS + 1, glyphs);
+	}
+	else
+	{
+	    pixman_composite_subpixel_glyphs_no_mask (PIXMAN_OP_OVER, src, res,
+						      0, 0, 0, 0,
+						      cache, N_PHASES, N_GLYPHS + 1, glyphs);
+	}
+
+	if (memcmp (pixman_image_get_data (ref), pixman_image_get_data (res),
+		    pixman_image_get_stride (ref) * HEIGHT) != 0)
+	{
+	    printf ("iteration %d: subpixel glyphs differ (%s)\n", i,
+		    use_mask ? "with mask" : "without mask");
+	    return 1;
+	}
+
+	pixman_image_unref (ref);
+	pixman_image_unref (res);
+    }
+
+    pixman_glyph_cache_thaw (cache);
+    pixman_glyph_cache_destroy (cache);
+
+    for (i = 0; i < N_KEYS; ++i)
+    {
+	for (k = 0; k < N_PHASES; ++k)
+	{
+	    if (glyph_images[i][k])
+		pixman_image_unref (glyph_images[i][k]);
+	}
+    }
+
+    pixman_image_unref (src);
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+/* rgba_half images must convert every half exactly to and from single
+ * precision floats, and compositing them must round like the float
+ * combiners followed by a conversion to half.
+ */
+
+static float
+half_to_float (uint16_t h)
+{
+    int exponent = (h >> 10) & 0x1f;
+    int mantissa = h & 0x3ff;
+    float f;
+
+    if (exponent == 0x1f)
+	f = mantissa ? NAN : INFINITY;
+    else if (exponent == 0)
+	f = ldexp (mantissa, -24);
+    else
+	f = ldexp (mantissa + 1024, exponent - 25);
+
+    return (h & 0x8000) ? -f : f;
+}
+
+static uint16_t
+float_to_half (float f)
+{
+    uint16_t sign = signbit (f) ? 0x8000 : 0;
+    double q;
+    int e;
+
+    f = fabsf (f);
+
+    if (isnan (f))
+	return sign | 0x7e00;
+
+    if (f >= 65520.0f)
+	return sign | 0x7c00;
+
+    if (f == 0)
+	return sign;
+
+    /* Round to a multiple of the spacing of halfs around f */
+    frexp (f, &e);
+    e = e - 11 < -24 ? -24 : e - 11;
+    q = nearbyint (ldexp (f, -e));
+
+    if (e == -24)
+	return sign | (uint16_t)q;
+
+    if (q == 2048)
+    {
+	q = 1024;
+	e++;
+    }
+
+    return sign | ((e + 25) << 10) | ((uint16_t)q - 1024);
+}
+
+static pixman_bool_t
+same_float (float a, float b)
+{
+    return (isnan (a) && isnan (b)) || (a == b && signbit (a) == signbit (b));
+}
+
+static pixman_bool_t
+same_half (uint16_t a, uint16_t b)
+{
+    /* Any NaN will do */
+    if ((a & 0x7c00) == 0x7c00 && (a & 0x3ff) &&
+	(b & 0x7c00) == 0x7c00 && (b & 0x3ff))
+    {
+	return TRUE;
+    }
+
+    return a == b;
+}
+
+/* What the float SRC combiner does to a source value */
+static float
+clamp_src (float f)
+{
+    return 1.0f < f ? 1.0f : f + 0.0f;
+}
+
+/* The float SRC combiner multiplies the destination with zero, so it
+ * must not have NaNs or infinities in it.
+ */
+static void
+src_cleared (pixman_image_t *src, pixman_image_t *dest,
+	     int src_x, int width, int height)
+{
+    memset (pixman_image_get_data (dest), 0,
+	    pixman_image_get_stride (dest) * pixman_image_get_height (dest));
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      src_x, 0, 0, 0, 0, 0, width, height);
+}
+
+/* Every half value through an rgba_float image and back, with the
+ * rgba_half source both inside and straddling the composite, and scaled
+ * up so that it is fetched a pixel at a time.
+ */
+static pixman_bool_t
+check_all_halfs (void)
+{
+    uint16_t *halfs = aligned_malloc (16, 65536 * 2);
+    pixman_image_t *half, *back, *floats;
+    pixman_transform_t transform;
+    pixman_bool_t ok = TRUE;
+    int i, j, offset;
+    float *f;
+    uint16_t *h;
+
+    for (i = 0; i < 65536; ++i)
+	halfs[i] = i;
+
+    half = pixman_image_create_bits (
+	PIXMAN_rgba_half, 128, 128, (uint32_t *)halfs, 128 * 8);
+    floats = pixman_image_create_bits (PIXMAN_rgba_float, 256, 256, NULL, -1);
+    back = pixman_image_create_bits (PIXMAN_rgba_half, 128, 128, NULL, -1);
+    f = (float *)pixman_image_get_data (floats);
+
+    for (offset = 1; offset >= 0; --offset)
+    {
+	src_cleared (half, floats, -offset, 128 + offset, 128);
+
+	for (i = 0; i < 65536 && ok; ++i)
+	{
+	    float expected = clamp_src (half_to_float (i));
+	    float got = f[(i / 512) * 1024 + (i % 512) + 4 * offset];
+
+	    if (!same_float (got, expected))
+	    {
+		printf ("half %04x fetched as %g, expected %g (offset %d)\n",
+			i, got, expected, offset);
+		ok = FALSE;
+	    }
+	}
+    }
+
+    src_cleared (floats, back, 0, 128, 128);
+    h = (uint16_t *)pixman_image_get_data (back);
+
+    for (i = 0; i < 65536 && ok; ++i)
+    {
+	uint16_t expected = float_to_half (clamp_src (half_to_float (i)));
+
+	if (!same_half (h[i], expected))
+	{
+	    printf ("half %04x stored as %04x, expected %04x\n", i, h[i], expected);
+	    ok = FALSE;
+	}
+    }
+
+    pixman_transform_init_scale (&transform, pixman_double_to_fixed (0.5),
+				 pixman_double_to_fixed (0.5));
+    pixman_image_set_transform (half, &transform);
+    src_cleared (half, floats, 0, 256, 256);
+
+    for (i = 0; i < 256 && ok; ++i)
+    {
+	for (j = 0; j < 256 * 4; ++j)
+	{
+	    int k = (i / 2) * 512 + (j / 8) * 4 + j % 4;
+	    float expected = clamp_src (half_to_float (k));
+
+	    if (!same_float (f[i * 1024 + j], expected))
+	    {
+		printf ("scaled half %04x fetched as %g\n", k, f[i * 1024 + j]);
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    pixman_image_unref (half);
+    pixman_image_unref (floats);
+    pixman_image_unref (back);
+    free (halfs);
+
+    return ok;
+}
+
+static uint16_t
+random_half (void)
+{
+    /* Mostly in [0, 1], some larger or negative ones */
+    if (prng_rand_n (8) == 0)
+	return float_to_half ((prng_rand_n (2001) - 1000) / 100.0f);
+    else
+	return float_to_half (prng_rand_n (100001) / 100000.0f);
+}
+
+static pixman_image_t *
+make_random_image (int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (PIXMAN_rgba_half, width, height, NULL, -1);
+    uint16_t *h = (uint16_t *)pixman_image_get_data (image);
+    int i;
+
+    for (i = 0; i < width * height * 4; ++i)
+	h[i] = random_half ();
+
+    return image;
+}
+
+/* OVER, and SRC between rgba_half images, compared with the float
+ * combiners. The composite either is inside the source, or starts one
+ * pixel to the left of it.
+ */
+static pixman_bool_t
+check_composite (int iter)
+{
+    int width = 1 + prng_rand_n (40), height = 1 + prng_rand_n (10);
+    pixman_op_t op = prng_rand_n (2) ? PIXMAN_OP_OVER : PIXMAN_OP_SRC;
+    int offset = op == PIXMAN_OP_OVER ? prng_rand_n (2) : 0;
+    pixman_image_t *src = make_random_image (width, height);
+    pixman_image_t *dest = make_random_image (width + offset, height);
+    uint16_t *s = (uint16_t *)pixman_image_get_data (src);
+    uint16_t *d = (uint16_t *)pixman_image_get_data (dest);
+    uint16_t *expected = malloc (width * height * 8);
+    int x, y, c;
+    pixman_bool_t ok = TRUE;
+
+    for (y = 0; y < height; ++y)
+    {
+	for (x = 0; x < width; ++x)
+	{
+	    uint16_t *sp = s + (y * width + x) * 4;
+	    uint16_t *dp = d + (y * (width + offset) + x + offset) * 4;
+	    float sa = half_to_float (sp[3]);
+
+	    for (c = 0; c < 4; ++c)
+	    {
+		float r = half_to_float (sp[c]);
+
+		if (op == PIXMAN_OP_OVER)
+		{
+		    r = r + half_to_float (dp[c]) * (1.0f - sa);
+		    r = 1.0f < r ? 1.0f : r;
+		}
+
+		expected[(y * width + x) * 4 + c] =
+		    op == PIXMAN_OP_OVER ? float_to_half (r) : sp[c];
+	    }
+	}
+    }
+
+    pixman_image_composite32 (op, src, NULL, dest, -offset, 0, 0, 0, 0, 0,
+			      width + offset, height);
+
+    for (y = 0; y < height && ok; ++y)
+    {
+	for (x = 0; x < width && ok; ++x)
+	{
+	    for (c = 0; c < 4; ++c)
+	    {
+		uint16_t got = d[(y * (width + offset) + x + offset) * 4 + c];
+		uint16_t e = expected[(y * width + x) * 4 + c];
+
+		if (!same_half (got, e))
+		{
+		    printf ("iteration %d: %s pixel %d %d channel %d is %04x, expected %04x\n",
+			    iter, operator_name (op), x, y, c, got, e);
+		    ok = FALSE;
+		    break;
+		}
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    free (expected);
+
+    return ok;
+}
+
+/* 8 bit channels survive a trip through rgba_half, give or take the
+ * truncation when converting back to 8 bits.
+ */
+static pixman_bool_t
+check_8888_round_trip (void)
+{
+    pixman_image_t *src, *half, *dest;
+    uint32_t *s, *d;
+    pixman_bool_t ok = TRUE;
+    int i, shift;
+
+    src = pixman_image_create_bits (PIXMAN_a8r8g8b8, 256, 16, NULL, -1);
+    half = pixman_image_create_bits (PIXMAN_rgba_half, 256, 16, NULL, -1);
+    dest = pixman_image_create_bits (PIXMAN_a8r8g8b8, 256, 16, NULL, -1);
+
+    prng_randmemset (pixman_image_get_data (src), 256 * 16 * 4, 0);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, half,
+			      0, 0, 0, 0, 0, 0, 256, 16);
+    pixman_image_composite32 (PIXMAN_OP_SRC, half, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 256, 16);
+
+    s = pixman_image_get_data (src);
+    d = pixman_image_get_data (dest);
+
+    for (i = 0; i < 256 * 16 && ok; ++i)
+    {
+	for (shift = 0; shift < 32; shift += 8)
+	{
+	    int diff = (int)((s[i] >> shift) & 0xff) - (int)((d[i] >> shift) & 0xff);
+
+	    if (diff < -1 || diff > 1)
+	    {
+		printf ("a8r8g8b8 pixel %08x became %08x going through rgba_half\n",
+			s[i], d[i]);
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (half);
+    pixman_image_unref (dest);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    assert (PIXMAN_FORMAT_BPP (PIXMAN_rgba_half) == 64);
+
+    if (!check_all_halfs () || !check_8888_round_trip ())
+	return 1;
+
+    for (i = 0; i < 3000; ++i)
+    {
+	if (!check_composite (i))
+	    return 1;
+    }
+
+    return 0;
+}
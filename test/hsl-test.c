@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include "utils.h"
+#include "pixman-private.h"
+
+/* The HSL blend modes must give exactly the results of the scalar float
+ * code in pixman-combine-float.c, both through the float combiners and
+ * when compositing 8888 images.
+ */
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_HSL_HUE,
+    PIXMAN_OP_HSL_SATURATION,
+    PIXMAN_OP_HSL_COLOR,
+    PIXMAN_OP_HSL_LUMINOSITY,
+};
+
+typedef struct
+{
+    float r, g, b;
+} rgb_t;
+
+static float
+minf (float a, float b)
+{
+    return a < b? a : b;
+}
+
+static float
+maxf (float a, float b)
+{
+    return a > b? a : b;
+}
+
+static float
+get_lum (const rgb_t *c)
+{
+    return c->r * 0.3f + c->g * 0.59f + c->b * 0.11f;
+}
+
+static float
+get_sat (const rgb_t *c)
+{
+    return maxf (maxf (c->r, c->g), c->b) - minf (minf (c->r, c->g), c->b);
+}
+
+static void
+clip_color (rgb_t *c, float a)
+{
+    float l = get_lum (c);
+    float n = minf (minf (c->r, c->g), c->b);
+    float x = maxf (maxf (c->r, c->g), c->b);
+    float t;
+
+    if (n < 0.0f)
+    {
+	t = l - n;
+	if (FLOAT_IS_ZERO (t))
+	{
+	    c->r = c->g = c->b = 0.0f;
+	}
+	else
+	{
+	    c->r = l + (((c->r - l) * l) / t);
+	    c->g = l + (((c->g - l) * l) / t);
+	    c->b = l + (((c->b - l) * l) / t);
+	}
+    }
+    if (x > a)
+    {
+	t = x - l;
+	if (FLOAT_IS_ZERO (t))
+	{
+	    c->r = c->g = c->b = a;
+	}
+	else
+	{
+	    c->r = l + (((c->r - l) * (a - l) / t));
+	    c->g = l + (((c->g - l) * (a - l) / t));
+	    c->b = l + (((c->b - l) * (a - l) / t));
+	}
+    }
+}
+
+static void
+set_lum (rgb_t *c, float sa, float l)
+{
+    float d = l - get_lum (c);
+
+    c->r += d;
+    c->g += d;
+    c->b += d;
+
+    clip_color (c, sa);
+}
+
+static void
+set_sat (rgb_t *c, float sat)
+{
+    float *max, *mid, *min;
+    float t;
+
+    if (c->r > c->g)
+    {
+	if (c->r > c->b)
+	{
+	    max = &c->r;
+	    mid = c->g > c->b ? &c->g : &c->b;
+	    min = c->g > c->b ? &c->b : &c->g;
+	}
+	else
+	{
+	    max = &c->b;
+	    mid = &c->r;
+	    min = &c->g;
+	}
+    }
+    else
+    {
+	if (c->r > c->b)
+	{
+	    max = &c->g;
+	    mid = &c->r;
+	    min = &c->b;
+	}
+	else
+	{
+	    min = &c->r;
+	    max = c->g > c->b ? &c->g : &c->b;
+	    mid = c->g > c->b ? &c->b : &c->g;
+	}
+    }
+
+    t = *max - *min;
+
+    if (FLOAT_IS_ZERO (t))
+    {
+	*mid = *max = 0.0f;
+    }
+    else
+    {
+	*mid = ((*mid - *min) * sat) / t;
+	*max = sat;
+    }
+
+    *min = 0.0f;
+}
+
+static void
+blend (pixman_op_t op, float *dest, const float *src, float ma)
+{
+    float sa = src[0] * ma, da = dest[0];
+    rgb_t sc = { src[1] * ma, src[2] * ma, src[3] * ma };
+    rgb_t dc = { dest[1], dest[2], dest[3] };
+    rgb_t rc;
+
+    switch (op)
+    {
+    case PIXMAN_OP_HSL_HUE:
+	rc.r = sc.r * da; rc.g = sc.g * da; rc.b = sc.b * da;
+	set_sat (&rc, get_sat (&dc) * sa);
+	set_lum (&rc, sa * da, get_lum (&dc) * sa);
+	break;
+
+    case PIXMAN_OP_HSL_SATURATION:
+	rc.r = dc.r * sa; rc.g = dc.g * sa; rc.b = dc.b * sa;
+	set_sat (&rc, get_sat (&sc) * da);
+	set_lum (&rc, sa * da, get_lum (&dc) * sa);
+	break;
+
+    case PIXMAN_OP_HSL_COLOR:
+	rc.r = sc.r * da; rc.g = sc.g * da; rc.b = sc.b * da;
+	set_lum (&rc, sa * da, get_lum (&dc) * sa);
+	break;
+
+    default:
+	rc.r = dc.r * sa; rc.g = dc.g * sa; rc.b = dc.b * sa;
+	set_lum (&rc, sa * da, get_lum (&sc) * da);
+	break;
+    }
+
+    dest[0] = sa + da - sa * da;
+    dest[1] = (1 - sa) * dc.r + (1 - da) * sc.r + rc.r;
+    dest[2] = (1 - sa) * dc.g + (1 - da) * sc.g + rc.g;
+    dest[3] = (1 - sa) * dc.b + (1 - da) * sc.b + rc.b;
+}
+
+/* Random premultiplied colors, with many ties between the channels */
+static void
+random_color (float *p)
+{
+    float a = prng_rand_n (4) ? prng_rand_n (256) / 255.f : 1.f;
+    int i;
+
+    p[0] = a;
+    for (i = 1; i < 4; ++i)
+    {
+	if (i > 1 && prng_rand_n (3) == 0)
+	    p[i] = p[i - 1];
+	else
+	    p[i] = prng_rand_n (256) / 255.f * a;
+    }
+}
+
+static pixman_combine_float_func_t
+lookup_combiner (pixman_implementation_t *imp, pixman_op_t op)
+{
+    pixman_combine_float_func_t f;
+
+    do
+    {
+	f = imp->combine_float[op];
+	imp = imp->fallback;
+    }
+    while (!f);
+
+    return f;
+}
+
+#define WIDTH 67
+
+static pixman_bool_t
+check_combiner (pixman_implementation_t *imp, pixman_op_t op, int iter)
+{
+    pixman_combine_float_func_t combine = lookup_combiner (imp, op);
+    float src[WIDTH * 4], mask[WIDTH * 4], dest[WIDTH * 4];
+    float expected[WIDTH * 4];
+    pixman_bool_t has_mask = prng_rand_n (2);
+    int width = 1 + prng_rand_n (WIDTH);
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	random_color (src + 4 * i);
+	random_color (dest + 4 * i);
+	mask[4 * i] = prng_rand_n (256) / 255.f;
+	mask[4 * i + 1] = mask[4 * i + 2] = mask[4 * i + 3] = 0.f;
+
+	memcpy (expected + 4 * i, dest + 4 * i, 4 * sizeof (float));
+	blend (op, expected + 4 * i, src + 4 * i,
+	       has_mask ? mask[4 * i] : 1.f);
+    }
+
+    combine (imp, op, dest, src, has_mask ? mask : NULL, width);
+
+    for (i = 0; i < width * 4; ++i)
+    {
+	if (memcmp (&dest[i], &expected[i], sizeof (float)) != 0)
+	{
+	    printf ("iteration %d: %s combiner, pixel %d channel %d "
+		    "is %.9g instead of %.9g\n", iter, operator_name (op),
+		    i / 4, i % 4, dest[i], expected[i]);
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8, PIXMAN_a8b8g8r8, PIXMAN_x8b8g8r8,
+};
+
+/* The same conversions as pixman-utils.c */
+static uint32_t
+float_to_unorm8 (float f)
+{
+    uint32_t u;
+
+    if (f > 1.0)
+	f = 1.0;
+    if (f < 0.0)
+	f = 0.0;
+
+    u = f * (1 << 8);
+    u -= (u >> 8);
+
+    return u;
+}
+
+static float
+unorm8_to_float (uint32_t u)
+{
+    return (u & 0xff) * (1.f / 255.f);
+}
+
+static uint32_t
+to_8888 (pixman_format_code_t format, const float *p)
+{
+    int r_shift = PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR ? 0 : 16;
+
+    return (float_to_unorm8 (p[0]) << 24)		|
+	   (float_to_unorm8 (p[1]) << r_shift)		|
+	   (float_to_unorm8 (p[2]) << 8)		|
+	   (float_to_unorm8 (p[3]) << (16 - r_shift));
+}
+
+static void
+from_8888 (pixman_format_code_t format, uint32_t u, float *p)
+{
+    int r_shift = PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR ? 0 : 16;
+
+    if (!PIXMAN_FORMAT_A (format))
+	u |= 0xff000000;
+
+    p[0] = unorm8_to_float (u >> 24);
+    p[1] = unorm8_to_float (u >> r_shift);
+    p[2] = unorm8_to_float (u >> 8);
+    p[3] = unorm8_to_float (u >> (16 - r_shift));
+}
+
+static pixman_bool_t
+check_composite (pixman_op_t op, int iter)
+{
+    int bgr = prng_rand_n (2) * 2;
+    pixman_format_code_t src_format = formats[bgr + prng_rand_n (2)];
+    pixman_format_code_t dest_format = formats[bgr + prng_rand_n (2)];
+    int width = 1 + prng_rand_n (WIDTH), height = 1 + prng_rand_n (3);
+    int mask_stride = (width + 3) & ~3;
+    uint32_t mask = PIXMAN_FORMAT_A (dest_format) ? 0xffffffff : 0x00ffffff;
+    pixman_image_t *src, *msk = NULL, *dest;
+    uint32_t *s, *d, *e;
+    uint8_t *m = NULL;
+    pixman_bool_t ok = TRUE;
+    int i;
+
+    s = malloc (width * height * 4);
+    d = malloc (width * height * 4);
+    e = malloc (width * height * 4);
+
+    for (i = 0; i < width * height; ++i)
+    {
+	float p[4];
+
+	random_color (p);
+	s[i] = to_8888 (src_format, p);
+	if (!PIXMAN_FORMAT_A (src_format))
+	    s[i] ^= prng_rand () & 0xff000000;
+	random_color (p);
+	d[i] = to_8888 (dest_format, p);
+    }
+
+    if (prng_rand_n (2))
+    {
+	m = malloc (mask_stride * height);
+	for (i = 0; i < mask_stride * height; ++i)
+	    m[i] = prng_rand_n (4) ? prng_rand_n (256) : 0;
+
+	msk = pixman_image_create_bits (PIXMAN_a8, width, height,
+					(uint32_t *)m, mask_stride);
+    }
+
+    for (i = 0; i < width * height; ++i)
+    {
+	float sp[4], dp[4];
+
+	from_8888 (src_format, s[i], sp);
+	from_8888 (dest_format, d[i], dp);
+	blend (op, dp, sp, m ? unorm8_to_float (
+		   m[i / width * mask_stride + i % width]) : 1.f);
+	e[i] = to_8888 (dest_format, dp);
+    }
+
+    src = pixman_image_create_bits (src_format, width, height, s, width * 4);
+    dest = pixman_image_create_bits (dest_format, width, height, d, width * 4);
+
+    pixman_image_composite32 (op, src, msk, dest, 0, 0, 0, 0, 0, 0,
+			      width, height);
+
+    for (i = 0; i < width * height; ++i)
+    {
+	if ((d[i] & mask) != (e[i] & mask))
+	{
+	    printf ("iteration %d: %s of %s onto %s%s, pixel %d is %08x "
+		    "instead of %08x\n", iter, operator_name (op),
+		    format_name (src_format), format_name (dest_format),
+		    m ? " with a8 mask" : "", i, d[i] & mask, e[i] & mask);
+	    ok = FALSE;
+	    break;
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    if (msk)
+	pixman_image_unref (msk);
+    free (s);
+    free (d);
+    free (e);
+    free (m);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_implementation_t *imp = _pixman_internal_only_get_implementation ();
+    int i;
+
+    enable_divbyzero_exceptions ();
+
+    prng_srand (0);
+
+    for (i = 0; i < 4000; ++i)
+    {
+	pixman_op_t op = ops[i % ARRAY_LENGTH (ops)];
+
+	if (!check_combiner (imp, op, i) || !check_composite (op, i))
+	    return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+/* yv12, i420 and nv12 images must convert like a floating point
+ * reference in all color spaces, give the same result whether or not
+ * the whole composite is inside the image, and scale like the converted
+ * image does.
+ */
+
+typedef struct
+{
+    pixman_format_code_t format;
+    pixman_yuv_color_space_t color_space;
+    int width, height, stride;
+    uint8_t *data;
+    pixman_image_t *image;
+} yuv_image_t;
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_yv12, PIXMAN_i420, PIXMAN_nv12,
+};
+
+static void
+get_yuv (const yuv_image_t *img, int x, int y, int *yy, int *u, int *v)
+{
+    const uint8_t *chroma = img->data + img->stride * img->height;
+    int cx = x >> 1, cy = y >> 1;
+    int cstride = img->stride / 2;
+
+    *yy = img->data[y * img->stride + x];
+
+    if (img->format == PIXMAN_nv12)
+    {
+	*u = chroma[cy * img->stride + 2 * cx];
+	*v = chroma[cy * img->stride + 2 * cx + 1];
+    }
+    else
+    {
+	/* The second chroma plane starts a quarter of the luma plane in */
+	const uint8_t *first = chroma + cy * cstride + cx;
+	const uint8_t *second = first + img->stride * img->height / 4;
+
+	*u = img->format == PIXMAN_i420 ? *first : *second;
+	*v = img->format == PIXMAN_i420 ? *second : *first;
+    }
+}
+
+static uint32_t
+reference_pixel (const yuv_image_t *img, int x, int y, int channel_shift)
+{
+    static const double kr[] = { 0.299, 0.299, 0.2126, 0.2126 };
+    static const double kb[] = { 0.114, 0.114, 0.0722, 0.0722 };
+    int limited = img->color_space == PIXMAN_YUV_BT601_LIMITED ||
+	img->color_space == PIXMAN_YUV_BT709_LIMITED;
+    double r = kr[img->color_space], b = kb[img->color_space], g = 1 - r - b;
+    double ys = limited ? 255.0 / 219 : 1, cs = limited ? 255.0 / 224 : 1;
+    double fy, fu, fv, c;
+    int yy, u, v;
+
+    get_yuv (img, x, y, &yy, &u, &v);
+
+    fy = (yy - (limited ? 16 : 0)) * ys;
+    fu = (u - 128) * cs;
+    fv = (v - 128) * cs;
+
+    switch (channel_shift)
+    {
+    case 16:
+	c = fy + 2 * (1 - r) * fv;
+	break;
+    case 8:
+	c = fy - 2 * b * (1 - b) / g * fu - 2 * r * (1 - r) / g * fv;
+	break;
+    default:
+	c = fy + 2 * (1 - b) * fu;
+	break;
+    }
+
+    return c < 0 ? 0 : c > 255 ? 255 : (uint32_t)c;
+}
+
+static void
+make_yuv_image (yuv_image_t *img)
+{
+    img->format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+    img->color_space = prng_rand_n (4);
+    img->width = 2 + prng_rand_n (100);
+    img->height = 2 + 2 * prng_rand_n (20);
+    img->stride = ((img->width + 7) & ~7) + 8 * prng_rand_n (3);
+    img->data = aligned_malloc (16, img->stride * (img->height + img->height / 2 + 2));
+
+    prng_randmemset (img->data, img->stride * (img->height + img->height / 2 + 2), 0);
+
+    img->image = pixman_image_create_bits (img->format, img->width, img->height,
+					   (uint32_t *)img->data, img->stride);
+    pixman_image_set_yuv_color_space (img->image, img->color_space);
+}
+
+static void
+free_yuv_image (yuv_image_t *img)
+{
+    pixman_image_unref (img->image);
+    free (img->data);
+}
+
+/* Pixel x of the image ends up at x + x_offset in the result. With an
+ * offset, the composite starts outside the image, which takes the general
+ * path instead of the SIMD one.
+ */
+static pixman_image_t *
+convert (yuv_image_t *img, int x_offset)
+{
+    pixman_image_t *dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, img->width + x_offset, img->height, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, img->image, NULL, dest,
+			      -x_offset, 0, 0, 0, 0, 0,
+			      img->width + x_offset, img->height);
+    return dest;
+}
+
+static pixman_bool_t
+check_conversion (yuv_image_t *img, int i)
+{
+    pixman_image_t *fast = convert (img, 0);
+    pixman_image_t *general = convert (img, 3);
+    uint32_t *f = pixman_image_get_data (fast);
+    uint32_t *g = pixman_image_get_data (general);
+    int x, y, shift;
+
+    for (y = 0; y < img->height; ++y)
+    {
+	for (x = 0; x < img->width; ++x)
+	{
+	    uint32_t p = f[y * img->width + x];
+	    uint32_t q = g[y * (img->width + 3) + x + 3];
+
+	    if (p != q)
+	    {
+		printf ("iteration %d: %s pixel %d %d is %08x with SIMD, %08x without\n",
+			i, format_name (img->format), x, y, p, q);
+		return FALSE;
+	    }
+
+	    for (shift = 0; shift <= 16; shift += 8)
+	    {
+		int diff = (int)((p >> shift) & 0xff) - (int)reference_pixel (img, x, y, shift);
+
+		if ((p >> 24) != 0xff || diff < -3 || diff > 3)
+		{
+		    printf ("iteration %d: %s color space %d pixel %d %d is %08x\n",
+			    i, format_name (img->format), img->color_space, x, y, p);
+		    return FALSE;
+		}
+	    }
+	}
+    }
+
+    pixman_image_unref (fast);
+    pixman_image_unref (general);
+
+    return TRUE;
+}
+
+static pixman_bool_t
+check_scaling (yuv_image_t *img, int i)
+{
+    pixman_image_t *rgb = convert (img, 0);
+    pixman_format_code_t dest_format = prng_rand_n (2) ? PIXMAN_a8r8g8b8 : PIXMAN_x8r8g8b8;
+    pixman_op_t op = prng_rand_n (2) ? PIXMAN_OP_SRC : PIXMAN_OP_OVER;
+    pixman_image_t *d1, *d2;
+    pixman_transform_t transform;
+    pixman_fixed_t sx = pixman_double_to_fixed (0.4 + prng_rand_n (300) / 100.0);
+    pixman_fixed_t sy = pixman_double_to_fixed (0.4 + prng_rand_n (300) / 100.0);
+    int w = 1 + prng_rand_n (120), h = 1 + prng_rand_n (60);
+    int src_x = prng_rand_n (3), src_y = prng_rand_n (3);
+    pixman_bool_t ok;
+
+    /* Sample only inside the image half of the time */
+    if (prng_rand_n (2))
+    {
+	src_x = src_y = 1;
+	w = MAX (1, (img->width - 1.5) / pixman_fixed_to_double (sx) - 1);
+	h = MAX (1, (img->height - 1.5) / pixman_fixed_to_double (sy) - 1);
+    }
+
+    pixman_transform_init_scale (&transform, sx, sy);
+    pixman_image_set_transform (img->image, &transform);
+    pixman_image_set_transform (rgb, &transform);
+    pixman_image_set_filter (img->image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    pixman_image_set_filter (rgb, PIXMAN_FILTER_BILINEAR, NULL, 0);
+
+    d1 = pixman_image_create_bits (dest_format, w, h, NULL, -1);
+    d2 = pixman_image_create_bits (dest_format, w, h, NULL, -1);
+
+    pixman_image_composite32 (op, img->image, NULL, d1,
+			      src_x, src_y, 0, 0, 0, 0, w, h);
+    pixman_image_composite32 (op, rgb, NULL, d2,
+			      src_x, src_y, 0, 0, 0, 0, w, h);
+
+    ok = memcmp (pixman_image_get_data (d1), pixman_image_get_data (d2),
+		 w * h * 4) == 0;
+    if (!ok)
+	printf ("iteration %d: scaled %s image differs\n", i, format_name (img->format));
+
+    pixman_image_set_transform (img->image, NULL);
+    pixman_image_set_filter (img->image, PIXMAN_FILTER_NEAREST, NULL, 0);
+
+    pixman_image_unref (rgb);
+    pixman_image_unref (d1);
+    pixman_image_unref (d2);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    for (i = 0; i < 2000; ++i)
+    {
+	yuv_image_t img;
+
+	make_yuv_image (&img);
+
+	if (!check_conversion (&img, i) || !check_scaling (&img, i))
+	    return 1;
+
+	free_yuv_image (&img);
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define WIDTH  100
+#define HEIGHT 100
+
+static pixman_format_code_t mask_formats[] =
+{
+    PIXMAN_a1, PIXMAN_a4, PIXMAN_a8,
+};
+
+static pixman_fixed_t
+random_coord (int size)
+{
+    return (pixman_fixed_t) prng_rand_n ((size + 40) << 16) - (20 << 16);
+}
+
+static void
+set_line (pixman_line_fixed_t *line,
+	  pixman_fixed_t x1, pixman_fixed_t y1,
+	  pixman_fixed_t x2, pixman_fixed_t y2)
+{
+    line->p1.x = x1;
+    line->p1.y = y1;
+    line->p2.x = x2;
+    line->p2.y = y2;
+}
+
+static void
+add_rectangle (pixman_line_fixed_t *lines,
+	       double x1, double y1, double x2, double y2,
+	       pixman_bool_t clockwise)
+{
+    pixman_fixed_t l = pixman_double_to_fixed (x1);
+    pixman_fixed_t t = pixman_double_to_fixed (y1);
+    pixman_fixed_t r = pixman_double_to_fixed (x2);
+    pixman_fixed_t b = pixman_double_to_fixed (y2);
+
+    if (clockwise)
+    {
+	set_line (&lines[0], r, t, r, b);
+	set_line (&lines[1], l, b, l, t);
+    }
+    else
+    {
+	set_line (&lines[0], r, b, r, t);
+	set_line (&lines[1], l, t, l, b);
+    }
+}
+
+static pixman_image_t *
+create_mask (pixman_format_code_t format)
+{
+    return pixman_image_create_bits (format, WIDTH, HEIGHT, NULL, -1);
+}
+
+static pixman_bool_t
+images_equal (pixman_image_t *a, pixman_image_t *b)
+{
+    int stride = pixman_image_get_stride (a);
+    int bytes = PIXMAN_FORMAT_BPP (pixman_image_get_format (a)) * WIDTH / 8;
+    uint8_t *pa = (uint8_t *)pixman_image_get_data (a);
+    uint8_t *pb = (uint8_t *)pixman_image_get_data (b);
+    int y;
+
+    for (y = 0; y < HEIGHT; ++y)
+    {
+	if (memcmp (pa + y * stride, pb + y * stride, bytes) != 0)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* A single triangle must rasterize exactly like
+ * pixman_composite_triangles(), whatever the fill rule.
+ */
+static void
+test_triangles (void)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_color_t color = { 0x7777, 0x6666, 0x5555, 0x9999 };
+    pixman_image_t *white_img = pixman_image_create_solid_fill (&white);
+    pixman_image_t *color_img = pixman_image_create_solid_fill (&color);
+    int i;
+
+    for (i = 0; i < 2000; ++i)
+    {
+	pixman_format_code_t format =
+	    mask_formats[prng_rand_n (ARRAY_LENGTH (mask_formats))];
+	pixman_fill_rule_t fill_rule =
+	    prng_rand_n (2) ? PIXMAN_FILL_RULE_EVEN_ODD : PIXMAN_FILL_RULE_NONZERO;
+	pixman_triangle_t tri;
+	pixman_line_fixed_t lines[3];
+	pixman_image_t *ref, *res;
+	int x_dst, y_dst;
+
+	tri.p1.x = random_coord (WIDTH);
+	tri.p1.y = random_coord (HEIGHT);
+	tri.p2.x = random_coord (WIDTH);
+	tri.p2.y = random_coord (HEIGHT);
+	tri.p3.x = random_coord (WIDTH);
+	tri.p3.y = random_coord (HEIGHT);
+
+	set_line (&lines[0], tri.p1.x, tri.p1.y, tri.p2.x, tri.p2.y);
+	set_line (&lines[1], tri.p2.x, tri.p2.y, tri.p3.x, tri.p3.y);
+	set_line (&lines[2], tri.p3.x, tri.p3.y, tri.p1.x, tri.p1.y);
+
+	x_dst = prng_rand_n (20) - 10;
+	y_dst = prng_rand_n (20) - 10;
+
+	ref = create_mask (format);
+	res = create_mask (format);
+
+	pixman_composite_triangles (PIXMAN_OP_ADD, white_img, ref, format,
+				    0, 0, x_dst, y_dst, 1, &tri);
+	pixman_composite_polygon (PIXMAN_OP_ADD, white_img, res, format,
+				  0, 0, x_dst, y_dst, 3, lines, fill_rule);
+
+	if (!images_equal (ref, res))
+	{
+	    printf ("triangle %d differs (format %s)\n", i, format_name (format));
+	    exit (1);
+	}
+
+	pixman_image_unref (ref);
+	pixman_image_unref (res);
+
+	/* Operators for which a zero mask has an effect, which must
+	 * composite over the same area of the destination.
+	 */
+	ref = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, -1);
+	res = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, -1);
+
+	pixman_composite_triangles (PIXMAN_OP_SRC, color_img, ref, format,
+				    0, 0, x_dst, y_dst, 1, &tri);
+	pixman_composite_polygon (PIXMAN_OP_SRC, color_img, res, format,
+				  0, 0, x_dst, y_dst, 3, lines, fill_rule);
+
+	if (!images_equal (ref, res))
+	{
+	    printf ("triangle %d differs with PIXMAN_OP_SRC\n", i);
+	    exit (1);
+	}
+
+	pixman_image_unref (ref);
+	pixman_image_unref (res);
+    }
+
+    pixman_image_unref (white_img);
+    pixman_image_unref (color_img);
+}
+
+static void
+test_fill_rules (void)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *white_img = pixman_image_create_solid_fill (&white);
+    pixman_line_fixed_t lines[4];
+    pixman_image_t *mask;
+    uint8_t *bits;
+    int stride;
+
+    /* Two overlapping squares with the same orientation */
+    add_rectangle (lines + 0, 10, 10, 60, 60, TRUE);
+    add_rectangle (lines + 2, 40, 40, 90, 90, TRUE);
+
+    mask = create_mask (PIXMAN_a8);
+    bits = (uint8_t *)pixman_image_get_data (mask);
+    stride = pixman_image_get_stride (mask);
+
+    pixman_composite_polygon (PIXMAN_OP_ADD, white_img, mask, PIXMAN_a8,
+			      0, 0, 0, 0, 4, lines, PIXMAN_FILL_RULE_NONZERO);
+
+    assert (bits[5 * stride + 5] == 0x00);
+    assert (bits[20 * stride + 20] == 0xff);
+    assert (bits[50 * stride + 50] == 0xff);
+    assert (bits[80 * stride + 80] == 0xff);
+    assert (bits[20 * stride + 80] == 0x00);
+
+    pixman_image_unref (mask);
+
+    mask = create_mask (PIXMAN_a8);
+    bits = (uint8_t *)pixman_image_get_data (mask);
+
+    pixman_composite_polygon (PIXMAN_OP_ADD, white_img, mask, PIXMAN_a8,
+			      0, 0, 0, 0, 4, lines, PIXMAN_FILL_RULE_EVEN_ODD);
+
+    assert (bits[20 * stride + 20] == 0xff);
+    assert (bits[50 * stride + 50] == 0x00);
+    assert (bits[80 * stride + 80] == 0xff);
+
+    pixman_image_unref (mask);
+
+    /* With opposite orientations, the overlap has a winding number of 0 */
+    add_rectangle (lines + 2, 40, 40, 90, 90, FALSE);
+
+    mask = create_mask (PIXMAN_a8);
+    bits = (uint8_t *)pixman_image_get_data (mask);
+
+    pixman_composite_polygon (PIXMAN_OP_ADD, white_img, mask, PIXMAN_a8,
+			      0, 0, 0, 0, 4, lines, PIXMAN_FILL_RULE_NONZERO);
+
+    assert (bits[20 * stride + 20] == 0xff);
+    assert (bits[50 * stride + 50] == 0x00);
+    assert (bits[80 * stride + 80] == 0xff);
+
+    pixman_image_unref (mask);
+
+    /* Shared edges are not counted twice: two adjacent half pixel wide
+     * rectangles cover the pixel between them exactly once.
+     */
+    add_rectangle (lines + 0, 10, 10, 20.5, 20, TRUE);
+    add_rectangle (lines + 2, 20.5, 10, 30, 20, TRUE);
+
+    mask = create_mask (PIXMAN_a8);
+    bits = (uint8_t *)pixman_image_get_data (mask);
+
+    pixman_composite_polygon (PIXMAN_OP_ADD, white_img, mask, PIXMAN_a8,
+			      0, 0, 0, 0, 4, lines, PIXMAN_FILL_RULE_NONZERO);
+
+    assert (bits[15 * stride + 20] == 0xff);
+
+    pixman_image_unref (mask);
+    pixman_image_unref (white_img);
+}
+
+int
+main (int argc, char **argv)
+{
+    prng_srand (0);
+
+    test_triangles ();
+    test_fill_rules ();
+
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* Premultiplying must round like the combiners do, and unpremultiplying
+ * must round c * max / a to the nearest value, with ties going up. All
+ * combinations of an 8 bit channel and alpha are checked, and random
+ * 16 bit pixels.
+ */
+
+static const pixman_format_code_t formats_8888[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_a8b8g8r8, PIXMAN_b8g8r8a8, PIXMAN_r8g8b8a8,
+};
+
+static uint32_t
+premultiply_un8 (uint32_t c, uint32_t a)
+{
+    return (c * a + 127) / 255;
+}
+
+static uint32_t
+unpremultiply_un8 (uint32_t c, uint32_t a)
+{
+    uint32_t u = a ? (c * 255 + a / 2) / a : 0;
+
+    return u > 255 ? 255 : u;
+}
+
+static uint32_t
+expected_8888 (uint32_t p, int alpha_shift, pixman_bool_t unpremultiply)
+{
+    uint32_t a = (p >> alpha_shift) & 0xff;
+    uint32_t result = a << alpha_shift;
+    int shift;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+	uint32_t c = (p >> shift) & 0xff;
+
+	if (shift == alpha_shift)
+	    continue;
+
+	c = unpremultiply ? unpremultiply_un8 (c, a) : premultiply_un8 (c, a);
+	result |= c << shift;
+    }
+
+    return result;
+}
+
+static uint64_t
+expected_16161616 (uint64_t p, pixman_bool_t unpremultiply)
+{
+    uint64_t a = p >> 48;
+    uint64_t result = a << 48;
+    int shift;
+
+    for (shift = 0; shift < 48; shift += 16)
+    {
+	uint64_t c = (p >> shift) & 0xffff;
+
+	if (unpremultiply)
+	    c = a ? MIN ((c * 65535 + a / 2) / a, 65535) : 0;
+	else
+	    c = (c * a + 32767) / 65535;
+
+	result |= c << shift;
+    }
+
+    return result;
+}
+
+/* Every combination of channel and alpha, with the rows laid out so
+ * that there are partial groups of pixels at the ends.
+ */
+#define WIDTH_8888 251
+#define HEIGHT_8888 ((256 * 256 + WIDTH_8888 - 1) / WIDTH_8888)
+
+static pixman_bool_t
+check_8888 (pixman_format_code_t format, pixman_bool_t unpremultiply)
+{
+    int alpha_shift = PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB ||
+		      PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR ? 24 : 0;
+    int stride = (WIDTH_8888 + 3) * 4;
+    int n = stride / 4 * HEIGHT_8888;
+    uint32_t *src = malloc (n * 4);
+    uint32_t *dst = malloc (n * 4);
+    pixman_bool_t ok = TRUE;
+    int i;
+
+    for (i = 0; i < n; ++i)
+    {
+	uint32_t c = i & 0xff, a = (i >> 8) & 0xff;
+	uint32_t p = (c | (c << 8) | (c << 16) | (c << 24)) ^ 0x00ff00ff;
+
+	if (!alpha_shift)
+	    p <<= 8;
+
+	src[i] = (p & ~(0xffu << alpha_shift)) | (a << alpha_shift);
+    }
+
+    memset (dst, 0xcc, n * 4);
+
+    if (!(unpremultiply ?
+	  pixman_unpremultiply_pixels (format, src, stride, dst, stride,
+				       WIDTH_8888, HEIGHT_8888) :
+	  pixman_premultiply_pixels (format, src, stride, dst, stride,
+				     WIDTH_8888, HEIGHT_8888)))
+    {
+	printf ("%s is not supported\n", format_name (format));
+	return FALSE;
+    }
+
+    for (i = 0; i < n && ok; ++i)
+    {
+	uint32_t expected = expected_8888 (src[i], alpha_shift, unpremultiply);
+
+	if (i % (stride / 4) >= WIDTH_8888)
+	    expected = 0xcccccccc;
+
+	if (dst[i] != expected)
+	{
+	    printf ("%s %s of %08x is %08x instead of %08x\n",
+		    unpremultiply ? "unpremultiply" : "premultiply",
+		    format_name (format), src[i], dst[i], expected);
+	    ok = FALSE;
+	}
+    }
+
+    /* In place */
+    if (ok)
+    {
+	if (unpremultiply)
+	{
+	    pixman_unpremultiply_pixels (format, src, stride, src, stride,
+					 WIDTH_8888, HEIGHT_8888);
+	}
+	else
+	{
+	    pixman_premultiply_pixels (format, src, stride, src, stride,
+				       WIDTH_8888, HEIGHT_8888);
+	}
+
+	for (i = 0; i < n; ++i)
+	{
+	    if (i % (stride / 4) < WIDTH_8888 && src[i] != dst[i])
+	    {
+		printf ("%s %s differs in place\n",
+			unpremultiply ? "unpremultiply" : "premultiply",
+			format_name (format));
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    free (src);
+    free (dst);
+
+    return ok;
+}
+
+static pixman_bool_t
+check_16161616 (pixman_bool_t unpremultiply)
+{
+    int width = 1 + prng_rand_n (33), height = 1 + prng_rand_n (4);
+    int stride = (width + prng_rand_n (2)) * 8;
+    int n = stride / 8 * height;
+    uint64_t *src = malloc (n * 8);
+    uint64_t *dst = malloc (n * 8);
+    pixman_bool_t ok = TRUE;
+    int i;
+
+    prng_randmemset (src, n * 8, 0);
+
+    for (i = 0; i < n; ++i)
+    {
+	uint64_t a = src[i] >> 48;
+
+	/* Mostly valid premultiplied pixels, and some opaque ones */
+	if (prng_rand_n (4))
+	{
+	    uint64_t r = (src[i] & 0xffff) % (a + 1);
+	    uint64_t g = ((src[i] >> 16) & 0xffff) % (a + 1);
+	    uint64_t b = ((src[i] >> 32) & 0xffff) % (a + 1);
+
+	    src[i] = (a << 48) | (b << 32) | (g << 16) | r;
+	}
+
+	if (prng_rand_n (4) == 0)
+	    src[i] |= (uint64_t)0xffff << 48;
+    }
+
+    memcpy (dst, src, n * 8);
+
+    if (unpremultiply)
+    {
+	pixman_unpremultiply_pixels (PIXMAN_a16b16g16r16, (uint32_t *)src,
+				     stride, (uint32_t *)dst, stride,
+				     width, height);
+    }
+    else
+    {
+	pixman_premultiply_pixels (PIXMAN_a16b16g16r16, (uint32_t *)src,
+				   stride, (uint32_t *)dst, stride,
+				   width, height);
+    }
+
+    for (i = 0; i < n && ok; ++i)
+    {
+	uint64_t expected = expected_16161616 (src[i], unpremultiply);
+
+	if (i % (stride / 8) >= width)
+	    expected = src[i];
+
+	if (dst[i] != expected)
+	{
+	    printf ("%s a16b16g16r16 of %016llx is %016llx instead of %016llx\n",
+		    unpremultiply ? "unpremultiply" : "premultiply",
+		    (unsigned long long)src[i], (unsigned long long)dst[i],
+		    (unsigned long long)expected);
+	    ok = FALSE;
+	}
+    }
+
+    free (src);
+    free (dst);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t bits[2] = { 0 };
+    int i;
+
+    prng_srand (0);
+
+    if (pixman_premultiply_pixels (PIXMAN_x8r8g8b8, bits, 4, bits, 4, 1, 1) ||
+	pixman_unpremultiply_pixels (PIXMAN_r5g6b5, bits, 4, bits, 4, 1, 1))
+    {
+	printf ("unsupported formats are accepted\n");
+	return 1;
+    }
+
+    for (i = 0; i < ARRAY_LENGTH (formats_8888); ++i)
+    {
+	if (!check_8888 (formats_8888[i], FALSE) ||
+	    !check_8888 (formats_8888[i], TRUE))
+	{
+	    return 1;
+	}
+    }
+
+    for (i = 0; i < 3000; ++i)
+    {
+	if (!check_16161616 (i & 1))
+	    return 1;
+    }
+
+    return 0;
+}
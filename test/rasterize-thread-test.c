@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#ifdef HAVE_PTHREADS
+# include <pthread.h>
+#elif defined (_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#endif
+
+/* Rasterizing with several threads must give exactly the same result
+ * as rasterizing with one, and must not call accessors from any thread
+ * other than the calling one.
+ */
+
+#define WIDTH  200
+#define HEIGHT 300
+#define N_SHAPES 300
+
+static pixman_format_code_t mask_formats[] =
+{
+    PIXMAN_a1, PIXMAN_a4, PIXMAN_a8,
+};
+
+static pixman_op_t operators[] =
+{
+    PIXMAN_OP_ADD, PIXMAN_OP_OVER, PIXMAN_OP_SRC, PIXMAN_OP_IN,
+};
+
+#ifdef HAVE_PTHREADS
+static pthread_t main_thread;
+# define on_main_thread() pthread_equal (pthread_self (), main_thread)
+#elif defined (_WIN32)
+static DWORD main_thread;
+# define on_main_thread() (GetCurrentThreadId () == main_thread)
+#else
+# define on_main_thread() TRUE
+#endif
+
+static pixman_bool_t accessed_from_other_thread;
+
+static void
+check_thread (void)
+{
+    if (!on_main_thread ())
+	accessed_from_other_thread = TRUE;
+}
+
+static uint32_t
+reader (const void *src, int size)
+{
+    check_thread ();
+
+    switch (size)
+    {
+    case 1:
+	return *(uint8_t *)src;
+    case 2:
+	return *(uint16_t *)src;
+    default:
+	return *(uint32_t *)src;
+    }
+}
+
+static void
+writer (void *src, uint32_t value, int size)
+{
+    check_thread ();
+
+    switch (size)
+    {
+    case 1:
+	*(uint8_t *)src = value;
+	break;
+    case 2:
+	*(uint16_t *)src = value;
+	break;
+    default:
+	*(uint32_t *)src = value;
+	break;
+    }
+}
+
+static pixman_fixed_t
+random_coord (int size)
+{
+    return (pixman_fixed_t) prng_rand_n ((size + 40) << 16) - (20 << 16);
+}
+
+static void
+random_trapezoids (pixman_trapezoid_t *traps, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+    {
+	pixman_trapezoid_t *trap = &traps[i];
+	pixman_fixed_t h = prng_rand_n (60 << 16);
+
+	trap->top = random_coord (HEIGHT);
+	trap->bottom = trap->top + h;
+
+	trap->left.p1.x = random_coord (WIDTH);
+	trap->left.p1.y = random_coord (HEIGHT);
+	trap->left.p2.x = trap->left.p1.x - (20 << 16) + prng_rand_n (40 << 16);
+	trap->left.p2.y = trap->left.p1.y + (1 << 16) + prng_rand_n (40 << 16);
+
+	trap->right.p1.x = trap->left.p1.x + prng_rand_n (50 << 16);
+	trap->right.p1.y = trap->left.p1.y;
+	trap->right.p2.x = trap->left.p2.x + prng_rand_n (50 << 16);
+	trap->right.p2.y = trap->left.p2.y;
+    }
+}
+
+static void
+random_triangles (pixman_triangle_t *tris, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+    {
+	tris[i].p1.x = random_coord (WIDTH);
+	tris[i].p1.y = random_coord (HEIGHT);
+	tris[i].p2.x = tris[i].p1.x + prng_rand_n (80 << 16) - (40 << 16);
+	tris[i].p2.y = tris[i].p1.y + prng_rand_n (80 << 16) - (40 << 16);
+	tris[i].p3.x = tris[i].p1.x + prng_rand_n (80 << 16) - (40 << 16);
+	tris[i].p3.y = tris[i].p1.y + prng_rand_n (80 << 16) - (40 << 16);
+    }
+}
+
+/* With self_src, the destination is also the source, at an offset, so
+ * that compositing a band reads rows that other bands write.
+ */
+static pixman_image_t *
+render (int n_threads, pixman_bool_t use_tris, pixman_bool_t exact,
+	pixman_bool_t self_src, pixman_bool_t accessors, pixman_op_t op,
+	pixman_format_code_t mask_format, pixman_format_code_t dst_format,
+	int x_dst, int y_dst,
+	const pixman_trapezoid_t *traps, const pixman_triangle_t *tris)
+{
+    pixman_color_t color = { 0x7777, 0x6666, 0x5555, 0x9999 };
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src, *dst;
+    uint32_t *bits;
+    int stride, i;
+
+    /* Non-zero contents so that operators other than ADD are visible */
+    stride = WIDTH * 4;
+    bits = malloc (stride * HEIGHT);
+    memset (bits, 0x33, stride * HEIGHT);
+
+    if (self_src)
+    {
+	for (i = 0; i < WIDTH * HEIGHT; ++i)
+	    bits[i] = i * 0x9e3779b9;
+    }
+
+    dst = pixman_image_create_bits (dst_format, WIDTH, HEIGHT, bits, stride);
+    pixman_image_set_exact_coverage (dst, exact);
+    if (accessors)
+	pixman_image_set_accessors (dst, reader, writer);
+
+    if (self_src)
+	src = pixman_image_ref (dst);
+    else if (PIXMAN_FORMAT_TYPE (dst_format) == PIXMAN_TYPE_A)
+	src = pixman_image_create_solid_fill (&white);
+    else
+	src = pixman_image_create_solid_fill (&color);
+
+    pixman_set_rasterization_threads (n_threads);
+
+    if (use_tris)
+    {
+	pixman_composite_triangles (op, src, dst, mask_format,
+				    0, 7, x_dst, y_dst, N_SHAPES, tris);
+    }
+    else
+    {
+	pixman_composite_trapezoids (op, src, dst, mask_format,
+				     0, 7, x_dst, y_dst, N_SHAPES, traps);
+    }
+
+    pixman_set_rasterization_threads (1);
+
+    pixman_image_unref (src);
+
+    return dst;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_trapezoid_t traps[N_SHAPES];
+    pixman_triangle_t tris[N_SHAPES];
+    int i;
+
+#ifdef HAVE_PTHREADS
+    main_thread = pthread_self ();
+#elif defined (_WIN32)
+    main_thread = GetCurrentThreadId ();
+#endif
+
+    prng_srand (0);
+
+    for (i = 0; i < 200; ++i)
+    {
+	pixman_bool_t use_tris = i & 1;
+	pixman_bool_t exact = prng_rand_n (4) == 0;
+	pixman_bool_t self_src = FALSE;
+	pixman_bool_t accessors = prng_rand_n (8) == 0;
+	pixman_format_code_t mask_format =
+	    mask_formats[prng_rand_n (ARRAY_LENGTH (mask_formats))];
+	pixman_op_t op = operators[prng_rand_n (ARRAY_LENGTH (operators))];
+	pixman_format_code_t dst_format;
+	int x_dst = prng_rand_n (20) - 10;
+	int y_dst = prng_rand_n (20) - 10;
+	pixman_image_t *ref, *res;
+
+	/* Half of the time, take the path that rasterizes straight
+	 * into the destination.
+	 */
+	if (prng_rand_n (2))
+	{
+	    op = PIXMAN_OP_ADD;
+	    dst_format = mask_format;
+	}
+	else
+	{
+	    dst_format = PIXMAN_a8r8g8b8;
+	    self_src = prng_rand_n (4) == 0;
+	}
+
+	if (use_tris)
+	    random_triangles (tris, N_SHAPES);
+	else
+	    random_trapezoids (traps, N_SHAPES);
+
+	ref = render (1, use_tris, exact, self_src, accessors, op,
+		      mask_format, dst_format, x_dst, y_dst, traps, tris);
+	res = render (4, use_tris, exact, self_src, accessors, op,
+		      mask_format, dst_format, x_dst, y_dst, traps, tris);
+
+	if (accessed_from_other_thread)
+	{
+	    printf ("iteration %d: accessors were called from another "
+		    "thread\n", i);
+	    return 1;
+	}
+
+	if (memcmp (pixman_image_get_data (ref), pixman_image_get_data (res),
+		    WIDTH * 4 * HEIGHT) != 0)
+	{
+	    printf ("iteration %d: %s with %s mask into %s%s differs\n", i,
+		    use_tris ? "triangles" : "trapezoids",
+		    format_name (mask_format), format_name (dst_format),
+		    self_src ? " from itself" : "");
+	    return 1;
+	}
+
+	free (pixman_image_get_data (ref));
+	free (pixman_image_get_data (res));
+	pixman_image_unref (ref);
+	pixman_image_unref (res);
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* 32 bit region data goes through the allocator set with
+ * pixman_set_region_allocator(), 16 bit region data doesn't, and
+ * compositing with a simple clip stops allocating once the per-thread
+ * pool is warm. The blocks in the pool of a thread are freed when it
+ * exits.
+ */
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+static int n_allocs, n_reallocs, n_frees;
+
+static void *
+counting_alloc (size_t size)
+{
+    n_allocs++;
+    return malloc (size);
+}
+
+static void *
+counting_realloc (void *ptr, size_t size)
+{
+    n_reallocs++;
+    return realloc (ptr, size);
+}
+
+static void
+counting_free (void *ptr)
+{
+    n_frees++;
+    free (ptr);
+}
+
+static pixman_image_t *src, *dest;
+
+static void
+composite_with_clip (void)
+{
+    pixman_image_composite32 (PIXMAN_OP_OVER, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 64, 64);
+}
+
+#ifdef HAVE_PTHREADS
+static void *
+thread_main (void *data)
+{
+    pixman_region32_t region;
+    int i;
+
+    for (i = 0; i < 100; ++i)
+    {
+	pixman_region32_init_rects (&region, data, 3);
+	pixman_region32_fini (&region);
+
+	composite_with_clip ();
+    }
+
+    return NULL;
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+    pixman_box32_t clip_boxes[] = {
+	{ 0, 0, 10, 10 }, { 20, 0, 30, 10 }, { 5, 20, 60, 40 },
+    };
+    pixman_color_t color = { 0x8000, 0x4000, 0xc000, 0xe000 };
+    pixman_region32_t r1, r2, clip;
+    pixman_region16_t r16;
+    int i, n;
+
+    if (!pixman_set_region_allocator (counting_alloc, counting_realloc,
+				      counting_free))
+    {
+	printf ("setting the region allocator failed\n");
+	return 1;
+    }
+
+    pixman_region32_init (&r1);
+    for (i = 0; i < 100; ++i)
+	pixman_region32_union_rect (&r1, &r1, i * 10, i * 3, 5, 50);
+
+    assert (n_allocs > 0);
+    assert (pixman_region32_n_rects (&r1) > 100);
+
+    /* Once region data has been allocated, the allocator is fixed */
+    assert (!pixman_set_region_allocator (malloc, realloc, free));
+
+    pixman_region32_init (&r2);
+    pixman_region32_copy (&r2, &r1);
+    assert (pixman_region32_equal (&r1, &r2));
+
+    pixman_region32_fini (&r1);
+    pixman_region32_fini (&r2);
+    assert (n_frees > 0);
+
+    /* 16 bit region data can be freed by callers, so it must use free () */
+    n = n_allocs + n_reallocs + n_frees;
+    pixman_region_init (&r16);
+    for (i = 0; i < 100; ++i)
+	pixman_region_union_rect (&r16, &r16, i * 10, i * 3, 5, 50);
+    assert (pixman_region_n_rects (&r16) > 100);
+    free (r16.data);
+    assert (n_allocs + n_reallocs + n_frees == n);
+
+    src = pixman_image_create_solid_fill (&color);
+    dest = pixman_image_create_bits (PIXMAN_a8r8g8b8, 64, 64, NULL, -1);
+
+    pixman_region32_init_rects (&clip, clip_boxes, ARRAY_LENGTH (clip_boxes));
+    pixman_image_set_clip_region32 (dest, &clip);
+    pixman_region32_fini (&clip);
+
+    for (i = 0; i < 10; ++i)
+	composite_with_clip ();
+
+#ifdef HAVE_PTHREADS
+    n = n_allocs + n_reallocs;
+    for (i = 0; i < 1000; ++i)
+	composite_with_clip ();
+
+    if (n_allocs + n_reallocs != n)
+    {
+	printf ("compositing with a simple clip allocated %d times\n",
+		n_allocs + n_reallocs - n);
+	return 1;
+    }
+
+    /* Everything that a thread allocates and doesn't keep is freed by the
+     * time it has exited.
+     */
+    {
+	pthread_t thread;
+
+	n = n_allocs - n_frees;
+	if (pthread_create (&thread, NULL, thread_main, clip_boxes) == 0)
+	{
+	    pthread_join (thread, NULL);
+
+	    if (n_allocs - n_frees != n)
+	    {
+		printf ("%d region data blocks leaked by a thread\n",
+			n_allocs - n_frees - n);
+		return 1;
+	    }
+	}
+    }
+#endif
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return 0;
+}
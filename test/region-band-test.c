@@ -0,0 +1,131 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* Point and rectangle containment in regions with many boxes per band
+ * must agree with a per-pixel check.
+ */
+
+#define SIZE 256
+
+static uint8_t pixels[SIZE][SIZE];
+
+static void
+make_region (pixman_region32_t *region)
+{
+    int i, x, y;
+
+    pixman_region32_init (region);
+
+    /* Thin vertical strips give wide bands with many boxes */
+    for (i = 0; i < 200; ++i)
+    {
+	int bx = prng_rand_n (SIZE);
+	int by = prng_rand_n (SIZE);
+	int bw = 1 + prng_rand_n (prng_rand_n (2) ? 3 : 40);
+	int bh = 1 + prng_rand_n (SIZE / 2);
+
+	pixman_region32_union_rect (region, region, bx, by, bw, bh);
+    }
+
+    pixman_region32_intersect_rect (region, region, 0, 0, SIZE, SIZE);
+
+    for (y = 0; y < SIZE; ++y)
+    {
+	for (x = 0; x < SIZE; ++x)
+	    pixels[y][x] = 0;
+    }
+
+    for (i = 0; i < pixman_region32_n_rects (region); ++i)
+    {
+	pixman_box32_t *b = &pixman_region32_rectangles (region, NULL)[i];
+
+	for (y = b->y1; y < b->y2; ++y)
+	{
+	    for (x = b->x1; x < b->x2; ++x)
+		pixels[y][x] = 1;
+	}
+    }
+}
+
+static pixman_region_overlap_t
+reference_contains_rectangle (const pixman_box32_t *box)
+{
+    pixman_bool_t in = FALSE, out = FALSE;
+    int x, y;
+
+    for (y = box->y1; y < box->y2; ++y)
+    {
+	for (x = box->x1; x < box->x2; ++x)
+	{
+	    if (x >= 0 && x < SIZE && y >= 0 && y < SIZE && pixels[y][x])
+		in = TRUE;
+	    else
+		out = TRUE;
+	}
+    }
+
+    if (!in)
+	return PIXMAN_REGION_OUT;
+
+    return out ? PIXMAN_REGION_PART : PIXMAN_REGION_IN;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i, j;
+
+    prng_srand (0);
+
+    for (i = 0; i < 20; ++i)
+    {
+	pixman_region32_t region;
+
+	make_region (&region);
+
+	for (j = 0; j < 20000; ++j)
+	{
+	    int x = prng_rand_n (SIZE + 20) - 10;
+	    int y = prng_rand_n (SIZE + 20) - 10;
+	    pixman_bool_t inside = x >= 0 && x < SIZE && y >= 0 && y < SIZE &&
+		pixels[y][x];
+	    pixman_box32_t box;
+
+	    if (pixman_region32_contains_point (&region, x, y, &box) != inside)
+	    {
+		printf ("region %d: point %d %d is wrong\n", i, x, y);
+		return 1;
+	    }
+
+	    if (inside)
+	    {
+		assert (box.x1 <= x && x < box.x2);
+		assert (box.y1 <= y && y < box.y2);
+	    }
+	}
+
+	for (j = 0; j < 2000; ++j)
+	{
+	    pixman_box32_t box;
+
+	    box.x1 = prng_rand_n (SIZE + 20) - 10;
+	    box.y1 = prng_rand_n (SIZE + 20) - 10;
+	    box.x2 = box.x1 + 1 + prng_rand_n (prng_rand_n (2) ? 4 : 60);
+	    box.y2 = box.y1 + 1 + prng_rand_n (prng_rand_n (2) ? 4 : 60);
+
+	    if (pixman_region32_contains_rectangle (&region, &box) !=
+		reference_contains_rectangle (&box))
+	    {
+		printf ("region %d: rectangle %d %d %d %d is wrong\n", i,
+			box.x1, box.y1, box.x2, box.y2);
+		return 1;
+	    }
+	}
+
+	pixman_region32_fini (&region);
+    }
+
+    return 0;
+}
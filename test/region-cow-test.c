@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* Copies of a region share their boxes; changing either the copy or the
+ * original must leave the other one alone.
+ */
+
+#define N_COPIES 4
+
+static void
+make_random_region (pixman_region32_t *region)
+{
+    int i, n = 2 + prng_rand_n (30);
+
+    pixman_region32_init (region);
+
+    for (i = 0; i < n; ++i)
+    {
+	pixman_region32_union_rect (region, region,
+				    prng_rand_n (200), prng_rand_n (200),
+				    1 + prng_rand_n (50), 1 + prng_rand_n (50));
+    }
+}
+
+/* An independent copy of a region, made from its boxes */
+static void
+snapshot (pixman_region32_t *dest, pixman_region32_t *src)
+{
+    pixman_box32_t *boxes;
+    int n_boxes;
+
+    boxes = pixman_region32_rectangles (src, &n_boxes);
+    pixman_region32_init_rects (dest, boxes, n_boxes);
+}
+
+static void
+mutate (pixman_region32_t *region)
+{
+    pixman_region32_t other;
+    pixman_box32_t box = { 10, 10, 150, 150 };
+
+    make_random_region (&other);
+
+    switch (prng_rand_n (8))
+    {
+    case 0:
+	pixman_region32_translate (region, 1 + prng_rand_n (10), prng_rand_n (10));
+	break;
+    case 1:
+	pixman_region32_union (region, region, &other);
+	break;
+    case 2:
+	pixman_region32_union (region, &other, region);
+	break;
+    case 3:
+	pixman_region32_intersect (region, region, &other);
+	break;
+    case 4:
+	pixman_region32_subtract (region, region, &other);
+	break;
+    case 5:
+	pixman_region32_union_rect (region, region, 5, 5, 20, 300);
+	break;
+    case 6:
+	pixman_region32_inverse (region, region, &box);
+	break;
+    case 7:
+	pixman_region32_copy (region, &other);
+	break;
+    }
+
+    pixman_region32_fini (&other);
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_region32_t copies[N_COPIES];
+    pixman_region32_t expected[N_COPIES];
+    int i, j;
+
+    for (i = 0; i < 5000; ++i)
+    {
+	int target;
+
+	prng_srand (i);
+	make_random_region (&copies[0]);
+
+	for (j = 1; j < N_COPIES; ++j)
+	{
+	    pixman_region32_init (&copies[j]);
+	    pixman_region32_copy (&copies[j], &copies[prng_rand_n (j)]);
+	}
+
+	for (j = 0; j < N_COPIES; ++j)
+	{
+	    assert (pixman_region32_equal (&copies[j], &copies[0]));
+	    snapshot (&expected[j], &copies[j]);
+	}
+
+	/* Change one of the regions, and its independent copy the same way */
+	target = prng_rand_n (N_COPIES);
+	prng_srand (100000 + i);
+	mutate (&copies[target]);
+	prng_srand (100000 + i);
+	mutate (&expected[target]);
+
+	for (j = 0; j < N_COPIES; ++j)
+	{
+	    assert (pixman_region32_selfcheck (&copies[j]));
+
+	    if (!pixman_region32_equal (&copies[j], &expected[j]))
+	    {
+		printf ("iteration %d: copy %d is wrong after changing copy %d\n",
+			i, j, target);
+		return 1;
+	    }
+	}
+
+	for (j = 0; j < N_COPIES; ++j)
+	{
+	    pixman_region32_fini (&copies[j]);
+	    pixman_region32_fini (&expected[j]);
+	}
+    }
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* pixman_region32_init_from_image() and its threshold variant must give
+ * the same region as adding the inside pixels of the image one run at a
+ * time.
+ */
+
+static pixman_bool_t
+pixel_is_inside (pixman_image_t *image, int x, int y, int threshold)
+{
+    uint8_t *line = (uint8_t *)pixman_image_get_data (image) +
+	y * pixman_image_get_stride (image);
+
+    if (pixman_image_get_format (image) == PIXMAN_a1)
+    {
+	uint32_t w = ((uint32_t *)line)[x >> 5];
+
+#ifdef WORDS_BIGENDIAN
+	return (w >> (31 - (x & 31))) & 1;
+#else
+	return (w >> (x & 31)) & 1;
+#endif
+    }
+    else
+    {
+	return line[x] >= threshold;
+    }
+}
+
+static void
+make_reference (pixman_region32_t *region, pixman_image_t *image, int threshold)
+{
+    int width = pixman_image_get_width (image);
+    int height = pixman_image_get_height (image);
+    int x, y;
+
+    pixman_region32_init (region);
+
+    for (y = 0; y < height; ++y)
+    {
+	x = 0;
+	while (x < width)
+	{
+	    int x1;
+
+	    while (x < width && !pixel_is_inside (image, x, y, threshold))
+		x++;
+
+	    x1 = x;
+	    while (x < width && pixel_is_inside (image, x, y, threshold))
+		x++;
+
+	    if (x > x1)
+		pixman_region32_union_rect (region, region, x1, y, x - x1, 1);
+	}
+    }
+}
+
+static pixman_image_t *
+make_random_image (pixman_format_code_t format)
+{
+    int width = 1 + prng_rand_n (200);
+    int height = 1 + prng_rand_n (40);
+    pixman_image_t *image;
+    uint8_t *data;
+    int stride, y;
+
+    image = pixman_image_create_bits (format, width, height, NULL, -1);
+    data = (uint8_t *)pixman_image_get_data (image);
+    stride = pixman_image_get_stride (image);
+
+    for (y = 0; y < height; ++y)
+    {
+	uint8_t *line = data + y * stride;
+
+	/* Repeat rows to get bands, and use long runs of 0x00 and 0xff
+	 * bytes so that whole words are inside or outside.
+	 */
+	if (y > 0 && prng_rand_n (2))
+	{
+	    memcpy (line, line - stride, stride);
+	}
+	else if (prng_rand_n (2))
+	{
+	    int x = 0;
+
+	    while (x < stride)
+	    {
+		int n = 1 + prng_rand_n (12);
+
+		if (n > stride - x)
+		    n = stride - x;
+
+		memset (line + x, prng_rand_n (2) ? 0xff : 0x00, n);
+		x += n;
+	    }
+	}
+	else
+	{
+	    prng_randmemset (line, stride, 0);
+	}
+    }
+
+    return image;
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_region16_t r16;
+    pixman_region32_t r1, r2;
+    pixman_image_t *image;
+    int i, threshold;
+
+    prng_srand (0);
+
+    for (i = 0; i < 3000; ++i)
+    {
+	pixman_format_code_t format = prng_rand_n (2) ? PIXMAN_a1 : PIXMAN_a8;
+
+	image = make_random_image (format);
+
+	if (prng_rand_n (2))
+	{
+	    threshold = 1;
+	    pixman_region32_init_from_image (&r2, image);
+	}
+	else
+	{
+	    threshold = 1 + prng_rand_n (255);
+	    pixman_region32_init_from_image_threshold (&r2, image, threshold);
+	}
+
+	make_reference (&r1, image, threshold);
+
+	assert (pixman_region32_selfcheck (&r2));
+
+	if (!pixman_region32_equal (&r1, &r2))
+	{
+	    printf ("iteration %d: region from %s image (threshold %d) differs\n",
+		    i, format == PIXMAN_a1 ? "a1" : "a8", threshold);
+	    return 1;
+	}
+
+	if (i % 10 == 0)
+	{
+	    pixman_region_init_from_image_threshold (&r16, image, threshold);
+	    assert (pixman_region_selfcheck (&r16));
+	    assert (pixman_region_n_rects (&r16) == pixman_region32_n_rects (&r1));
+	    pixman_region_fini (&r16);
+	}
+
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+	pixman_image_unref (image);
+    }
+
+    return 0;
+}
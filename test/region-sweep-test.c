@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* pixman_region32_init_from_boxes_unsorted() and
+ * pixman_region32_union_many() must give the same regions as
+ * pixman_region32_init_rects() and repeated pixman_region32_union().
+ */
+
+#define MAX_BOXES 500
+#define MAX_REGIONS 20
+
+static void
+random_box (pixman_box32_t *box, int n_boxes, int size)
+{
+    box->x1 = prng_rand_n (size) - size / 4;
+    box->y1 = prng_rand_n (size) - size / 4;
+
+    /* Include some empty and malformed boxes */
+    box->x2 = box->x1 + prng_rand_n (size / 2) - 1;
+    box->y2 = box->y1 + prng_rand_n (size / 2) - 1;
+
+    /* ... but pixman_region32_init_rects() complains about a single
+     * malformed box.
+     */
+    if (n_boxes == 1 && (box->x2 < box->x1 || box->y2 < box->y1))
+    {
+	box->x2 = box->x1;
+	box->y2 = box->y1;
+    }
+}
+
+static void
+check_equal (pixman_region32_t *a, pixman_region32_t *b, const char *what, int i)
+{
+    assert (pixman_region32_selfcheck (a));
+
+    if (!pixman_region32_equal (a, b))
+    {
+	printf ("iteration %d: %s differs\n", i, what);
+	exit (1);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_box32_t boxes[MAX_BOXES];
+    pixman_region32_t regions[MAX_REGIONS];
+    pixman_region32_t r1, r2;
+    pixman_box16_t boxes16[3] = {
+	{ 0, 0, 10, 10 }, { 5, 5, 20, 20 }, { 20, 0, 30, 5 },
+    };
+    pixman_region16_t s1, s2;
+    int i, j, n;
+
+    prng_srand (0);
+
+    for (i = 0; i < 2000; ++i)
+    {
+	int size = prng_rand_n (2) ? 64 : 100000;
+
+	n = prng_rand_n (MAX_BOXES + 1);
+	for (j = 0; j < n; ++j)
+	    random_box (&boxes[j], n, size);
+
+	pixman_region32_init_rects (&r1, boxes, n);
+	pixman_region32_init_from_boxes_unsorted (&r2, boxes, n);
+	check_equal (&r2, &r1, "init_from_boxes_unsorted", i);
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+
+	n = prng_rand_n (MAX_REGIONS + 1);
+	pixman_region32_init (&r1);
+	for (j = 0; j < n; ++j)
+	{
+	    int k, n_boxes = prng_rand_n (30);
+
+	    for (k = 0; k < n_boxes; ++k)
+		random_box (&boxes[k], n_boxes, size);
+
+	    pixman_region32_init_rects (&regions[j], boxes, n_boxes);
+	    pixman_region32_union (&r1, &r1, &regions[j]);
+	}
+
+	pixman_region32_init (&r2);
+	pixman_region32_union_many (&r2, regions, n);
+	check_equal (&r2, &r1, "union_many", i);
+
+	/* The destination may be one of the regions */
+	if (n)
+	{
+	    pixman_region32_union_many (&regions[0], regions, n);
+	    check_equal (&regions[0], &r1, "union_many in place", i);
+	}
+
+	for (j = 0; j < n; ++j)
+	    pixman_region32_fini (&regions[j]);
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+    }
+
+    pixman_region_init_rects (&s1, boxes16, 3);
+    pixman_region_init_from_boxes_unsorted (&s2, boxes16, 3);
+    assert (pixman_region_equal (&s1, &s2));
+    pixman_region_fini (&s1);
+    pixman_region_fini (&s2);
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+/* Storing to the sRGB formats must pick the sRGB value whose linear
+ * value is nearest, and the sRGB fast paths must give the same results
+ * as compositing through rgba_float images.
+ */
+
+static float to_linear[256];
+
+static pixman_image_t *
+convert (pixman_image_t *src, pixman_format_code_t format, int src_x)
+{
+    int width = pixman_image_get_width (src) - src_x;
+    int height = pixman_image_get_height (src);
+    pixman_image_t *dest =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      src_x, 0, 0, 0, 0, 0, width, height);
+
+    return dest;
+}
+
+/* The linear values that every sRGB value decodes to, also when an
+ * r8g8b8_sRGB image is fetched from somewhere else than its first pixel
+ */
+static pixman_bool_t
+get_linear_values (void)
+{
+    pixman_image_t *srgb, *srgb24, *f, *f24;
+    uint8_t *p24;
+    uint32_t *p;
+    float *v, *v24;
+    int i;
+
+    srgb = pixman_image_create_bits (PIXMAN_a8r8g8b8_sRGB, 256, 1, NULL, -1);
+    srgb24 = pixman_image_create_bits (PIXMAN_r8g8b8_sRGB, 259, 1, NULL, -1);
+    p = pixman_image_get_data (srgb);
+    p24 = (uint8_t *)pixman_image_get_data (srgb24);
+
+    for (i = 0; i < 256; ++i)
+    {
+	p[i] = (i << 24) | (i << 16) | ((255 - i) << 8) | i;
+	p24[3 * (i + 3) + 0] = i;
+	p24[3 * (i + 3) + 1] = i;
+	p24[3 * (i + 3) + 2] = i;
+    }
+
+    f = convert (srgb, PIXMAN_rgba_float, 0);
+    f24 = convert (srgb24, PIXMAN_rgba_float, 3);
+    v = (float *)pixman_image_get_data (f);
+    v24 = (float *)pixman_image_get_data (f24);
+
+    for (i = 0; i < 256; ++i)
+	to_linear[i] = v[4 * i];
+
+    for (i = 0; i < 256; ++i)
+    {
+	if (v[4 * i + 1] != to_linear[255 - i] || v[4 * i + 2] != to_linear[i] ||
+	    v[4 * i + 3] != i * (1.f / 255.f) ||
+	    v24[4 * i] != to_linear[i] || v24[4 * i + 3] != 1.f)
+	{
+	    printf ("sRGB value %d decoded inconsistently\n", i);
+	    return FALSE;
+	}
+
+	if (i && to_linear[i] <= to_linear[i - 1])
+	{
+	    printf ("sRGB to linear table is not increasing at %d\n", i);
+	    return FALSE;
+	}
+    }
+
+    pixman_image_unref (srgb);
+    pixman_image_unref (srgb24);
+    pixman_image_unref (f);
+    pixman_image_unref (f24);
+
+    return TRUE;
+}
+
+/* Nearest sRGB value, ties going to the lower one */
+static int
+reference_encode (float f)
+{
+    int low = 0, high = 255;
+
+    while (high - low > 1)
+    {
+	int mid = (low + high) / 2;
+
+	if (to_linear[mid] > f)
+	    high = mid;
+	else
+	    low = mid;
+    }
+
+    if (to_linear[high] - f < f - to_linear[low])
+	return high;
+    else
+	return low;
+}
+
+#define N_VALUES (255 * 20 + 4096)
+
+/* Values around every point where the encoding goes up, and random
+ * ones, some of them outside [0, 1].
+ */
+static pixman_bool_t
+check_encode (void)
+{
+    pixman_image_t *f, *srgb, *srgb24;
+    pixman_bool_t ok = TRUE;
+    float *v;
+    uint32_t *p;
+    uint8_t *p24;
+    int i, j, n = 0;
+
+    f = pixman_image_create_bits (PIXMAN_rgba_float, N_VALUES, 1, NULL, -1);
+    v = (float *)pixman_image_get_data (f);
+
+    for (i = 0; i < 255; ++i)
+    {
+	float mid = (to_linear[i] + to_linear[i + 1]) / 2;
+	float below = mid, above = mid;
+
+	for (j = 0; j < 8; ++j)
+	{
+	    below = nextafterf (below, 0.0f);
+	    above = nextafterf (above, 1.0f);
+
+	    v[4 * n++] = below;
+	    v[4 * n++] = above;
+	}
+
+	v[4 * n++] = to_linear[i];
+	v[4 * n++] = nextafterf (to_linear[i], 0.0f);
+	v[4 * n++] = nextafterf (to_linear[i], 1.0f);
+	v[4 * n++] = to_linear[i] + 0.00001f;
+    }
+
+    while (n < N_VALUES)
+	v[4 * n++] = (prng_rand_n (120001) - 10000) / 100000.f;
+
+    for (i = 0; i < N_VALUES; ++i)
+    {
+	v[4 * i + 1] = v[4 * ((i + 1) % N_VALUES)];
+	v[4 * i + 2] = v[4 * ((i + 2) % N_VALUES)];
+	v[4 * i + 3] = prng_rand_n (256) / 255.f;
+    }
+
+    srgb = convert (f, PIXMAN_a8r8g8b8_sRGB, 0);
+    srgb24 = convert (f, PIXMAN_r8g8b8_sRGB, 0);
+    p = pixman_image_get_data (srgb);
+    p24 = (uint8_t *)pixman_image_get_data (srgb24);
+
+    for (i = 0; i < N_VALUES && ok; ++i)
+    {
+	uint32_t expected =
+	    ((uint32_t)(v[4 * i + 3] * 255.f + 0.5f) << 24)	|
+	    (reference_encode (v[4 * i]) << 16)			|
+	    (reference_encode (v[4 * i + 1]) << 8)		|
+	    (reference_encode (v[4 * i + 2]));
+	uint32_t got24 = (p24[3 * i + 2] << 16) | (p24[3 * i + 1] << 8) | p24[3 * i];
+
+#ifdef WORDS_BIGENDIAN
+	got24 = (p24[3 * i] << 16) | (p24[3 * i + 1] << 8) | p24[3 * i + 2];
+#endif
+
+	if (p[i] != expected || got24 != (expected & 0xffffff))
+	{
+	    printf ("%g %g %g %g encoded as %08x and %06x, expected %08x\n",
+		    v[4 * i], v[4 * i + 1], v[4 * i + 2], v[4 * i + 3],
+		    p[i], got24, expected);
+	    ok = FALSE;
+	}
+    }
+
+    pixman_image_unref (f);
+    pixman_image_unref (srgb);
+    pixman_image_unref (srgb24);
+
+    return ok;
+}
+
+static pixman_image_t *
+create_random_image (pixman_format_code_t format, int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (format, width, height, NULL, -1);
+    uint32_t *p = pixman_image_get_data (image);
+    int i;
+
+    prng_randmemset (p, pixman_image_get_stride (image) * height, 0);
+
+    /* Some transparent and opaque pixels */
+    if (PIXMAN_FORMAT_BPP (format) == 32)
+    {
+	for (i = 0; i < width * height; ++i)
+	{
+	    if (prng_rand_n (8) == 0)
+		p[i] = 0;
+	    else if (prng_rand_n (8) == 0)
+		p[i] |= 0xff000000;
+	}
+    }
+
+    return image;
+}
+
+static pixman_bool_t
+images_equal (pixman_image_t *a, pixman_image_t *b)
+{
+    int bytes = pixman_image_get_width (a) *
+	PIXMAN_FORMAT_BPP (pixman_image_get_format (a)) / 8;
+    int stride = pixman_image_get_stride (a);
+    uint8_t *pa = (uint8_t *)pixman_image_get_data (a);
+    uint8_t *pb = (uint8_t *)pixman_image_get_data (b);
+    int y;
+
+    for (y = 0; y < pixman_image_get_height (a); ++y)
+    {
+	if (memcmp (pa + y * stride, pb + y * stride, bytes) != 0)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* OVER, ADD and SRC of a8r8g8b8 and the sRGB formats onto the sRGB
+ * formats, compared with the same composite done between rgba_float
+ * images.
+ */
+static pixman_bool_t
+check_composite (int iter)
+{
+    static const pixman_op_t ops[] =
+	{ PIXMAN_OP_OVER, PIXMAN_OP_ADD, PIXMAN_OP_SRC };
+    static const pixman_format_code_t src_formats[] =
+	{ PIXMAN_a8r8g8b8, PIXMAN_a8r8g8b8_sRGB, PIXMAN_r8g8b8_sRGB };
+    static const pixman_format_code_t dest_formats[] =
+	{ PIXMAN_a8r8g8b8_sRGB, PIXMAN_r8g8b8_sRGB };
+    pixman_op_t op = ops[prng_rand_n (ARRAY_LENGTH (ops))];
+    pixman_format_code_t src_format =
+	src_formats[prng_rand_n (ARRAY_LENGTH (src_formats))];
+    pixman_format_code_t dest_format =
+	dest_formats[prng_rand_n (ARRAY_LENGTH (dest_formats))];
+    int width = 1 + prng_rand_n (64), height = 1 + prng_rand_n (4);
+    pixman_image_t *src, *dest, *fsrc, *fdest, *expected;
+    pixman_bool_t ok;
+
+    src = create_random_image (src_format, width, height);
+    dest = create_random_image (dest_format, width, height);
+
+    fsrc = convert (src, PIXMAN_rgba_float, 0);
+    fdest = convert (dest, PIXMAN_rgba_float, 0);
+    pixman_image_composite32 (op, fsrc, NULL, fdest,
+			      0, 0, 0, 0, 0, 0, width, height);
+    expected = convert (fdest, dest_format, 0);
+
+    pixman_image_composite32 (op, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, width, height);
+
+    ok = images_equal (dest, expected);
+    if (!ok)
+    {
+	printf ("iteration %d: %s %s onto %s differs\n",
+		iter, operator_name (op), format_name (src_format),
+		format_name (dest_format));
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    pixman_image_unref (fsrc);
+    pixman_image_unref (fdest);
+    pixman_image_unref (expected);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    if (!get_linear_values () || !check_encode ())
+	return 1;
+
+    for (i = 0; i < 6000; ++i)
+    {
+	if (!check_composite (i))
+	    return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,406 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+/* a16b16g16r16 and x16b16g16r16 images must composite at 16 bits per
+ * channel, with the products rounded to the nearest value like the 8 bit
+ * combiners do it, also when some of the images are a8r8g8b8 or a8.
+ */
+
+static const pixman_op_t operators[] =
+{
+    PIXMAN_OP_CLEAR, PIXMAN_OP_SRC, PIXMAN_OP_DST, PIXMAN_OP_OVER,
+    PIXMAN_OP_OVER_REVERSE, PIXMAN_OP_IN, PIXMAN_OP_IN_REVERSE,
+    PIXMAN_OP_OUT, PIXMAN_OP_OUT_REVERSE, PIXMAN_OP_ATOP,
+    PIXMAN_OP_ATOP_REVERSE, PIXMAN_OP_XOR, PIXMAN_OP_ADD,
+};
+
+typedef enum { F_ZERO, F_ONE, F_SA, F_DA, F_INV_SA, F_INV_DA } factor_t;
+
+static const factor_t factors[][2] =
+{
+    { F_ZERO,	F_ZERO },	/* CLEAR */
+    { F_ONE,	F_ZERO },	/* SRC */
+    { F_ZERO,	F_ONE },	/* DST */
+    { F_ONE,	F_INV_SA },	/* OVER */
+    { F_INV_DA,	F_ONE },	/* OVER_REVERSE */
+    { F_DA,	F_ZERO },	/* IN */
+    { F_ZERO,	F_SA },		/* IN_REVERSE */
+    { F_INV_DA,	F_ZERO },	/* OUT */
+    { F_ZERO,	F_INV_SA },	/* OUT_REVERSE */
+    { F_DA,	F_INV_SA },	/* ATOP */
+    { F_INV_DA,	F_SA },		/* ATOP_REVERSE */
+    { F_INV_DA,	F_INV_SA },	/* XOR */
+    { F_ONE,	F_ONE },	/* ADD */
+};
+
+static const pixman_format_code_t src_formats[] =
+{
+    PIXMAN_a16b16g16r16, PIXMAN_x16b16g16r16, PIXMAN_a8r8g8b8, PIXMAN_null,
+};
+
+static const pixman_format_code_t mask_formats[] =
+{
+    PIXMAN_null, PIXMAN_a16b16g16r16, PIXMAN_a8,
+};
+
+static const pixman_format_code_t dest_formats[] =
+{
+    PIXMAN_a16b16g16r16, PIXMAN_x16b16g16r16, PIXMAN_a8r8g8b8,
+};
+
+static uint32_t
+mul_un16 (uint32_t a, uint32_t b)
+{
+    uint32_t t = a * b + 0x8000;
+
+    return ((t >> 16) + t) >> 16;
+}
+
+static uint32_t
+get_factor (factor_t f, uint32_t sa, uint32_t da)
+{
+    switch (f)
+    {
+    case F_ONE:		return 0xffff;
+    case F_SA:		return sa;
+    case F_DA:		return da;
+    case F_INV_SA:	return 0xffff - sa;
+    case F_INV_DA:	return 0xffff - da;
+    default:		return 0;
+    }
+}
+
+/* Channels are in a, r, g, b order */
+static void
+get_pixel (pixman_image_t *image, int x, int y, uint32_t c[4])
+{
+    pixman_format_code_t format = pixman_image_get_format (image);
+    uint8_t *row = (uint8_t *)pixman_image_get_data (image) +
+	y * pixman_image_get_stride (image);
+    int i;
+
+    if (PIXMAN_FORMAT_BPP (format) == 64)
+    {
+	uint64_t p = ((uint64_t *)row)[x];
+
+	c[0] = format == PIXMAN_x16b16g16r16 ? 0xffff : p >> 48;
+	c[1] = p & 0xffff;
+	c[2] = (p >> 16) & 0xffff;
+	c[3] = (p >> 32) & 0xffff;
+    }
+    else if (format == PIXMAN_a8)
+    {
+	c[0] = row[x] * 257;
+	c[1] = c[2] = c[3] = 0;
+    }
+    else
+    {
+	uint32_t p = ((uint32_t *)row)[x];
+
+	for (i = 0; i < 4; ++i)
+	    c[i] = ((p >> (24 - 8 * i)) & 0xff) * 257;
+    }
+}
+
+static uint64_t
+random_pixel_64 (void)
+{
+    uint64_t p = prng_rand () | ((uint64_t)prng_rand () << 32);
+    uint32_t a = p >> 48, c;
+    int i;
+
+    /* Mostly premultiplied, with some opaque and transparent pixels */
+    switch (prng_rand_n (4))
+    {
+    case 0:
+	return p;
+    case 1:
+	a = 0xffff;
+	break;
+    case 2:
+	a = 0;
+	break;
+    }
+
+    p = (uint64_t)a << 48;
+    for (i = 0; i < 3; ++i)
+    {
+	c = a ? prng_rand_n (a + 1) : 0;
+	p |= (uint64_t)c << (16 * i);
+    }
+
+    return p;
+}
+
+static pixman_image_t *
+create_image (pixman_format_code_t format, int width, int height)
+{
+    pixman_image_t *image;
+    int i;
+
+    if (format == PIXMAN_null)
+    {
+	pixman_color_t color;
+
+	color.alpha = prng_rand_n (0x10000);
+	color.red = prng_rand_n (color.alpha + 1);
+	color.green = prng_rand_n (color.alpha + 1);
+	color.blue = prng_rand_n (color.alpha + 1);
+
+	return pixman_image_create_solid_fill (&color);
+    }
+
+    image = pixman_image_create_bits (format, width, height, NULL, -1);
+
+    if (PIXMAN_FORMAT_BPP (format) == 64)
+    {
+	uint64_t *bits = (uint64_t *)pixman_image_get_data (image);
+
+	for (i = 0; i < width * height; ++i)
+	{
+	    bits[i] = random_pixel_64 ();
+
+	    if (format == PIXMAN_x16b16g16r16)
+		bits[i] &= 0x0000ffffffffffffULL;
+	}
+    }
+    else
+    {
+	prng_randmemset (pixman_image_get_data (image),
+			 pixman_image_get_stride (image) * height, 0);
+    }
+
+    return image;
+}
+
+static void
+get_source_pixel (pixman_image_t *image, int x, int y, uint32_t c[4])
+{
+    int width, height;
+
+    if (image->type == SOLID)
+    {
+	c[0] = image->solid.color.alpha;
+	c[1] = image->solid.color.red;
+	c[2] = image->solid.color.green;
+	c[3] = image->solid.color.blue;
+	return;
+    }
+
+    width = pixman_image_get_width (image);
+    height = pixman_image_get_height (image);
+
+    if (image->common.repeat == PIXMAN_REPEAT_NORMAL)
+    {
+	x = ((x % width) + width) % width;
+	y = ((y % height) + height) % height;
+    }
+    else if (x < 0 || x >= width || y < 0 || y >= height)
+    {
+	c[0] = c[1] = c[2] = c[3] = 0;
+	return;
+    }
+
+    get_pixel (image, x, y, c);
+}
+
+static uint32_t
+un16_to_un8 (uint32_t u)
+{
+    return (u * 255 + 32895) >> 16;
+}
+
+static uint64_t
+expected_pixel (pixman_op_t op, pixman_image_t *src, pixman_image_t *mask,
+		pixman_image_t *dest, int src_x, int src_y, int x, int y)
+{
+    const factor_t *f = factors[op];
+    uint32_t s[4], m[4], d[4], sa[4], r[4];
+    pixman_format_code_t format = pixman_image_get_format (dest);
+    int i;
+
+    get_source_pixel (src, src_x, src_y, s);
+    get_pixel (dest, x, y, d);
+
+    for (i = 0; i < 4; ++i)
+	sa[i] = s[0];
+
+    if (mask)
+    {
+	pixman_bool_t ca = mask->common.component_alpha;
+	uint32_t alpha = s[0];
+
+	get_source_pixel (mask, x, y, m);
+
+	/* Without component alpha, only the alpha of the mask counts */
+	for (i = 0; i < 4; ++i)
+	{
+	    uint32_t mc = ca ? m[i] : m[0];
+
+	    sa[i] = mul_un16 (mc, alpha);
+	    s[i] = mul_un16 (s[i], mc);
+	}
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+	uint32_t fa = get_factor (f[0], sa[i], d[0]);
+	uint32_t fb = get_factor (f[1], sa[i], d[0]);
+
+	r[i] = mul_un16 (s[i], fa) + mul_un16 (d[i], fb);
+	if (r[i] > 0xffff)
+	    r[i] = 0xffff;
+    }
+
+    if (format == PIXMAN_a8r8g8b8)
+    {
+	return (un16_to_un8 (r[0]) << 24) | (un16_to_un8 (r[1]) << 16) |
+	    (un16_to_un8 (r[2]) << 8) | un16_to_un8 (r[3]);
+    }
+
+    if (format == PIXMAN_x16b16g16r16)
+	r[0] = 0;
+
+    return ((uint64_t)r[0] << 48) | ((uint64_t)r[3] << 32) |
+	((uint64_t)r[2] << 16) | r[1];
+}
+
+static uint64_t
+read_dest (pixman_image_t *dest, int x, int y)
+{
+    uint8_t *row = (uint8_t *)pixman_image_get_data (dest) +
+	y * pixman_image_get_stride (dest);
+
+    if (PIXMAN_FORMAT_BPP (pixman_image_get_format (dest)) == 64)
+	return ((uint64_t *)row)[x];
+    else
+	return ((uint32_t *)row)[x];
+}
+
+static pixman_bool_t
+check_composite (int iter)
+{
+    pixman_op_t op = operators[prng_rand_n (ARRAY_LENGTH (operators))];
+    pixman_format_code_t src_format, mask_format, dest_format;
+    int width = 1 + prng_rand_n (40), height = 1 + prng_rand_n (6);
+    int src_x = prng_rand_n (5) - 2, src_y = prng_rand_n (5) - 2;
+    pixman_image_t *src, *mask = NULL, *dest, *orig;
+    pixman_bool_t ok = TRUE;
+    int x, y;
+
+    do
+    {
+	src_format = src_formats[prng_rand_n (ARRAY_LENGTH (src_formats))];
+	mask_format = mask_formats[prng_rand_n (ARRAY_LENGTH (mask_formats))];
+	dest_format = dest_formats[prng_rand_n (ARRAY_LENGTH (dest_formats))];
+    } while (src_format != PIXMAN_a16b16g16r16 &&
+	     src_format != PIXMAN_x16b16g16r16 &&
+	     mask_format != PIXMAN_a16b16g16r16 &&
+	     dest_format == PIXMAN_a8r8g8b8);
+
+    src = create_image (src_format, width, height);
+    if (src_format != PIXMAN_null && prng_rand_n (2))
+	pixman_image_set_repeat (src, PIXMAN_REPEAT_NORMAL);
+
+    if (mask_format != PIXMAN_null)
+    {
+	mask = create_image (mask_format, width, height);
+	if (mask_format == PIXMAN_a16b16g16r16 && prng_rand_n (2))
+	    pixman_image_set_component_alpha (mask, TRUE);
+    }
+
+    dest = create_image (dest_format, width, height);
+    orig = create_image (dest_format, width, height);
+    memcpy (pixman_image_get_data (orig), pixman_image_get_data (dest),
+	    pixman_image_get_stride (dest) * height);
+
+    pixman_image_composite32 (op, src, mask, dest, src_x, src_y, 0, 0, 0, 0,
+			      width, height);
+
+    for (y = 0; y < height && ok; ++y)
+    {
+	for (x = 0; x < width; ++x)
+	{
+	    uint64_t expected = expected_pixel (
+		op, src, mask, orig, src_x + x, src_y + y, x, y);
+	    uint64_t got = read_dest (dest, x, y);
+
+	    if (got != expected)
+	    {
+		printf ("iteration %d: %s %s %s %s %s, pixel %d %d\n"
+			"  got      %016llx\n  expected %016llx\n",
+			iter, operator_name (op),
+			src_format == PIXMAN_null ?
+			    "solid" : format_name (src_format),
+			mask_format == PIXMAN_null ?
+			    "none" : format_name (mask_format),
+			mask && mask->common.component_alpha ? "(ca)" : "",
+			format_name (dest_format), x, y,
+			(unsigned long long)got, (unsigned long long)expected);
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (dest);
+    pixman_image_unref (orig);
+
+    return ok;
+}
+
+/* 16 bit channels survive being fetched to and stored from floats */
+static pixman_bool_t
+check_wide_round_trip (void)
+{
+    pixman_image_t *src, *floats, *dest;
+    pixman_bool_t ok;
+
+    src = create_image (PIXMAN_a16b16g16r16, 64, 64);
+    floats = pixman_image_create_bits (PIXMAN_rgba_float, 64, 64, NULL, -1);
+    dest = pixman_image_create_bits (PIXMAN_a16b16g16r16, 64, 64, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, floats,
+			      0, 0, 0, 0, 0, 0, 64, 64);
+    pixman_image_composite32 (PIXMAN_OP_SRC, floats, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 64, 64);
+
+    ok = memcmp (pixman_image_get_data (src), pixman_image_get_data (dest),
+		 64 * 64 * 8) == 0;
+    if (!ok)
+	printf ("a16b16g16r16 changed going through rgba_float\n");
+
+    pixman_image_unref (src);
+    pixman_image_unref (floats);
+    pixman_image_unref (dest);
+
+    return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+
+    prng_srand (0);
+
+    assert (PIXMAN_FORMAT_BPP (PIXMAN_a16b16g16r16) == 64);
+    assert (PIXMAN_FORMAT_A (PIXMAN_a16b16g16r16) == 16);
+    assert (PIXMAN_FORMAT_A (PIXMAN_x16b16g16r16) == 0);
+
+    if (!check_wide_round_trip ())
+	return 1;
+
+    for (i = 0; i < 20000; ++i)
+    {
+	if (!check_composite (i))
+	    return 1;
+    }
+
+    return 0;
+}
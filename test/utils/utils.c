@@ -1227,6 +1227,10 @@ static const format_entry_t format_list[] =
     ENTRY (rgba_float),
 /* 96bpp formats */
     ENTRY (rgb_float),
+/* 64bpp formats */
+    ENTRY (rgba_half),
+    ENTRY (a16b16g16r16),
+    ENTRY (x16b16g16r16),
 
 /* 32bpp formats */
     ENTRY (a8r8g8b8),
@@ -1315,6 +1319,10 @@ static const format_entry_t format_list[] =
     /* ENTRY (yuy2), */
     ALIAS (yv12,		"yv12"),
     /* ENTRY (yv12), */
+    ALIAS (i420,		"i420"),
+    /* ENTRY (i420), */
+    ALIAS (nv12,		"nv12"),
+    /* ENTRY (nv12), */
 
 /* Fake formats, not in pixman_format_code_t enum */
     ALIAS (null,		"null"),
@@ -2022,7 +2030,8 @@ pixel_checker_init (pixel_checker_t *checker, pixman_format_code_t format)
     checker->format = format;
 
     if (format == PIXMAN_rgba_float ||
-	format == PIXMAN_rgb_float)
+	format == PIXMAN_rgb_float ||
+	PIXMAN_FORMAT_BPP (format) == 64)
 	return;
 
     switch (PIXMAN_FORMAT_TYPE (format))
@@ -2101,7 +2110,8 @@ static void
 pixel_checker_require_uint32_format (const pixel_checker_t *checker)
 {
     assert (checker->format != PIXMAN_rgba_float &&
-	    checker->format != PIXMAN_rgb_float);
+	    checker->format != PIXMAN_rgb_float &&
+	    PIXMAN_FORMAT_BPP (checker->format) != 64);
 }
 
 void